@@ -20,9 +20,16 @@
  *
  */
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PAULA_SSE2
+#endif
+
 #include "audio/mods/paula.h"
 #include "audio/null.h"
 
+#include "common/config-manager.h"
+
 namespace Audio {
 
 Paula::Paula(bool stereo, int rate, uint interruptFreq) :
@@ -41,11 +48,24 @@ Paula::Paula(bool stereo, int rate, uint interruptFreq) :
 	_timerBase = 1;
 	_playing = false;
 	_end = true;
+	_interpolation = kInterpolationNone;
 }
 
 Paula::~Paula() {
 }
 
+Paula::InterpolationMode Paula::getConfiguredInterpolation() {
+	if (ConfMan.hasKey("amiga_interpolation")) {
+		const Common::String &mode = ConfMan.get("amiga_interpolation");
+		if (mode == "linear")
+			return kInterpolationLinear;
+		else if (mode == "cubic")
+			return kInterpolationCubic;
+	}
+
+	return kInterpolationNone;
+}
+
 void Paula::clearVoice(byte voice) {
 	assert(voice < NUM_VOICES);
 
@@ -57,6 +77,7 @@ void Paula::clearVoice(byte voice) {
 	_voice[voice].volume = 0;
 	_voice[voice].offset = Offset(0);
 	_voice[voice].dmaCount = 0;
+	_voice[voice].prevSample = 0;
 }
 
 int Paula::readBuffer(int16 *buffer, const int numSamples) {
@@ -74,23 +95,148 @@ int Paula::readBuffer(int16 *buffer, const int numSamples) {
 }
 
 
+enum {
+	// Number of frames fetched from a voice before they are mixed
+	kMixBlockSize = 256
+};
+
+/**
+ * Returns the sample at index, continuing into the repeat data when index is
+ * past the end of the current data, as the voice will do after wrapping.
+ */
+static inline int32 sampleAt(const int8 *data, uint length, const int8 *dataRepeat, uint lengthRepeat, uint index) {
+	if (index < length)
+		return data[index];
+	index -= length;
+	if (dataRepeat && lengthRepeat > 2 && index < lengthRepeat)
+		return dataRepeat[index];
+	return 0;
+}
+
+/**
+ * Fetches the volume scaled samples of a voice for up to count frames,
+ * stopping at the end of the data. Between interrupts the period doesn't
+ * change, so the stepping only depends on the offset. prevSample is the
+ * sample played before the first one of the data.
+ */
+static int fetchSamples(int16 *block, int count, const int8 *data, uint length, const int8 *dataRepeat, uint lengthRepeat,
+                        int8 prevSample, Paula::Offset &offset, frac_t rate, byte volume, Paula::InterpolationMode mode) {
+	// Number of frames until the offset reaches the end of the data
+	if (rate > 0) {
+		const uint left = length - offset.int_off;
+		if (left < 0x8000) {
+			const uint32 leftFrac = (left << FRAC_BITS) - offset.rem_off;
+			count = MIN<uint32>(count, (leftFrac + rate - 1) / rate);
+		} else {
+			// Long samples can't be counted down in 16.16 fixed point, but
+			// this many frames are always available
+			count = MIN<uint32>(count, left / (fracToInt(rate) + 1));
+		}
+	}
+
+	uint pos = offset.int_off;
+	frac_t rem = offset.rem_off;
+
+	switch (mode) {
+	case Paula::kInterpolationNone:
+		for (int i = 0; i < count; ++i) {
+			block[i] = data[pos] * volume;
+			rem += rate;
+			pos += fracToInt(rem);
+			rem &= FRAC_LO_MASK;
+		}
+		break;
+
+	case Paula::kInterpolationLinear:
+		for (int i = 0; i < count; ++i) {
+			const int32 s0 = data[pos];
+			const int32 s1 = sampleAt(data, length, dataRepeat, lengthRepeat, pos + 1);
+			block[i] = (((s0 << FRAC_BITS) + (s1 - s0) * rem) >> 8) * volume >> 8;
+			rem += rate;
+			pos += fracToInt(rem);
+			rem &= FRAC_LO_MASK;
+		}
+		break;
+
+	case Paula::kInterpolationCubic:
+		for (int i = 0; i < count; ++i) {
+			// Catmull-Rom spline through the two samples around the offset
+			const float s0 = pos ? data[pos - 1] : prevSample;
+			const float s1 = data[pos];
+			const float s2 = sampleAt(data, length, dataRepeat, lengthRepeat, pos + 1);
+			const float s3 = sampleAt(data, length, dataRepeat, lengthRepeat, pos + 2);
+			const float t = rem * (1.0f / FRAC_ONE);
+			const float v = s1 + 0.5f * t * (s2 - s0 + t * (2.0f * s0 - 5.0f * s1 + 4.0f * s2 - s3 + t * (3.0f * (s1 - s2) + s3 - s0)));
+			block[i] = (int16)(CLIP(v, -256.0f, 255.0f) * volume);
+			rem += rate;
+			pos += fracToInt(rem);
+			rem &= FRAC_LO_MASK;
+		}
+		break;
+	}
+
+	offset.int_off = pos;
+	offset.rem_off = rem;
+	return count;
+}
+
+/**
+ * Adds the fetched samples to the output buffer. The sums wrap around like
+ * the 16 bit additions of the sample by sample mixer did.
+ */
 template<bool stereo>
-inline int mixBuffer(int16 *&buf, const int8 *data, Paula::Offset &offset, frac_t rate, int neededSamples, uint bufSize, byte volume, byte panning) {
-	int samples;
-	for (samples = 0; samples < neededSamples && offset.int_off < bufSize; ++samples) {
-		const int32 tmp = ((int32) data[offset.int_off]) * volume;
+static void mixSamples(int16 *buf, const int16 *block, int count, byte panning) {
+	int i = 0;
+
+#ifdef PAULA_SSE2
+	if (stereo) {
+		const __m128i left = _mm_set1_epi16(255 - panning);
+		const __m128i right = _mm_set1_epi16(panning);
+		for (; i + 8 <= count; i += 8) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)(block + i));
+
+			// 32 bit products of the samples and the panning factors
+			const __m128i lLo = _mm_mullo_epi16(s, left), lHi = _mm_mulhi_epi16(s, left);
+			const __m128i rLo = _mm_mullo_epi16(s, right), rHi = _mm_mulhi_epi16(s, right);
+			const __m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lLo, lHi), 7),
+			                                  _mm_srai_epi32(_mm_unpackhi_epi16(lLo, lHi), 7));
+			const __m128i r = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(rLo, rHi), 7),
+			                                  _mm_srai_epi32(_mm_unpackhi_epi16(rLo, rHi), 7));
+
+			__m128i *out = (__m128i *)(buf + i * 2);
+			_mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_unpacklo_epi16(l, r)));
+			_mm_storeu_si128(out + 1, _mm_add_epi16(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(l, r)));
+		}
+	} else {
+		for (; i + 8 <= count; i += 8) {
+			__m128i *out = (__m128i *)(buf + i);
+			_mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_loadu_si128((const __m128i *)(block + i))));
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		const int32 tmp = block[i];
 		if (stereo) {
-			*buf++ += (tmp * (255 - panning)) >> 7;
-			*buf++ += (tmp * (panning)) >> 7;
+			buf[i * 2] += (tmp * (255 - panning)) >> 7;
+			buf[i * 2 + 1] += (tmp * (panning)) >> 7;
 		} else
-			*buf++ += tmp;
+			buf[i] += tmp;
+	}
+}
 
-		// Step to next source sample
-		offset.rem_off += rate;
-		if (offset.rem_off >= (frac_t)FRAC_ONE) {
-			offset.int_off += fracToInt(offset.rem_off);
-			offset.rem_off &= FRAC_LO_MASK;
-		}
+template<bool stereo>
+int Paula::mixBuffer(int16 *&buf, Channel &ch, frac_t rate, int neededSamples) {
+	int16 block[kMixBlockSize];
+	int samples = 0;
+
+	while (samples < neededSamples && ch.offset.int_off < ch.length) {
+		const int count = fetchSamples(block, MIN<int>(neededSamples - samples, kMixBlockSize),
+		                               ch.data, ch.length, ch.dataRepeat, ch.lengthRepeat,
+		                               ch.prevSample, ch.offset, rate, ch.volume, _interpolation);
+		mixSamples<stereo>(buf, block, count, ch.panning);
+		buf += stereo ? count * 2 : count;
+		samples += count;
 	}
 
 	return samples;
@@ -135,7 +281,7 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 			assert(ch.offset.int_off < ch.length);
 
 			// Mix the generated samples into the output buffer
-			neededSamples -= mixBuffer<stereo>(p, ch.data, ch.offset, rate, neededSamples, ch.length, ch.volume, ch.panning);
+			neededSamples -= mixBuffer<stereo>(p, ch, rate, neededSamples);
 
 			// Wrap around if necessary
 			if (ch.offset.int_off >= ch.length) {
@@ -148,6 +294,7 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 				ch.offset.int_off -= ch.length;
 				ch.dmaCount++;
 
+				ch.prevSample = ch.data[ch.length - 1];
 				ch.data = ch.dataRepeat;
 				ch.length = ch.lengthRepeat;
 			}
@@ -157,12 +304,13 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 				// Repeat as long as necessary.
 				while (neededSamples > 0) {
 					// Mix the generated samples into the output buffer
-					neededSamples -= mixBuffer<stereo>(p, ch.data, ch.offset, rate, neededSamples, ch.length, ch.volume, ch.panning);
+					neededSamples -= mixBuffer<stereo>(p, ch, rate, neededSamples);
 
 					if (ch.offset.int_off >= ch.length) {
 						// Wrap around. See also the note above.
 						ch.offset.int_off -= ch.length;
 						ch.dmaCount++;
+						ch.prevSample = ch.data[ch.length - 1];
 					}
 				}
 			}
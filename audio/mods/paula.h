@@ -54,6 +54,12 @@ public:
 		explicit Offset(int off = 0) : int_off(off), rem_off(0) {}
 	};
 
+	enum InterpolationMode {
+		kInterpolationNone,		///< Play the nearest sample, like the hardware does
+		kInterpolationLinear,
+		kInterpolationCubic
+	};
+
 	Paula(bool stereo = false, int rate = 44100, uint interruptFreq = 0);
 	~Paula();
 
@@ -74,6 +80,17 @@ public:
 	void stopPlay() { _playing = false; }
 	void pausePlay(bool pause) { _playing = !pause; }
 
+	/**
+	 * Sets how samples are resampled to the output rate. The default is
+	 * kInterpolationNone; players set the one returned by
+	 * getConfiguredInterpolation() when they are set up.
+	 */
+	void setInterpolation(InterpolationMode mode) { _interpolation = mode; }
+	InterpolationMode getInterpolation() const { return _interpolation; }
+
+	/** Returns the mode selected by the "amiga_interpolation" setting (none, linear or cubic). */
+	static InterpolationMode getConfiguredInterpolation();
+
 // AudioStream API
 	int readBuffer(int16 *buffer, const int numSamples);
 	bool isStereo() const { return _stereo; }
@@ -91,6 +108,7 @@ protected:
 		Offset offset;
 		byte panning; // For stereo mixing: 0 = far left, 255 = far right
 		int dmaCount;
+		int8 prevSample; // Played before data[0], for interpolation
 	};
 
 	bool _end;
@@ -125,6 +143,7 @@ protected:
 		ch.length = ch.lengthRepeat;
 		// actually first 2 bytes are dropped?
 		ch.offset = Offset(0);
+		ch.prevSample = 0;
 		// ch.period = ch.periodRepeat;
 	}
 
@@ -197,6 +216,10 @@ private:
 	uint _curInt;
 	uint32 _timerBase;
 	bool _playing;
+	InterpolationMode _interpolation;
+
+	template<bool stereo>
+	int mixBuffer(int16 *&buf, Channel &ch, frac_t rate, int neededSamples);
 
 	template<bool stereo>
 	int readBufferIntern(int16 *buffer, const int numSamples);
@@ -459,7 +459,9 @@ void ProtrackerStream::interrupt() {
 namespace Audio {
 
 AudioStream *makeProtrackerStream(Common::SeekableReadStream *stream, int offs, int rate, bool stereo) {
-	return new Modules::ProtrackerStream(stream, offs, rate, stereo);
+	Modules::ProtrackerStream *protracker = new Modules::ProtrackerStream(stream, offs, rate, stereo);
+	protracker->setInterpolation(Paula::getConfiguredInterpolation());
+	return protracker;
 }
 
 } // End of namespace Audio
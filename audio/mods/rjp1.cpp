@@ -566,6 +566,7 @@ const int Rjp1::_periodsCount = ARRAYSIZE(_periodsTable);
 
 AudioStream *makeRjp1Stream(Common::SeekableReadStream *songData, Common::SeekableReadStream *instrumentsData, int num, int rate, bool stereo) {
 	Rjp1 *stream = new Rjp1(rate, stereo);
+	stream->setInterpolation(Paula::getConfiguredInterpolation());
 	if (stream->load(songData, instrumentsData)) {
 		if (num < 0) {
 			stream->startPattern(3, -num);
@@ -262,6 +262,7 @@ void SoundFx::interrupt() {
 
 AudioStream *makeSoundFxStream(Common::SeekableReadStream *data, LoadSoundFxInstrumentCallback loadCb, int rate, bool stereo) {
 	SoundFx *stream = new SoundFx(rate, stereo);
+	stream->setInterpolation(Paula::getConfiguredInterpolation());
 	if (stream->load(data, loadCb)) {
 		stream->play();
 		return stream;
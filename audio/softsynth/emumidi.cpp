@@ -0,0 +1,447 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+// Re-enable some forbidden symbols to avoid clashes with time.h
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
+#include "audio/softsynth/emumidi.h"
+
+#include "common/debug.h"
+#include "common/queue.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+
+#if defined(POSIX) || defined(USE_THREADS)
+#include <time.h>
+#endif
+
+enum {
+	// Frames rendered at once by the render thread
+	kRenderChunk = 512
+};
+
+#ifdef USE_THREADS
+/**
+ * Ring buffer passing samples from one producer to one consumer thread
+ * without locking.
+ */
+class EmulatedSampleRing {
+	int16 *_buffer;
+	uint32 _mask;
+	volatile uint32 _readPos;
+	volatile uint32 _writePos;
+
+public:
+	EmulatedSampleRing(uint32 minSize) : _readPos(0), _writePos(0) {
+		uint32 size = 1;
+		while (size < minSize)
+			size <<= 1;
+		_buffer = new int16[size];
+		_mask = size - 1;
+	}
+
+	~EmulatedSampleRing() {
+		delete[] _buffer;
+	}
+
+	uint32 getSize() const { return _mask + 1; }
+	uint32 getAvailable() const { return _writePos - _readPos; }
+	uint32 getSpace() const { return _mask + 1 - getAvailable(); }
+
+	/** Only to be called by the producer, with count <= getSpace(). */
+	void write(const int16 *data, uint32 count) {
+		const uint32 pos = _writePos & _mask;
+		const uint32 first = MIN(count, _mask + 1 - pos);
+		memcpy(_buffer + pos, data, first * sizeof(int16));
+		memcpy(_buffer, data + first, (count - first) * sizeof(int16));
+
+		// The samples have to be visible before the new position
+		__sync_synchronize();
+		_writePos += count;
+	}
+
+	/** Only to be called by the consumer, with count <= getAvailable(). */
+	void read(int16 *data, uint32 count) {
+		__sync_synchronize();
+		const uint32 pos = _readPos & _mask;
+		const uint32 first = MIN(count, _mask + 1 - pos);
+		memcpy(data, _buffer + pos, first * sizeof(int16));
+		memcpy(data + first, _buffer, (count - first) * sizeof(int16));
+
+		__sync_synchronize();
+		_readPos += count;
+	}
+};
+
+/** A MIDI event waiting for the render thread to reach its frame. */
+struct EmulatedMidiEvent {
+	uint32 time;
+	uint32 b;
+	byte *sysEx;
+	uint16 length;
+};
+#endif
+
+struct EmulatedRenderState {
+#ifdef USE_THREADS
+	pthread_t renderingThread;
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool quit;
+	EmulatedSampleRing *ring;
+	int16 *chunk;
+
+	// Positions in frames. Events are due latency frames after the
+	// frame the mixer is about to play.
+	volatile uint32 playPos;
+	uint32 renderPos;
+	uint32 latency;
+
+	pthread_mutex_t eventMutex;
+	Common::Queue<EmulatedMidiEvent> events;
+#endif
+};
+
+static uint32 getMicros() {
+#if defined(POSIX)
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	return g_system->getMillis() * 1000;
+#endif
+}
+
+MidiDriver_Emulated::MidiDriver_Emulated(Audio::Mixer *mixer) :
+	_isOpen(false),
+	_mixer(mixer),
+	_timerProc(0),
+	_timerParam(0),
+	_nextTick(0),
+	_samplesPerTick(0),
+	_rendering(false),
+	_underruns(0),
+	_statSamples(0),
+	_statTime(0),
+	_baseFreq(250) {
+
+	_renderState = new EmulatedRenderState;
+#ifdef USE_THREADS
+	_renderState->ring = 0;
+	_renderState->chunk = 0;
+#endif
+}
+
+MidiDriver_Emulated::~MidiDriver_Emulated() {
+	stopRenderAhead();
+	delete _renderState;
+}
+
+int MidiDriver_Emulated::renderBuffer(int16 *data, const int numSamples) {
+	const int stereoFactor = isStereo() ? 2 : 1;
+	int len = numSamples / stereoFactor;
+	int step;
+
+	do {
+		step = len;
+		if (step > (_nextTick >> FIXP_SHIFT))
+			step = (_nextTick >> FIXP_SHIFT);
+
+		generateSamples(data, step);
+
+		_nextTick -= step << FIXP_SHIFT;
+		if (!(_nextTick >> FIXP_SHIFT)) {
+			if (_timerProc)
+				(*_timerProc)(_timerParam);
+
+			onTimer();
+
+			_nextTick += _samplesPerTick;
+		}
+
+		data += step * stereoFactor;
+		len -= step;
+	} while (len);
+
+	flushSamples();
+
+	return numSamples;
+}
+
+void MidiDriver_Emulated::updateStats(uint32 start, int numSamples) {
+	// Report the real-time factor, i.e. the time spent rendering relative
+	// to the length of the output, every ten seconds of output
+	_statTime += getMicros() - start;
+	_statSamples += numSamples / (isStereo() ? 2 : 1);
+	if (_statSamples >= (uint32)getRate() * 10) {
+		debug(1, "Emulated MIDI driver: real-time factor %.3f, %d underruns",
+			_statTime / (_statSamples * 1000000.0 / getRate()), _underruns);
+		_statSamples = 0;
+		_statTime = 0;
+	}
+}
+
+bool MidiDriver_Emulated::isRenderingThread() const {
+#ifdef USE_THREADS
+	return _rendering && pthread_equal(pthread_self(), _renderState->renderingThread);
+#else
+	return false;
+#endif
+}
+
+int MidiDriver_Emulated::readBuffer(int16 *data, const int numSamples) {
+#ifdef USE_THREADS
+	EmulatedRenderState *state = _renderState;
+	if (state->ring) {
+		const uint32 count = MIN<uint32>(numSamples, state->ring->getAvailable());
+		state->ring->read(data, count);
+		if (count < (uint32)numSamples) {
+			memset(data + count, 0, (numSamples - count) * sizeof(int16));
+			_underruns++;
+		}
+
+		// Silence filled in on an underrun still counts as played, so that
+		// queued events keep their distance to the output
+		state->playPos += numSamples / (isStereo() ? 2 : 1);
+		pthread_cond_signal(&state->cond);
+		return numSamples;
+	}
+
+	state->renderingThread = pthread_self();
+#endif
+
+	const uint32 start = getMicros();
+	_rendering = true;
+	renderBuffer(data, numSamples);
+	_rendering = false;
+	updateStats(start, numSamples);
+
+	return numSamples;
+}
+
+#ifdef USE_THREADS
+
+bool MidiDriver_Emulated::queueEvent(uint32 b) {
+	EmulatedRenderState *state = _renderState;
+	if (!state->ring || isRenderingThread())
+		return false;
+
+	EmulatedMidiEvent event;
+	event.time = state->playPos + state->latency;
+	event.b = b;
+	event.sysEx = 0;
+	event.length = 0;
+
+	pthread_mutex_lock(&state->eventMutex);
+	state->events.push(event);
+	pthread_mutex_unlock(&state->eventMutex);
+	return true;
+}
+
+bool MidiDriver_Emulated::queueSysEx(const byte *msg, uint16 length) {
+	EmulatedRenderState *state = _renderState;
+	if (!state->ring || isRenderingThread())
+		return false;
+
+	EmulatedMidiEvent event;
+	event.time = state->playPos + state->latency;
+	event.b = 0;
+	event.sysEx = new byte[length];
+	event.length = length;
+	memcpy(event.sysEx, msg, length);
+
+	pthread_mutex_lock(&state->eventMutex);
+	state->events.push(event);
+	pthread_mutex_unlock(&state->eventMutex);
+	return true;
+}
+
+void MidiDriver_Emulated::renderChunk(int16 *data, int numSamples) {
+	EmulatedRenderState *state = _renderState;
+	const int stereoFactor = isStereo() ? 2 : 1;
+	int len = numSamples / stereoFactor;
+
+	const uint32 start = getMicros();
+	state->renderingThread = pthread_self();
+	_rendering = true;
+
+	while (len) {
+		// Apply all events which are due and render up to the next one
+		int step = len;
+
+		pthread_mutex_lock(&state->eventMutex);
+		while (!state->events.empty()) {
+			const int32 due = (int32)(state->events.front().time - state->renderPos);
+			if (due > 0) {
+				step = MIN<int>(step, due);
+				break;
+			}
+
+			EmulatedMidiEvent event = state->events.pop();
+			pthread_mutex_unlock(&state->eventMutex);
+			if (event.sysEx) {
+				sysEx(event.sysEx, event.length);
+				delete[] event.sysEx;
+			} else {
+				send(event.b);
+			}
+			pthread_mutex_lock(&state->eventMutex);
+		}
+		pthread_mutex_unlock(&state->eventMutex);
+
+		renderBuffer(data, step * stereoFactor);
+		state->renderPos += step;
+		data += step * stereoFactor;
+		len -= step;
+	}
+
+	_rendering = false;
+	updateStats(start, numSamples);
+}
+
+void *MidiDriver_Emulated::renderThreadProc(void *param) {
+	((MidiDriver_Emulated *)param)->renderThread();
+	return 0;
+}
+
+void MidiDriver_Emulated::renderThread() {
+	EmulatedRenderState *state = _renderState;
+	const uint32 chunkSamples = kRenderChunk * (isStereo() ? 2 : 1);
+
+	pthread_mutex_lock(&state->mutex);
+	while (!state->quit) {
+		if (state->ring->getSpace() < chunkSamples) {
+			// The mixer signals after every read; the timeout only
+			// covers signals sent while the thread wasn't waiting yet
+			timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += 2000000;
+			if (ts.tv_nsec >= 1000000000) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+			pthread_cond_timedwait(&state->cond, &state->mutex, &ts);
+			continue;
+		}
+
+		pthread_mutex_unlock(&state->mutex);
+		renderChunk(state->chunk, chunkSamples);
+		state->ring->write(state->chunk, chunkSamples);
+		pthread_mutex_lock(&state->mutex);
+	}
+	pthread_mutex_unlock(&state->mutex);
+}
+
+bool MidiDriver_Emulated::startRenderAhead(uint32 latency) {
+	EmulatedRenderState *state = _renderState;
+	if (state->ring || !latency)
+		return false;
+
+	const int stereoFactor = isStereo() ? 2 : 1;
+	const uint32 chunkSamples = kRenderChunk * stereoFactor;
+	EmulatedSampleRing *ring = new EmulatedSampleRing(MAX<uint32>(getRate() * latency / 1000 * stereoFactor, chunkSamples * 2));
+
+	state->quit = false;
+	state->chunk = new int16[chunkSamples];
+	state->playPos = 0;
+	state->renderPos = 0;
+	state->latency = ring->getSize() / stereoFactor;
+	pthread_mutex_init(&state->eventMutex, 0);
+
+	// Start with a full buffer, the first mixer callback would underrun otherwise
+	while (ring->getSpace() >= chunkSamples) {
+		renderChunk(state->chunk, chunkSamples);
+		ring->write(state->chunk, chunkSamples);
+	}
+
+	pthread_mutex_init(&state->mutex, 0);
+	pthread_cond_init(&state->cond, 0);
+
+	state->ring = ring;
+	if (pthread_create(&state->thread, 0, &renderThreadProc, this) != 0) {
+		warning("Emulated MIDI driver: Could not create render thread");
+		state->ring = 0;
+		pthread_cond_destroy(&state->cond);
+		pthread_mutex_destroy(&state->mutex);
+		pthread_mutex_destroy(&state->eventMutex);
+		delete ring;
+		delete[] state->chunk;
+		state->chunk = 0;
+		return false;
+	}
+
+	debug(1, "Emulated MIDI driver: Rendering %d ms ahead", state->latency * 1000 / getRate());
+	return true;
+}
+
+void MidiDriver_Emulated::stopRenderAhead() {
+	EmulatedRenderState *state = _renderState;
+	if (!state->ring)
+		return;
+
+	pthread_mutex_lock(&state->mutex);
+	state->quit = true;
+	pthread_cond_signal(&state->cond);
+	pthread_mutex_unlock(&state->mutex);
+
+	pthread_join(state->thread, 0);
+
+	delete state->ring;
+	state->ring = 0;
+	delete[] state->chunk;
+	state->chunk = 0;
+
+	// Events which weren't due yet are dropped along with the output
+	while (!state->events.empty())
+		delete[] state->events.pop().sysEx;
+
+	pthread_cond_destroy(&state->cond);
+	pthread_mutex_destroy(&state->mutex);
+	pthread_mutex_destroy(&state->eventMutex);
+}
+
+#else
+
+bool MidiDriver_Emulated::queueEvent(uint32 b) {
+	return false;
+}
+
+bool MidiDriver_Emulated::queueSysEx(const byte *msg, uint16 length) {
+	return false;
+}
+
+bool MidiDriver_Emulated::startRenderAhead(uint32 latency) {
+	if (latency)
+		warning("Emulated MIDI driver: Rendering ahead is not supported on this platform");
+	return false;
+}
+
+void MidiDriver_Emulated::stopRenderAhead() {
+}
+
+#endif
@@ -28,6 +28,8 @@
 
 #define FIXP_SHIFT 16
 
+struct EmulatedRenderState;
+
 class MidiDriver_Emulated : public Audio::AudioStream, public MidiDriver {
 protected:
 	bool _isOpen;
@@ -41,22 +43,64 @@ private:
 	int _nextTick;
 	int _samplesPerTick;
 
+	EmulatedRenderState *_renderState;
+	volatile bool _rendering;
+	uint32 _underruns;
+	uint32 _statSamples;
+	uint32 _statTime;
+
+	static void *renderThreadProc(void *param);
+	void renderThread();
+	void renderChunk(int16 *data, int numSamples);
+	void updateStats(uint32 start, int numSamples);
+	int renderBuffer(int16 *data, const int numSamples);
+
 protected:
 	int _baseFreq;
 
 	virtual void generateSamples(int16 *buf, int len) = 0;
 	virtual void onTimer() {}
 
+	/**
+	 * Called after every rendered block, for drivers which collect the
+	 * generateSamples() calls and render them at once.
+	 */
+	virtual void flushSamples() {}
+
+	/**
+	 * Starts rendering on a separate thread, ahead of the mixer. Has to be
+	 * called before the stream is passed to the mixer.
+	 *
+	 * Events sent from any other thread than the rendering one are queued
+	 * and applied at the sample they are due, latency milliseconds after
+	 * the sample the mixer is currently playing.
+	 *
+	 * @param latency	time to render ahead, in milliseconds
+	 * @return true if the render thread is running
+	 */
+	bool startRenderAhead(uint32 latency);
+
+	/** Stops the render thread. Has to be called after the mixer released the stream. */
+	void stopRenderAhead();
+
+	/**
+	 * Queues a MIDI event for the render thread. Drivers call this at the
+	 * start of send() and return if it succeeded.
+	 *
+	 * @return true if the event was queued, false if it has to be
+	 *         applied right away
+	 */
+	bool queueEvent(uint32 b);
+
+	/** Queues a SysEx message for the render thread, like queueEvent(). */
+	bool queueSysEx(const byte *msg, uint16 length);
+
+	/** Returns whether the calling thread is currently rendering samples. */
+	bool isRenderingThread() const;
+
 public:
-	MidiDriver_Emulated(Audio::Mixer *mixer) :
-		_mixer(mixer),
-		_isOpen(false),
-		_timerProc(0),
-		_timerParam(0),
-		_nextTick(0),
-		_samplesPerTick(0),
-		_baseFreq(250) {
-	}
+	MidiDriver_Emulated(Audio::Mixer *mixer);
+	virtual ~MidiDriver_Emulated();
 
 	// MidiDriver API
 	virtual int open() {
@@ -84,35 +128,11 @@ public:
 		return 1000000 / _baseFreq;
 	}
 
-	// AudioStream API
-	virtual int readBuffer(int16 *data, const int numSamples) {
-		const int stereoFactor = isStereo() ? 2 : 1;
-		int len = numSamples / stereoFactor;
-		int step;
-
-		do {
-			step = len;
-			if (step > (_nextTick >> FIXP_SHIFT))
-				step = (_nextTick >> FIXP_SHIFT);
+	/** Returns the number of mixer callbacks the render thread couldn't fill in time. */
+	uint32 getUnderruns() const { return _underruns; }
 
-			generateSamples(data, step);
-
-			_nextTick -= step << FIXP_SHIFT;
-			if (!(_nextTick >> FIXP_SHIFT)) {
-				if (_timerProc)
-					(*_timerProc)(_timerParam);
-
-				onTimer();
-
-				_nextTick += _samplesPerTick;
-			}
-
-			data += step * stereoFactor;
-			len -= step;
-		} while (len);
-
-		return numSamples;
-	}
+	// AudioStream API
+	virtual int readBuffer(int16 *data, const int numSamples);
 
 	virtual bool endOfData() const {
 		return false;
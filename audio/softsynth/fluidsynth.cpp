@@ -142,6 +142,8 @@ int MidiDriver_FluidSynth::open() {
 
 	MidiDriver_Emulated::open();
 
+	startRenderAhead(ConfMan.getInt("softsynth_latency"));
+
 	// The MT-32 emulator uses kSFXSoundType here. I don't know why.
 	_mixer->playStream(Audio::Mixer::kMusicSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 	return 0;
@@ -153,6 +155,7 @@ void MidiDriver_FluidSynth::close() {
 	_isOpen = false;
 
 	_mixer->stopHandle(_mixerSoundHandle);
+	stopRenderAhead();
 
 	if (_soundFont != -1)
 		fluid_synth_sfunload(_synth, _soundFont, 1);
@@ -162,6 +165,9 @@ void MidiDriver_FluidSynth::close() {
 }
 
 void MidiDriver_FluidSynth::send(uint32 b) {
+	if (queueEvent(b))
+		return;
+
 	//byte param3 = (byte) ((b >> 24) & 0xFF);
 	uint param2 = (byte) ((b >> 16) & 0xFF);
 	uint param1 = (byte) ((b >>  8) & 0xFF);
@@ -59,8 +59,18 @@ private:
 
 	int _outputRate;
 
+	// With several render threads, rendering is deferred until the next
+	// MIDI event or the end of the buffer, so that the synth gets blocks
+	// long enough to be split up
+	bool _deferRendering;
+	int16 *_pendingBuf;
+	int _pendingLen;
+
+	void flushPendingSamples();
+
 protected:
 	void generateSamples(int16 *buf, int len);
+	void flushSamples() { flushPendingSamples(); }
 
 public:
 	bool _initializing;
@@ -284,6 +294,10 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 	// rely on Mixer to convert.
 	_outputRate = 32000; //_mixer->getOutputRate();
 	_initializing = false;
+
+	_deferRendering = false;
+	_pendingBuf = 0;
+	_pendingLen = 0;
 }
 
 MidiDriver_MT32::~MidiDriver_MT32() {
@@ -310,6 +324,12 @@ int MidiDriver_MT32::open() {
 	prop.report = MT32_Report;
 	prop.openFile = MT32_OpenFile;
 
+	// The output is the same for any number of threads
+	prop.renderThreads = MAX(ConfMan.getInt("mt32_render_threads"), 1);
+#if MT32EMU_USE_THREADS
+	_deferRendering = (prop.renderThreads > 1);
+#endif
+
 	_synth = new MT32Emu::Synth();
 
 	Graphics::PixelFormat screenFormat = g_system->getScreenFormat();
@@ -337,12 +357,18 @@ int MidiDriver_MT32::open() {
 
 	g_system->updateScreen();
 
+	startRenderAhead(ConfMan.getInt("softsynth_latency"));
+
 	_mixer->playStream(Audio::Mixer::kSFXSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 
 	return 0;
 }
 
 void MidiDriver_MT32::send(uint32 b) {
+	if (queueEvent(b))
+		return;
+	if (_pendingLen && isRenderingThread())
+		flushPendingSamples();
 	_synth->playMsg(b);
 }
 
@@ -364,6 +390,10 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
+	if (queueSysEx(msg, length))
+		return;
+	if (_pendingLen && isRenderingThread())
+		flushPendingSamples();
 	if (msg[0] == 0xf0) {
 		_synth->playSysex(msg, length);
 	} else {
@@ -381,13 +411,30 @@ void MidiDriver_MT32::close() {
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
 
+	stopRenderAhead();
+
 	_synth->close();
 	delete _synth;
 	_synth = NULL;
 }
 
 void MidiDriver_MT32::generateSamples(int16 *data, int len) {
-	_synth->render(data, len);
+	if (!_deferRendering) {
+		_synth->render(data, len);
+		return;
+	}
+
+	if (_pendingLen && _pendingBuf + _pendingLen * 2 != data)
+		flushPendingSamples();
+	if (!_pendingLen)
+		_pendingBuf = data;
+	_pendingLen += len;
+}
+
+void MidiDriver_MT32::flushPendingSamples() {
+	if (_pendingLen)
+		_synth->render(_pendingBuf, _pendingLen);
+	_pendingLen = 0;
 }
 
 uint32 MidiDriver_MT32::property(int prop, uint32 param) {
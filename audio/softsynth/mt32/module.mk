@@ -6,6 +6,7 @@ MODULE_OBJS := \
 	part.o \
 	partial.o \
 	partialManager.o \
+	renderthreads.o \
 	synth.o \
 	tables.o \
 	freeverb.o
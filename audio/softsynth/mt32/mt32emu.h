@@ -56,6 +56,15 @@
 #define MT32EMU_USE_MMX 0
 #endif
 
+// Partials can be rendered on several threads, see SynthProperties::renderThreads.
+// USE_THREADS is set by configure when pthreads are available.
+#include "common/scummsys.h"
+#ifdef USE_THREADS
+#define MT32EMU_USE_THREADS 1
+#else
+#define MT32EMU_USE_THREADS 0
+#endif
+
 #include "freeverb.h"
 
 #include "structures.h"
@@ -64,6 +73,7 @@
 #include "tables.h"
 #include "partial.h"
 #include "partialManager.h"
+#include "renderthreads.h"
 #include "part.h"
 #include "synth.h"
 
@@ -0,0 +1,157 @@
+/* Copyright (c) 2003-2005 Various contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+// pthread.h pulls in time.h
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
+#include "mt32emu.h"
+
+#if MT32EMU_USE_THREADS
+
+#include <pthread.h>
+
+namespace MT32Emu {
+
+struct RenderThreadsState {
+	pthread_mutex_t mutex;
+	pthread_cond_t startCond;
+	pthread_cond_t doneCond;
+	pthread_t *workers;
+	unsigned int workerCount;
+
+	// The current batch, only changed while all workers are waiting
+	RenderThreads::Job job;
+	void *param;
+	unsigned int count;
+	unsigned int generation;
+	bool quit;
+
+	// Next index to hand out, taken without holding the mutex
+	volatile unsigned int next;
+	// Number of workers done with the current batch
+	unsigned int finishedWorkers;
+};
+
+static void runJobs(RenderThreadsState *state) {
+	for (;;) {
+		unsigned int index = __sync_fetch_and_add(&state->next, 1);
+		if (index >= state->count)
+			break;
+		state->job(state->param, index);
+	}
+}
+
+RenderThreads::RenderThreads(unsigned int useThreadCount) {
+	state = new RenderThreadsState;
+	pthread_mutex_init(&state->mutex, NULL);
+	pthread_cond_init(&state->startCond, NULL);
+	pthread_cond_init(&state->doneCond, NULL);
+	state->job = NULL;
+	state->param = NULL;
+	state->count = 0;
+	state->generation = 0;
+	state->quit = false;
+	state->next = 0;
+	state->finishedWorkers = 0;
+
+	state->workers = new pthread_t[useThreadCount];
+	state->workerCount = 0;
+	for (unsigned int i = 1; i < useThreadCount; i++) {
+		if (pthread_create(&state->workers[state->workerCount], NULL, &workerThread, this) != 0)
+			break;
+		state->workerCount++;
+	}
+	threadCount = state->workerCount + 1;
+}
+
+RenderThreads::~RenderThreads() {
+	pthread_mutex_lock(&state->mutex);
+	state->quit = true;
+	pthread_cond_broadcast(&state->startCond);
+	pthread_mutex_unlock(&state->mutex);
+
+	for (unsigned int i = 0; i < state->workerCount; i++)
+		pthread_join(state->workers[i], NULL);
+
+	pthread_cond_destroy(&state->doneCond);
+	pthread_cond_destroy(&state->startCond);
+	pthread_mutex_destroy(&state->mutex);
+	delete[] state->workers;
+	delete state;
+}
+
+void *RenderThreads::workerThread(void *param) {
+	((RenderThreads *)param)->work();
+	return NULL;
+}
+
+void RenderThreads::work() {
+	unsigned int generation = 0;
+
+	pthread_mutex_lock(&state->mutex);
+	for (;;) {
+		while (!state->quit && state->generation == generation)
+			pthread_cond_wait(&state->startCond, &state->mutex);
+		if (state->quit)
+			break;
+		generation = state->generation;
+		pthread_mutex_unlock(&state->mutex);
+
+		runJobs(state);
+
+		// run() doesn't return before every worker checked in, so no
+		// worker can still be busy with a batch when the next one starts
+		pthread_mutex_lock(&state->mutex);
+		if (++state->finishedWorkers == state->workerCount)
+			pthread_cond_signal(&state->doneCond);
+	}
+	pthread_mutex_unlock(&state->mutex);
+}
+
+void RenderThreads::run(Job job, void *param, unsigned int count) {
+	if (state->workerCount == 0 || count < 2) {
+		for (unsigned int i = 0; i < count; i++)
+			job(param, i);
+		return;
+	}
+
+	pthread_mutex_lock(&state->mutex);
+	state->job = job;
+	state->param = param;
+	state->count = count;
+	state->next = 0;
+	state->finishedWorkers = 0;
+	state->generation++;
+	pthread_cond_broadcast(&state->startCond);
+	pthread_mutex_unlock(&state->mutex);
+
+	runJobs(state);
+
+	pthread_mutex_lock(&state->mutex);
+	while (state->finishedWorkers != state->workerCount)
+		pthread_cond_wait(&state->doneCond, &state->mutex);
+	pthread_mutex_unlock(&state->mutex);
+}
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+/* Copyright (c) 2003-2005 Various contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MT32EMU_RENDERTHREADS_H
+#define MT32EMU_RENDERTHREADS_H
+
+namespace MT32Emu {
+
+struct RenderThreadsState;
+
+// A pool of worker threads, used to render independent partials in parallel.
+// The thread calling run() takes part in the work, so a pool created for N
+// threads starts N - 1 workers.
+class RenderThreads {
+public:
+	typedef void (*Job)(void *param, unsigned int index);
+
+private:
+	RenderThreadsState *state;
+	unsigned int threadCount;
+
+	static void *workerThread(void *param);
+	void work();
+
+public:
+	RenderThreads(unsigned int useThreadCount);
+	~RenderThreads();
+
+	unsigned int getThreadCount() const { return threadCount; }
+
+	// Calls job(param, index) for every index below count, spread over all
+	// threads, and returns once all of them are done
+	void run(Job job, void *param, unsigned int count);
+};
+
+}
+
+#endif
@@ -25,6 +25,8 @@
 namespace MT32Emu {
 
 const unsigned int MAX_SAMPLE_OUTPUT = 4096;
+// Shorter blocks aren't worth spreading over several threads
+const unsigned int MIN_PARALLEL_RENDER_LENGTH = 128;
 
 // MT32EMU_MEMADDR() converts from sysex-padded, MT32EMU_SYSEXMEMADDR converts to it
 // Roland provides documentation using the sysex-padded addresses, so we tend to use that in code and output
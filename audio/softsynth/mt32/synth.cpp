@@ -107,6 +107,8 @@ Synth::Synth() {
 	isOpen = false;
 	reverbModel = NULL;
 	partialManager = NULL;
+	renderThreads = NULL;
+	partialBuffers = NULL;
 	memset(parts, 0, sizeof(parts));
 }
 
@@ -520,6 +522,14 @@ bool Synth::open(SynthProperties &useProp) {
 	}
 #endif
 
+#if MT32EMU_USE_THREADS
+	if (myProp.renderThreads > 1) {
+		renderThreads = new RenderThreads(myProp.renderThreads);
+		partialBuffers = new Bit16s[MT32EMU_MAX_PARTIALS * MAX_SAMPLE_OUTPUT * 2];
+		printDebug("Rendering partials on %d threads", renderThreads->getThreadCount());
+	}
+#endif
+
 	isOpen = true;
 	isEnabled = false;
 
@@ -555,6 +565,14 @@ void Synth::close(void) {
 
 	delete[] pcmWaves;
 	delete[] pcmROMData;
+
+#if MT32EMU_USE_THREADS
+	delete renderThreads;
+	renderThreads = NULL;
+#endif
+	delete[] partialBuffers;
+	partialBuffers = NULL;
+
 	isOpen = false;
 }
 
@@ -1135,10 +1153,105 @@ void Synth::render(Bit16s *stream, Bit32u len) {
 	}
 }
 
+void Synth::reverbStream(Bit16s *stream, Bit32u len) {
+	Bit32u m = 0;
+	for (unsigned int i = 0; i < len; i++) {
+		sndbufl[i] = (float)stream[m] / 32767.0f;
+		m++;
+		sndbufr[i] = (float)stream[m] / 32767.0f;
+		m++;
+	}
+	reverbModel->processreplace(sndbufl, sndbufr, outbufl, outbufr, len, 1);
+	m=0;
+	for (unsigned int i = 0; i < len; i++) {
+		stream[m] = (Bit16s)(outbufl[i] * 32767.0f);
+		m++;
+		stream[m] = (Bit16s)(outbufr[i] * 32767.0f);
+		m++;
+	}
+}
+
+bool Synth::prepareRenderGroups() {
+	// doRender() renders the reverb partials first
+	int order[MT32EMU_MAX_PARTIALS];
+	unsigned int orderCount = 0;
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		partialReverb[i] = myProp.useReverb && partialManager->shouldReverb(i);
+		if (partialReverb[i])
+			order[orderCount++] = i;
+	}
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		if (!partialReverb[i])
+			order[orderCount++] = i;
+	}
+
+	// The first partial of a pair to be rendered also renders the samples
+	// of the other one, so both have to be rendered by the same thread
+	bool grouped[MT32EMU_MAX_PARTIALS];
+	memset(grouped, 0, sizeof(grouped));
+	renderGroupCount = 0;
+	for (unsigned int n = 0; n < MT32EMU_MAX_PARTIALS; n++) {
+		int i = order[n];
+		if (grouped[i])
+			continue;
+
+		int *group = renderGroups[renderGroupCount++];
+		group[0] = i;
+		group[1] = -1;
+		grouped[i] = true;
+
+		const Partial *partial = partialManager->getPartial(i);
+		if (partial->getOwnerPart() < 0 || partial->pair == NULL)
+			continue;
+
+		for (int j = 0; j < MT32EMU_MAX_PARTIALS; j++) {
+			if (partialManager->getPartial(j) == partial->pair) {
+				// Pairs which don't point at each other can't be split up safely
+				if (grouped[j] || partial->pair->pair != partial)
+					return false;
+				group[1] = j;
+				grouped[j] = true;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+void Synth::renderGroup(void *param, unsigned int group) {
+	Synth *synth = (Synth *)param;
+	for (int n = 0; n < 2; n++) {
+		int i = synth->renderGroups[group][n];
+		if (i < 0)
+			break;
+		synth->partialOutput[i] = synth->partialManager->produceOutput(i, &synth->partialBuffers[i * MAX_SAMPLE_OUTPUT * 2], synth->renderLength);
+	}
+}
+
+void Synth::doRenderParallel(Bit16s *stream, Bit32u len) {
+	renderLength = len;
+	renderThreads->run(renderGroup, this, renderGroupCount);
+
+	// The partials are mixed in the same order as by doRender(), which
+	// keeps the output independent of the number of threads
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		if (partialReverb[i] && partialOutput[i])
+			ProduceOutput1(&partialBuffers[i * MAX_SAMPLE_OUTPUT * 2], stream, len, masterVolume);
+	}
+	if (myProp.useReverb)
+		reverbStream(stream, len);
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		if (!partialReverb[i] && partialOutput[i])
+			ProduceOutput1(&partialBuffers[i * MAX_SAMPLE_OUTPUT * 2], stream, len, masterVolume);
+	}
+}
+
 void Synth::doRender(Bit16s *stream, Bit32u len) {
 	partialManager->ageAll();
 
-	if (myProp.useReverb) {
+	if (renderThreads != NULL && len >= MIN_PARALLEL_RENDER_LENGTH && prepareRenderGroups()) {
+		doRenderParallel(stream, len);
+	} else if (myProp.useReverb) {
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (partialManager->shouldReverb(i)) {
 				if (partialManager->produceOutput(i, &tmpBuffer[0], len)) {
@@ -1146,21 +1259,7 @@ void Synth::doRender(Bit16s *stream, Bit32u len) {
 				}
 			}
 		}
-		Bit32u m = 0;
-		for (unsigned int i = 0; i < len; i++) {
-			sndbufl[i] = (float)stream[m] / 32767.0f;
-			m++;
-			sndbufr[i] = (float)stream[m] / 32767.0f;
-			m++;
-		}
-		reverbModel->processreplace(sndbufl, sndbufr, outbufl, outbufr, len, 1);
-		m=0;
-		for (unsigned int i = 0; i < len; i++) {
-			stream[m] = (Bit16s)(outbufl[i] * 32767.0f);
-			m++;
-			stream[m] = (Bit16s)(outbufr[i] * 32767.0f);
-			m++;
-		}
+		reverbStream(stream, len);
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (!partialManager->shouldReverb(i)) {
 				if (partialManager->produceOutput(i, &tmpBuffer[0], len)) {
@@ -87,6 +87,9 @@ struct SynthProperties {
 	File *(*openFile)(void *userData, const char *filename, File::OpenMode mode);
 	// Callback for closing a File. May be NULL, in which case the File will automatically be close()d/deleted.
 	void (*closeFile)(void *userData, File *file);
+	// Number of threads rendering the partials. The output doesn't depend on it.
+	// 0 or 1 renders everything on the calling thread.
+	unsigned int renderThreads;
 };
 
 // This is the specification of the Callback routine used when calling the RecalcWaveforms
@@ -224,6 +227,17 @@ private:
 	Part *parts[9];
 
 	Bit16s tmpBuffer[MAX_SAMPLE_OUTPUT * 2];
+
+	// Used when rendering the partials in parallel. Partials are rendered in
+	// groups of a partial and its pair, in the order doRender() would render
+	// them, each into its own buffer.
+	RenderThreads *renderThreads;
+	Bit16s *partialBuffers;
+	bool partialOutput[MT32EMU_MAX_PARTIALS];
+	bool partialReverb[MT32EMU_MAX_PARTIALS];
+	int renderGroups[MT32EMU_MAX_PARTIALS][2];
+	unsigned int renderGroupCount;
+	Bit32u renderLength;
 	float sndbufl[MAX_SAMPLE_OUTPUT];
 	float sndbufr[MAX_SAMPLE_OUTPUT];
 	float outbufl[MAX_SAMPLE_OUTPUT];
@@ -234,6 +248,10 @@ private:
 	bool loadPreset(File *file);
 	void initReverb(Bit8u newRevMode, Bit8u newRevTime, Bit8u newRevLevel);
 	void doRender(Bit16s * stream, Bit32u len);
+	bool prepareRenderGroups();
+	void doRenderParallel(Bit16s * stream, Bit32u len);
+	void reverbStream(Bit16s *stream, Bit32u len);
+	static void renderGroup(void *param, unsigned int group);
 
 	void playAddressedSysex(unsigned char channel, const Bit8u *sysex, Bit32u len);
 	void readSysex(unsigned char channel, const Bit8u *sysex, Bit32u len);
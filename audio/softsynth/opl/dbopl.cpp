@@ -34,6 +34,11 @@
 
 // Last synch with DOSBox SVN trunk r3556
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DBOPL_SSE2
+#endif
+
 #include "dbopl.h"
 
 #ifndef DISABLE_DOSBOX_OPL
@@ -90,6 +95,9 @@ namespace DBOPL {
 //Has to fit within 16bit lookuptable
 #define MUL_SH		16
 
+//Amount of samples the envelope and phase of the operators are generated for in one go
+#define BLOCK_SIZE	64
+
 //Check some ranges
 #if ENV_EXTRA > 3
 #error Too many envelope bits
@@ -582,6 +590,55 @@ INLINE Bits Operator::GetWave( Bitu index, Bitu vol ) {
 #endif
 }
 
+INLINE void Operator::ForwardVolumeBlock( Bit32u samples, Bit32u* vol ) {
+	Bit32u i = 0;
+	while ( i < samples ) {
+		Bit32u constant;
+		if ( state == OFF ) {
+			constant = ENV_MAX;
+		} else if ( state == SUSTAIN && ( reg20 & MASK_SUSTAIN ) ) {
+			constant = volume;
+		} else {
+			//Step the envelope until it reaches another state
+			Bit8u current = state;
+			do {
+				vol[ i++ ] = currentLevel + (this->*volHandler)();
+			} while ( i < samples && state == current );
+			continue;
+		}
+		//Nothing changes until the next register write
+		constant += currentLevel;
+		for ( ; i < samples; i++ )
+			vol[ i ] = constant;
+	}
+}
+
+INLINE void Operator::ForwardWaveBlock( Bit32u samples, Bit32u* phase ) {
+	Bit32u index = waveIndex;
+	Bit32u i = 0;
+#ifdef DBOPL_SSE2
+	const __m128i step = _mm_set1_epi32( waveCurrent * 4 );
+	__m128i current = _mm_setr_epi32( index + waveCurrent, index + waveCurrent * 2,
+		index + waveCurrent * 3, index + waveCurrent * 4 );
+	for ( ; i + 4 <= samples; i += 4 ) {
+		_mm_storeu_si128( (__m128i *)( phase + i ), _mm_srli_epi32( current, WAVE_SH ) );
+		current = _mm_add_epi32( current, step );
+	}
+	index += waveCurrent * i;
+#endif
+	for ( ; i < samples; i++ ) {
+		index += waveCurrent;
+		phase[ i ] = index >> WAVE_SH;
+	}
+	waveIndex = index;
+}
+
+INLINE Bits Operator::GetBlockSample( Bit32u vol, Bit32u phase, Bits modulation ) {
+	if ( ENV_SILENT( vol ) )
+		return 0;
+	return GetWave( phase + modulation, vol );
+}
+
 INLINE Bits Operator::GetSample( Bits modulation ) {
 	Bitu vol = ForwardVolume();
 	if ( ENV_SILENT( vol ) ) {
@@ -911,80 +968,68 @@ Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 		Op( 4 )->Prepare( chip );
 		Op( 5 )->Prepare( chip );
 	}
-	for ( Bitu i = 0; i < samples; i++ ) {
-		//Early out for percussion handlers
-		if ( mode == sm2Percussion ) {
-			GeneratePercussion<false>( chip, output + i );
-			continue;	//Prevent some unitialized value bitching
-		} else if ( mode == sm3Percussion ) {
-			GeneratePercussion<true>( chip, output + i * 2 );
-			continue;	//Prevent some unitialized value bitching
+	//Percussion mixes in noise and shares operators between the drums, it's
+	//generated sample by sample
+	if ( mode == sm2Percussion || mode == sm3Percussion ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			if ( mode == sm2Percussion ) {
+				GeneratePercussion<false>( chip, output + i );
+			} else {
+				GeneratePercussion<true>( chip, output + i * 2 );
+			}
 		}
-
-		//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
-		Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
-		old[0] = old[1];
-		old[1] = Op(0)->GetSample( mod );
-		Bit32s sample;
-		Bit32s out0 = old[0];
-		if ( mode == sm2AM || mode == sm3AM ) {
-			sample = out0 + Op(1)->GetSample( 0 );
-		} else if ( mode == sm2FM || mode == sm3FM ) {
-			sample = Op(1)->GetSample( out0 );
-		} else if ( mode == sm3FMFM ) {
-			Bits next = Op(1)->GetSample( out0 );
-			next = Op(2)->GetSample( next );
-			sample = Op(3)->GetSample( next );
-		} else if ( mode == sm3AMFM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			next = Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( next );
-		} else if ( mode == sm3FMAM ) {
-			sample = Op(1)->GetSample( out0 );
-			Bits next = Op(2)->GetSample( 0 );
-			sample += Op(3)->GetSample( next );
-		} else if ( mode == sm3AMAM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			sample += Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( 0 );
+		return( this + 3 );
+	}
+	//The envelope and phase of an operator don't depend on the other operators,
+	//so they are generated for a block of samples before the operators get mixed
+	const Bitu ops = ( mode > sm4Start ) ? 4 : 2;
+	Bit32u vol[ 4 ][ BLOCK_SIZE ];
+	Bit32u phase[ 4 ][ BLOCK_SIZE ];
+	while ( samples > 0 ) {
+		const Bit32u count = samples < BLOCK_SIZE ? samples : BLOCK_SIZE;
+		for ( Bitu o = 0; o < ops; o++ ) {
+			Op( o )->ForwardVolumeBlock( count, vol[ o ] );
+			Op( o )->ForwardWaveBlock( count, phase[ o ] );
 		}
-		switch( mode ) {
-		case sm2AM:
-		case sm2FM:
-			output[ i ] += sample;
-			break;
-		case sm3AM:
-		case sm3FM:
-		case sm3FMFM:
-		case sm3AMFM:
-		case sm3FMAM:
-		case sm3AMAM:
-			output[ i * 2 + 0 ] += sample & maskLeft;
-			output[ i * 2 + 1 ] += sample & maskRight;
-			break;
-		case sm2Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm3Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm4Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm6Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
+		for ( Bitu i = 0; i < count; i++ ) {
+			//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
+			Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
+			old[0] = old[1];
+			old[1] = Op(0)->GetBlockSample( vol[0][i], phase[0][i], mod );
+			Bit32s sample = 0;
+			Bit32s out0 = old[0];
+			if ( mode == sm2AM || mode == sm3AM ) {
+				sample = out0 + Op(1)->GetBlockSample( vol[1][i], phase[1][i], 0 );
+			} else if ( mode == sm2FM || mode == sm3FM ) {
+				sample = Op(1)->GetBlockSample( vol[1][i], phase[1][i], out0 );
+			} else if ( mode == sm3FMFM ) {
+				Bits next = Op(1)->GetBlockSample( vol[1][i], phase[1][i], out0 );
+				next = Op(2)->GetBlockSample( vol[2][i], phase[2][i], next );
+				sample = Op(3)->GetBlockSample( vol[3][i], phase[3][i], next );
+			} else if ( mode == sm3AMFM ) {
+				sample = out0;
+				Bits next = Op(1)->GetBlockSample( vol[1][i], phase[1][i], 0 );
+				next = Op(2)->GetBlockSample( vol[2][i], phase[2][i], next );
+				sample += Op(3)->GetBlockSample( vol[3][i], phase[3][i], next );
+			} else if ( mode == sm3FMAM ) {
+				sample = Op(1)->GetBlockSample( vol[1][i], phase[1][i], out0 );
+				Bits next = Op(2)->GetBlockSample( vol[2][i], phase[2][i], 0 );
+				sample += Op(3)->GetBlockSample( vol[3][i], phase[3][i], next );
+			} else if ( mode == sm3AMAM ) {
+				sample = out0;
+				Bits next = Op(1)->GetBlockSample( vol[1][i], phase[1][i], 0 );
+				sample += Op(2)->GetBlockSample( vol[2][i], phase[2][i], next );
+				sample += Op(3)->GetBlockSample( vol[3][i], phase[3][i], 0 );
+			}
+			if ( mode == sm2AM || mode == sm2FM ) {
+				output[ i ] += sample;
+			} else {
+				output[ i * 2 + 0 ] += sample & maskLeft;
+				output[ i * 2 + 1 ] += sample & maskRight;
+			}
 		}
+		samples -= count;
+		output += ( mode == sm2AM || mode == sm2FM ) ? count : count * 2;
 	}
 	switch( mode ) {
 	case sm2AM:
@@ -178,6 +178,11 @@ public:
 
 	Bits GetSample( Bits modulation );
 	Bits GetWave( Bitu index, Bitu vol );
+
+	//Block versions, generating the envelope and phase for several samples at once
+	void ForwardVolumeBlock( Bit32u samples, Bit32u* vol );
+	void ForwardWaveBlock( Bit32u samples, Bit32u* phase );
+	Bits GetBlockSample( Bit32u vol, Bit32u phase, Bits modulation );
 public:
 	Operator();
 };
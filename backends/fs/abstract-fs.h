@@ -158,6 +158,15 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns a value which changes whenever the file referred by this node
+	 * is written or replaced, e.g. derived from its modification time.
+	 *
+	 * @return the modification stamp, or 0 if it is not known, which is the
+	 *         default.
+	 */
+	virtual uint32 getModificationStamp() const { return 0; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -168,6 +177,16 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStream() = 0;
 
+	/**
+	 * Creates a SeekableReadStream instance for reading game data from the
+	 * file referred by this node. Unlike createReadStream(), the stream may
+	 * map the file into memory, so the file must not be modified while the
+	 * stream exists. The default implementation calls createReadStream().
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	virtual Common::SeekableReadStream *createDataReadStream() { return createReadStream(); }
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -29,6 +29,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_getenv
 
 #include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-mmapstream.h"
 #include "backends/fs/stdiostream.h"
 #include "common/algorithm.h"
 
@@ -241,10 +242,62 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 	return makeNode(Common::String(start, end));
 }
 
+uint32 POSIXFilesystemNode::getModificationStamp() const {
+	struct stat st;
+	if (stat(_path.c_str(), &st) != 0)
+		return 0;
+
+	// Writing the file changes its modification time. Replacing it changes
+	// the status change time, which can't be set from user space, or the
+	// inode, even when the old modification time is restored, as "cp -p"
+	// does. The nanoseconds, where the system has them, tell apart writes
+	// within the same second.
+	const uint32 fields[] = {
+		(uint32)st.st_mtime,
+		(uint32)st.st_ctime,
+		(uint32)st.st_ino,
+		(uint32)st.st_dev
+#if defined(__APPLE__)
+		, (uint32)st.st_mtimespec.tv_nsec
+		, (uint32)st.st_ctimespec.tv_nsec
+#elif defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+		, (uint32)st.st_mtim.tv_nsec
+		, (uint32)st.st_ctim.tv_nsec
+#endif
+	};
+
+	// FNV-1a over the fields
+	uint32 stamp = 2166136261u;
+	for (int i = 0; i < ARRAYSIZE(fields); ++i) {
+		for (uint j = 0; j < 4; ++j) {
+			stamp ^= (fields[i] >> (j * 8)) & 0xFF;
+			stamp *= 16777619u;
+		}
+	}
+
+	// 0 means that the stamp isn't known
+	return stamp ? stamp : 1;
+}
+
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
+Common::SeekableReadStream *POSIXFilesystemNode::createDataReadStream() {
+#ifndef __OS2__
+	// Large game data files are mapped into memory, so that they can be
+	// accessed without copying them through the stdio buffers. Truncating a
+	// file while it is mapped makes reads from the stream raise SIGBUS, see
+	// POSIXMmapStream, which is why savefiles and the config file, which we
+	// rewrite ourselves, go through createReadStream().
+	Common::SeekableReadStream *stream = POSIXMmapStream::makeFromPath(getPath());
+	if (stream)
+		return stream;
+#endif
+
+	return createReadStream();
+}
+
 Common::WriteStream *POSIXFilesystemNode::createWriteStream() {
 	return StdioStream::makeFromPath(getPath(), true);
 }
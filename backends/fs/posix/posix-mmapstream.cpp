@@ -0,0 +1,68 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX) && !defined(__OS2__)
+
+// Re-enable some forbidden symbols to avoid clashes with stat.h and unistd.h.
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_mkdir
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+POSIXMmapStream *POSIXMmapStream::makeFromPath(const Common::String &path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < (off_t)kMinMapSize || st.st_size > 0x7FFFFFFF) {
+		close(fd);
+		return 0;
+	}
+
+	const uint32 size = st.st_size;
+	void *mapping = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping keeps its own reference to the file
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return 0;
+
+	return new POSIXMmapStream(mapping, size);
+}
+
+POSIXMmapStream::POSIXMmapStream(void *mapping, uint32 size)
+	: Common::MemoryReadStream((const byte *)mapping, size), _mapping(mapping), _mappingSize(size) {
+}
+
+POSIXMmapStream::~POSIXMmapStream() {
+	munmap(_mapping, _mappingSize);
+}
+
+#endif
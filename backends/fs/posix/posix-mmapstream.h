@@ -0,0 +1,68 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+/**
+ * A read stream on a file which is mapped into memory with mmap().
+ *
+ * Reads are plain memory copies, and getView() gives direct access to the
+ * file contents. Only the pages which are actually accessed are loaded, and
+ * they can be dropped by the kernel again under memory pressure.
+ *
+ * The size of the stream is the size of the file when it was mapped. If the
+ * file is truncated while the stream exists, by another process or through
+ * a write stream on the same file, accessing the pages past the new end of
+ * the file raises SIGBUS instead of failing the read. Files must therefore
+ * not be rewritten while a read stream on them is open; writing a file
+ * replaces its contents in place, so the stream does not keep the old data
+ * either.
+ */
+class POSIXMmapStream : public Common::MemoryReadStream {
+public:
+	/**
+	 * Files smaller than this are not mapped, since the system call
+	 * overhead outweighs the saved copy.
+	 */
+	static const uint32 kMinMapSize = 64 * 1024;
+
+	/**
+	 * Given a path, maps the file at that path into memory and wraps the
+	 * mapping in a POSIXMmapStream instance. Returns 0 if the file could
+	 * not be opened or mapped, or if it is smaller than kMinMapSize.
+	 */
+	static POSIXMmapStream *makeFromPath(const Common::String &path);
+
+	virtual ~POSIXMmapStream();
+
+private:
+	POSIXMmapStream(void *mapping, uint32 size);
+
+	void *_mapping;
+	uint32 _mappingSize;
+};
+
+#endif
@@ -0,0 +1,148 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "backends/graphics/headless/headless-graphics.h"
+
+#include "common/endian.h"
+#include "common/rect.h"
+#include "common/util.h"
+
+static const uint32 kChecksumPrime = 16777619;
+
+/** FNV-1a, taking 32 bits at a time. */
+static uint32 checksumData(uint32 hash, const byte *data, uint32 size) {
+	for (; size >= 4; size -= 4, data += 4)
+		hash = (hash ^ READ_UINT32(data)) * kChecksumPrime;
+	for (; size > 0; size--, data++)
+		hash = (hash ^ *data) * kChecksumPrime;
+	return hash;
+}
+
+static uint32 checksumSurface(uint32 hash, const Graphics::Surface &surface) {
+	const uint32 rowSize = surface.w * surface.format.bytesPerPixel;
+	for (int y = 0; y < surface.h; ++y)
+		hash = checksumData(hash, (const byte *)surface.getBasePtr(0, y), rowSize);
+	return hash;
+}
+
+HeadlessGraphicsManager::HeadlessGraphicsManager()
+	: _overlayVisible(false), _screenChangeID(0),
+	  _checksumFrames(true), _frameCount(0), _frameChecksum(0) {
+	memset(_palette, 0, sizeof(_palette));
+	_screen.format = Graphics::PixelFormat::createFormatCLUT8();
+}
+
+HeadlessGraphicsManager::~HeadlessGraphicsManager() {
+	_screen.free();
+	_overlay.free();
+}
+
+Common::List<Graphics::PixelFormat> HeadlessGraphicsManager::getSupportedFormats() const {
+	// The screen is only kept in memory, so any format would do
+	Common::List<Graphics::PixelFormat> list;
+	list.push_back(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	list.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+	list.push_back(Graphics::PixelFormat::createFormatCLUT8());
+	return list;
+}
+
+void HeadlessGraphicsManager::initSize(uint width, uint height, const Graphics::PixelFormat *format) {
+	const Graphics::PixelFormat newFormat = format ? *format : Graphics::PixelFormat::createFormatCLUT8();
+	if (_screen.pixels && _screen.w == (int)width && _screen.h == (int)height && _screen.format == newFormat)
+		return;
+
+	_screen.create(width, height, newFormat);
+	_overlay.create(width, height, getOverlayFormat());
+
+	_screenChangeID++;
+}
+
+void HeadlessGraphicsManager::setPalette(const byte *colors, uint start, uint num) {
+	assert(start + num <= 256);
+	memcpy(_palette + start * 3, colors, num * 3);
+}
+
+void HeadlessGraphicsManager::grabPalette(byte *colors, uint start, uint num) {
+	assert(start + num <= 256);
+	memcpy(colors, _palette + start * 3, num * 3);
+}
+
+void HeadlessGraphicsManager::copyRect(Graphics::Surface &dst, const byte *buf, int pitch, int x, int y, int w, int h) {
+	// Clip like the other backends do, engines rely on that
+	if (x < 0) {
+		w += x;
+		buf -= x * dst.format.bytesPerPixel;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		buf -= y * pitch;
+		y = 0;
+	}
+	w = MIN<int>(w, dst.w - x);
+	h = MIN<int>(h, dst.h - y);
+	if (w <= 0 || h <= 0)
+		return;
+
+	byte *dstPtr = (byte *)dst.getBasePtr(x, y);
+	for (int i = 0; i < h; ++i, buf += pitch, dstPtr += dst.pitch)
+		memcpy(dstPtr, buf, w * dst.format.bytesPerPixel);
+}
+
+void HeadlessGraphicsManager::copyRectToScreen(const byte *buf, int pitch, int x, int y, int w, int h) {
+	copyRect(_screen, buf, pitch, x, y, w, h);
+}
+
+void HeadlessGraphicsManager::fillScreen(uint32 col) {
+	if (_screen.pixels)
+		_screen.fillRect(Common::Rect(_screen.w, _screen.h), col);
+}
+
+void HeadlessGraphicsManager::updateScreen() {
+	_frameCount++;
+	if (!_checksumFrames)
+		return;
+
+	uint32 hash = 2166136261u;
+	hash = checksumSurface(hash, _screen);
+	if (_screen.format.bytesPerPixel == 1)
+		hash = checksumData(hash, _palette, sizeof(_palette));
+	if (_overlayVisible)
+		hash = checksumSurface(hash, _overlay);
+	_frameChecksum = hash;
+}
+
+void HeadlessGraphicsManager::clearOverlay() {
+	if (_overlay.pixels)
+		memset(_overlay.pixels, 0, _overlay.pitch * _overlay.h);
+}
+
+void HeadlessGraphicsManager::grabOverlay(OverlayColor *buf, int pitch) {
+	// The overlay pitch is given in pixels
+	const byte *src = (const byte *)_overlay.pixels;
+	for (int y = 0; y < _overlay.h; ++y, src += _overlay.pitch, buf += pitch)
+		memcpy(buf, src, _overlay.w * sizeof(OverlayColor));
+}
+
+void HeadlessGraphicsManager::copyRectToOverlay(const OverlayColor *buf, int pitch, int x, int y, int w, int h) {
+	copyRect(_overlay, (const byte *)buf, pitch * sizeof(OverlayColor), x, y, w, h);
+}
@@ -0,0 +1,89 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_HEADLESS_H
+#define BACKENDS_GRAPHICS_HEADLESS_H
+
+#include "backends/graphics/null/null-graphics.h"
+#include "graphics/surface.h"
+
+/**
+ * Graphics manager without any output, which keeps the screen and the
+ * overlay in memory so that engines can draw as usual. Every frame passed
+ * to updateScreen() can be checksummed, so that replays of recorded
+ * sessions can be checked for changes in the output.
+ */
+class HeadlessGraphicsManager : public NullGraphicsManager {
+public:
+	HeadlessGraphicsManager();
+	virtual ~HeadlessGraphicsManager();
+
+	/** Sets whether updateScreen() checksums the frames or discards them. */
+	void setChecksumFrames(bool enable) { _checksumFrames = enable; }
+
+	/** Returns the number of updateScreen() calls so far. */
+	uint32 getFrameCount() const { return _frameCount; }
+
+	/**
+	 * Returns the checksum of the screen, the palette and the visible
+	 * overlay at the last updateScreen() call, or 0 if frames are discarded.
+	 */
+	uint32 getFrameChecksum() const { return _frameChecksum; }
+
+	Graphics::PixelFormat getScreenFormat() const { return _screen.format; }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const;
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL);
+	int getScreenChangeID() const { return _screenChangeID; }
+
+	int16 getHeight() { return _screen.h; }
+	int16 getWidth() { return _screen.w; }
+	void setPalette(const byte *colors, uint start, uint num);
+	void grabPalette(byte *colors, uint start, uint num);
+	void copyRectToScreen(const byte *buf, int pitch, int x, int y, int w, int h);
+	Graphics::Surface *lockScreen() { return &_screen; }
+	void fillScreen(uint32 col);
+	void updateScreen();
+
+	void showOverlay() { _overlayVisible = true; }
+	void hideOverlay() { _overlayVisible = false; }
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+	void clearOverlay();
+	void grabOverlay(OverlayColor *buf, int pitch);
+	void copyRectToOverlay(const OverlayColor *buf, int pitch, int x, int y, int w, int h);
+	int16 getOverlayHeight() { return _overlay.h; }
+	int16 getOverlayWidth() { return _overlay.w; }
+
+protected:
+	Graphics::Surface _screen;
+	Graphics::Surface _overlay;
+	byte _palette[256 * 3];
+	bool _overlayVisible;
+	int _screenChangeID;
+
+	bool _checksumFrames;
+	uint32 _frameCount;
+	uint32 _frameChecksum;
+
+	static void copyRect(Graphics::Surface &dst, const byte *buf, int pitch, int x, int y, int w, int h);
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "backends/graphics/opengl/opengl-graphics.h"
 #include "backends/graphics/opengl/glerrorcheck.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/file.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
@@ -44,6 +45,7 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 #endif
 	_gameTexture(0), _overlayTexture(0), _cursorTexture(0),
 	_screenChangeCount(1 << (sizeof(int) * 8 - 2)), _screenNeedsRedraw(false),
+	_screenStagingAlloc(0), _screenStaging(0), _screenStagingSize(0),
 	_shakePos(0),
 	_overlayVisible(false), _overlayNeedsRedraw(false),
 	_transactionMode(kTransactionNone),
@@ -64,6 +66,12 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 
 	_gamePalette = (byte *)calloc(sizeof(byte) * 3, 256);
 	_cursorPalette = (byte *)calloc(sizeof(byte) * 3, 256);
+
+	// Opaque black, like the RGB palette
+	memset(_gamePaletteRGBA, 0, sizeof(_gamePaletteRGBA));
+	for (int i = 0; i < 256; ++i)
+		((byte *)&_gamePaletteRGBA[i])[3] = 255;
+	memset(&_screenUploadStats, 0, sizeof(_screenUploadStats));
 }
 
 OpenGLGraphicsManager::~OpenGLGraphicsManager() {
@@ -73,6 +81,7 @@ OpenGLGraphicsManager::~OpenGLGraphicsManager() {
 
 	free(_gamePalette);
 	free(_cursorPalette);
+	free(_screenStagingAlloc);
 
 	delete _gameTexture;
 	delete _overlayTexture;
@@ -328,6 +337,15 @@ void OpenGLGraphicsManager::setPalette(const byte *colors, uint start, uint num)
 	// Save the screen palette
 	memcpy(_gamePalette + start * 3, colors, num * 3);
 
+	// And the texture pixels for it
+	for (uint i = start; i < start + num; ++i) {
+		byte *color = (byte *)&_gamePaletteRGBA[i];
+		color[0] = _gamePalette[i * 3];
+		color[1] = _gamePalette[i * 3 + 1];
+		color[2] = _gamePalette[i * 3 + 2];
+		color[3] = 255;
+	}
+
 	_screenNeedsRedraw = true;
 
 	if (_cursorPaletteDisabled)
@@ -360,11 +378,35 @@ void OpenGLGraphicsManager::copyRectToScreen(const byte *buf, int pitch, int x,
 		dst += _screenData.pitch;
 	}
 
-	// Extend dirty area if not full screen redraw is flagged
-	if (!_screenNeedsRedraw) {
-		const Common::Rect dirtyRect(x, y, x + w, y + h);
-		_screenDirtyRect.extend(dirtyRect);
+	// Add dirty area if not full screen redraw is flagged
+	if (!_screenNeedsRedraw)
+		addScreenDirtyRect(Common::Rect(x, y, x + w, y + h));
+}
+
+void OpenGLGraphicsManager::addScreenDirtyRect(const Common::Rect &rect) {
+	// Merge the rect into an existing one, if that doesn't add more area
+	// than uploading both separately
+	const int area = rect.width() * rect.height();
+	for (uint i = 0; i < _screenDirtyRects.size(); ++i) {
+		Common::Rect merged = _screenDirtyRects[i];
+		merged.extend(rect);
+		if (merged.width() * merged.height() <= _screenDirtyRects[i].width() * _screenDirtyRects[i].height() + area) {
+			_screenDirtyRects[i] = merged;
+			return;
+		}
 	}
+
+	if (_screenDirtyRects.size() < kMaxScreenDirtyRects) {
+		_screenDirtyRects.push_back(rect);
+		return;
+	}
+
+	// Too many scattered updates, upload their bounding box instead
+	Common::Rect bounds = rect;
+	for (uint i = 0; i < _screenDirtyRects.size(); ++i)
+		bounds.extend(_screenDirtyRects[i]);
+	_screenDirtyRects.clear();
+	_screenDirtyRects.push_back(bounds);
 }
 
 Graphics::Surface *OpenGLGraphicsManager::lockScreen() {
@@ -688,46 +730,83 @@ void OpenGLGraphicsManager::setFullscreenMode(bool enable) {
 	}
 }
 
-void OpenGLGraphicsManager::refreshGameScreen() {
-	if (_screenNeedsRedraw)
-		_screenDirtyRect = Common::Rect(0, 0, _screenData.w, _screenData.h);
+/**
+ * Converts a row of CLUT8 pixels to RGBA8888 texture pixels. Looking up
+ * the colors is a gather, which SSE2 can't do, so the palette is kept in
+ * the texture format instead and every pixel is one load and one store.
+ */
+static void convertCLUT8Row(uint32 *dst, const byte *src, int w, const uint32 *palette) {
+	for (; w >= 4; w -= 4) {
+		const uint32 c0 = palette[src[0]];
+		const uint32 c1 = palette[src[1]];
+		const uint32 c2 = palette[src[2]];
+		const uint32 c3 = palette[src[3]];
+		dst[0] = c0;
+		dst[1] = c1;
+		dst[2] = c2;
+		dst[3] = c3;
+		src += 4;
+		dst += 4;
+	}
+
+	while (w--)
+		*dst++ = palette[*src++];
+}
 
-	int x = _screenDirtyRect.left;
-	int y = _screenDirtyRect.top;
-	int w = _screenDirtyRect.width();
-	int h = _screenDirtyRect.height();
+void OpenGLGraphicsManager::refreshGameScreen() {
+	if (_screenNeedsRedraw) {
+		_screenDirtyRects.clear();
+		_screenDirtyRects.push_back(Common::Rect(0, 0, _screenData.w, _screenData.h));
+	}
 
 	if (_screenData.format.bytesPerPixel == 1) {
-		// Create a temporary RGB888 surface
-		byte *surface = new byte[w * h * 3];
+		// (Re)allocate the staging buffer, 16 byte aligned
+		const uint size = _screenData.w * _screenData.h;
+		if (_screenStagingSize < size) {
+			free(_screenStagingAlloc);
+			_screenStagingAlloc = (byte *)malloc(size * sizeof(uint32) + 15);
+			_screenStaging = (uint32 *)(((size_t)_screenStagingAlloc + 15) & ~(size_t)15);
+			_screenStagingSize = size;
+		}
+	}
 
-		// Convert the paletted buffer to RGB888
-		const byte *src = (byte *)_screenData.pixels + y * _screenData.pitch;
-		src += x * _screenData.format.bytesPerPixel;
-		byte *dst = surface;
-		for (int i = 0; i < h; i++) {
-			for (int j = 0; j < w; j++) {
-				dst[0] = _gamePalette[src[j] * 3];
-				dst[1] = _gamePalette[src[j] * 3 + 1];
-				dst[2] = _gamePalette[src[j] * 3 + 2];
-				dst += 3;
+	for (uint i = 0; i < _screenDirtyRects.size(); ++i) {
+		const Common::Rect &rect = _screenDirtyRects[i];
+		const int x = rect.left;
+		const int y = rect.top;
+		const int w = rect.width();
+		const int h = rect.height();
+
+		const byte *src = (byte *)_screenData.pixels + y * _screenData.pitch +
+			x * _screenData.format.bytesPerPixel;
+
+		if (_screenData.format.bytesPerPixel == 1) {
+			// Convert the paletted buffer to RGBA8888
+			uint32 *dst = _screenStaging;
+			for (int j = 0; j < h; j++) {
+				convertCLUT8Row(dst, src, w, _gamePaletteRGBA);
+				src += _screenData.pitch;
+				dst += w;
 			}
-			src += _screenData.pitch;
-		}
 
-		// Update the texture
-		_gameTexture->updateBuffer(surface, w * 3, x, y, w, h);
+			// Update the texture
+			_gameTexture->updateBuffer(_screenStaging, w * 4, x, y, w, h);
+		} else {
+			// Update the texture
+			_gameTexture->updateBuffer(src, _screenData.pitch, x, y, w, h);
+		}
 
-		// Free the temp surface
-		delete[] surface;
-	} else {
-		// Update the texture
-		_gameTexture->updateBuffer((byte *)_screenData.pixels + y * _screenData.pitch +
-			x * _screenData.format.bytesPerPixel, _screenData.pitch, x, y, w, h);
+		_screenUploadStats.frameRects++;
+		_screenUploadStats.framePixels += w * h;
 	}
 
+	_screenUploadStats.totalRects += _screenUploadStats.frameRects;
+	_screenUploadStats.totalPixels += _screenUploadStats.framePixels;
+	debug(9, "OpenGLGraphicsManager: Uploaded %u game screen rects, %u pixels",
+		_screenUploadStats.frameRects, _screenUploadStats.framePixels);
+
 	_screenNeedsRedraw = false;
-	_screenDirtyRect = Common::Rect();
+	_screenDirtyRects.clear();
 }
 
 void OpenGLGraphicsManager::refreshOverlay() {
@@ -937,11 +1016,12 @@ void OpenGLGraphicsManager::getGLPixelFormat(Graphics::PixelFormat pixelFormat,
 		glFormat = GL_RGBA;
 		gltype = GL_UNSIGNED_SHORT_4_4_4_4;
 	} else if (pixelFormat.bytesPerPixel == 1) { // CLUT8
-		// If uses a palette, create texture as RGB888. The pixel data will be converted
-		// later.
-		bpp = 3;
-		intFormat = GL_RGB;
-		glFormat = GL_RGB;
+		// If uses a palette, create texture as RGBA8888. The pixel data will be
+		// converted later; four bytes per pixel let the conversion store whole
+		// words.
+		bpp = 4;
+		intFormat = GL_RGBA;
+		glFormat = GL_RGBA;
 		gltype = GL_UNSIGNED_BYTE;
 #ifndef USE_GLES
 	} else if (pixelFormat == Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)) { // ARGB8888
@@ -999,7 +1079,10 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 	// Clear the screen buffer
 	glClear(GL_COLOR_BUFFER_BIT); CHECK_GL_ERROR();
 
-	if (_screenNeedsRedraw || !_screenDirtyRect.isEmpty())
+	_screenUploadStats.frameRects = 0;
+	_screenUploadStats.framePixels = 0;
+
+	if (_screenNeedsRedraw || !_screenDirtyRects.empty())
 		// Refresh texture if dirty
 		refreshGameScreen();
 
@@ -235,13 +235,44 @@ protected:
 	Graphics::Surface _screenData;
 	int _screenChangeCount;
 	bool _screenNeedsRedraw;
-	Common::Rect _screenDirtyRect;
+
+	enum {
+		/** Above this number of dirty rects, they are merged into one */
+		kMaxScreenDirtyRects = 8
+	};
+
+	/**
+	 * The dirty areas of the game screen. Updates far apart from each other
+	 * are kept separate, so that the area in between isn't uploaded.
+	 */
+	Common::Array<Common::Rect> _screenDirtyRects;
+
+	void addScreenDirtyRect(const Common::Rect &rect);
 
 #ifdef USE_RGB_COLOR
 	Graphics::PixelFormat _screenFormat;
 #endif
 	byte *_gamePalette;
 
+	/** The game palette as RGBA8888 texture pixels, for CLUT8 game screens */
+	uint32 _gamePaletteRGBA[256];
+
+	/**
+	 * Buffer for converting CLUT8 game screen data before uploading it.
+	 * It's kept around between frames, and big enough for the whole screen.
+	 */
+	byte *_screenStagingAlloc;
+	uint32 *_screenStaging;
+	uint _screenStagingSize;
+
+	/** Number of texture updates and uploaded pixels, of the last frame and in total */
+	struct UploadStats {
+		uint32 frameRects;
+		uint32 framePixels;
+		uint32 totalRects;
+		uint32 totalPixels;
+	} _screenUploadStats;
+
 	virtual void refreshGameScreen();
 
 	// Shake mode
@@ -106,7 +106,7 @@ void Keymapper::initKeymap(Domain &domain, Keymap *map) {
 	if (map->isComplete(_hardwareKeys) == false) {
 		map->automaticMapping(_hardwareKeys);
 		map->saveMappings();
-		ConfMan.flushToDisk();
+		ConfMan.scheduleFlush();
 	}
 
 	domain.addKeymap(map);
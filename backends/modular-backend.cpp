@@ -30,6 +30,7 @@
 #include "backends/mutex/mutex.h"
 
 #include "audio/mixer.h"
+#include "common/config-manager.h"
 #include "common/events.h"
 #include "gui/message.h"
 #include "graphics/pixelformat.h"
@@ -281,5 +282,6 @@ FilesystemFactory *ModularBackend::getFilesystemFactory() {
 }
 
 void ModularBackend::quit() {
+	Common::ConfigManager::flushBeforeQuit();
 	exit(0);
 }
@@ -74,8 +74,10 @@ ifdef POSIX
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
+	fs/posix/posix-mmapstream.o \
 	plugins/posix/posix-provider.o \
-	saves/posix/posix-saves.o
+	saves/posix/posix-saves.o \
+	timer/posix/posix-timer.o
 endif
 
 ifdef MACOSX
@@ -139,6 +141,11 @@ MODULE_OBJS += \
 	fs/n64/romfsstream.o
 endif
 
+ifeq ($(BACKEND),null)
+MODULE_OBJS += \
+	graphics/headless/headless-graphics.o
+endif
+
 ifeq ($(BACKEND),openpandora)
 MODULE_OBJS += \
 	events/openpandora/op-events.o \
@@ -134,6 +134,7 @@ void OSystem_Dreamcast::setWindowCaption(const char *caption)
 }
 
 void OSystem_Dreamcast::quit() {
+  Common::ConfigManager::flushBeforeQuit();
   (*(void(**)(int))0x8c0000e0)(0);
 }
 
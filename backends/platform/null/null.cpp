@@ -20,15 +20,26 @@
  *
  */
 
+// The replay report is based on the processor time
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
 #include "backends/modular-backend.h"
 #include "base/main.h"
 
 #if defined(USE_NULL_DRIVER)
+#include "backends/audiocd/default/default-audiocd.h"
+#include "backends/events/default/default-events.h"
+#include "backends/graphics/headless/headless-graphics.h"
+#include "backends/mutex/null/null-mutex.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "audio/mixer_intern.h"
+#include "common/config-manager.h"
+#include "common/EventRecorder.h"
 #include "common/scummsys.h"
 
+#include <time.h>
+
 /*
  * Include header files needed for the getFilesystemFactory() method.
  */
@@ -40,7 +51,32 @@
 	#include "backends/fs/windows/windows-fs-factory.h"
 #endif
 
-class OSystem_NULL : public ModularBackend {
+/**
+ * Timer manager which runs on the virtual time of the null backend.
+ */
+class NullTimerManager : public DefaultTimerManager {
+public:
+	NullTimerManager(const uint32 &millis) : _millis(millis) {}
+
+protected:
+	virtual uint32 getMicroseconds() { return _millis * 1000; }
+
+private:
+	const uint32 &_millis;
+};
+
+/**
+ * Backend without any input or output.
+ *
+ * Time is virtual: it only advances when the engine waits in delayMillis()
+ * or when a played back recording says so, and the timers and the mixer
+ * are run for the elapsed time without actually waiting. Playing back a
+ * recording (--record-mode=playback) thus runs as fast as the engine can,
+ * which turns recorded sessions into benchmarks. The backend quits once
+ * the recording is over, and reports the processor time spent in the
+ * engine and the backend subsystems on exit.
+ */
+class OSystem_NULL : public ModularBackend, public Common::EventSource {
 public:
 	OSystem_NULL();
 	virtual ~OSystem_NULL();
@@ -53,11 +89,54 @@ public:
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
+	virtual void copyRectToScreen(const byte *buf, int pitch, int x, int y, int w, int h);
+	virtual void fillScreen(uint32 col);
+	virtual void updateScreen();
+
 	virtual Common::SeekableReadStream *createConfigReadStream();
 	virtual Common::WriteStream *createConfigWriteStream();
+	virtual Common::SeekableReadStream *createConfigCacheReadStream();
+	virtual Common::WriteStream *createConfigCacheWriteStream();
+	virtual uint32 getConfigModificationStamp();
+
+	virtual void quit();
+
+	/** Logs the statistics of the session so far. */
+	void printReport();
+
+private:
+	enum {
+		kMixSamples = 1024
+	};
+
+	HeadlessGraphicsManager *_headlessGraphics;
+	NullTimerManager *_nullTimerManager;
+
+	uint32 _millis;
+	uint32 _mixedMillis;
+	uint32 _mixRemainder;
+	int16 _mixBuffer[kMixSamples * 2];
+	bool _inSubsystems;
+	bool _quitSent;
+
+	bool _checksum;
+	uint32 _frameChecksum;
+	uint32 _audioChecksum;
+	Common::WriteStream *_checksumLog;
+
+	clock_t _startTime;
+	clock_t _graphicsTime;
+	clock_t _audioTime;
+	clock_t _timerTime;
+
+	void runSubsystems();
+	void mixAudio();
 };
 
-OSystem_NULL::OSystem_NULL() {
+OSystem_NULL::OSystem_NULL()
+	: _headlessGraphics(0), _nullTimerManager(0), _millis(0), _mixedMillis(0), _mixRemainder(0),
+	  _inSubsystems(false), _quitSent(false), _checksum(true), _frameChecksum(0), _audioChecksum(0),
+	  _checksumLog(0), _startTime(0), _graphicsTime(0), _audioTime(0), _timerTime(0) {
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
 	#elif defined(POSIX)
@@ -70,35 +149,176 @@ OSystem_NULL::OSystem_NULL() {
 }
 
 OSystem_NULL::~OSystem_NULL() {
+	if (_checksumLog) {
+		_checksumLog->finalize();
+		delete _checksumLog;
+	}
 }
 
 void OSystem_NULL::initBackend() {
+	_checksum = (ConfMan.get("replay_frames") != "discard");
+
+	_headlessGraphics = new HeadlessGraphicsManager();
+	_headlessGraphics->setChecksumFrames(_checksum);
+
 	_mutexManager = (MutexManager *)new NullMutexManager();
-	_timerManager = new DefaultTimerManager();
+	_nullTimerManager = new NullTimerManager(_millis);
+	_timerManager = _nullTimerManager;
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
-	_graphicsManager = (GraphicsManager *)new NullGraphicsManager();
-	_audiocdManager = (AudioCDManager *)new DefaultAudioCDManager();
+	_graphicsManager = (GraphicsManager *)_headlessGraphics;
 	_mixer = new Audio::MixerImpl(this, 22050);
+	_audiocdManager = (AudioCDManager *)new DefaultAudioCDManager();
+
+	// The mixer is driven by the virtual time, see mixAudio()
+	((Audio::MixerImpl *)_mixer)->setReady(true);
 
-	((Audio::MixerImpl *)_mixer)->setReady(false);
+	if (_checksum && ConfMan.hasKey("replay_checksum_file")) {
+		Common::FSNode file(ConfMan.get("replay_checksum_file"));
+		_checksumLog = file.createWriteStream();
+		if (!_checksumLog)
+			warning("Could not open checksum file '%s'", file.getPath().c_str());
+	}
 
-	// Note that both the mixer and the timer manager are useless
-	// this way; they need to be hooked into the system somehow to
-	// be functional. Of course, can't do that in a NULL backend :).
+	_startTime = clock();
 
 	OSystem::initBackend();
 }
 
 bool OSystem_NULL::pollEvent(Common::Event &event) {
+	runSubsystems();
+
+	// There is nobody to continue the session after the recording
+	if (!_quitSent && g_eventRec.isPlaybackFinished()) {
+		_quitSent = true;
+		event.type = Common::EVENT_QUIT;
+		return true;
+	}
+
 	return false;
 }
 
 uint32 OSystem_NULL::getMillis() {
-	return 0;
+	uint32 millis = _millis;
+	g_eventRec.processMillis(millis);
+
+	// Recorded times can only move the virtual time forward
+	if ((int32)(millis - _millis) > 0)
+		_millis = millis;
+	return millis;
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
+	_millis += msecs;
+	runSubsystems();
+}
+
+void OSystem_NULL::runSubsystems() {
+	// Timer procs may call back into the backend
+	if (_inSubsystems)
+		return;
+	_inSubsystems = true;
+
+	const clock_t start = clock();
+	_nullTimerManager->handler();
+	const clock_t timersDone = clock();
+	mixAudio();
+
+	_timerTime += timersDone - start;
+	_audioTime += clock() - timersDone;
+	_inSubsystems = false;
+}
+
+void OSystem_NULL::mixAudio() {
+	const uint32 rate = _mixer->getOutputRate();
+
+	while (_mixedMillis != _millis) {
+		// At most a second at once, so that the sample count can't overflow
+		const uint32 millis = MIN<uint32>(_millis - _mixedMillis, 1000);
+		_mixedMillis += millis;
+		_mixRemainder += millis * rate;
+		uint32 samples = _mixRemainder / 1000;
+		_mixRemainder %= 1000;
+
+		while (samples > 0) {
+			const uint32 count = MIN<uint32>(samples, kMixSamples);
+			((Audio::MixerImpl *)_mixer)->mixCallback((byte *)_mixBuffer, count * 4);
+			samples -= count;
+
+			if (_checksum) {
+				for (uint32 i = 0; i < count * 2; ++i)
+					_audioChecksum = _audioChecksum * 31 + (uint16)_mixBuffer[i];
+			}
+		}
+	}
+}
+
+void OSystem_NULL::copyRectToScreen(const byte *buf, int pitch, int x, int y, int w, int h) {
+	const clock_t start = clock();
+	ModularBackend::copyRectToScreen(buf, pitch, x, y, w, h);
+	_graphicsTime += clock() - start;
+}
+
+void OSystem_NULL::fillScreen(uint32 col) {
+	const clock_t start = clock();
+	ModularBackend::fillScreen(col);
+	_graphicsTime += clock() - start;
+}
+
+void OSystem_NULL::updateScreen() {
+	const clock_t start = clock();
+	ModularBackend::updateScreen();
+
+	if (_checksum) {
+		const uint32 checksum = _headlessGraphics->getFrameChecksum();
+		_frameChecksum = _frameChecksum * 31 + checksum;
+
+		if (_checksumLog)
+			_checksumLog->writeString(Common::String::format("%u %u %08x\n",
+			                          _headlessGraphics->getFrameCount(), _millis, checksum));
+	}
+
+	_graphicsTime += clock() - start;
+}
+
+void OSystem_NULL::quit() {
+	// The launcher quits through here instead of returning from scummvm_main
+	printReport();
+	if (_checksumLog) {
+		_checksumLog->finalize();
+		delete _checksumLog;
+		_checksumLog = 0;
+	}
+
+	ModularBackend::quit();
+}
+
+void OSystem_NULL::printReport() {
+	const double total = (double)(clock() - _startTime) / CLOCKS_PER_SEC;
+	const double graphics = (double)_graphicsTime / CLOCKS_PER_SEC;
+	const double audio = (double)_audioTime / CLOCKS_PER_SEC;
+	const double timers = (double)_timerTime / CLOCKS_PER_SEC;
+	const double engine = total - graphics - audio - timers;
+	const double virtualTime = _millis / 1000.0;
+	const uint32 frames = _headlessGraphics->getFrameCount();
+
+	// Avoid divisions by zero for sessions which end right away
+	const double divisor = MAX(total, 0.000001);
+
+	Common::String report = "Replay report:\n";
+	report += Common::String::format("  Virtual time   %10.3f s\n", virtualTime);
+	report += Common::String::format("  Processor time %10.3f s (%.1fx real time)\n", total, virtualTime / divisor);
+	report += Common::String::format("  Frames         %10u (%.1f frames/s)\n", frames, frames / divisor);
+	report += Common::String::format("  Engine         %10.3f s %5.1f%% (game logic and scripts)\n", engine, engine * 100 / divisor);
+	report += Common::String::format("  Graphics       %10.3f s %5.1f%%\n", graphics, graphics * 100 / divisor);
+	report += Common::String::format("  Audio          %10.3f s %5.1f%%\n", audio, audio * 100 / divisor);
+	report += Common::String::format("  Timers         %10.3f s %5.1f%%\n", timers, timers * 100 / divisor);
+	if (_checksum) {
+		report += Common::String::format("  Frame checksum   %08x\n", _frameChecksum);
+		report += Common::String::format("  Audio checksum   %08x\n", _audioChecksum);
+	}
+
+	logMessage(LogMessageType::kDebug, report.c_str());
 }
 
 #define DEFAULT_CONFIG_FILE "scummvm.ini"
@@ -113,6 +333,21 @@ Common::WriteStream *OSystem_NULL::createConfigWriteStream() {
 	return file.createWriteStream();
 }
 
+Common::SeekableReadStream *OSystem_NULL::createConfigCacheReadStream() {
+	Common::FSNode file(DEFAULT_CONFIG_FILE ".cache");
+	return file.createReadStream();
+}
+
+Common::WriteStream *OSystem_NULL::createConfigCacheWriteStream() {
+	Common::FSNode file(DEFAULT_CONFIG_FILE ".cache");
+	return file.createWriteStream();
+}
+
+uint32 OSystem_NULL::getConfigModificationStamp() {
+	Common::FSNode file(DEFAULT_CONFIG_FILE);
+	return file.getModificationStamp();
+}
+
 OSystem *OSystem_NULL_create() {
 	return new OSystem_NULL();
 }
@@ -123,6 +358,7 @@ int main(int argc, char *argv[]) {
 
 	// Invoke the actual ScummVM main entry point:
 	int res = scummvm_main(argc, argv);
+	((OSystem_NULL *)g_system)->printReport();
 	delete (OSystem_NULL *)g_system;
 	return res;
 }
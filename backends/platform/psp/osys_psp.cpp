@@ -416,6 +416,7 @@ void OSystem_PSP::setupMixer(void) {
 }
 
 void OSystem_PSP::quit() {
+	Common::ConfigManager::flushBeforeQuit();
 	_audio.close();
 	sceKernelExitGame();
 }
@@ -27,6 +27,7 @@
 #include "backends/platform/samsungtv/samsungtv.h"
 #include "backends/events/samsungtvsdl/samsungtvsdl-events.h"
 #include "backends/graphics/samsungtvsdl/samsungtvsdl-graphics.h"
+#include "common/config-manager.h"
 #include "common/textconsole.h"
 
 OSystem_SDL_SamsungTV::OSystem_SDL_SamsungTV()
@@ -47,6 +48,7 @@ void OSystem_SDL_SamsungTV::initBackend() {
 }
 
 void OSystem_SDL_SamsungTV::quit() {
+	Common::ConfigManager::flushBeforeQuit();
 	delete this;
 }
 
@@ -39,6 +39,9 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
 #include "backends/timer/sdl/sdl-timer.h"
+#if defined(POSIX)
+#include "backends/timer/posix/posix-timer.h"
+#endif
 #include "backends/graphics/sdl/sdl-graphics.h"
 #ifdef USE_OPENGL
 #include "backends/graphics/openglsdl/openglsdl-graphics.h"
@@ -123,8 +126,15 @@ void OSystem_SDL::init() {
 	if (_mutexManager == 0)
 		_mutexManager = new SdlMutexManager();
 
-	if (_timerManager == 0)
+	if (_timerManager == 0) {
+#if defined(POSIX)
+		// A thread of our own has a much finer resolution than the 10ms
+		// SDL timer
+		_timerManager = new PosixTimerManager();
+#else
 		_timerManager = new SdlTimerManager();
+#endif
+	}
 
 #ifdef USE_OPENGL
 	// Setup a list with both SDL and OpenGL graphics modes
@@ -258,6 +268,21 @@ Common::WriteStream *OSystem_SDL::createConfigWriteStream() {
 	return file.createWriteStream();
 }
 
+Common::SeekableReadStream *OSystem_SDL::createConfigCacheReadStream() {
+	Common::FSNode file(getDefaultConfigFileName() + ".cache");
+	return file.createReadStream();
+}
+
+Common::WriteStream *OSystem_SDL::createConfigCacheWriteStream() {
+	Common::FSNode file(getDefaultConfigFileName() + ".cache");
+	return file.createWriteStream();
+}
+
+uint32 OSystem_SDL::getConfigModificationStamp() {
+	Common::FSNode file(getDefaultConfigFileName());
+	return file.getModificationStamp();
+}
+
 void OSystem_SDL::setWindowCaption(const char *caption) {
 	Common::String cap;
 	byte c;
@@ -277,6 +302,7 @@ void OSystem_SDL::setWindowCaption(const char *caption) {
 }
 
 void OSystem_SDL::quit() {
+	Common::ConfigManager::flushBeforeQuit();
 	delete this;
 	exit(0);
 }
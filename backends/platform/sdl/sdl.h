@@ -67,6 +67,9 @@ public:
 	virtual void addSysArchivesToSearchSet(Common::SearchSet &s, int priority = 0);
 	virtual Common::SeekableReadStream *createConfigReadStream();
 	virtual Common::WriteStream *createConfigWriteStream();
+	virtual Common::SeekableReadStream *createConfigCacheReadStream();
+	virtual Common::WriteStream *createConfigCacheWriteStream();
+	virtual uint32 getConfigModificationStamp();
 	virtual uint32 getMillis();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &td) const;
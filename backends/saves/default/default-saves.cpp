@@ -93,11 +93,16 @@ Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String
 
 	// Open the file for reading
 	Common::SeekableReadStream *sf = file.createReadStream();
+	if (sf && _listener)
+		_listener->savefileLoaded(filename);
 
 	return Common::wrapCompressedReadStream(sf);
 }
 
 Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String &filename) {
+	if (_listener)
+		_listener->savefileChanged(filename);
+
 	// Ensure that the savepath is valid. If not, generate an appropriate error.
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
@@ -116,6 +121,9 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 }
 
 bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
+	if (_listener)
+		_listener->savefileChanged(filename);
+
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
 	if (getError().getCode() != Common::kNoError)
@@ -154,7 +162,7 @@ Common::String DefaultSaveFileManager::getSavePath() const {
 	// ScummVM, which would insert a bad savepath value into config files.
 	if (dir == "None") {
 		ConfMan.removeKey("savepath", ConfMan.getActiveDomainName());
-		ConfMan.flushToDisk();
+		ConfMan.scheduleFlush();
 		dir = ConfMan.get("savepath");
 	}
 
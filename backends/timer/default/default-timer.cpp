@@ -30,104 +30,150 @@ struct TimerSlot {
 	void *refCon;
 	uint32 interval;	// in microseconds
 
-	uint32 nextFireTime;	// in milliseconds
-	uint32 nextFireTimeMicro;	// microseconds part of nextFire
+	uint32 nextFireTime;	// in microseconds, wraps around
+	uint heapIndex;	// position in the heap
 
-	TimerSlot *next;
+	uint32 calls;
+	uint32 overruns;
+	uint32 maxJitter;
+	uint32 totalJitter;
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
+static inline bool firesBefore(const TimerSlot *a, const TimerSlot *b) {
+	// Fire times wrap around, but all scheduled timers are close enough
+	// to each other for the difference to be meaningful
+	return (int32)(a->nextFireTime - b->nextFireTime) < 0;
+}
 
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
 
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
+DefaultTimerManager::DefaultTimerManager() :
+	_timerHandler(0) {
+}
+
+DefaultTimerManager::~DefaultTimerManager() {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _heap.size(); ++i)
+		delete _heap[i];
+	_heap.clear();
+}
+
+uint32 DefaultTimerManager::getMicroseconds() {
+	return g_system->getMillis() * 1000;
+}
+
+void DefaultTimerManager::siftUp(uint index) {
+	TimerSlot *slot = _heap[index];
+
+	while (index > 0) {
+		const uint parent = (index - 1) / 2;
+		if (!firesBefore(slot, _heap[parent]))
+			break;
+
+		_heap[index] = _heap[parent];
+		_heap[index]->heapIndex = index;
+		index = parent;
 	}
+
+	_heap[index] = slot;
+	slot->heapIndex = index;
 }
 
+void DefaultTimerManager::siftDown(uint index) {
+	TimerSlot *slot = _heap[index];
+	const uint size = _heap.size();
 
-DefaultTimerManager::DefaultTimerManager() :
-	_timerHandler(0),
-	_head(0) {
+	while (true) {
+		uint child = index * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && firesBefore(_heap[child + 1], _heap[child]))
+			child++;
+		if (!firesBefore(_heap[child], slot))
+			break;
+
+		_heap[index] = _heap[child];
+		_heap[index]->heapIndex = index;
+		index = child;
+	}
 
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+	_heap[index] = slot;
+	slot->heapIndex = index;
 }
 
-DefaultTimerManager::~DefaultTimerManager() {
-	Common::StackLock lock(_mutex);
+void DefaultTimerManager::removeSlot(TimerSlot *slot) {
+	const uint index = slot->heapIndex;
+	assert(index < _heap.size() && _heap[index] == slot);
+
+	TimerSlot *last = _heap.back();
+	_heap.pop_back();
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	// Move the last slot into the gap and restore the heap order
+	if (last != slot) {
+		_heap[index] = last;
+		last->heapIndex = index;
+		siftUp(index);
+		siftDown(last->heapIndex);
 	}
-	_head = 0;
+
+	delete slot;
 }
 
-void DefaultTimerManager::handler() {
+uint32 DefaultTimerManager::handler() {
 	Common::StackLock lock(_mutex);
 
-	const uint32 curTime = g_system->getMillis();
+	const uint32 curTime = getMicroseconds();
 
 	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
-
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
+	while (!_heap.empty()) {
+		TimerSlot *slot = _heap[0];
+		const int32 delay = (int32)(curTime - slot->nextFireTime);
+		if (delay < 0)
+			return -delay;
+
+		slot->calls++;
+		slot->totalJitter += delay;
+		slot->maxJitter = MAX<uint32>(slot->maxJitter, delay);
+		if ((uint32)delay >= slot->interval)
+			slot->overruns++;
+
+		// Schedule the next invocation relative to this one, so that late
+		// invocations don't add up
 		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
-		}
-		insertPrioQueue(_head, slot);
+		slot->nextFireTime += slot->interval;
+		siftDown(0);
 
 		// Invoke the timer callback
 		assert(slot->callback);
 		slot->callback(slot->refCon);
-
-		// Look at the next scheduled timer
-		slot = _head->next;
 	}
+
+	return 0xFFFFFFFF;
 }
 
 bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, void *refCon) {
 	assert(interval > 0);
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = new TimerSlot;
-	slot->callback = callback;
-	slot->refCon = refCon;
-	slot->interval = interval;
-	slot->nextFireTime = g_system->getMillis() + interval / 1000;
-	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
-
 	// FIXME: It seems we do allow the client to add one callback multiple times over here,
 	// but "removeTimerProc" will remove *all* added instances. We should either prevent
 	// multiple additions of a timer proc OR we should change removeTimerProc to only remove
 	// a specific timer proc entry.
 	// Probably we can safely just allow a single addition of a specific function once
 	// and just update our Timer documentation accordingly.
-	insertPrioQueue(_head, slot);
+
+	TimerSlot *slot = new TimerSlot;
+	slot->callback = callback;
+	slot->refCon = refCon;
+	slot->interval = interval;
+	slot->nextFireTime = getMicroseconds() + interval;
+	slot->calls = 0;
+	slot->overruns = 0;
+	slot->maxJitter = 0;
+	slot->totalJitter = 0;
+
+	_heap.push_back(slot);
+	siftUp(_heap.size() - 1);
 
 	return true;
 }
@@ -135,15 +181,33 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
+	// Removing a slot reorders the heap, so look for matches from the start
+	// again after each removal. Timer procs are only removed rarely.
+	uint i = 0;
+	while (i < _heap.size()) {
+		if (_heap[i]->callback == callback) {
+			removeSlot(_heap[i]);
+			i = 0;
 		} else {
-			slot = slot->next;
+			i++;
 		}
 	}
 }
+
+void DefaultTimerManager::getStatistics(Common::Array<Statistics> &stats) {
+	Common::StackLock lock(_mutex);
+
+	stats.clear();
+	for (uint i = 0; i < _heap.size(); ++i) {
+		const TimerSlot *slot = _heap[i];
+
+		Statistics stat;
+		stat.callback = slot->callback;
+		stat.interval = slot->interval;
+		stat.calls = slot->calls;
+		stat.overruns = slot->overruns;
+		stat.maxJitter = slot->maxJitter;
+		stat.totalJitter = slot->totalJitter;
+		stats.push_back(stat);
+	}
+}
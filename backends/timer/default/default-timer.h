@@ -23,15 +23,46 @@
 #define BACKENDS_TIMER_DEFAULT_H
 
 #include "common/timer.h"
+#include "common/array.h"
 #include "common/mutex.h"
 
 struct TimerSlot;
 
+/**
+ * Timer manager which keeps the installed timers in a binary heap ordered
+ * by their next fire time. The backend has to invoke handler() regularly.
+ *
+ * Fire times are kept in microseconds and advanced by exactly one interval
+ * on every invocation, so timers don't drift when the handler is called
+ * late; they are invoked several times to catch up instead.
+ */
 class DefaultTimerManager : public Common::TimerManager {
+public:
+	/** Timing information about one installed timer. */
+	struct Statistics {
+		TimerProc callback;
+		uint32 interval;    ///< Requested interval, in microseconds
+		uint32 calls;       ///< Number of invocations so far
+		uint32 overruns;    ///< Invocations which were late by a whole interval or more
+		uint32 maxJitter;   ///< Maximum delay of an invocation, in microseconds
+		uint32 totalJitter; ///< Sum of the delays of all invocations, in microseconds
+	};
+
 private:
 	Common::Mutex _mutex;
 	void *_timerHandler;
-	TimerSlot *_head;
+	Common::Array<TimerSlot *> _heap;
+
+	void siftUp(uint index);
+	void siftDown(uint index);
+	void removeSlot(TimerSlot *slot);
+
+protected:
+	/**
+	 * Returns the current time in microseconds. The value may wrap around.
+	 * The default implementation is based on OSystem::getMillis().
+	 */
+	virtual uint32 getMicroseconds();
 
 public:
 	DefaultTimerManager();
@@ -39,10 +70,16 @@ public:
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon);
 	virtual void removeTimerProc(TimerProc proc);
 
+	/** Returns the timing information of all installed timers. */
+	void getStatistics(Common::Array<Statistics> &stats);
+
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
+	 *
+	 * @return the time until the next timer is due, in microseconds, or
+	 *         0xFFFFFFFF if no timer is installed
 	 */
-	void handler();
+	uint32 handler();
 };
 
 #endif
@@ -0,0 +1,158 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if defined(POSIX)
+
+// Re-enable some forbidden symbols to avoid clashes with time.h, sys/time.h
+// and unistd.h
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "backends/timer/posix/posix-timer.h"
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+// Condition variables can wait on the monotonic clock where the clock
+// selection option is supported, which e.g. Mac OS X lacks.
+#if defined(CLOCK_MONOTONIC) && defined(_POSIX_CLOCK_SELECTION) && _POSIX_CLOCK_SELECTION >= 0
+#define POSIX_TIMER_MONOTONIC_WAIT
+#endif
+
+enum {
+	// Upper limit for a single wait, which keeps the thread responsive in
+	// case it has to wait on the wall clock and that is changed
+	kMaxSleep = 10000
+};
+
+struct PosixTimerThread {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool monotonic;     ///< Whether cond waits on CLOCK_MONOTONIC instead of the wall clock
+	bool quit;
+	bool wakeUp;
+};
+
+PosixTimerManager::PosixTimerManager() : _thread(new PosixTimerThread) {
+	_thread->quit = false;
+	_thread->wakeUp = false;
+	pthread_mutex_init(&_thread->mutex, 0);
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+#ifdef POSIX_TIMER_MONOTONIC_WAIT
+	_thread->monotonic = (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0);
+#else
+	_thread->monotonic = false;
+#endif
+	pthread_cond_init(&_thread->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&_thread->thread, 0, &timerThread, this) != 0)
+		error("Could not create timer thread");
+}
+
+PosixTimerManager::~PosixTimerManager() {
+	pthread_mutex_lock(&_thread->mutex);
+	_thread->quit = true;
+	pthread_cond_signal(&_thread->cond);
+	pthread_mutex_unlock(&_thread->mutex);
+
+	pthread_join(_thread->thread, 0);
+
+	pthread_cond_destroy(&_thread->cond);
+	pthread_mutex_destroy(&_thread->mutex);
+	delete _thread;
+}
+
+bool PosixTimerManager::installTimerProc(TimerProc proc, int32 interval, void *refCon) {
+	const bool result = DefaultTimerManager::installTimerProc(proc, interval, refCon);
+
+	// The new timer might be due before the thread would wake up
+	pthread_mutex_lock(&_thread->mutex);
+	_thread->wakeUp = true;
+	pthread_cond_signal(&_thread->cond);
+	pthread_mutex_unlock(&_thread->mutex);
+
+	return result;
+}
+
+uint32 PosixTimerManager::getMicroseconds() {
+#if defined(CLOCK_MONOTONIC)
+	struct timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == 0)
+		return (uint32)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint32)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void *PosixTimerManager::timerThread(void *param) {
+	PosixTimerManager *manager = (PosixTimerManager *)param;
+	PosixTimerThread *thread = manager->_thread;
+
+	pthread_mutex_lock(&thread->mutex);
+	while (!thread->quit) {
+		pthread_mutex_unlock(&thread->mutex);
+		const uint32 delay = MIN<uint32>(manager->handler(), kMaxSleep);
+		pthread_mutex_lock(&thread->mutex);
+
+		if (thread->quit || thread->wakeUp) {
+			thread->wakeUp = false;
+			continue;
+		}
+
+		// pthread_cond_timedwait() takes an absolute time of the clock the
+		// condition variable waits on
+		struct timespec until;
+#ifdef POSIX_TIMER_MONOTONIC_WAIT
+		if (thread->monotonic) {
+			clock_gettime(CLOCK_MONOTONIC, &until);
+		} else
+#endif
+		{
+			struct timeval now;
+			gettimeofday(&now, 0);
+			until.tv_sec = now.tv_sec;
+			until.tv_nsec = now.tv_usec * 1000;
+		}
+
+		const uint32 nsec = until.tv_nsec + delay * 1000;
+		until.tv_sec += nsec / 1000000000;
+		until.tv_nsec = nsec % 1000000000;
+
+		pthread_cond_timedwait(&thread->cond, &thread->mutex, &until);
+		thread->wakeUp = false;
+	}
+	pthread_mutex_unlock(&thread->mutex);
+
+	return 0;
+}
+
+#endif
@@ -110,6 +110,13 @@ static const char HELP_STRING[] =
 	"  --render-mode=MODE       Enable additional render modes (cga, ega, hercGreen,\n"
 	"                           hercAmber, amiga)\n"
 	"\n"
+#ifdef USE_NULL_DRIVER
+	"  --replay-frames=MODE     Checksum or discard the frames when playing back a\n"
+	"                           recording (checksum, discard; default: checksum)\n"
+	"  --replay-checksum-file=FILE\n"
+	"                           Write the checksum of every frame to FILE\n"
+	"\n"
+#endif
 #if defined(ENABLE_SKY) || defined(ENABLE_QUEEN)
 	"  --alt-intro              Use alternative intro for CD versions of Beneath a\n"
 	"                           Steel Sky and Flight of the Amazon Queen\n"
@@ -179,9 +186,12 @@ void registerDefaults() {
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("softsynth_latency", 0);
+	ConfMan.registerDefault("amiga_interpolation", "none");
 //	ConfMan.registerDefault("music_driver", ???);
 
 	ConfMan.registerDefault("mt32_device", "null");
+	ConfMan.registerDefault("mt32_render_threads", 1);
 	ConfMan.registerDefault("gm_device", "null");
 
 	ConfMan.registerDefault("cdrom", 0);
@@ -227,6 +237,10 @@ void registerDefaults() {
 	ConfMan.registerDefault("record_temp_file_name", "record.tmp");
 	ConfMan.registerDefault("record_time_file_name", "record.time");
 
+#ifdef USE_NULL_DRIVER
+	ConfMan.registerDefault("replay_frames", "checksum");
+#endif
+
 #if 0
 	// NEW CODE TO HIDE CONSOLE FOR WIN32
 #ifdef WIN32
@@ -542,6 +556,14 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("record-time-file-name")
 			END_OPTION
 
+#ifdef USE_NULL_DRIVER
+			DO_LONG_OPTION("replay-frames")
+			END_OPTION
+
+			DO_LONG_OPTION("replay-checksum-file")
+			END_OPTION
+#endif
+
 #ifdef IPHONE
 			// This is automatically set when launched from the Springboard.
 			DO_LONG_OPTION_OPT("launchedFromSB", 0)
@@ -587,15 +609,17 @@ static void listTargets() {
 	       "-------------------- ------------------------------------------------------\n");
 
 	using namespace Common;
-	const ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
-	ConfigManager::DomainMap::const_iterator iter;
+	// Only the description is read, the targets aren't loaded from the
+	// config snapshot
+	const Common::Array<Common::String> domains = ConfMan.getGameDomainNames();
+	Common::Array<Common::String>::const_iterator iter;
 
 	Common::Array<Common::String> targets;
 	targets.reserve(domains.size());
 
 	for (iter = domains.begin(); iter != domains.end(); ++iter) {
-		Common::String name(iter->_key);
-		Common::String description(iter->_value.getVal("description"));
+		Common::String name(*iter);
+		Common::String description(ConfMan.getGameDomainValue(name, "description"));
 
 		if (description.empty()) {
 			// FIXME: At this point, we should check for a "gameid" override
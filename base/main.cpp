@@ -51,6 +51,7 @@
 
 #include "gui/gui-manager.h"
 #include "gui/error.h"
+#include "gui/savemetaindex.h"
 
 #include "audio/mididrv.h"
 #include "audio/musicplugin.h"  /* for music manager */
@@ -215,6 +216,8 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// We clear all debug levels again even though the engine should do it
 	DebugMan.clearAllDebugChannels();
 
+	debug(1, "SearchMan lookup cache: %u hits, %u misses", SearchMan.getLookupCacheHits(), SearchMan.getLookupCacheMisses());
+
 	// Reset the file/directory mappings
 	SearchMan.clear();
 
@@ -359,6 +362,9 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+	// Keep the save state meta indexes up to date when engines save
+	GUI::SaveMetaIndex::attach();
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -462,8 +468,10 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	}
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
+	GUI::SaveMetaIndex::detach();
 	GUI::GuiManager::destroy();
 	Common::ConfigManager::destroy();
+	Common::AtomTable::destroyGlobal();
 	Common::SearchManager::destroy();
 #ifdef USE_TRANSLATION
 	Common::TranslationManager::destroy();
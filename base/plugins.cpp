@@ -428,7 +428,7 @@ void PluginManagerUncached::updateConfigWithFileName(const Common::String &gameI
 		assert(domain);
 		(*domain)[gameId] = (*_currentPlugin)->getFileName();
 
-		ConfMan.flushToDisk();
+		ConfMan.scheduleFlush();
 	}
 }
 
@@ -304,6 +304,11 @@ void EventRecorder::processMillis(uint32 &millis) {
 	g_system->unlockMutex(_timeMutex);
 }
 
+bool EventRecorder::isPlaybackFinished() const {
+	return _recordMode == kRecorderPlayback && !_hasPlaybackEvent &&
+	       _playbackCount >= _recordCount && _playbackTimeCount >= _recordTimeCount;
+}
+
 bool EventRecorder::notifyEvent(const Event &ev) {
 	if (_recordMode != kRecorderRecord)
 		return false;
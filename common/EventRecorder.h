@@ -56,6 +56,12 @@ public:
 	/** TODO: Add documentation, this is only used by the backend */
 	void processMillis(uint32 &millis);
 
+	/**
+	 * Returns whether all recorded events and times have been played back.
+	 * This is always false unless a recording is being played back.
+	 */
+	bool isPlaybackFinished() const;
+
 private:
 	bool notifyEvent(const Event &ev);
 	bool pollEvent(Event &ev);
@@ -62,6 +62,13 @@ int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern)
 
 
 
+// Incremented whenever any SearchSet changes, see SearchSet::LookupCache
+static uint32 s_searchSetGeneration = 0;
+
+SearchSet::SearchSet()
+	: _lookupCacheGeneration(0), _lookupCacheHits(0), _lookupCacheMisses(0) {
+}
+
 SearchSet::ArchiveNodeList::iterator SearchSet::find(const String &name) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
@@ -92,6 +99,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	s_searchSetGeneration++;
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -174,6 +182,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		s_searchSetGeneration++;
 	}
 }
 
@@ -188,6 +197,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	s_searchSetGeneration++;
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -206,17 +216,42 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
-bool SearchSet::hasFile(const String &name) {
-	if (name.empty())
-		return false;
+void SearchSet::invalidateLookupCache() {
+	s_searchSetGeneration++;
+}
 
-	ArchiveNodeList::iterator it = _list.begin();
+Archive *SearchSet::lookup(const String &name) const {
+	if (_lookupCacheGeneration != s_searchSetGeneration || _lookupCache.size() >= kMaxLookupCacheSize) {
+		_lookupCache.clear(true);
+		_lookupCacheGeneration = s_searchSetGeneration;
+	}
+
+	LookupCache::const_iterator cached = _lookupCache.find(name);
+	if (cached != _lookupCache.end()) {
+		_lookupCacheHits++;
+		return cached->_value;
+	}
+
+	_lookupCacheMisses++;
+
+	Archive *archive = 0;
+	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return true;
+		if (it->_arc->hasFile(name)) {
+			archive = it->_arc;
+			break;
+		}
 	}
 
-	return false;
+	_lookupCache[name] = archive;
+	return archive;
+}
+
+bool SearchSet::hasFile(const String &name) {
+	if (name.empty())
+		return false;
+
+	return lookup(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) {
@@ -243,23 +278,26 @@ ArchiveMemberPtr SearchSet::getMember(const String &name) {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
-
-	return ArchiveMemberPtr();
+	Archive *archive = lookup(name);
+	return archive ? archive->getMember(name) : ArchiveMemberPtr();
 }
 
 SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) const {
 	if (name.empty())
 		return 0;
 
+	Archive *archive = lookup(name);
+	if (!archive)
+		return 0;
+
+	SeekableReadStream *stream = archive->createReadStreamForMember(name);
+	if (stream)
+		return stream;
+
+	// The file could not be opened, try the other archives like before
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
-		if (stream)
+		if (it->_arc != archive && (stream = it->_arc->createReadStreamForMember(name)))
 			return stream;
 	}
 
@@ -24,6 +24,8 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
@@ -140,13 +142,35 @@ class SearchSet : public Archive {
 	typedef List<Node> ArchiveNodeList;
 	ArchiveNodeList _list;
 
+	enum {
+		kMaxLookupCacheSize = 4096
+	};
+
+	/**
+	 * Maps the names looked up in the set to the archive which contains
+	 * them, or to 0 if none does. Since a SearchSet can contain other ones,
+	 * the caches of all sets are invalidated whenever any set changes.
+	 */
+	typedef HashMap<String, Archive *> LookupCache;
+	mutable LookupCache _lookupCache;
+	mutable uint32 _lookupCacheGeneration;
+	mutable uint32 _lookupCacheHits;
+	mutable uint32 _lookupCacheMisses;
+
 	ArchiveNodeList::iterator find(const String &name);
 	ArchiveNodeList::const_iterator find(const String &name) const;
 
 	// Add an archive keeping the list sorted by ascending priorities.
 	void insert(const Node& node);
 
+	/**
+	 * Returns the first archive containing the given file, or 0 if there
+	 * is none.
+	 */
+	Archive *lookup(const String &name) const;
+
 public:
+	SearchSet();
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -241,6 +265,18 @@ public:
 	 * opening the first file encountered that matches the name.
 	 */
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+
+	/**
+	 * Forget which archives contain which files. This is done automatically
+	 * when the set or any other SearchSet is changed, but has to be called
+	 * when files are added to or removed from an archive in the set.
+	 */
+	void invalidateLookupCache();
+
+	/** Number of file lookups answered from the cache. */
+	uint32 getLookupCacheHits() const { return _lookupCacheHits; }
+	/** Number of file lookups which had to search the archives. */
+	uint32 getLookupCacheMisses() const { return _lookupCacheMisses; }
 };
 
 
@@ -0,0 +1,140 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "common/atom.h"
+
+namespace Common {
+
+static AtomTable *g_atomTable = 0;
+
+Atom::Atom(const char *str) {
+	assert(str);
+	*this = AtomTable::getGlobal().intern(str);
+}
+
+Atom::Atom(const String &str) {
+	*this = AtomTable::getGlobal().intern(str);
+}
+
+Atom::Atom(const String &str, AtomTable &table) {
+	*this = table.intern(str);
+}
+
+bool Atom::find(const String &str, Atom &atom) {
+	return AtomTable::getGlobal().find(str, atom);
+}
+
+bool Atom::findIgnoreCase(const String &str, Atom &atom) {
+	return AtomTable::getGlobal().findIgnoreCase(str, atom);
+}
+
+const String &Atom::getString() const {
+	if (_entry)
+		return _entry->_str;
+
+	static const String empty;
+	return empty;
+}
+
+
+#pragma mark -
+
+
+AtomTable::AtomTable() {
+}
+
+AtomTable::~AtomTable() {
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i)
+		_entryPool.deleteChunk(const_cast<Atom::Entry *>(i->_value));
+}
+
+AtomTable &AtomTable::getGlobal() {
+	if (!g_atomTable)
+		g_atomTable = new AtomTable();
+	return *g_atomTable;
+}
+
+void AtomTable::destroyGlobal() {
+	delete g_atomTable;
+	g_atomTable = 0;
+}
+
+Atom AtomTable::intern(const String &str) {
+	if (str.empty())
+		return Atom();
+
+	Key key = { str.c_str(), hashit(str.c_str()) };
+	EntryMap::const_iterator i = _entries.find(key);
+	if (i != _entries.end())
+		return Atom(i->_value);
+
+	Atom::Entry *entry = new (_entryPool) Atom::Entry();
+	entry->_str = str;
+	entry->_hash = key._hash;
+	entry->_hashLower = hashit_lower(str.c_str());
+
+	// From now on the key points to the string of the entry, which never
+	// moves
+	key._str = entry->_str.c_str();
+	_entries[key] = entry;
+
+	// The first entry of all which only differ in case represents them
+	const Key lowerKey = { key._str, entry->_hashLower };
+	const Atom::Entry *&lower = _lowerEntries[lowerKey];
+	if (!lower)
+		lower = entry;
+	entry->_lower = lower;
+
+	return Atom(entry);
+}
+
+bool AtomTable::find(const String &str, Atom &atom) const {
+	if (str.empty()) {
+		atom = Atom();
+		return true;
+	}
+
+	const Key key = { str.c_str(), hashit(str.c_str()) };
+	EntryMap::const_iterator i = _entries.find(key);
+	if (i == _entries.end())
+		return false;
+
+	atom = Atom(i->_value);
+	return true;
+}
+
+bool AtomTable::findIgnoreCase(const String &str, Atom &atom) const {
+	if (str.empty()) {
+		atom = Atom();
+		return true;
+	}
+
+	const Key key = { str.c_str(), hashit_lower(str.c_str()) };
+	LowerEntryMap::const_iterator i = _lowerEntries.find(key);
+	if (i == _lowerEntries.end())
+		return false;
+
+	atom = Atom(i->_value);
+	return true;
+}
+
+}	// End of namespace Common
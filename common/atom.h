@@ -0,0 +1,207 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_ATOM_H
+#define COMMON_ATOM_H
+
+#include "common/hash-str.h"
+#include "common/memorypool.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+class AtomTable;
+
+/**
+ * An interned string. Every distinct string is stored only once in an
+ * AtomTable, together with its case sensitive and case insensitive hash,
+ * and an Atom is merely a pointer to that entry. Thus copying, comparing
+ * and hashing atoms is as cheap as it gets. Comparing two atoms while
+ * ignoring the case is a pointer comparison as well, since all entries
+ * which only differ in case share one representative.
+ *
+ * Atoms are meant for strings which are used over and over again, like
+ * config keys, config domain names or file names, and which are compared
+ * or looked up far more often than they are created. Interned strings are
+ * only released with their table. The global table used by default is
+ * released at shutdown, so it should only hold strings which are stored
+ * anyway; use find() for strings which are merely looked up, and a table
+ * of its own for strings which belong to a single object.
+ *
+ * The empty string is represented without any table entry, so default
+ * constructed atoms are free.
+ */
+class Atom {
+	friend class AtomTable;
+
+public:
+	struct Entry {
+		String _str;
+		uint _hash;			///< hashit() of the string
+		uint _hashLower;	///< hashit_lower() of the string
+		const Entry *_lower;	///< The representative of all entries equal to this one when ignoring case
+	};
+
+private:
+	const Entry *_entry;	///< 0 for the empty string
+
+	explicit Atom(const Entry *entry) : _entry(entry) {}
+
+public:
+	/** Construct the empty atom. */
+	Atom() : _entry(0) {}
+
+	/** Intern the given string in the global atom table. */
+	Atom(const char *str);
+	Atom(const String &str);
+
+	/** Intern the given string in the given atom table. */
+	Atom(const String &str, AtomTable &table);
+
+	/**
+	 * Look up the atom of the given string in the global atom table,
+	 * without interning the string if it's not there yet.
+	 * @return true if the string has been interned before
+	 */
+	static bool find(const String &str, Atom &atom);
+
+	/**
+	 * Like find(), but return an atom which equals the given string
+	 * when ignoring the case.
+	 */
+	static bool findIgnoreCase(const String &str, Atom &atom);
+
+	const String &getString() const;
+	operator const String &() const { return getString(); }
+
+	const char *c_str() const { return getString().c_str(); }
+	uint size() const { return _entry ? _entry->_str.size() : 0; }
+	bool empty() const { return _entry == 0; }
+
+	/** Return hashit() of the string, without computing it. */
+	uint hash() const { return _entry ? _entry->_hash : 0; }
+	/** Return hashit_lower() of the string, without computing it. */
+	uint hashIgnoreCase() const { return _entry ? _entry->_hashLower : 0; }
+
+	bool operator==(const Atom &x) const { return _entry == x._entry; }
+	bool operator!=(const Atom &x) const { return _entry != x._entry; }
+
+	bool equalsIgnoreCase(const Atom &x) const {
+		return (_entry ? _entry->_lower : 0) == (x._entry ? x._entry->_lower : 0);
+	}
+};
+
+/**
+ * A table of interned strings. Besides the global table, which is used
+ * by default, subsystems may keep their own tables, e.g. to release
+ * their atoms again. Atoms of different tables never compare equal, and
+ * atoms must not be used anymore once their table is destroyed.
+ */
+class AtomTable : NonCopyable {
+public:
+	AtomTable();
+	~AtomTable();
+
+	/** Return the atom of the given string, interning it if necessary. */
+	Atom intern(const String &str);
+
+	/**
+	 * Return the atom of the given string without interning it.
+	 * @return true if the string has been interned before
+	 */
+	bool find(const String &str, Atom &atom) const;
+
+	/**
+	 * Like find(), but return an atom which equals the given string
+	 * when ignoring the case.
+	 */
+	bool findIgnoreCase(const String &str, Atom &atom) const;
+
+	/** Return the number of interned strings. */
+	uint size() const { return _entries.size(); }
+
+	/** Return the table used by the atoms which don't specify one. */
+	static AtomTable &getGlobal();
+
+	/**
+	 * Release the global table. No atom of it must be used anymore
+	 * afterwards, so this is only called at shutdown, once everything
+	 * using the global table is gone.
+	 */
+	static void destroyGlobal();
+
+private:
+	struct Key {
+		const char *_str;
+		uint _hash;
+	};
+
+	struct Key_Hash {
+		uint operator()(const Key &x) const { return x._hash; }
+	};
+
+	struct Key_EqualTo {
+		bool operator()(const Key &x, const Key &y) const { return !strcmp(x._str, y._str); }
+	};
+
+	struct Key_IgnoreCase_EqualTo {
+		bool operator()(const Key &x, const Key &y) const { return !scumm_stricmp(x._str, y._str); }
+	};
+
+	// The keys point to the strings of the entries, so the strings are
+	// not stored twice.
+	typedef HashMap<Key, const Atom::Entry *, Key_Hash, Key_EqualTo> EntryMap;
+	typedef HashMap<Key, const Atom::Entry *, Key_Hash, Key_IgnoreCase_EqualTo> LowerEntryMap;
+
+	EntryMap _entries;
+	LowerEntryMap _lowerEntries;
+	ObjectPool<Atom::Entry> _entryPool;
+};
+
+
+struct Atom_Hash {
+	uint operator()(const Atom &x) const { return x.hash(); }
+};
+
+struct Atom_EqualTo {
+	bool operator()(const Atom &x, const Atom &y) const { return x == y; }
+};
+
+struct Atom_IgnoreCase_Hash {
+	uint operator()(const Atom &x) const { return x.hashIgnoreCase(); }
+};
+
+struct Atom_IgnoreCase_EqualTo {
+	bool operator()(const Atom &x, const Atom &y) const { return x.equalsIgnoreCase(y); }
+};
+
+template <>
+struct Hash<Atom> {
+	uint operator()(const Atom &x) const { return x.hash(); }
+};
+
+// Atom to string map -- case insensitive, like StringMap
+typedef HashMap<Atom, String, Atom_IgnoreCase_Hash, Atom_IgnoreCase_EqualTo> AtomStringMap;
+
+}	// End of namespace Common
+
+#endif
@@ -22,8 +22,12 @@
 
 #include "common/config-manager.h"
 #include "common/debug.h"
+#include "common/events.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/streamreader.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
@@ -47,8 +51,267 @@ const char *ConfigManager::kKeymapperDomain = "keymapper";
 
 #pragma mark -
 
+/*
+ * The binary snapshot of the config file is stored next to it, and is used
+ * instead of parsing the config file when the size and the modification
+ * stamp of the file still match the ones stored in the snapshot. Then the
+ * config file isn't even read. Where the stamp isn't known, the file is
+ * hashed and its MD5 is compared instead.
+ *
+ * The stamp misses changes which keep the size of the file only where the
+ * file system timestamps are too coarse, i.e. when the file is changed in
+ * place twice within their resolution, e.g. within the same second on a
+ * file system without sub-second timestamps. The snapshot holds the domains in the
+ * order they appear in the file, so loading it results in exactly the same
+ * domains as parsing the file. The game domains are only decoded when they
+ * are accessed.
+ *
+ *   uint32BE   tag, 'CFGS'
+ *   byte       version
+ *   byte       flags, the snapshot can't be used by builds with other flags
+ *   uint32LE   size of the config file
+ *   uint32LE   modification stamp of the config file, 0 if not known
+ *   byte[16]   MD5 of the config file
+ *   uint16LE   number of keys, followed by the keys as strings
+ *   uint32LE   number of domains, followed by the domains:
+ *     string     name
+ *     byte       1 for a game domain, i.e. the domain has a "gameid" key
+ *     uint32LE   size of the rest of the domain
+ *     string     domain comment
+ *     uint16LE   number of entries, followed by the entries:
+ *       uint16LE   index of the key
+ *       string     value
+ *       string     comment
+ *
+ * Strings are stored as their uint16LE size followed by the characters.
+ */
+
+enum {
+	kSnapshotTag = MKTAG('C','F','G','S'),
+	kSnapshotVersion = 3,
+	kSnapshotHeaderSize = 4 + 1 + 1 + 4 + 4 + 16
+};
+
+enum {
+	kSnapshotKeymapper = 1 << 0
+};
+
+#ifdef ENABLE_KEYMAPPER
+static const byte kSnapshotFlags = kSnapshotKeymapper;
+#else
+static const byte kSnapshotFlags = 0;
+#endif
+
+static bool readSnapshotString(StreamReader &in, String &str) {
+	const uint16 size = in.readUint16LE();
+	const byte *data = in.require(size);
+	if (!data)
+		return false;
+
+	str = size ? String((const char *)data, size) : String();
+	return true;
+}
+
+/** Check that a domain in the snapshot is complete, without decoding it. */
+static bool checkSnapshotDomain(StreamReader &in, uint keyCount) {
+	if (!in.require(in.readUint16LE()))
+		return false;
+
+	uint16 entries = in.readUint16LE();
+	while (entries-- && !in.eos()) {
+		if (in.readUint16LE() >= keyCount)
+			return false;
+		in.require(in.readUint16LE());
+		in.require(in.readUint16LE());
+	}
+
+	return !in.eos() && in.pos() == in.size();
+}
+
+static void readSnapshotDomain(StreamReader &in, const Array<Atom> &keys, ConfigManager::Domain &domain) {
+	String str;
+	readSnapshotString(in, str);
+	domain.setDomainComment(str);
+
+	uint16 entries = in.readUint16LE();
+	while (entries--) {
+		const Atom &key = keys[in.readUint16LE()];
+		readSnapshotString(in, domain[key]);
+		readSnapshotString(in, str);
+		if (!str.empty())
+			domain.setKVComment(key, str);
+	}
+}
+
+/**
+ * Strings which don't come out of the config file as they went in can't be
+ * stored in the snapshot, which must match the file. The config file
+ * parser itself never returns such strings.
+ */
+static bool isSnapshotKey(const String &key) {
+	return !key.empty() && key[0] != '#' && key[0] != '[' && !isspace(key[0]) && !isspace(key.lastChar()) &&
+	       !strpbrk(key.c_str(), "=\r\n") && key.size() <= 0xFFFF;
+}
+
+static bool isSnapshotValue(const String &value) {
+	return !isspace(value[0]) && !isspace(value.lastChar()) && !strpbrk(value.c_str(), "\r\n") && value.size() <= 0xFFFF;
+}
+
+static bool isSnapshotComment(const String &comment) {
+	// Comments are made of lines starting with '#'
+	if (comment.empty())
+		return true;
+	if (comment[0] != '#' || comment.lastChar() != '\n' || strchr(comment.c_str(), '\r') || comment.size() > 0xFFFF)
+		return false;
+
+	for (const char *p = strchr(comment.c_str(), '\n'); p[1]; p = strchr(p + 1, '\n')) {
+		if (p[1] != '#')
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Collects the snapshot while the config file is written. It starts with
+ * the keys of the current snapshot, so the lazy domains can be copied over
+ * without decoding them.
+ */
+class ConfigManager::SnapshotWriter {
+public:
+	SnapshotWriter(const Array<Atom> &keys) : _domains(DisposeAfterUse::YES), _keys(keys), _domainCount(0), _valid(true) {
+		for (uint i = 0; i < _keys.size(); ++i)
+			_keyIndices[_keys[i]] = i;
+	}
+
+	bool isValid() const { return _valid; }
+	void invalidate() { _valid = false; }
+
+	uint16 getKeyIndex(const Atom &key) {
+		HashMap<Atom, uint>::const_iterator i = _keyIndices.find(key);
+		if (i != _keyIndices.end())
+			return i->_value;
+
+		if (_keys.size() > 0xFFFF)
+			_valid = false;
+		_keyIndices[key] = _keys.size();
+		_keys.push_back(key);
+		return _keys.size() - 1;
+	}
+
+	void addDomain(const String &name, bool isGame, const byte *data, uint32 size) {
+		writeString(_domains, name);
+		_domains.writeByte(isGame);
+		_domains.writeUint32LE(size);
+		_domains.write(data, size);
+		_domainCount++;
+	}
+
+	static void writeString(WriteStream &out, const String &str) {
+		out.writeUint16LE(str.size());
+		out.write(str.c_str(), str.size());
+	}
+
+	/** Write the snapshot of the config file with the given size, stamp and MD5. */
+	bool write(WriteStream &out, uint32 configSize, uint32 configStamp, const uint8 configDigest[16]) {
+		if (!_valid)
+			return false;
+
+		MemoryWriteStreamDynamic header(DisposeAfterUse::YES);
+		header.writeUint32BE(kSnapshotTag);
+		header.writeByte(kSnapshotVersion);
+		header.writeByte(kSnapshotFlags);
+		header.writeUint32LE(configSize);
+		header.writeUint32LE(configStamp);
+		header.write(configDigest, 16);
+
+		header.writeUint16LE(_keys.size());
+		for (uint i = 0; i < _keys.size(); ++i)
+			writeString(header, _keys[i]);
+		header.writeUint32LE(_domainCount);
+
+		out.write(header.getData(), header.size());
+		out.write(_domains.getData(), _domains.size());
+		out.finalize();
+		return !out.err();
+	}
 
-ConfigManager::ConfigManager() : _activeDomain(0) {
+private:
+	MemoryWriteStreamDynamic _domains;
+	Array<Atom> _keys;
+	HashMap<Atom, uint> _keyIndices;
+	uint32 _domainCount;
+	bool _valid;
+};
+
+/**
+ * Writes the changes delayed by ConfigManager::scheduleFlush() from the
+ * event loop. It never returns any events itself.
+ */
+class ConfigFlushSource : public EventSource {
+public:
+	ConfigFlushSource(ConfigManager &manager) : _manager(manager) {}
+
+	bool pollEvent(Event &event) {
+		if (_manager._flushPending && g_system->getMillis() - _manager._lastFlushTime >= ConfigManager::kFlushDelay)
+			_manager.writeToDisk();
+		return false;
+	}
+
+	bool allowMapping() const { return false; }
+
+private:
+	ConfigManager &_manager;
+};
+
+static SeekableReadStream *openSnapshotForReading(const String &filename) {
+	// An empty filename stands for the default config file
+	if (filename.empty())
+		return g_system->createConfigCacheReadStream();
+
+	File *file = new File();
+	if (!file->open(FSNode(filename + ".cache"))) {
+		delete file;
+		return 0;
+	}
+	return file;
+}
+
+/** Return the modification stamp of the config file, or 0 if it isn't known. */
+static uint32 getConfigModificationStamp(const String &filename) {
+	if (filename.empty())
+		return g_system->getConfigModificationStamp();
+	return FSNode(filename).getModificationStamp();
+}
+
+static WriteStream *openSnapshotForWriting(const String &filename) {
+	if (filename.empty())
+		return g_system->createConfigCacheWriteStream();
+
+	DumpFile *dump = new DumpFile();
+	if (!dump->open(filename + ".cache")) {
+		delete dump;
+		return 0;
+	}
+	return dump;
+}
+
+#pragma mark -
+
+
+ConfigManager::ConfigManager() : _activeDomain(0), _snapshot(0), _snapshotSize(0), _diskSize(0), _diskStamp(0), _diskValid(false),
+	_lastFlushTime(0), _flushPending(false), _flushSource(0) {
+}
+
+ConfigManager::~ConfigManager() {
+	flushPendingChanges();
+
+	if (_flushSource) {
+		if (g_system && g_system->getEventManager())
+			g_system->getEventManager()->getEventDispatcher()->unregisterSource(_flushSource);
+		delete _flushSource;
+	}
+
+	freeSnapshot();
 }
 
 void ConfigManager::defragment() {
@@ -59,6 +322,8 @@ void ConfigManager::defragment() {
 }
 
 void ConfigManager::copyFrom(ConfigManager &source) {
+	source.loadLazyDomains();
+
 	_transientDomain = source._transientDomain;
 	_gameDomains = source._gameDomains;
 	_miscDomains = source._miscDomains;
@@ -71,6 +336,10 @@ void ConfigManager::copyFrom(ConfigManager &source) {
 	_activeDomainName = source._activeDomainName;
 	_activeDomain = &_gameDomains[_activeDomainName];
 	_filename = source._filename;
+	_diskSize = source._diskSize;
+	_diskStamp = source._diskStamp;
+	memcpy(_diskDigest, source._diskDigest, sizeof(_diskDigest));
+	_diskValid = source._diskValid;
 }
 
 
@@ -123,18 +392,7 @@ void ConfigManager::addDomain(const Common::String &domainName, const ConfigMana
 #endif
 	} else if (domain.contains("gameid")) {
 		// If the domain contains "gameid" we assume it's a game domain
-		if (_gameDomains.contains(domainName))
-			warning("Game domain %s already exists in ConfigManager", domainName.c_str());
-
-		_gameDomains[domainName] = domain;
-
-		_domainSaveOrder.push_back(domainName);
-
-		// Check if we have the same misc domain. For older config files
-		// we could have 'ghost' domains with the same name, so delete
-		// the ghost domain
-		if (_miscDomains.contains(domainName))
-			_miscDomains.erase(domainName);
+		insertGameDomain(domainName) = domain;
 	} else {
 		// Otherwise it's a miscellaneous domain
 		if (_miscDomains.contains(domainName))
@@ -145,12 +403,28 @@ void ConfigManager::addDomain(const Common::String &domainName, const ConfigMana
 }
 
 
-void ConfigManager::loadFromStream(SeekableReadStream &stream) {
-	String domainName;
-	String comment;
-	Domain domain;
-	int lineno = 0;
+/**
+ * Add the game domain with the given name, as if it was read from the
+ * config file, and return it.
+ */
+ConfigManager::Domain &ConfigManager::insertGameDomain(const String &domainName) {
+	if (_gameDomains.contains(domainName))
+		warning("Game domain %s already exists in ConfigManager", domainName.c_str());
+
+	Domain &domain = _gameDomains[domainName];
+
+	_domainSaveOrder.push_back(domainName);
+
+	// Check if we have the same misc domain. For older config files
+	// we could have 'ghost' domains with the same name, so delete
+	// the ghost domain
+	if (_miscDomains.contains(domainName))
+		_miscDomains.erase(domainName);
 
+	return domain;
+}
+
+void ConfigManager::clearDomains() {
 	_appDomain.clear();
 	_gameDomains.clear();
 	_miscDomains.clear();
@@ -161,6 +435,166 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 	_keymapperDomain.clear();
 #endif
 
+	freeSnapshot();
+}
+
+void ConfigManager::loadFromStream(SeekableReadStream &stream) {
+	clearDomains();
+
+	// Without a valid snapshot, the next flush writes one even if the file
+	// itself didn't change
+	const uint32 size = stream.size() - stream.pos();
+	const uint32 stamp = getConfigModificationStamp(_filename);
+	_diskValid = stamp && loadSnapshot(size, stamp, 0);
+	if (_diskValid) {
+		debug(2, "Using configuration snapshot");
+		return;
+	}
+
+	// The whole file is read at once. Without a modification stamp it has
+	// to be hashed to validate the snapshot, and it is parsed from memory
+	// otherwise.
+	byte *data = (byte *)malloc(size + 1);
+	MemoryReadStream config(data, stream.read(data, size), DisposeAfterUse::YES);
+
+	if (!stamp) {
+		uint8 digest[16];
+		_diskValid = computeStreamMD5(config, digest) && loadSnapshot(config.size(), 0, digest);
+		config.seek(0);
+		if (_diskValid) {
+			debug(2, "Using configuration snapshot");
+			return;
+		}
+	}
+
+	parseConfig(config);
+}
+
+/**
+ * Load the snapshot of the config file, if it belongs to the file with the
+ * given size and either the given modification stamp, or the given MD5 if
+ * the stamp isn't known.
+ */
+bool ConfigManager::loadSnapshot(uint32 configSize, uint32 configStamp, const uint8 *configDigest) {
+	SeekableReadStream *in = openSnapshotForReading(_filename);
+	if (!in)
+		return false;
+
+	// Read the whole snapshot at once, the lazy domains are decoded from
+	// there later on
+	_snapshotSize = in->size();
+	_snapshot = (byte *)malloc(_snapshotSize + 1);
+	const bool readOk = in->read(_snapshot, _snapshotSize) == _snapshotSize;
+	delete in;
+
+	MemoryReadStream stream(_snapshot, readOk ? _snapshotSize : 0);
+	StreamReader reader(stream);
+
+	const byte *header = reader.require(kSnapshotHeaderSize);
+	if (!header || READ_BE_UINT32(header) != kSnapshotTag || header[4] != kSnapshotVersion ||
+	    header[5] != kSnapshotFlags || READ_LE_UINT32(header + 6) != configSize ||
+	    (configDigest ? memcmp(header + 14, configDigest, 16) != 0 : READ_LE_UINT32(header + 10) != configStamp)) {
+		freeSnapshot();
+		return false;
+	}
+
+	// The snapshot knows the MD5 of the file, to find out whether the file
+	// changed when it is written
+	_diskSize = configSize;
+	_diskStamp = configStamp;
+	memcpy(_diskDigest, header + 14, 16);
+
+	uint16 keyCount = reader.readUint16LE();
+	String str;
+	while (keyCount-- && readSnapshotString(reader, str))
+		_snapshotKeys.push_back(str);
+
+	String domainName;
+	bool valid = true;
+	uint32 domainCount = reader.readUint32LE();
+	while (domainCount-- && valid && !reader.eos()) {
+		readSnapshotString(reader, domainName);
+		const bool isGame = reader.readByte() != 0;
+		const uint32 size = reader.readUint32LE();
+		const uint32 offset = reader.pos();
+		const byte *data = reader.require(size);
+		if (!data)
+			break;
+
+		MemoryReadStream domainStream(data, size);
+		StreamReader domainReader(domainStream);
+		valid = !domainName.empty() && isValidDomainName(domainName) &&
+		        checkSnapshotDomain(domainReader, _snapshotKeys.size());
+		if (!valid)
+			break;
+
+		// Game domains are decoded when they are accessed. The others are
+		// few, and the special ones are always needed.
+		bool lazy = isGame && domainName != kApplicationDomain;
+#ifdef ENABLE_KEYMAPPER
+		lazy = lazy && domainName != kKeymapperDomain;
+#endif
+		if (lazy) {
+			insertGameDomain(domainName) = Domain();
+			const LazyDomain lazyDomain = { offset, size };
+			_lazyDomains[domainName] = lazyDomain;
+		} else {
+			Domain domain;
+			domainReader.seek(0);
+			readSnapshotDomain(domainReader, _snapshotKeys, domain);
+			addDomain(domainName, domain);
+		}
+	}
+
+	if (!valid || reader.eos() || reader.pos() != reader.size()) {
+		warning("Ignoring invalid configuration snapshot");
+		clearDomains();
+		return false;
+	}
+
+	if (_lazyDomains.empty())
+		freeSnapshot();
+	return true;
+}
+
+void ConfigManager::loadLazyDomain(const Atom &domName) const {
+	LazyDomainMap::iterator lazy = _lazyDomains.find(domName);
+	if (lazy == _lazyDomains.end())
+		return;
+
+	// The domain is in the map already, it's only filled in. Thus this
+	// doesn't change the config, and const methods may do it.
+	DomainMap::iterator domain = const_cast<DomainMap &>(_gameDomains).find(domName);
+	assert(domain != _gameDomains.end());
+
+	MemoryReadStream stream(_snapshot + lazy->_value.offset, lazy->_value.size);
+	StreamReader reader(stream);
+	readSnapshotDomain(reader, _snapshotKeys, domain->_value);
+
+	_lazyDomains.erase(lazy);
+	if (_lazyDomains.empty())
+		freeSnapshot();
+}
+
+void ConfigManager::loadLazyDomains() const {
+	while (!_lazyDomains.empty())
+		loadLazyDomain(_lazyDomains.begin()->_key);
+}
+
+void ConfigManager::freeSnapshot() const {
+	_lazyDomains.clear();
+	_snapshotKeys.clear();
+	free(_snapshot);
+	_snapshot = 0;
+	_snapshotSize = 0;
+}
+
+void ConfigManager::parseConfig(SeekableReadStream &stream) {
+	String domainName;
+	String comment;
+	Domain domain;
+	int lineno = 0;
+
 	// TODO: Detect if a domain occurs multiple times (or likewise, if
 	// a key occurs multiple times inside one domain).
 
@@ -182,7 +616,7 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 			// It's a new domain which begins here.
 			// Determine where the previously accumulated domain goes, if we accumulated anything.
 			addDomain(domainName, domain);
-			domain.clear();
+			domain = Domain();
 			const char *p = line.c_str() + 1;
 			// Get the domain name, and check whether it's valid (that
 			// is, verify that it only consists of alphanumerics,
@@ -243,65 +677,150 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 }
 
 void ConfigManager::flushToDisk() {
-#ifndef __DC__
-	WriteStream *stream;
+	writeToDisk();
+}
 
-	if (_filename.empty()) {
-		// Write to the default config file
-		assert(g_system);
-		stream = g_system->createConfigWriteStream();
-		if (!stream)    // If writing to the config file is not possible, do nothing
-			return;
-	} else {
-		DumpFile *dump = new DumpFile();
-		assert(dump);
+void ConfigManager::scheduleFlush() {
+	// Coalesce writes which closely follow the last one. The flush source
+	// exists once the config was written, and writes the changes later on.
+	if (_flushSource && g_system->getMillis() - _lastFlushTime < kFlushDelay) {
+		_flushPending = true;
+		return;
+	}
 
-		if (!dump->open(_filename)) {
-			warning("Unable to write configuration file: %s", _filename.c_str());
-			delete dump;
-			return;
-		}
+	writeToDisk();
+}
 
-		stream = dump;
+void ConfigManager::flushPendingChanges() {
+	if (_flushPending)
+		writeToDisk();
+}
+
+void ConfigManager::flushBeforeQuit() {
+	// Don't create the config manager only to find nothing to write
+	if (_singleton)
+		_singleton->flushPendingChanges();
+}
+
+void ConfigManager::writeToDisk() {
+	_flushPending = false;
+
+	if (g_system) {
+		_lastFlushTime = g_system->getMillis();
+
+		if (!_flushSource && g_system->getEventManager()) {
+			_flushSource = new ConfigFlushSource(*this);
+			g_system->getEventManager()->getEventDispatcher()->registerSource(_flushSource, false);
+		}
 	}
 
+#ifndef __DC__
+	// The file is put together in memory first, to find out whether it
+	// changed at all
+	MemoryWriteStreamDynamic config(DisposeAfterUse::YES);
+	SnapshotWriter snapshot(_snapshotKeys);
+
 	// Write the application domain
-	writeDomain(*stream, kApplicationDomain, _appDomain);
+	writeDomain(config, snapshot, kApplicationDomain, _appDomain);
 
 #ifdef ENABLE_KEYMAPPER
 	// Write the keymapper domain
-	writeDomain(*stream, kKeymapperDomain, _keymapperDomain);
+	writeDomain(config, snapshot, kKeymapperDomain, _keymapperDomain);
 #endif
 
 	DomainMap::const_iterator d;
 
 	// Write the miscellaneous domains next
 	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
-		writeDomain(*stream, d->_key, d->_value);
+		writeDomain(config, snapshot, d->_key, d->_value);
 	}
 
 	// First write the domains in _domainSaveOrder, in that order.
 	// Note: It's possible for _domainSaveOrder to list domains which
 	// are not present anymore, so we validate each name.
+	HashMap<Atom, bool, Atom_IgnoreCase_Hash, Atom_IgnoreCase_EqualTo> ordered;
+	LazyDomainMap::const_iterator lazy;
 	Array<String>::const_iterator i;
 	for (i = _domainSaveOrder.begin(); i != _domainSaveOrder.end(); ++i) {
-		if (_gameDomains.contains(*i)) {
-			writeDomain(*stream, *i, _gameDomains[*i]);
+		d = _gameDomains.find(*i);
+		if (d != _gameDomains.end()) {
+			lazy = _lazyDomains.find(d->_key);
+			if (lazy != _lazyDomains.end())
+				writeLazyDomain(config, snapshot, *i, lazy->_value);
+			else
+				writeDomain(config, snapshot, *i, d->_value);
 		}
+		ordered[*i] = true;
 	}
 
 	// Now write the domains which haven't been written yet
 	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
-		if (find(_domainSaveOrder.begin(), _domainSaveOrder.end(), d->_key) == _domainSaveOrder.end())
-			writeDomain(*stream, d->_key, d->_value);
+		if (ordered.contains(d->_key))
+			continue;
+
+		lazy = _lazyDomains.find(d->_key);
+		if (lazy != _lazyDomains.end())
+			writeLazyDomain(config, snapshot, d->_key, lazy->_value);
+		else
+			writeDomain(config, snapshot, d->_key, d->_value);
 	}
 
+	const uint32 size = config.size();
+	uint8 digest[16];
+	MemoryReadStream configStream(config.getData(), size);
+	const bool hashed = computeStreamMD5(configStream, digest);
+	if (hashed && _diskValid && size == _diskSize && !memcmp(digest, _diskDigest, sizeof(digest)))
+		return;
+
+	WriteStream *stream;
+
+	if (_filename.empty()) {
+		// Write to the default config file
+		assert(g_system);
+		stream = g_system->createConfigWriteStream();
+		if (!stream)    // If writing to the config file is not possible, do nothing
+			return;
+	} else {
+		DumpFile *dump = new DumpFile();
+		assert(dump);
+
+		if (!dump->open(_filename)) {
+			warning("Unable to write configuration file: %s", _filename.c_str());
+			delete dump;
+			return;
+		}
+
+		stream = dump;
+	}
+
+	stream->write(config.getData(), size);
+	stream->finalize();
+	_diskValid = hashed && !stream->err();
 	delete stream;
 
+	if (!_diskValid)
+		return;
+
+	_diskSize = size;
+	_diskStamp = getConfigModificationStamp(_filename);
+	memcpy(_diskDigest, digest, sizeof(digest));
+
+	if (!snapshot.isValid())
+		return;
+
+	// The snapshot is only of use if it belongs to the file, a stale one is
+	// recognized by the size and modification stamp of the file
+	WriteStream *out = openSnapshotForWriting(_filename);
+	if (out) {
+		if (!snapshot.write(*out, size, _diskStamp, digest))
+			debug(2, "Could not write configuration snapshot");
+		delete out;
+	}
+
 #endif // !__DC__
 }
 
-void ConfigManager::writeDomain(WriteStream &stream, const String &name, const Domain &domain) {
+void ConfigManager::writeDomain(WriteStream &stream, SnapshotWriter &snapshot, const String &name, const Domain &domain) {
 	if (domain.empty())
 		return;     // Don't bother writing empty domains.
 
@@ -311,12 +830,31 @@ void ConfigManager::writeDomain(WriteStream &stream, const String &name, const D
 	if (domain.contains("id_came_from_command_line"))
 		return;
 
+	// The snapshot holds the domain as it's read from the file again
+	MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+	Domain::const_iterator x;
+	uint entries = 0;
+	for (x = domain.begin(); x != domain.end(); ++x) {
+		if (!x->_value.empty())
+			entries++;
+	}
+
+	Domain::const_iterator gameid = domain.find("gameid");
+	const bool isGame = gameid != domain.end() && !gameid->_value.empty();
+
+	if (entries > 0xFFFF)
+		snapshot.invalidate();
+
 	String comment;
 
 	// Write domain comment (if any)
 	comment = domain.getDomainComment();
 	if (!comment.empty())
 		stream.writeString(comment);
+	if (!isSnapshotComment(comment))
+		snapshot.invalidate();
+	SnapshotWriter::writeString(data, comment);
+	data.writeUint16LE(entries);
 
 	// Write domain start
 	stream.writeByte('[');
@@ -325,10 +863,10 @@ void ConfigManager::writeDomain(WriteStream &stream, const String &name, const D
 	stream.writeByte('\n');
 
 	// Write all key/value pairs in this domain, including comments
-	Domain::const_iterator x;
 	for (x = domain.begin(); x != domain.end(); ++x) {
 		if (!x->_value.empty()) {
 			// Write comment (if any)
+			comment.clear();
 			if (domain.hasKVComment(x->_key)) {
 				comment = domain.getKVComment(x->_key);
 				stream.writeString(comment);
@@ -338,9 +876,52 @@ void ConfigManager::writeDomain(WriteStream &stream, const String &name, const D
 			stream.writeByte('=');
 			stream.writeString(x->_value);
 			stream.writeByte('\n');
+
+			if (!isSnapshotKey(x->_key) || !isSnapshotValue(x->_value) || !isSnapshotComment(comment))
+				snapshot.invalidate();
+			data.writeUint16LE(snapshot.getKeyIndex(x->_key));
+			SnapshotWriter::writeString(data, x->_value);
+			SnapshotWriter::writeString(data, comment);
 		}
 	}
 	stream.writeByte('\n');
+
+	snapshot.addDomain(name, isGame, data.getData(), data.size());
+}
+
+/**
+ * Write a game domain which wasn't loaded from the snapshot yet, straight
+ * from there.
+ */
+void ConfigManager::writeLazyDomain(WriteStream &stream, SnapshotWriter &snapshot, const String &name, const LazyDomain &lazy) {
+	MemoryReadStream data(_snapshot + lazy.offset, lazy.size);
+	StreamReader reader(data);
+	String comment, value;
+
+	readSnapshotString(reader, comment);
+	stream.writeString(comment);
+
+	stream.writeByte('[');
+	stream.writeString(name);
+	stream.writeByte(']');
+	stream.writeByte('\n');
+
+	uint16 entries = reader.readUint16LE();
+	while (entries--) {
+		const Atom &key = _snapshotKeys[reader.readUint16LE()];
+		readSnapshotString(reader, value);
+		readSnapshotString(reader, comment);
+
+		stream.writeString(comment);
+		stream.writeString(key);
+		stream.writeByte('=');
+		stream.writeString(value);
+		stream.writeByte('\n');
+	}
+	stream.writeByte('\n');
+
+	// The snapshot writer starts with the same keys, so the data stays valid
+	snapshot.addDomain(name, true, _snapshot + lazy.offset, lazy.size);
 }
 
 
@@ -359,10 +940,19 @@ const ConfigManager::Domain *ConfigManager::getDomain(const String &domName) con
 	if (domName == kKeymapperDomain)
 		return &_keymapperDomain;
 #endif
-	if (_gameDomains.contains(domName))
-		return &_gameDomains[domName];
-	if (_miscDomains.contains(domName))
-		return &_miscDomains[domName];
+	// Names which were never interned can't be the name of a domain
+	Atom domAtom;
+	if (!Atom::findIgnoreCase(domName, domAtom))
+		return 0;
+
+	DomainMap::const_iterator i = _gameDomains.find(domAtom);
+	if (i != _gameDomains.end()) {
+		loadLazyDomain(domAtom);
+		return &i->_value;
+	}
+	i = _miscDomains.find(domAtom);
+	if (i != _miscDomains.end())
+		return &i->_value;
 
 	return 0;
 }
@@ -379,10 +969,19 @@ ConfigManager::Domain *ConfigManager::getDomain(const String &domName) {
 	if (domName == kKeymapperDomain)
 		return &_keymapperDomain;
 #endif
-	if (_gameDomains.contains(domName))
-		return &_gameDomains[domName];
-	if (_miscDomains.contains(domName))
-		return &_miscDomains[domName];
+	// Names which were never interned can't be the name of a domain
+	Atom domAtom;
+	if (!Atom::findIgnoreCase(domName, domAtom))
+		return 0;
+
+	DomainMap::iterator i = _gameDomains.find(domAtom);
+	if (i != _gameDomains.end()) {
+		loadLazyDomain(domAtom);
+		return &i->_value;
+	}
+	i = _miscDomains.find(domAtom);
+	if (i != _miscDomains.end())
+		return &i->_value;
 
 	return 0;
 }
@@ -398,13 +997,19 @@ bool ConfigManager::hasKey(const String &key) const {
 	// 3) the application domain.
 	// The defaults domain is explicitly *not* checked.
 
-	if (_transientDomain.contains(key))
+	// Look the key up only once for all domains. Keys which were never
+	// interned can't be in any of them.
+	Atom keyAtom;
+	if (!Atom::findIgnoreCase(key, keyAtom))
+		return false;
+
+	if (_transientDomain.contains(keyAtom))
 		return true;
 
-	if (_activeDomain && _activeDomain->contains(key))
+	if (_activeDomain && _activeDomain->contains(keyAtom))
 		return true;
 
-	if (_appDomain.contains(key))
+	if (_appDomain.contains(keyAtom))
 		return true;
 
 	return false;
@@ -419,9 +1024,10 @@ bool ConfigManager::hasKey(const String &key, const String &domName) const {
 
 	const Domain *domain = getDomain(domName);
 
-	if (!domain)
+	Atom keyAtom;
+	if (!domain || !Atom::findIgnoreCase(key, keyAtom))
 		return false;
-	return domain->contains(key);
+	return domain->contains(keyAtom);
 }
 
 void ConfigManager::removeKey(const String &key, const String &domName) {
@@ -431,7 +1037,9 @@ void ConfigManager::removeKey(const String &key, const String &domName) {
 		error("ConfigManager::removeKey(%s, %s) called on non-existent domain",
 		      key.c_str(), domName.c_str());
 
-	domain->erase(key);
+	Atom keyAtom;
+	if (Atom::findIgnoreCase(key, keyAtom))
+		domain->erase(keyAtom);
 }
 
 
@@ -439,14 +1047,27 @@ void ConfigManager::removeKey(const String &key, const String &domName) {
 
 
 const String &ConfigManager::get(const String &key) const {
-	if (_transientDomain.contains(key))
-		return _transientDomain[key];
-	else if (_activeDomain && _activeDomain->contains(key))
-		return (*_activeDomain)[key];
-	else if (_appDomain.contains(key))
-		return _appDomain[key];
+	// Look the key up only once for all domains. Keys which were never
+	// interned can't be in any of them, and the empty atom isn't either.
+	Atom keyAtom;
+	if (!Atom::findIgnoreCase(key, keyAtom))
+		return _defaultsDomain.getVal(Atom());
+
+	Domain::const_iterator i = _transientDomain.find(keyAtom);
+	if (i != _transientDomain.end())
+		return i->_value;
+
+	if (_activeDomain) {
+		i = _activeDomain->find(keyAtom);
+		if (i != _activeDomain->end())
+			return i->_value;
+	}
 
-	return _defaultsDomain.getVal(key);
+	i = _appDomain.find(keyAtom);
+	if (i != _appDomain.end())
+		return i->_value;
+
+	return _defaultsDomain.getVal(keyAtom);
 }
 
 const String &ConfigManager::get(const String &key, const String &domName) const {
@@ -462,10 +1083,15 @@ const String &ConfigManager::get(const String &key, const String &domName) const
 		error("ConfigManager::get(%s,%s) called on non-existent domain",
 		      key.c_str(), domName.c_str());
 
-	if (domain->contains(key))
-		return (*domain)[key];
+	Atom keyAtom;
+	if (!Atom::findIgnoreCase(key, keyAtom))
+		return _defaultsDomain.getVal(Atom());
+
+	Domain::const_iterator i = domain->find(keyAtom);
+	if (i != domain->end())
+		return i->_value;
 
-	return _defaultsDomain.getVal(key);
+	return _defaultsDomain.getVal(keyAtom);
 }
 
 int ConfigManager::getInt(const String &key, const String &domName) const {
@@ -506,15 +1132,18 @@ bool ConfigManager::getBool(const String &key, const String &domName) const {
 
 
 void ConfigManager::set(const String &key, const String &value) {
+	// The key is stored, so it has to be interned anyway
+	const Atom keyAtom(key);
+
 	// Remove the transient domain value, if any.
-	_transientDomain.erase(key);
+	_transientDomain.erase(keyAtom);
 
 	// Write the new key/value pair into the active domain, resp. into
 	// the application domain if no game domain is active.
 	if (_activeDomain)
-		(*_activeDomain)[key] = value;
+		(*_activeDomain)[keyAtom] = value;
 	else
-		_appDomain[key] = value;
+		_appDomain[keyAtom] = value;
 }
 
 void ConfigManager::set(const String &key, const String &value, const String &domName) {
@@ -600,6 +1229,7 @@ void ConfigManager::setActiveDomain(const String &domName) {
 	} else {
 		assert(isValidDomainName(domName));
 		_activeDomain = & _gameDomains[domName];
+		loadLazyDomain(domName);
 	}
 	_activeDomainName = domName;
 }
@@ -628,13 +1258,21 @@ void ConfigManager::addMiscDomain(const String &domName) {
 void ConfigManager::removeGameDomain(const String &domName) {
 	assert(!domName.empty());
 	assert(isValidDomainName(domName));
-	_gameDomains.erase(domName);
+
+	Atom domAtom;
+	if (Atom::findIgnoreCase(domName, domAtom)) {
+		_gameDomains.erase(domAtom);
+		_lazyDomains.erase(domAtom);
+	}
 }
 
 void ConfigManager::removeMiscDomain(const String &domName) {
 	assert(!domName.empty());
 	assert(isValidDomainName(domName));
-	_miscDomains.erase(domName);
+
+	Atom domAtom;
+	if (Atom::findIgnoreCase(domName, domAtom))
+		_miscDomains.erase(domAtom);
 }
 
 
@@ -658,6 +1296,9 @@ void ConfigManager::renameDomain(const String &oldName, const String &newName, D
 	assert(isValidDomainName(oldName));
 	assert(isValidDomainName(newName));
 
+	loadLazyDomain(oldName);
+	loadLazyDomain(newName);
+
 //	_gameDomains[newName].merge(_gameDomains[oldName]);
 	Domain &oldDom = map[oldName];
 	Domain &newDom = map[newName];
@@ -670,12 +1311,56 @@ void ConfigManager::renameDomain(const String &oldName, const String &newName, D
 
 bool ConfigManager::hasGameDomain(const String &domName) const {
 	assert(!domName.empty());
-	return isValidDomainName(domName) && _gameDomains.contains(domName);
+	Atom domAtom;
+	return isValidDomainName(domName) && Atom::findIgnoreCase(domName, domAtom) && _gameDomains.contains(domAtom);
 }
 
 bool ConfigManager::hasMiscDomain(const String &domName) const {
 	assert(!domName.empty());
-	return isValidDomainName(domName) && _miscDomains.contains(domName);
+	Atom domAtom;
+	return isValidDomainName(domName) && Atom::findIgnoreCase(domName, domAtom) && _miscDomains.contains(domAtom);
+}
+
+Array<String> ConfigManager::getGameDomainNames() const {
+	Array<String> names;
+	names.reserve(_gameDomains.size());
+	for (DomainMap::const_iterator i = _gameDomains.begin(); i != _gameDomains.end(); ++i)
+		names.push_back(i->_key);
+	return names;
+}
+
+String ConfigManager::getGameDomainValue(const String &domName, const String &key) const {
+	// Names which were never interned can't be the name of a domain or key
+	Atom domAtom, keyAtom;
+	if (!Atom::findIgnoreCase(domName, domAtom) || !Atom::findIgnoreCase(key, keyAtom))
+		return String();
+
+	DomainMap::const_iterator domain = _gameDomains.find(domAtom);
+	if (domain == _gameDomains.end())
+		return String();
+
+	LazyDomainMap::const_iterator lazy = _lazyDomains.find(domAtom);
+	if (lazy == _lazyDomains.end())
+		return domain->_value.getVal(keyAtom, String());
+
+	// Look for the entry in the snapshot, skipping all the others. The
+	// domain was checked when the snapshot was loaded.
+	MemoryReadStream stream(_snapshot + lazy->_value.offset, lazy->_value.size);
+	StreamReader reader(stream);
+	String value;
+	reader.skip(reader.readUint16LE());
+
+	uint16 entries = reader.readUint16LE();
+	while (entries--) {
+		if (_snapshotKeys[reader.readUint16LE()].equalsIgnoreCase(keyAtom)) {
+			readSnapshotString(reader, value);
+			break;
+		}
+		reader.skip(reader.readUint16LE());
+		reader.skip(reader.readUint16LE());
+	}
+
+	return value;
 }
 
 #pragma mark -
@@ -688,7 +1373,11 @@ const String &ConfigManager::Domain::getDomainComment() const {
 }
 
 void ConfigManager::Domain::setKVComment(const String &key, const String &comment) {
-	_keyValueComments[key] = comment;
+	// Most keys don't have a comment, there is no need to store that
+	if (comment.empty())
+		_keyValueComments.erase(key);
+	else
+		_keyValueComments[key] = comment;
 }
 const String &ConfigManager::Domain::getKVComment(const String &key) const {
 	return _keyValueComments[key];
@@ -24,6 +24,7 @@
 #define COMMON_CONFIG_MANAGER_H
 
 #include "common/array.h"
+#include "common/atom.h"
 //#include "common/config-file.h"
 #include "common/hashmap.h"
 #include "common/singleton.h"
@@ -34,6 +35,7 @@ namespace Common {
 
 class WriteStream;
 class SeekableReadStream;
+class ConfigFlushSource;
 
 /**
  * The (singleton) configuration manager, used to query & set configuration
@@ -47,9 +49,13 @@ class ConfigManager : public Singleton<ConfigManager> {
 
 public:
 
-	class Domain : public StringMap {
+	/**
+	 * A config domain. The keys are atoms, as the same few keys are used
+	 * in all domains, and looked up over and over again.
+	 */
+	class Domain : public AtomStringMap {
 	private:
-		StringMap _keyValueComments;
+		AtomStringMap _keyValueComments;
 		String _domainComment;
 
 	public:
@@ -61,7 +67,7 @@ public:
 		bool hasKVComment(const String &key) const;
 	};
 
-	typedef HashMap<String, Domain, IgnoreCase_Hash, IgnoreCase_EqualTo> DomainMap;
+	typedef HashMap<Atom, Domain, Atom_IgnoreCase_Hash, Atom_IgnoreCase_EqualTo> DomainMap;
 
 	/** The name of the application domain (normally 'scummvm'). */
 	static const char *kApplicationDomain;
@@ -124,8 +130,36 @@ public:
 	void				registerDefault(const String &key, int value);
 	void				registerDefault(const String &key, bool value);
 
+	/**
+	 * Write the config file, and the binary snapshot of it which speeds up
+	 * loading it again. Nothing is written if the config didn't change.
+	 * Any changes delayed by scheduleFlush() are written as well.
+	 */
 	void				flushToDisk();
 
+	/**
+	 * Like flushToDisk(), but for changes which need not be on disk right
+	 * away, like the ones the backends and the GUI make on their own.
+	 * Calls which closely follow a write are coalesced: the changes are
+	 * written from the event loop once kFlushDelay milliseconds have passed
+	 * since the last write, by flushPendingChanges(), or when the
+	 * ConfigManager is destroyed.
+	 */
+	void				scheduleFlush();
+
+	/** Write the changes delayed by scheduleFlush() right away, if there are any. */
+	void				flushPendingChanges();
+
+	/**
+	 * Write the delayed changes of the config manager, if there is one.
+	 * Called by the backends before they end the process without
+	 * destroying the config manager, e.g. in OSystem::quit(). Not
+	 * called on fatal errors: error() may run on any thread, even in the
+	 * middle of loading or changing the config, so changes which were
+	 * still delayed then are lost.
+	 */
+	static void			flushBeforeQuit();
+
 	void				setActiveDomain(const String &domName);
 	Domain *			getActiveDomain() { return _activeDomain; }
 	const Domain *		getActiveDomain() const { return _activeDomain; }
@@ -142,19 +176,58 @@ public:
 	bool				hasGameDomain(const String &domName) const;
 	bool				hasMiscDomain(const String &domName) const;
 
-	const DomainMap &	getGameDomains() const { return _gameDomains; }
-	DomainMap &			getGameDomains() { return _gameDomains; }
+	const DomainMap &	getGameDomains() const { loadLazyDomains(); return _gameDomains; }
+	DomainMap &			getGameDomains() { loadLazyDomains(); return _gameDomains; }
+
+	/**
+	 * Return the names of all game domains. Unlike getGameDomains(), this
+	 * doesn't load the game domains which are still in the snapshot.
+	 */
+	Array<String>		getGameDomainNames() const;
+
+	/**
+	 * Return the value of a key in a game domain, or an empty string if
+	 * either doesn't exist. If the domain is still in the snapshot, only
+	 * this value is decoded, so listing the targets with e.g. their gameid
+	 * and description doesn't load their domains.
+	 */
+	String				getGameDomainValue(const String &domName, const String &key) const;
 
 	static void			defragment();	// move in memory to reduce fragmentation
 	void 				copyFrom(ConfigManager &source);
 	
 private:
 	friend class Singleton<SingletonBaseType>;
+	friend class ConfigFlushSource;
 	ConfigManager();
+	~ConfigManager();
+
+	enum {
+		kFlushDelay = 2000	///< Minimum time between two writes of the config file, in ms
+	};
+
+	/** Location of a game domain in the snapshot, which hasn't been loaded yet. */
+	struct LazyDomain {
+		uint32 offset;
+		uint32 size;
+	};
+
+	typedef HashMap<Atom, LazyDomain, Atom_IgnoreCase_Hash, Atom_IgnoreCase_EqualTo> LazyDomainMap;
+
+	class SnapshotWriter;
 
 	void			loadFromStream(SeekableReadStream &stream);
+	void			parseConfig(SeekableReadStream &stream);
+	bool			loadSnapshot(uint32 configSize, uint32 configStamp, const uint8 *configDigest);
+	void			loadLazyDomain(const Atom &domName) const;
+	void			loadLazyDomains() const;
+	void			freeSnapshot() const;
+	void			clearDomains();
 	void			addDomain(const Common::String &domainName, const Domain &domain);
-	void			writeDomain(WriteStream &stream, const String &name, const Domain &domain);
+	Domain &		insertGameDomain(const String &domainName);
+	void			writeToDisk();
+	void			writeDomain(WriteStream &stream, SnapshotWriter &snapshot, const String &name, const Domain &domain);
+	void			writeLazyDomain(WriteStream &stream, SnapshotWriter &snapshot, const String &name, const LazyDomain &lazy);
 	void			renameDomain(const String &oldName, const String &newName, DomainMap &map);
 
 	Domain			_transientDomain;
@@ -173,6 +246,23 @@ private:
 	Domain *		_activeDomain;
 
 	String			_filename;
+
+	// The snapshot the lazy game domains are loaded from. The domains are
+	// already in _gameDomains, but empty.
+	mutable LazyDomainMap	_lazyDomains;
+	mutable byte *	_snapshot;
+	mutable uint32	_snapshotSize;
+	mutable Array<Atom>	_snapshotKeys;
+
+	// The config file as it was last read or written
+	uint32			_diskSize;
+	uint32			_diskStamp;
+	uint8			_diskDigest[16];
+	bool			_diskValid;
+
+	uint32			_lastFlushTime;
+	bool			_flushPending;
+	ConfigFlushSource *	_flushSource;
 };
 
 }	// End of namespace Common
@@ -68,7 +68,7 @@ bool File::open(const FSNode &node) {
 		return false;
 	}
 
-	SeekableReadStream *stream = node.createReadStream();
+	SeekableReadStream *stream = node.createDataReadStream();
 	return open(stream, node.getPath());
 }
 
@@ -131,6 +131,11 @@ int32 File::size() const {
 	return _handle->size();
 }
 
+const byte *File::getView(uint32 offset, uint32 size) {
+	assert(_handle);
+	return _handle->getView(offset, size);
+}
+
 bool File::seek(int32 offs, int whence) {
 	assert(_handle);
 	return _handle->seek(offs, whence);
@@ -125,6 +125,7 @@ public:
 	int32 pos() const;	// implement abstract SeekableReadStream method
 	int32 size() const;	// implement abstract SeekableReadStream method
 	bool seek(int32 offs, int whence = SEEK_SET);	// implement abstract SeekableReadStream method
+	const byte *getView(uint32 offset, uint32 size);
 	uint32 read(void *dataPtr, uint32 dataSize);	// implement abstract SeekableReadStream method
 };
 
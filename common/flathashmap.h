@@ -0,0 +1,528 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+
+namespace Common {
+
+#if (defined(__sgi) && !defined(__GNUC__)) || defined(__INTEL_COMPILER)
+template<class T> class IteratorImpl;
+#endif
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in replacement for HashMap<Key,Val> with
+ * the same interface and the same requirements on the hash and equality
+ * functors.
+ *
+ * Instead of a table of pointers to separately allocated nodes, it stores
+ * the keys and values together with their hash in a single array, and
+ * resolves collisions by robin hood linear probing. Lookups thus touch a
+ * few neighboring entries instead of chasing pointers, most mismatches
+ * are rejected by the cached hash without calling the equality functor,
+ * and the storage can be grown without hashing the keys again. Erased
+ * entries are filled by moving their successors back, so there are no
+ * dummy nodes either.
+ *
+ * The differences to HashMap are:
+ * - Inserting or erasing an entry moves other entries and invalidates all
+ *   iterators, references and pointers into the map. In particular,
+ *   entries can't be erased while iterating over the map. Looking up a
+ *   key which is in the map, also through operator[], moves nothing.
+ * - The keys must not be changed through an iterator.
+ * - Empty entries hold default constructed keys and values, so both
+ *   should be cheap to construct.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		Key _key;
+		Val _value;
+		Node() : _key(), _value() {}
+	};
+
+	struct Entry {
+		Node _node;
+		uint _hash;
+		uint _distance;	///< Distance to the home slot plus one, 0 for empty entries
+		Entry() : _node(), _hash(0), _distance(0) {}
+	};
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage may fill up before being increased. Higher
+		// loads still work, but the probe sequences get long enough to
+		// make the lookups hard to predict.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 3,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 4
+	};
+
+	Entry *_storage;	///< hashtable of size _mask + 1
+	uint _mask;		///< Capacity of the FlatHashMap minus one; capacity is a power of two
+	uint _shift;	///< 32 minus the binary logarithm of the capacity
+	uint _size;
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Return the home slot of the given hash. Multiplying with the golden
+	 * ratio spreads hashes which only differ in their upper bits, like the
+	 * trivial ones of integers, over the whole table.
+	 */
+	uint homeSlot(uint hash) const {
+		return (uint)((uint32)(hash * 2654435769U) >> _shift) & _mask;
+	}
+
+	void allocStorage(uint capacity);
+	void assign(const HM_t &map);
+	uint lookup(const Key &key) const;
+	uint lookupAndCreateIfMissing(const Key &key);
+	void place(uint idx, uint hash, uint distance);
+	void eraseAt(uint idx);
+	void expandStorage(uint newCapacity);
+
+#if !defined(__sgi) || defined(__GNUC__)
+	template<class T> friend class IteratorImpl;
+#endif
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+#if (defined(__sgi) && !defined(__GNUC__)) || defined(__INTEL_COMPILER)
+		template<class T> friend class Common::IteratorImpl;
+#else
+		template<class T> friend class IteratorImpl;
+#endif
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		uint _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(uint idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->_storage[_idx]._distance != 0);
+			return const_cast<Node *>(&_hashmap->_storage[_idx]._node);
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && _hashmap->_storage[_idx]._distance == 0);
+			if (_idx > _hashmap->_mask)
+				_idx = (uint)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		delete[] _storage;
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	uint size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (uint ctr = 0; ctr <= _mask; ++ctr) {
+			if (_storage[ctr]._distance)
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((uint)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (uint ctr = 0; ctr <= _mask; ++ctr) {
+			if (_storage[ctr]._distance)
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((uint)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		uint ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		uint ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap()
+//
+// We have to skip _defaultVal() on PS2 to avoid gcc 3.2.2 ICE
+//
+#ifdef __PLAYSTATION2__
+	{
+#else
+	: _defaultVal() {
+#endif
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) :
+	_defaultVal() {
+	assign(map);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	delete[] _storage;
+}
+
+/**
+ * Internal method for allocating empty storage of the given capacity,
+ * which must be a power of two.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(uint capacity) {
+	assert((capacity & (capacity - 1)) == 0);
+
+	_storage = new Entry[capacity];
+	assert(_storage != NULL);
+	_mask = capacity - 1;
+	_size = 0;
+
+	_shift = 32;
+	while (capacity > 1) {
+		capacity >>= 1;
+		_shift--;
+	}
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// The layout only depends on the hashes, so the entries can simply
+	// be copied one by one.
+	for (uint ctr = 0; ctr <= _mask; ++ctr)
+		_storage[ctr] = map._storage[ctr];
+	_size = map._size;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		delete[] _storage;
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (uint ctr = 0; ctr <= _mask; ++ctr) {
+		if (_storage[ctr]._distance)
+			_storage[ctr] = Entry();
+	}
+	_size = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(uint newCapacity) {
+	assert(newCapacity > _mask+1);
+
+	const uint old_size = _size;
+	const uint old_mask = _mask;
+	Entry *old_storage = _storage;
+
+	allocStorage(newCapacity);
+
+	// Reinsert all the old entries with their cached hashes. As no key
+	// exists twice, there is no need to call _equal().
+	for (uint ctr = 0; ctr <= old_mask; ++ctr) {
+		Entry &old = old_storage[ctr];
+		if (!old._distance)
+			continue;
+
+		uint idx = homeSlot(old._hash);
+		uint distance = 1;
+		while (_storage[idx]._distance >= distance) {
+			idx = (idx + 1) & _mask;
+			distance++;
+		}
+
+		place(idx, old._hash, distance);
+		_storage[idx]._node = old._node;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+	(void)old_size;
+
+	delete[] old_storage;
+}
+
+/**
+ * Return the index of the given key, or _mask + 1 if the map doesn't
+ * contain it.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+uint FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint hash = _hash(key);
+	uint ctr = homeSlot(hash);
+
+	// The entries of a probe sequence are ordered by their distance to
+	// their home slot. Once an entry is closer to its home than the key
+	// would be, the key can't be in the map.
+	for (uint distance = 1; distance <= _storage[ctr]._distance; ++distance) {
+		const Entry &entry = _storage[ctr];
+		if (entry._hash == hash && _equal(entry._node._key, key))
+			return ctr;
+		ctr = (ctr + 1) & _mask;
+	}
+
+	return _mask + 1;
+}
+
+/**
+ * Internal method for inserting a new empty entry at the given index.
+ * All following entries up to the next empty one are moved back by one,
+ * which keeps the entries of every probe sequence ordered.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::place(uint idx, uint hash, uint distance) {
+	uint last = idx;
+	while (_storage[last]._distance)
+		last = (last + 1) & _mask;
+
+	while (last != idx) {
+		const uint prev = (last - 1) & _mask;
+		_storage[last] = _storage[prev];
+		_storage[last]._distance++;
+		last = prev;
+	}
+
+	Entry &entry = _storage[idx];
+	entry._node = Node();
+	entry._hash = hash;
+	entry._distance = distance;
+	_size++;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+uint FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const uint hash = _hash(key);
+	uint ctr = homeSlot(hash);
+	uint distance = 1;
+
+	for (; distance <= _storage[ctr]._distance; ++distance) {
+		const Entry &entry = _storage[ctr];
+		if (entry._hash == hash && _equal(entry._node._key, key))
+			return ctr;
+		ctr = (ctr + 1) & _mask;
+	}
+
+	// Keep the load factor below a certain threshold. The storage only
+	// grows when a key is inserted, and the slot is searched again then.
+	const uint capacity = _mask + 1;
+	if ((_size + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR >
+	        capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		expandStorage(capacity < 500 ? (capacity * 4) : (capacity * 2));
+
+		ctr = homeSlot(hash);
+		for (distance = 1; distance <= _storage[ctr]._distance; ++distance)
+			ctr = (ctr + 1) & _mask;
+	}
+
+	// The key goes in front of the first entry closer to its home
+	place(ctr, hash, distance);
+	_storage[ctr]._node._key = key;
+	return ctr;
+}
+
+/**
+ * Internal method for erasing the entry at the given index. All following
+ * entries which aren't in their home slot are moved forward by one.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseAt(uint idx) {
+	assert(idx <= _mask);
+	assert(_storage[idx]._distance != 0);
+
+	uint next = (idx + 1) & _mask;
+	while (_storage[next]._distance > 1) {
+		_storage[idx] = _storage[next];
+		_storage[idx]._distance--;
+		idx = next;
+		next = (next + 1) & _mask;
+	}
+
+	_storage[idx] = Entry();
+	_size--;
+}
+
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	uint ctr = lookupAndCreateIfMissing(key);
+	return _storage[ctr]._node._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	uint ctr = lookup(key);
+	if (ctr <= _mask)
+		return _storage[ctr]._node._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	uint ctr = lookupAndCreateIfMissing(key);
+	_storage[ctr]._node._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	eraseAt(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	uint ctr = lookup(key);
+	if (ctr <= _mask)
+		eraseAt(ctr);
+}
+
+}	// End of namespace Common
+
+#endif
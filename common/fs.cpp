@@ -124,6 +124,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+uint32 FSNode::getModificationStamp() const {
+	return _realNode ? _realNode->getModificationStamp() : 0;
+}
+
 Common::SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -139,6 +143,21 @@ Common::SeekableReadStream *FSNode::createReadStream() const {
 	return _realNode->createReadStream();
 }
 
+Common::SeekableReadStream *FSNode::createDataReadStream() const {
+	if (_realNode == 0)
+		return 0;
+
+	if (!_realNode->exists()) {
+		warning("FSNode::createDataReadStream: '%s' does not exist", getName().c_str());
+		return 0;
+	} else if (_realNode->isDirectory()) {
+		warning("FSNode::createDataReadStream: '%s' is a directory", getName().c_str());
+		return 0;
+	}
+
+	return _realNode->createDataReadStream();
+}
+
 Common::WriteStream *FSNode::createWriteStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -190,8 +209,15 @@ FSNode *FSDirectory::lookupCache(NodeCache &cache, const String &name) const {
 	if (!name.empty()) {
 		ensureCached();
 
-		if (cache.contains(name))
-			return &cache[name];
+		// All cached names are interned, so there is no need to look for
+		// a name which isn't
+		Atom atom;
+		if (!_atoms.findIgnoreCase(name, atom))
+			return 0;
+
+		NodeCache::iterator i = cache.find(atom);
+		if (i != cache.end())
+			return &i->_value;
 	}
 
 	return 0;
@@ -229,7 +255,7 @@ SeekableReadStream *FSDirectory::createReadStreamForMember(const String &name) c
 	FSNode *node = lookupCache(_fileCache, name);
 	if (!node)
 		return 0;
-	SeekableReadStream *stream = node->createReadStream();
+	SeekableReadStream *stream = node->createDataReadStream();
 	if (!stream)
 		warning("FSDirectory::createReadStreamForMember: Can't create stream for file '%s'", name.c_str());
 
@@ -265,23 +291,24 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String&
 		// don't touch name as it might be used for warning messages
 		String lowercaseName = name;
 		lowercaseName.toLowercase();
+		const Atom atom = _atoms.intern(lowercaseName);
 
 		// since the hashmap is case insensitive, we need to check for clashes when caching
 		if (it->isDirectory()) {
-			if (!_flat && _subDirCache.contains(lowercaseName)) {
+			if (!_flat && _subDirCache.contains(atom)) {
 				warning("FSDirectory::cacheDirectory: name clash when building cache, ignoring sub-directory '%s'", name.c_str());
 			} else {
-				if (_subDirCache.contains(lowercaseName)) {
+				if (_subDirCache.contains(atom)) {
 					warning("FSDirectory::cacheDirectory: name clash when building subDirCache with subdirectory '%s'", name.c_str());
 				}
 				cacheDirectoryRecursive(*it, depth - 1, _flat ? prefix : lowercaseName + "/");
-				_subDirCache[lowercaseName] = *it;
+				_subDirCache[atom] = *it;
 			}
 		} else {
-			if (_fileCache.contains(lowercaseName)) {
+			if (_fileCache.contains(atom)) {
 				warning("FSDirectory::cacheDirectory: name clash when building cache, ignoring file '%s'", name.c_str());
 			} else {
-				_fileCache[lowercaseName] = *it;
+				_fileCache[atom] = *it;
 			}
 		}
 	}
@@ -310,7 +337,7 @@ int FSDirectory::listMatchingMembers(ArchiveMemberList &list, const String &patt
 	int matches = 0;
 	NodeCache::iterator it = _fileCache.begin();
 	for ( ; it != _fileCache.end(); ++it) {
-		if (it->_key.matchString(lowercasePattern, false, true)) {
+		if (it->_key.getString().matchString(lowercasePattern, false, true)) {
 			list.push_back(ArchiveMemberPtr(new FSNode(it->_value)));
 			matches++;
 		}
@@ -24,6 +24,7 @@
 
 #include "common/array.h"
 #include "common/archive.h"
+#include "common/atom.h"
 #include "common/hash-str.h"
 #include "common/hashmap.h"
 #include "common/ptr.h"
@@ -205,6 +206,17 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns a value which changes whenever the file referred by this node
+	 * is written or replaced. It is only of use to compare it to another
+	 * stamp of the same file: when the stamps differ, the file changed.
+	 * Equal stamps don't guarantee that it didn't, since the stamp is only
+	 * as exact as the file system timestamps it is derived from.
+	 *
+	 * @return the modification stamp, or 0 if it is not known.
+	 */
+	uint32 getModificationStamp() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -214,6 +226,17 @@ public:
 	 */
 	virtual SeekableReadStream *createReadStream() const;
 
+	/**
+	 * Creates a SeekableReadStream instance for reading game data from the
+	 * file referred by this node. Backends may map the file into memory
+	 * instead of reading it, so this must only be used for files which are
+	 * not modified while the stream exists. Savefiles and the config file
+	 * are read through createReadStream() instead.
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	SeekableReadStream *createDataReadStream() const;
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -265,8 +288,10 @@ class FSDirectory : public Archive {
 	void setPrefix(const String &prefix);
 
 	// Caches are case insensitive, clashes are dealt with when creating
-	// Key is stored in lowercase.
-	typedef HashMap<String, FSNode, IgnoreCase_Hash, IgnoreCase_EqualTo> NodeCache;
+	// Key is stored in lowercase, and interned in _atoms, which is released
+	// together with the directory.
+	typedef HashMap<Atom, FSNode, Atom_IgnoreCase_Hash, Atom_IgnoreCase_EqualTo> NodeCache;
+	mutable AtomTable	_atoms;
 	mutable NodeCache	_fileCache, _subDirCache;
 	mutable bool _cached;
 	mutable int	_depth;
@@ -21,6 +21,7 @@
  */
 
 #include "common/memorypool.h"
+#include "common/mutex.h"
 #include "common/util.h"
 
 namespace Common {
@@ -44,6 +45,8 @@ MemoryPool::MemoryPool(size_t chunkSize)
 	: _chunkSize(adjustChunkSize(chunkSize)) {
 
 	_next = NULL;
+	_liveChunks = 0;
+	_peakChunks = 0;
 
 	_chunksPerPage = INITIAL_CHUNKS_PER_PAGE;
 }
@@ -103,10 +106,16 @@ void *MemoryPool::allocChunk() {
 	assert(_next);
 	void *result = _next;
 	_next = *(void **)result;
+
+	if (++_liveChunks > _peakChunks)
+		_peakChunks = _liveChunks;
 	return result;
 }
 
 void MemoryPool::freeChunk(void *ptr) {
+	assert(_liveChunks > 0);
+	--_liveChunks;
+
 	// Add the chunk back to (the start of) the list of free chunks
 	*(void **)ptr = _next;
 	_next = ptr;
@@ -179,5 +188,153 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+
+#pragma mark -
+
+
+SharedMemoryPool::SharedMemoryPool(size_t chunkSize, size_t magazineSize)
+	: _depot(chunkSize), _mutex(new Mutex()), _magazineSize(magazineSize), _cachedChunks(0) {
+	assert(magazineSize > 0);
+	for (int i = 0; i < kBatchSlots; ++i)
+		_batches[i] = NULL;
+}
+
+SharedMemoryPool::~SharedMemoryPool() {
+	releaseBatches();
+	delete _mutex;
+}
+
+void *SharedMemoryPool::allocChunk() {
+	StackLock lock(*_mutex);
+	return _depot.allocChunk();
+}
+
+void SharedMemoryPool::freeChunk(void *ptr) {
+	StackLock lock(*_mutex);
+	_depot.freeChunk(ptr);
+}
+
+void SharedMemoryPool::freeUnusedPages() {
+	releaseBatches();
+
+	StackLock lock(*_mutex);
+	_depot.freeUnusedPages();
+}
+
+size_t SharedMemoryPool::getLiveChunks() const {
+	StackLock lock(*_mutex);
+	return _depot.getLiveChunks() - _cachedChunks;
+}
+
+size_t SharedMemoryPool::getPeakChunks() const {
+	StackLock lock(*_mutex);
+	return _depot.getPeakChunks();
+}
+
+size_t SharedMemoryPool::getPageCount() const {
+	StackLock lock(*_mutex);
+	return _depot.getPageCount();
+}
+
+void SharedMemoryPool::refill(Magazine &magazine) {
+	// Only called for an empty magazine
+#ifdef USE_THREADS
+	// Take a batch another magazine gave back. Exchanging the slot hands
+	// the whole list over to this thread.
+	for (int i = 0; i < kBatchSlots; ++i) {
+		if (!_batches[i])
+			continue;
+
+		void *batch = __sync_lock_test_and_set(&_batches[i], (void *)NULL);
+		if (batch) {
+			__sync_fetch_and_sub(&_cachedChunks, _magazineSize);
+			magazine._chunks = batch;
+			magazine._numChunks = _magazineSize;
+			return;
+		}
+	}
+#endif
+
+	// The batch is built as a list in the depot's order, so that it is
+	// handed out the same way
+	void *chunks = NULL;
+	void **tail = &chunks;
+
+	{
+		StackLock lock(*_mutex);
+		for (size_t i = 0; i < _magazineSize; ++i) {
+			void *chunk = _depot.allocChunk();
+			*tail = chunk;
+			tail = (void **)chunk;
+		}
+	}
+
+	*tail = NULL;
+	magazine._chunks = chunks;
+	magazine._numChunks = _magazineSize;
+}
+
+void SharedMemoryPool::drain(Magazine &magazine, size_t count) {
+	assert(count <= magazine._numChunks);
+
+	// Detach the batch before taking the lock, the magazine belongs to
+	// the calling thread anyway
+	void *chunks = magazine._chunks;
+	void *last = chunks;
+	for (size_t i = 1; i < count; ++i)
+		last = *(void **)last;
+
+	magazine._chunks = *(void **)last;
+	magazine._numChunks -= count;
+	*(void **)last = NULL;
+
+#ifdef USE_THREADS
+	// Full batches are left in a free slot for the next refill(). The
+	// count goes up first, so that it never drops below the number of
+	// chunks in the slots.
+	if (count == _magazineSize) {
+		__sync_fetch_and_add(&_cachedChunks, count);
+		for (int i = 0; i < kBatchSlots; ++i) {
+			if (!_batches[i] && __sync_bool_compare_and_swap(&_batches[i], (void *)NULL, chunks))
+				return;
+		}
+		__sync_fetch_and_sub(&_cachedChunks, count);
+	}
+#endif
+
+	StackLock lock(*_mutex);
+	while (chunks) {
+		void *next = *(void **)chunks;
+		_depot.freeChunk(chunks);
+		chunks = next;
+	}
+}
+
+void SharedMemoryPool::releaseBatches() {
+#ifdef USE_THREADS
+	for (int i = 0; i < kBatchSlots; ++i) {
+		void *chunks = __sync_lock_test_and_set(&_batches[i], (void *)NULL);
+		if (!chunks)
+			continue;
+
+		StackLock lock(*_mutex);
+		while (chunks) {
+			void *next = *(void **)chunks;
+			_depot.freeChunk(chunks);
+			chunks = next;
+		}
+		__sync_fetch_and_sub(&_cachedChunks, _magazineSize);
+	}
+#endif
+}
+
+SharedMemoryPool::Magazine::Magazine(SharedMemoryPool &pool)
+	: _pool(pool), _chunks(NULL), _numChunks(0) {
+}
+
+SharedMemoryPool::Magazine::~Magazine() {
+	flush();
+}
+
 } // End of namespace Common
 
@@ -29,6 +29,8 @@
 
 namespace Common {
 
+class Mutex;
+
 /**
  * This class provides a pool of memory 'chunks' of identical size.
  * The size of a chunk is determined when creating the memory pool.
@@ -53,6 +55,8 @@ protected:
 	Array<Page>		_pages;
 	void			*_next;
 	size_t			_chunksPerPage;
+	size_t			_liveChunks;
+	size_t			_peakChunks;
 
 	void	allocPage();
 	void	addPageToPool(const Page &page);
@@ -94,6 +98,23 @@ public:
 	 * Return the chunk size used by this memory pool.
 	 */
 	size_t	getChunkSize() const { return _chunkSize; }
+
+	/**
+	 * Return the number of chunks which are currently allocated.
+	 */
+	size_t	getLiveChunks() const { return _liveChunks; }
+
+	/**
+	 * Return the highest number of chunks which were allocated at
+	 * the same time during the life time of this memory pool.
+	 */
+	size_t	getPeakChunks() const { return _peakChunks; }
+
+	/**
+	 * Return the number of pages which were obtained via malloc and
+	 * haven't been released by freeUnusedPages() yet.
+	 */
+	size_t	getPageCount() const { return _pages.size(); }
 };
 
 /**
@@ -141,6 +162,165 @@ public:
 	}
 };
 
+/**
+ * A memory pool which may be used by several threads at once.
+ *
+ * Every thread allocates and frees its chunks through its own Magazine,
+ * a small cache of free chunks which is accessed without any locking.
+ * Only when a magazine runs empty, or holds too many free chunks, a
+ * whole batch of chunks is moved between it and the shared depot.
+ *
+ * In builds with threads, full batches given back by the magazines are
+ * kept in a few slots, from which other magazines take them again. The
+ * slots are exchanged with atomic operations, so moving a batch between
+ * magazines takes no lock. The depot itself, where new batches come from
+ * and surplus ones go to, is protected by a mutex. Without threads, every
+ * batch goes through the depot. Either way, the mutex is taken at most
+ * once every magazineSize allocations or deallocations of a thread.
+ *
+ * Chunks may be freed through a different magazine than the one they
+ * were allocated from, e.g. when a decoder thread hands its buffers over
+ * to the main thread.
+ *
+ * There is no portable way to look up the magazine of the current thread,
+ * so each thread has to create (and destroy) its own. Threads without a
+ * magazine may still use allocChunk() and freeChunk() of the pool itself,
+ * which take the mutex on every call.
+ */
+class SharedMemoryPool {
+private:
+	SharedMemoryPool(const SharedMemoryPool&);
+	SharedMemoryPool& operator=(const SharedMemoryPool&);
+
+	enum {
+		kBatchSlots = 8
+	};
+
+	MemoryPool		_depot;
+	Mutex			*_mutex;
+	const size_t	_magazineSize;
+
+	/** Full batches of free chunks, exchanged without locking. */
+	void * volatile	_batches[kBatchSlots];
+	/** Number of free chunks in _batches, which left the depot. */
+	volatile size_t	_cachedChunks;
+
+public:
+	class Magazine;
+	friend class Magazine;
+
+	/**
+	 * A per thread cache of free chunks. A magazine must only be used by
+	 * a single thread, and it must be destroyed before its pool. Any free
+	 * chunks it still holds are returned to the pool at that point.
+	 */
+	class Magazine {
+		friend class SharedMemoryPool;
+
+	private:
+		Magazine(const Magazine&);
+		Magazine& operator=(const Magazine&);
+
+		SharedMemoryPool	&_pool;
+		void				*_chunks;
+		size_t				_numChunks;
+
+	public:
+		explicit Magazine(SharedMemoryPool &pool);
+		~Magazine();
+
+		/**
+		 * Allocate a new chunk. This only locks the pool when the
+		 * magazine is empty.
+		 */
+		void *allocChunk() {
+			if (!_chunks)
+				_pool.refill(*this);
+
+			void *result = _chunks;
+			_chunks = *(void **)result;
+			--_numChunks;
+			return result;
+		}
+
+		/**
+		 * Return a chunk obtained from any magazine of the same pool,
+		 * or from the pool itself. This only locks the pool when the
+		 * magazine is full.
+		 */
+		void freeChunk(void *ptr) {
+			if (_numChunks >= 2 * _pool._magazineSize)
+				_pool.drain(*this, _pool._magazineSize);
+
+			*(void **)ptr = _chunks;
+			_chunks = ptr;
+			++_numChunks;
+		}
+
+		/**
+		 * Return all free chunks held by this magazine to the pool.
+		 */
+		void flush() {
+			if (_numChunks)
+				_pool.drain(*this, _numChunks);
+		}
+
+		/**
+		 * Return the number of free chunks held by this magazine.
+		 */
+		size_t getCachedChunks() const { return _numChunks; }
+	};
+
+	/**
+	 * Constructor for a shared memory pool with the given chunk size.
+	 * @param chunkSize		the chunk size of this memory pool
+	 * @param magazineSize	the number of chunks moved between a magazine
+	 *						and the pool at once
+	 */
+	explicit SharedMemoryPool(size_t chunkSize, size_t magazineSize = 32);
+	~SharedMemoryPool();
+
+	/**
+	 * Allocate a new chunk directly from the pool, for threads without a
+	 * magazine.
+	 */
+	void	*allocChunk();
+	/**
+	 * Return a chunk directly to the pool, for threads without a magazine.
+	 */
+	void	freeChunk(void *ptr);
+	/**
+	 * Release unused pages, see MemoryPool::freeUnusedPages(). Pages
+	 * with chunks in any magazine are still considered as used; cached
+	 * batches are returned to the depot first.
+	 */
+	void	freeUnusedPages();
+
+	size_t	getChunkSize() const { return _depot.getChunkSize(); }
+
+	/**
+	 * Return the number of chunks which left the pool. This includes the
+	 * free chunks which are held by the magazines. The value is only
+	 * exact while no other thread uses the pool.
+	 */
+	size_t	getLiveChunks() const;
+	/**
+	 * Return the highest number of chunks which were out of the depot at
+	 * the same time. Unlike getLiveChunks(), this includes the cached
+	 * batches.
+	 */
+	size_t	getPeakChunks() const;
+	/**
+	 * Return the number of pages allocated by the pool.
+	 */
+	size_t	getPageCount() const;
+
+private:
+	void	refill(Magazine &magazine);
+	void	drain(Magazine &magazine, size_t count);
+	void	releaseBatches();
+};
+
 }	// End of namespace Common
 
 /**
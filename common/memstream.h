@@ -70,6 +70,10 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	const byte *getView(uint32 offset, uint32 size) {
+		return (offset <= _size && size <= _size - offset) ? _ptrOrig + offset : 0;
+	}
 };
 
 
@@ -128,7 +132,10 @@ private:
 
 		byte *old_data = _data;
 
-		_capacity = new_len + 32;
+		// Grow geometrically, or writing many small pieces gets quadratic
+		_capacity *= 2;
+		if (_capacity < new_len + 32)
+			_capacity = new_len + 32;
 		_data = (byte *)malloc(_capacity);
 		_ptr = _data + _pos;
 
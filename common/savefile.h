@@ -47,6 +47,21 @@ typedef SeekableReadStream InSaveFile;
 typedef WriteStream OutSaveFile;
 
 
+/**
+ * Receives notifications about the savefiles a SaveFileManager loads,
+ * writes and removes, for code which keeps information derived from them.
+ */
+class SaveFileListener {
+public:
+	virtual ~SaveFileListener() {}
+
+	/** Called after a savefile was opened for loading. */
+	virtual void savefileLoaded(const String &name) = 0;
+
+	/** Called before a savefile is written or removed. */
+	virtual void savefileChanged(const String &name) = 0;
+};
+
 /**
  * The SaveFileManager is serving as a factory for InSaveFile
  * and OutSaveFile objects.
@@ -65,6 +80,7 @@ class SaveFileManager : NonCopyable {
 protected:
 	Error _error;
 	String _errorDesc;
+	SaveFileListener *_listener;
 
 	/**
 	 * Set some information about the last error which occurred .
@@ -74,8 +90,15 @@ protected:
 	virtual void setError(Error error, const String &errorDesc) { _error = error; _errorDesc = errorDesc; }
 
 public:
+	SaveFileManager() : _listener(0) {}
 	virtual ~SaveFileManager() {}
 
+	/**
+	 * Sets the listener which is notified about savefiles being loaded,
+	 * written and removed. Not every save file manager sends notifications.
+	 */
+	void setListener(SaveFileListener *listener) { _listener = listener; }
+
 	/**
 	 * Clears the last set error code and string.
 	 */
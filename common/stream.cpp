@@ -23,6 +23,7 @@
 #include "common/stream.h"
 #include "common/memstream.h"
 #include "common/substream.h"
+#include "common/streamreader.h"
 #include "common/str.h"
 
 namespace Common {
@@ -493,4 +494,130 @@ WriteStream *wrapBufferedWriteStream(WriteStream *parentStream, uint32 bufSize)
 	return 0;
 }
 
+#pragma mark -
+
+StreamReader::StreamReader(SeekableReadStream &stream, uint32 bufSize)
+	: _stream(stream), _buffer(0), _bufSize(bufSize), _size(stream.size()),
+	  _windowPos(stream.pos()), _eos(false), _err(false) {
+
+	// Streams in memory are used as one big window
+	_start = _stream.getView(_windowPos, _size - _windowPos);
+	if (!_start)
+		_start = _buffer = new byte[_bufSize];
+
+	_ptr = _start;
+	_end = _buffer ? _start : _start + (_size - _windowPos);
+}
+
+StreamReader::~StreamReader() {
+	const int32 position = pos();
+	if (_stream.pos() != position)
+		_stream.seek(position, SEEK_SET);
+
+	delete[] _buffer;
+}
+
+bool StreamReader::fill(uint32 size) {
+	// Without a buffer, the window always reaches up to the end of the stream
+	if (!_buffer || size > _bufSize) {
+		_eos = true;
+		return false;
+	}
+
+	// Keep the rest of the window, and append the following data to it
+	const uint32 left = _end - _ptr;
+	memmove(_buffer, _ptr, left);
+	_windowPos = pos();
+
+	const int32 fillPos = _windowPos + left;
+	if (_stream.pos() != fillPos)
+		_stream.seek(fillPos, SEEK_SET);
+	const uint32 readSize = _stream.read(_buffer + left, _bufSize - left);
+	if (_stream.err())
+		_err = true;
+
+	_start = _ptr = _buffer;
+	_end = _buffer + left + readSize;
+
+	if (left + readSize < size) {
+		_eos = true;
+		return false;
+	}
+
+	return true;
+}
+
+bool StreamReader::seek(int32 offset, int whence) {
+	int32 target = offset;
+	if (whence == SEEK_CUR)
+		target += pos();
+	else if (whence == SEEK_END)
+		target += _size;
+
+	if (target < 0 || target > _size)
+		return false;
+
+	_eos = false;
+
+	if (target >= _windowPos && target <= _windowPos + (_end - _start)) {
+		_ptr = _start + (target - _windowPos);
+		return true;
+	}
+
+	_windowPos = target;
+
+	if (!_buffer) {
+		_start = _stream.getView(_windowPos, _size - _windowPos);
+		if (_start) {
+			_ptr = _start;
+			_end = _start + (_size - _windowPos);
+			return true;
+		}
+
+		_buffer = new byte[_bufSize];
+	}
+
+	// The window is filled on the next read
+	_start = _ptr = _end = _buffer;
+	return true;
+}
+
+uint32 StreamReader::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = (byte *)dataPtr;
+	uint32 avail = _end - _ptr;
+
+	// Small reads go through the window, larger ones directly to the stream
+	if (avail < dataSize && dataSize <= _bufSize / 2) {
+		fill(dataSize);
+		avail = _end - _ptr;
+	}
+
+	if (dataSize <= avail) {
+		memcpy(dst, _ptr, dataSize);
+		_ptr += dataSize;
+		return dataSize;
+	}
+
+	memcpy(dst, _ptr, avail);
+	_ptr += avail;
+
+	if (!_buffer || _eos) {
+		_eos = true;
+		return avail;
+	}
+
+	const int32 readPos = pos();
+	if (_stream.pos() != readPos)
+		_stream.seek(readPos, SEEK_SET);
+	const uint32 readSize = _stream.read(dst + avail, dataSize - avail);
+	if (_stream.err())
+		_err = true;
+	if (avail + readSize < dataSize)
+		_eos = true;
+
+	_windowPos = readPos + readSize;
+	_start = _ptr = _end = _buffer;
+	return avail + readSize;
+}
+
 }	// End of namespace Common
@@ -371,6 +371,33 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Returns a pointer to the stream data in the range [offset, offset+size),
+	 * without copying it. This is optional: only streams which keep their
+	 * data in memory, or map it there, support it.
+	 *
+	 * The data must not be modified, and stays valid as long as the stream
+	 * exists. The position of the stream is not changed.
+	 *
+	 * @param offset	the start of the range, relative to the stream start
+	 * @param size	the size of the range in bytes
+	 * @return a pointer to the data, or 0 if the stream doesn't support
+	 *         direct access or the range isn't inside the stream
+	 */
+	virtual const byte *getView(uint32 offset, uint32 size) { return 0; }
+
+	/**
+	 * Like getView(), for the data at the current position. If a pointer is
+	 * returned, the position is advanced past the range, like read() would.
+	 */
+	const byte *readView(uint32 size) {
+		const int32 position = pos();
+		const byte *data = (position >= 0) ? getView(position, size) : 0;
+		if (data)
+			seek(size, SEEK_CUR);
+		return data;
+	}
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -0,0 +1,161 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_STREAMREADER_H
+#define COMMON_STREAMREADER_H
+
+#include "common/endian.h"
+#include "common/noncopyable.h"
+#include "common/stream.h"
+
+namespace Common {
+
+/**
+ * A cursor for parsing many small fields out of a SeekableReadStream.
+ *
+ * The read methods of ReadStream go through the virtual read() for every
+ * field. A StreamReader instead pulls a whole window of data from the
+ * stream and decodes the fields inline from there. Streams which support
+ * SeekableReadStream::getView() are accessed directly, without copying the
+ * data into a buffer first.
+ *
+ * Records of a known size can be checked once with require(), and then be
+ * decoded with the READ_* macros from common/endian.h:
+ * @code
+ * while (const byte *entry = reader.require(6)) {
+ *     uint16 id = READ_LE_UINT16(entry);
+ *     uint32 offset = READ_LE_UINT32(entry + 2);
+ * }
+ * @endcode
+ *
+ * The reader owns the position in the stream while it exists; when it is
+ * destroyed, the stream is positioned right after the data read through it.
+ */
+class StreamReader : NonCopyable {
+public:
+	enum {
+		kDefaultBufferSize = 4096
+	};
+
+	/**
+	 * Creates a reader starting at the current position of the stream.
+	 *
+	 * @param stream	the stream to read from, must outlive the reader
+	 * @param bufSize	size of the window buffer, if the stream has to be
+	 *                  read through a buffer; no single request may be larger
+	 */
+	StreamReader(SeekableReadStream &stream, uint32 bufSize = kDefaultBufferSize);
+	~StreamReader();
+
+	/** Returns the current position, relative to the start of the stream. */
+	int32 pos() const { return _windowPos + (_ptr - _start); }
+	int32 size() const { return _size; }
+
+	/** Returns true if a read failed because the end of the stream was reached. */
+	bool eos() const { return _eos; }
+	/** Returns true if the underlying stream reported an error. */
+	bool err() const { return _err; }
+
+	/**
+	 * Changes the position like SeekableReadStream::seek(). Seeking inside
+	 * the current window does not touch the stream.
+	 */
+	bool seek(int32 offset, int whence = SEEK_SET);
+	bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
+
+	/**
+	 * Makes sure that the next size bytes are in the window, and returns
+	 * a pointer to them. The position is advanced past them.
+	 *
+	 * @return a pointer to the data, or 0 if the stream ends before, in
+	 *         which case the position is not changed and eos() is set
+	 */
+	const byte *require(uint32 size) {
+		if ((uint32)(_end - _ptr) < size && !fill(size))
+			return 0;
+
+		const byte *data = _ptr;
+		_ptr += size;
+		return data;
+	}
+
+	/**
+	 * Reads the given amount of data, like ReadStream::read(). Large reads
+	 * are passed on to the stream without going through the buffer.
+	 */
+	uint32 read(void *dataPtr, uint32 dataSize);
+
+	// The same field accessors as ReadStream. They return 0 and set eos()
+	// if the stream ends before the field.
+
+	byte readByte() {
+		const byte *data = require(1);
+		return data ? *data : 0;
+	}
+
+	uint16 readUint16LE() {
+		const byte *data = require(2);
+		return data ? READ_LE_UINT16(data) : 0;
+	}
+
+	uint32 readUint32LE() {
+		const byte *data = require(4);
+		return data ? READ_LE_UINT32(data) : 0;
+	}
+
+	uint16 readUint16BE() {
+		const byte *data = require(2);
+		return data ? READ_BE_UINT16(data) : 0;
+	}
+
+	uint32 readUint32BE() {
+		const byte *data = require(4);
+		return data ? READ_BE_UINT32(data) : 0;
+	}
+
+	int8 readSByte() { return (int8)readByte(); }
+	int16 readSint16LE() { return (int16)readUint16LE(); }
+	int32 readSint32LE() { return (int32)readUint32LE(); }
+	int16 readSint16BE() { return (int16)readUint16BE(); }
+	int32 readSint32BE() { return (int32)readUint32BE(); }
+
+private:
+	/** Moves the window so that it contains at least size bytes from the current position. */
+	bool fill(uint32 size);
+
+	SeekableReadStream &_stream;
+	byte *_buffer;
+	const uint32 _bufSize;
+	const int32 _size;
+
+	int32 _windowPos;   ///< Stream position of _start
+	const byte *_start;
+	const byte *_ptr;
+	const byte *_end;
+
+	bool _eos;
+	bool _err;
+};
+
+} // End of namespace Common
+
+#endif
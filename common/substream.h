@@ -82,6 +82,12 @@ public:
 	virtual int32 size() const { return _end - _begin; }
 
 	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+	virtual const byte *getView(uint32 offset, uint32 size) {
+		if (offset > _end - _begin || size > _end - _begin - offset)
+			return 0;
+		return _parentStream->getView(_begin + offset, size);
+	}
 };
 
 /**
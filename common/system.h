@@ -995,6 +995,35 @@ public:
 	 */
 	virtual Common::WriteStream *createConfigWriteStream() = 0;
 
+	/**
+	 * Open the binary snapshot the ConfigManager keeps of the default config
+	 * file for reading. It is stored next to the config file, and only used
+	 * to load the config faster.
+	 *
+	 * May return 0 to indicate that there is no snapshot, which is the
+	 * default.
+	 */
+	virtual Common::SeekableReadStream *createConfigCacheReadStream() { return 0; }
+
+	/**
+	 * Open the binary snapshot of the default config file for writing.
+	 *
+	 * May return 0 to indicate that the backend doesn't keep a snapshot,
+	 * which is the default.
+	 */
+	virtual Common::WriteStream *createConfigCacheWriteStream() { return 0; }
+
+	/**
+	 * Return the modification stamp of the default config file, see
+	 * Common::FSNode::getModificationStamp(). The ConfigManager uses it to
+	 * find out whether the snapshot still belongs to the config file,
+	 * without reading the file.
+	 *
+	 * May return 0 to indicate that the stamp is not known, which is the
+	 * default. The config file is hashed instead then.
+	 */
+	virtual uint32 getConfigModificationStamp() { return 0; }
+
 	/**
 	 * Logs a given message.
 	 *
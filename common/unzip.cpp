@@ -105,10 +105,103 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
 
+namespace Common {
+
+/**
+ * Stream of a ZIP archive, shared by the archive and its member streams.
+ * Those may be read from different threads, so it is only read through
+ * ZipStreamCursor, which positions and reads it under a lock.
+ */
+class ZipSharedStream : NonCopyable {
+public:
+	ZipSharedStream(SeekableReadStream *stream) : _stream(stream), _size(stream->size()) {}
+	~ZipSharedStream() { delete _stream; }
+
+	int32 size() const { return _size; }
+
+	/** Views don't depend on the position of the stream, so they need no lock. */
+	const byte *getView(uint32 offset, uint32 size) { return _stream->getView(offset, size); }
+
+	/**
+	 * Reads data from the given position.
+	 *
+	 * @param err   Set if reading failed.
+	 * @return the number of bytes read.
+	 */
+	uint32 readAt(uint32 position, void *dataPtr, uint32 dataSize, bool &err) {
+		StackLock lock(_mutex);
+		_stream->seek(position, SEEK_SET);
+		const uint32 readSize = _stream->read(dataPtr, dataSize);
+		err = _stream->err();
+		_stream->clearErr();
+		return readSize;
+	}
+
+private:
+	SeekableReadStream *_stream;
+	const int32 _size;
+	Mutex _mutex;
+};
+
+/**
+ * Reads a ZipSharedStream with its own position, so the archive and every
+ * member stream can read it independently of each other.
+ */
+class ZipStreamCursor : public SeekableReadStream {
+public:
+	ZipStreamCursor(const SharedPtr<ZipSharedStream> &shared) : _shared(shared), _pos(0), _eos(false), _err(false) {}
+
+	virtual bool err() const { return _err; }
+	virtual void clearErr() { _eos = _err = false; }
+	virtual bool eos() const { return _eos; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _shared->size(); }
+
+	virtual bool seek(int32 offset, int whence = SEEK_SET) {
+		if (whence == SEEK_CUR)
+			offset += _pos;
+		else if (whence == SEEK_END)
+			offset += size();
+
+		if (offset < 0 || offset > size())
+			return false;
+
+		_pos = offset;
+		_eos = false;
+		return true;
+	}
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		bool err;
+		const uint32 readSize = _shared->readAt(_pos, dataPtr, dataSize, err);
+		_pos += readSize;
+		if (err)
+			_err = true;
+		if (readSize < dataSize)
+			_eos = true;
+		return readSize;
+	}
+
+	virtual const byte *getView(uint32 offset, uint32 size) { return _shared->getView(offset, size); }
+
+private:
+	SharedPtr<ZipSharedStream> _shared;
+	int32 _pos;
+	bool _eos;
+	bool _err;
+};
+
+} // End of namespace Common
+
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
     from (void*) without cast */
@@ -378,7 +471,9 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 /* unz_s contain internal information about the zipfile
 */
 typedef struct {
-	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SeekableReadStream *_stream;				/* io structore of the zipfile, owned by _cursor */
+	Common::ScopedPtr<Common::ZipStreamCursor> _cursor;	/* cursor of the archive on _shared */
+	Common::SharedPtr<Common::ZipSharedStream> _shared;	/* archive stream, shared with the member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -540,7 +635,9 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 
 	int err=UNZ_OK;
 
-	us->_stream = stream;
+	us->_shared = Common::SharedPtr<Common::ZipSharedStream>(new Common::ZipSharedStream(stream));
+	us->_cursor.reset(new Common::ZipStreamCursor(us->_shared));
+	us->_stream = us->_cursor.get();
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -592,7 +689,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -641,7 +737,6 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1122,6 +1217,33 @@ int unzOpenCurrentFile (unzFile file) {
 }
 
 
+/*
+  Give the position of the data of the current file in the underlying stream,
+  without opening the file for reading.
+  If there is no error, the return value is UNZ_OK.
+*/
+static int unzGetCurrentFileDataOffset(unzFile file, uLong *poffset) {
+	uInt iSizeVar;
+	unz_s* s;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*poffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+		iSizeVar + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1416,10 +1538,302 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+#ifdef USE_ZLIB
+
+/**
+ * Inflates a deflated member while it is read.
+ *
+ * Seeking backwards would have to restart decompression at the beginning of
+ * the member, so a copy of the inflate state is kept every
+ * kCheckpointInterval bytes, from which decompression can continue instead.
+ * Each copy holds the 32 KB window of the inflater. At most kMaxCheckpoints
+ * are kept: when there would be more, every other one is dropped and the
+ * interval is doubled.
+ */
+class ZipInflateStream : public SeekableReadStream {
+public:
+	ZipInflateStream(const SharedPtr<ZipSharedStream> &zipStream, uint32 dataStart,
+	                 uint32 compressedSize, uint32 uncompressedSize, uint32 crc);
+	~ZipInflateStream();
+
+	bool init();
+
+	virtual bool err() const { return _err; }
+	virtual void clearErr();
+	virtual bool eos() const { return _eos; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _uncompressedSize; }
+	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+private:
+	enum {
+		kCheckpointInterval = 256 * 1024,
+		kMaxCheckpoints = 32
+	};
+
+	struct Checkpoint {
+		uint32 pos;       ///< Position in the uncompressed data
+		uint32 inPos;     ///< Position in the compressed data
+		z_stream stream;  ///< Copy of the inflate state, must not be moved
+	};
+
+	void fillInput();
+	void addCheckpoint();
+	bool restart(uint32 target, bool force = false);
+
+	ZipStreamCursor _zipStream;
+	const uint32 _dataStart;
+	const uint32 _compressedSize;
+	const uint32 _uncompressedSize;
+	const uint32 _crc;
+
+	z_stream _stream;
+	bool _streamInitialized;
+	byte _inBuf[UNZ_BUFSIZE];
+	uint32 _inPos;
+
+	uint32 _pos;
+	uint32 _crc32Data;
+	bool _crcValid;
+	bool _eos;
+	bool _err;
+
+	Array<Checkpoint *> _checkpoints;
+	uint32 _checkpointInterval;
+};
+
+ZipInflateStream::ZipInflateStream(const SharedPtr<ZipSharedStream> &zipStream, uint32 dataStart,
+                                   uint32 compressedSize, uint32 uncompressedSize, uint32 crc)
+	: _zipStream(zipStream), _dataStart(dataStart), _compressedSize(compressedSize),
+	  _uncompressedSize(uncompressedSize), _crc(crc), _streamInitialized(false), _inPos(0),
+	  _pos(0), _crc32Data(0), _crcValid(true), _eos(false), _err(false),
+	  _checkpointInterval(kCheckpointInterval) {
+}
+
+ZipInflateStream::~ZipInflateStream() {
+	for (uint i = 0; i < _checkpoints.size(); ++i) {
+		inflateEnd(&_checkpoints[i]->stream);
+		delete _checkpoints[i];
+	}
+
+	if (_streamInitialized)
+		inflateEnd(&_stream);
+}
+
+bool ZipInflateStream::init() {
+	_stream.zalloc = Z_NULL;
+	_stream.zfree = Z_NULL;
+	_stream.opaque = Z_NULL;
+	_stream.next_in = _inBuf;
+	_stream.avail_in = 0;
+
+	// Members are stored without zlib header, see unzOpenCurrentFile()
+	_streamInitialized = (inflateInit2(&_stream, -MAX_WBITS) == Z_OK);
+	return _streamInitialized;
+}
+
+void ZipInflateStream::fillInput() {
+	// Inflate straight from the archive data if it is in memory already
+	const byte *view = _zipStream.getView(_dataStart + _inPos, _compressedSize - _inPos);
+	if (view) {
+		_stream.next_in = const_cast<Bytef *>(view);
+		_stream.avail_in = _compressedSize - _inPos;
+		_inPos = _compressedSize;
+		return;
+	}
+
+	const uint32 size = MIN<uint32>(sizeof(_inBuf), _compressedSize - _inPos);
+
+	_zipStream.seek(_dataStart + _inPos, SEEK_SET);
+	const uint32 readSize = _zipStream.read(_inBuf, size);
+	if (readSize != size)
+		_err = true;
+
+	_inPos += readSize;
+	_stream.next_in = _inBuf;
+	_stream.avail_in = readSize;
+}
+
+void ZipInflateStream::addCheckpoint() {
+	if (_checkpoints.size() == kMaxCheckpoints) {
+		uint kept = 0;
+		for (uint i = 0; i < _checkpoints.size(); ++i) {
+			if (i & 1) {
+				inflateEnd(&_checkpoints[i]->stream);
+				delete _checkpoints[i];
+			} else {
+				_checkpoints[kept++] = _checkpoints[i];
+			}
+		}
+
+		_checkpoints.resize(kept);
+		_checkpointInterval *= 2;
+
+		if (_pos < _checkpoints.back()->pos + _checkpointInterval)
+			return;
+	}
+
+	Checkpoint *checkpoint = new Checkpoint();
+	if (inflateCopy(&checkpoint->stream, &_stream) != Z_OK) {
+		delete checkpoint;
+		return;
+	}
+
+	// The input buffer is not part of the copy, it is read again on restart
+	checkpoint->pos = _pos;
+	checkpoint->inPos = _inPos - _stream.avail_in;
+	checkpoint->stream.next_in = Z_NULL;
+	checkpoint->stream.avail_in = 0;
+	_checkpoints.push_back(checkpoint);
+}
+
+bool ZipInflateStream::restart(uint32 target, bool force) {
+	// Find the closest checkpoint before the target position
+	Checkpoint *checkpoint = 0;
+	for (uint i = 0; i < _checkpoints.size() && _checkpoints[i]->pos <= target; ++i)
+		checkpoint = _checkpoints[i];
+
+	if (!force && target >= _pos && (!checkpoint || checkpoint->pos <= _pos))
+		return true;
+
+	if (checkpoint) {
+		if (_streamInitialized)
+			inflateEnd(&_stream);
+		_streamInitialized = (inflateCopy(&_stream, &checkpoint->stream) == Z_OK);
+		if (!_streamInitialized)
+			return false;
+
+		_pos = checkpoint->pos;
+		_inPos = checkpoint->inPos;
+		_crcValid = false;
+	} else {
+		if (_streamInitialized ? inflateReset(&_stream) != Z_OK : !init())
+			return false;
+
+		_pos = 0;
+		_inPos = 0;
+		_crc32Data = 0;
+		_crcValid = true;
+	}
+
+	_stream.next_in = _inBuf;
+	_stream.avail_in = 0;
+	return true;
+}
+
+void ZipInflateStream::clearErr() {
+	_eos = false;
+	if (!_err)
+		return;
+
+	// The inflate state may be broken after an error, so decompression
+	// continues from the closest checkpoint before the current position.
+	_err = false;
+	const uint32 pos = _pos;
+	if (!restart(pos, true))
+		_err = true;
+	else
+		seek(pos);
+}
+
+bool ZipInflateStream::seek(int32 offset, int whence) {
+	int32 newPos = offset;
+	if (whence == SEEK_CUR)
+		newPos += _pos;
+	else if (whence == SEEK_END)
+		newPos += _uncompressedSize;
+
+	if (newPos < 0 || (uint32)newPos > _uncompressedSize)
+		return false;
+
+	if (_err || !restart(newPos)) {
+		_err = true;
+		return false;
+	}
+
+	// Skip to the target position by inflating the data in between
+	byte tmpBuf[1024];
+	while (!_err && _pos < (uint32)newPos)
+		read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), newPos - _pos));
+
+	_eos = false;
+	return !_err;
+}
+
+uint32 ZipInflateStream::read(void *dataPtr, uint32 dataSize) {
+	if (_err)
+		return 0;
+
+	if (dataSize > _uncompressedSize - _pos) {
+		dataSize = _uncompressedSize - _pos;
+		_eos = true;
+	}
+
+	_stream.next_out = (Bytef *)dataPtr;
+	_stream.avail_out = dataSize;
+
+	while (_stream.avail_out > 0) {
+		if (_stream.avail_in == 0 && _inPos < _compressedSize) {
+			fillInput();
+			if (_err)
+				break;
+		}
+
+		Bytef *out = _stream.next_out;
+		const int zErr = inflate(&_stream, Z_SYNC_FLUSH);
+		const uint32 outSize = _stream.next_out - out;
+
+		if (_crcValid)
+			_crc32Data = crc32(_crc32Data, out, outSize);
+		_pos += outSize;
+
+		if (zErr == Z_STREAM_END) {
+			// The member is shorter than its header claims
+			if (_stream.avail_out > 0)
+				_err = true;
+			break;
+		} else if (zErr != Z_OK) {
+			_err = true;
+			break;
+		}
+
+		const uint32 lastCheckpoint = _checkpoints.empty() ? 0 : _checkpoints.back()->pos;
+		if (_pos >= lastCheckpoint + _checkpointInterval && _pos < _uncompressedSize)
+			addCheckpoint();
+	}
+
+	if (_pos == _uncompressedSize && _crcValid) {
+		if (_crc32Data != _crc) {
+			warning("ZipInflateStream: CRC mismatch");
+			_err = true;
+		}
+		// Only check once, the data is not summed up again after seeking
+		_crcValid = false;
+	}
+
+	return dataSize - _stream.avail_out;
+}
+
+#endif // USE_ZLIB
+
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
 
+	/**
+	 * Deflated members below this size are inflated completely when they
+	 * are opened, which is cheaper than keeping an inflate state around.
+	 */
+	enum {
+		kInflateInMemoryLimit = 64 * 1024
+	};
+
+	const cached_file_in_zip *findFile(const String &name) const;
+	SeekableReadStream *inflateMember() const;
+
 public:
 	ZipArchive(unzFile zipFile);
 
@@ -1458,27 +1872,26 @@ ZipArchive::~ZipArchive() {
 	unzClose(_zipFile);
 }
 
+const cached_file_in_zip *ZipArchive::findFile(const String &name) const {
+	// The central directory was indexed by unzOpen()
+	const ZipHash &hash = ((unz_s *)_zipFile)->_hash;
+	ZipHash::const_iterator i = hash.find(name);
+	if (i == hash.end())
+		return 0;
+	return &i->_value;
+}
+
 bool ZipArchive::hasFile(const Common::String &name) {
-	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
+	return findFile(name) != 0;
 }
 
 int ZipArchive::listMembers(Common::ArchiveMemberList &list) {
-	int matches = 0;
-	int err = unzGoToFirstFile(_zipFile);
+	const ZipHash &hash = ((unz_s *)_zipFile)->_hash;
 
-	while (err == UNZ_OK) {
-		char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
-		if (unzGetCurrentFileInfo(_zipFile, NULL,
-		                          szCurrentFileName, sizeof(szCurrentFileName)-1,
-		                          NULL, 0, NULL, 0) == UNZ_OK) {
-			list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(szCurrentFileName, this)));
-			matches++;
-		}
-
-		err = unzGoToNextFile(_zipFile);
-	}
+	for (ZipHash::const_iterator i = hash.begin(); i != hash.end(); ++i)
+		list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(i->_key, this)));
 
-	return matches;
+	return hash.size();
 }
 
 ArchiveMemberPtr ZipArchive::getMember(const String &name) {
@@ -1488,10 +1901,7 @@ ArchiveMemberPtr ZipArchive::getMember(const String &name) {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
-Common::SeekableReadStream *ZipArchive::createReadStreamForMember(const Common::String &name) const {
-	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
-		return 0;
-
+SeekableReadStream *ZipArchive::inflateMember() const {
 	unz_file_info fileInfo;
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
@@ -1512,12 +1922,40 @@ Common::SeekableReadStream *ZipArchive::createReadStreamForMember(const Common::
 		return 0;
 	}
 
-	return new Common::MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+}
+
+Common::SeekableReadStream *ZipArchive::createReadStreamForMember(const Common::String &name) const {
+	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
+		return 0;
+
+	const unz_s *s = (const unz_s *)_zipFile;
+	const unz_file_info &fileInfo = s->cur_file_info;
+
+	uLong dataStart;
+	if (unzGetCurrentFileDataOffset(_zipFile, &dataStart) != UNZ_OK)
+		return 0;
+
+	// Stored members are read straight from the archive. Member streams
+	// have their own cursor on the archive stream, so they can be used at the
+	// same time, from different threads, and after the archive was closed.
+	if (fileInfo.compression_method == 0)
+		return new SeekableSubReadStream(new ZipStreamCursor(s->_shared), dataStart,
+		                                 dataStart + fileInfo.uncompressed_size, DisposeAfterUse::YES);
+
+#ifdef USE_ZLIB
+	if (fileInfo.compression_method == Z_DEFLATED && fileInfo.uncompressed_size >= kInflateInMemoryLimit) {
+		ZipInflateStream *stream = new ZipInflateStream(s->_shared, dataStart,
+			fileInfo.compressed_size, fileInfo.uncompressed_size, fileInfo.crc);
+		if (!stream->init()) {
+			delete stream;
+			return 0;
+		}
+		return stream;
+	}
+#endif
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return inflateMember();
 }
 
 Archive *makeZipArchive(const String &name) {
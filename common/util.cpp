@@ -397,7 +397,7 @@ void updateGameGUIOptions(const uint32 options, const String &langOption) {
 	if ((options && !ConfMan.hasKey("guioptions")) ||
 	    (ConfMan.hasKey("guioptions") && ConfMan.get("guioptions") != newOptionString)) {
 		ConfMan.set("guioptions", newOptionString);
-		ConfMan.flushToDisk();
+		ConfMan.scheduleFlush();
 	}
 }
 
@@ -49,6 +49,8 @@ Console::Console(AgiEngine *vm) : GUI::Debugger() {
 	DCmd_Register("setobj",     WRAP_METHOD(Console, Cmd_SetObj));
 	DCmd_Register("room",       WRAP_METHOD(Console, Cmd_Room));
 	DCmd_Register("bt",         WRAP_METHOD(Console, Cmd_BT));
+	DCmd_Register("piccache",   WRAP_METHOD(Console, Cmd_PictureCache));
+	DCmd_Register("benchpics",  WRAP_METHOD(Console, Cmd_BenchPictures));
 }
 
 bool Console::Cmd_SetVar(int argc, const char **argv) {
@@ -275,6 +277,91 @@ bool Console::Cmd_BT(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::Cmd_PictureCache(int argc, const char **argv) {
+	if (argc == 2) {
+		if (!scumm_stricmp(argv[1], "on")) {
+			_vm->_picture->enablePictureCache(true);
+		} else if (!scumm_stricmp(argv[1], "off")) {
+			_vm->_picture->enablePictureCache(false);
+		} else if (!scumm_stricmp(argv[1], "clear")) {
+			_vm->_picture->clearPictureCache();
+		} else {
+			DebugPrintf("Usage: %s [on|off|clear]\n", argv[0]);
+			return true;
+		}
+	}
+
+	const PictureMgr::CacheStatistics stats = _vm->_picture->getCacheStatistics();
+	DebugPrintf("Picture cache: %s\n", _vm->_picture->isPictureCacheEnabled() ? "on" : "off");
+	DebugPrintf("%d pictures, %d bytes, %d hits, %d misses\n", stats.entries, stats.bytes, stats.hits, stats.misses);
+
+	return true;
+}
+
+bool Console::Cmd_BenchPictures(int argc, const char **argv) {
+	if (_vm->getFeatures() & (GF_AGI256 | GF_AGI256_2)) {
+		DebugPrintf("Not supported for AGI256 games\n");
+		return true;
+	}
+
+	const int iterations = (argc == 2) ? MAX<int>(1, strtoul(argv[1], NULL, 0)) : 10;
+	const int size = _DEFAULT_WIDTH * _DEFAULT_HEIGHT;
+	PictureMgr *picture = _vm->_picture;
+	const bool cacheEnabled = picture->isPictureCacheEnabled();
+
+	// Rendering destroys the current picture, which is restored afterwards
+	uint8 *screen = (uint8 *)malloc(size);
+	uint8 *reference = (uint8 *)malloc(size);
+	memcpy(screen, _vm->_game.sbuf16c, size);
+
+	int pictures = 0, mismatches = 0;
+	uint32 renderTime = 0, cacheTime = 0;
+
+	for (int n = 0; n < MAX_DIRS; n++) {
+		if (_vm->_game.dirPic[n].offset == _EMPTY)
+			continue;
+
+		const bool loaded = (_vm->_game.dirPic[n].flags & RES_LOADED) != 0;
+		if (_vm->agiLoadResource(rPICTURE, n) != errOK)
+			continue;
+
+		pictures++;
+
+		picture->enablePictureCache(false);
+		uint32 start = g_system->getMillis();
+		for (int i = 0; i < iterations; i++)
+			picture->renderPicture(n, true);
+		renderTime += g_system->getMillis() - start;
+		memcpy(reference, _vm->_game.sbuf16c, size);
+
+		// The first rendering fills the cache, all others are cache hits
+		picture->enablePictureCache(true);
+		picture->renderPicture(n, true);
+		start = g_system->getMillis();
+		for (int i = 0; i < iterations; i++)
+			picture->renderPicture(n, true);
+		cacheTime += g_system->getMillis() - start;
+
+		if (memcmp(reference, _vm->_game.sbuf16c, size)) {
+			DebugPrintf("Picture %d differs when taken from the cache\n", n);
+			mismatches++;
+		}
+
+		if (!loaded)
+			_vm->agiUnloadResource(rPICTURE, n);
+	}
+
+	picture->enablePictureCache(cacheEnabled);
+	memcpy(_vm->_game.sbuf16c, screen, size);
+	free(screen);
+	free(reference);
+
+	DebugPrintf("Rendered %d pictures %d times each, %d mismatches\n", pictures, iterations, mismatches);
+	DebugPrintf("Decoding: %d ms, cached: %d ms\n", renderTime, cacheTime);
+
+	return true;
+}
+
 PreAGI_Console::PreAGI_Console(PreAgiEngine *vm) {
 	_vm = vm;
 }
@@ -62,6 +62,8 @@ private:
 	bool Cmd_Cont(int argc, const char **argv);
 	bool Cmd_Room(int argc, const char **argv);
 	bool Cmd_BT(int argc, const char **argv);
+	bool Cmd_PictureCache(int argc, const char **argv);
+	bool Cmd_BenchPictures(int argc, const char **argv);
 
 private:
 	AgiEngine *_vm;
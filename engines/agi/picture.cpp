@@ -41,6 +41,14 @@ PictureMgr::PictureMgr(AgiBase *agi, GfxMgr *gfx) {
 	_minCommand = 0xf0;
 	_flags = 0;
 	_currentStep = 0;
+
+	_cacheEnabled = true;
+	_cacheClock = 0;
+	_cacheHits = _cacheMisses = 0;
+}
+
+PictureMgr::~PictureMgr() {
+	clearPictureCache();
 }
 
 void PictureMgr::putVirtPixel(int x, int y) {
@@ -227,17 +235,7 @@ void PictureMgr::absoluteDrawLine() {
 /**************************************************************************
 ** okToFill
 **************************************************************************/
-int PictureMgr::isOkFillHere(int x, int y) {
-	uint8 p;
-
-	x += _xOffset;
-	y += _yOffset;
-
-	if (x < 0 || x >= _width || y < 0 || y >= _height)
-		return false;
-
-	p = _vm->_game.sbuf16c[y * _width + x];
-
+bool PictureMgr::isOkFillColor(uint8 p) const {
 	if (_flags & kPicFTrollMode)
 		return ((p & 0x0f) != 11 && (p & 0x0f) != _scrColor);
 
@@ -257,42 +255,68 @@ void PictureMgr::agiFill(unsigned int x, unsigned int y) {
 	if (!_scrOn && !_priOn)
 		return;
 
+	x += _xOffset;
+	y += _yOffset;
+
+	if (x >= (unsigned int)_width || y >= (unsigned int)_height)
+		return;
+
+	// Whether a pixel can be filled and what it turns into only depends on
+	// its value, so both are looked up in tables while scanning the spans.
+	// Pixels which would still be fillable after being filled (possible in
+	// Troll's Tale, which only fills priority) are skipped, since the fill
+	// wouldn't terminate otherwise.
+	uint8 fillable[256];
+	uint8 filled[256];
+
+	for (int p = 0; p < 256; p++) {
+		filled[p] = p;
+		if (_priOn)
+			filled[p] = (_priColor << 4) | (filled[p] & 0x0f);
+		if (_scrOn)
+			filled[p] = _scrColor | (filled[p] & 0xf0);
+	}
+
+	for (int p = 0; p < 256; p++)
+		fillable[p] = isOkFillColor(p) && !isOkFillColor(filled[p]);
+
+	uint8 *buffer = _vm->_game.sbuf16c;
+
 	// Push initial pixel on the stack
 	Common::Stack<Common::Point> stack;
-	stack.push(Common::Point(x,y));
+	stack.push(Common::Point(x, y));
 
 	// Exit if stack is empty
 	while (!stack.empty()) {
 		Common::Point p = stack.pop();
-		unsigned int c;
-		int newspanUp, newspanDown;
+		uint8 *line = buffer + p.y * _width;
 
-		if (!isOkFillHere(p.x, p.y))
+		if (!fillable[line[p.x]])
 			continue;
 
-		// Scan for left border
-		for (c = p.x - 1; isOkFillHere(c, p.y); c--)
-			;
-
-		newspanUp = newspanDown = 1;
-		for (c++; isOkFillHere(c, p.y); c++) {
-			putVirtPixel(c, p.y);
-			if (isOkFillHere(c, p.y - 1)) {
-				if (newspanUp) {
-					stack.push(Common::Point(c,p.y-1));
-					newspanUp = 0;
+		// Scan for the borders and fill the whole span
+		int left = p.x, right = p.x;
+		while (left > 0 && fillable[line[left - 1]])
+			left--;
+		while (right < _width - 1 && fillable[line[right + 1]])
+			right++;
+
+		for (int c = left; c <= right; c++)
+			line[c] = filled[line[c]];
+
+		// Push one seed for every fillable span above and below
+		for (int dy = -1; dy <= 1; dy += 2) {
+			const int ny = p.y + dy;
+			if (ny < 0 || ny >= _height)
+				continue;
+
+			const uint8 *next = buffer + ny * _width;
+			for (int c = left; c <= right; c++) {
+				if (fillable[next[c]]) {
+					stack.push(Common::Point(c, ny));
+					while (c < right && fillable[next[c + 1]])
+						c++;
 				}
-			} else {
-				newspanUp = 1;
-			}
-
-			if (isOkFillHere(c, p.y + 1)) {
-				if (newspanDown) {
-					stack.push(Common::Point(c,p.y+1));
-					newspanDown = 0;
-				}
-			} else {
-				newspanDown = 1;
 			}
 		}
 	}
@@ -796,36 +820,42 @@ uint8 *PictureMgr::convertV3Pic(uint8 *src, uint32 len) {
 }
 
 /**
- * Decode an AGI picture resource.
- * This function decodes an AGI picture resource into the correct slot
- * and draws it on the AGI screen, optionally clearing the screen before
- * drawing.
- * @param n      AGI picture resource number
- * @param clear  clear AGI screen before drawing
- * @param agi256 load an AGI256 picture resource
+ * Set up the picture data to be drawn, and reset the drawing state.
+ * @param data   the AGI Picture data
+ * @param length the size of the picture data buffer
  */
-int PictureMgr::decodePicture(int n, int clr, bool agi256, int pic_width, int pic_height) {
-	debugC(8, kDebugLevelResources, "(%d)", n);
-
+void PictureMgr::setupPicture(byte *data, uint32 length, int pic_width, int pic_height) {
 	_patCode = 0;
 	_patNum = 0;
 	_priOn = _scrOn = false;
 	_scrColor = 0xF;
 	_priColor = 0x4;
 
-	_data = _vm->_game.pictures[n].rdata;
-	_flen = _vm->_game.dirPic[n].len;
+	_data = data;
+	_flen = length;
 	_foffs = 0;
 
 	_width = pic_width;
 	_height = pic_height;
+}
 
-	if (clr && !agi256) // 256 color pictures should always fill the whole screen, so no clearing for them.
-		memset(_vm->_game.sbuf16c, 0x4f, _width * _height); // Clear 16 color AGI screen (Priority 4, color white).
+/**
+ * Decode an AGI picture resource.
+ * This function decodes an AGI picture resource into the correct slot
+ * and draws it on the AGI screen, optionally clearing the screen before
+ * drawing.
+ * @param n      AGI picture resource number
+ * @param clear  clear AGI screen before drawing
+ * @param agi256 load an AGI256 picture resource
+ */
+int PictureMgr::decodePicture(int n, int clr, bool agi256, int pic_width, int pic_height) {
+	debugC(8, kDebugLevelResources, "(%d)", n);
 
 	if (!agi256) {
-		drawPicture(); // Draw 16 color picture.
+		renderPicture(n, clr, pic_width, pic_height); // Draw 16 color picture.
 	} else {
+		setupPicture(_vm->_game.pictures[n].rdata, _vm->_game.dirPic[n].len, pic_width, pic_height);
+
 		const uint32 maxFlen = _width * _height;
 		memcpy(_vm->_game.sbuf256c, _data, MIN(_flen, maxFlen)); // Draw 256 color picture.
 
@@ -843,6 +873,32 @@ int PictureMgr::decodePicture(int n, int clr, bool agi256, int pic_width, int pi
 	return errOK;
 }
 
+/**
+ * Render a 16 color AGI picture resource into the AGI screen buffer.
+ * Unlike decodePicture(), the picture isn't recorded on the image stack.
+ * Pictures drawn on a cleared screen are taken from and added to the
+ * picture cache, overlays are always drawn on top of the current screen.
+ * @param n      AGI picture resource number
+ * @param clear  clear AGI screen before drawing
+ */
+void PictureMgr::renderPicture(int n, bool clr, int pic_width, int pic_height) {
+	setupPicture(_vm->_game.pictures[n].rdata, _vm->_game.dirPic[n].len, pic_width, pic_height);
+
+	// The Mickey crystal animation stops drawing halfway, so it can't be cached
+	const bool cacheable = clr && _cacheEnabled && !(_flags & kPicFStep);
+
+	if (cacheable && restoreCachedPicture(n))
+		return;
+
+	if (clr)
+		memset(_vm->_game.sbuf16c, 0x4f, _width * _height); // Clear 16 color AGI screen (Priority 4, color white).
+
+	drawPicture();
+
+	if (cacheable)
+		storeCachedPicture(n);
+}
+
 /**
  * Decode an AGI picture resource.
  * This function decodes an AGI picture resource into the correct slot
@@ -853,18 +909,7 @@ int PictureMgr::decodePicture(int n, int clr, bool agi256, int pic_width, int pi
  * @param clear  clear AGI screen before drawing
  */
 int PictureMgr::decodePicture(byte* data, uint32 length, int clr, int pic_width, int pic_height) {
-	_patCode = 0;
-	_patNum = 0;
-	_priOn = _scrOn = false;
-	_scrColor = 0xF;
-	_priColor = 0x4;
-
-	_data = data;
-	_flen = length;
-	_foffs = 0;
-
-	_width = pic_width;
-	_height = pic_height;
+	setupPicture(data, length, pic_width, pic_height);
 
 	if (clr) // 256 color pictures should always fill the whole screen, so no clearing for them.
 		memset(_vm->_game.sbuf16c, 0x4f, _width * _height); // Clear 16 color AGI screen (Priority 4, color white).
@@ -894,6 +939,83 @@ void PictureMgr::clear() {
 	memset(_vm->_game.sbuf16c, 0x4f, _width * _height);
 }
 
+uint32 PictureMgr::cacheKey(int n) const {
+	return (n & 0xffff) | (_pictureVersion << 16) | ((_flags & 0xff) << 24);
+}
+
+bool PictureMgr::restoreCachedPicture(int n) {
+	PictureCache::iterator i = _cache.find(cacheKey(n));
+
+	if (i == _cache.end() || i->_value.flen != _flen ||
+		i->_value.width != _width || i->_value.height != _height) {
+		_cacheMisses++;
+		return false;
+	}
+
+	memcpy(_vm->_game.sbuf16c, i->_value.buffer, _width * _height);
+	i->_value.lastUse = ++_cacheClock;
+	_cacheHits++;
+	return true;
+}
+
+void PictureMgr::storeCachedPicture(int n) {
+	const uint32 key = cacheKey(n);
+	const uint32 size = _width * _height;
+
+	PictureCache::iterator i = _cache.find(key);
+	if (i != _cache.end()) {
+		free(i->_value.buffer);
+		_cache.erase(i);
+	} else if (_cache.size() >= kMaxCachedPictures) {
+		// Evict the least recently used picture
+		PictureCache::iterator oldest = _cache.begin();
+		for (i = _cache.begin(); i != _cache.end(); ++i) {
+			if (i->_value.lastUse < oldest->_value.lastUse)
+				oldest = i;
+		}
+
+		free(oldest->_value.buffer);
+		_cache.erase(oldest);
+	}
+
+	CachedPicture entry;
+	entry.buffer = (uint8 *)malloc(size);
+	if (!entry.buffer)
+		return;
+
+	memcpy(entry.buffer, _vm->_game.sbuf16c, size);
+	entry.flen = _flen;
+	entry.width = _width;
+	entry.height = _height;
+	entry.lastUse = ++_cacheClock;
+	_cache[key] = entry;
+}
+
+void PictureMgr::enablePictureCache(bool enable) {
+	_cacheEnabled = enable;
+	if (!enable)
+		clearPictureCache();
+}
+
+void PictureMgr::clearPictureCache() {
+	for (PictureCache::iterator i = _cache.begin(); i != _cache.end(); ++i)
+		free(i->_value.buffer);
+	_cache.clear();
+}
+
+PictureMgr::CacheStatistics PictureMgr::getCacheStatistics() const {
+	CacheStatistics stats;
+	stats.hits = _cacheHits;
+	stats.misses = _cacheMisses;
+	stats.entries = _cache.size();
+	stats.bytes = 0;
+
+	for (PictureCache::const_iterator i = _cache.begin(); i != _cache.end(); ++i)
+		stats.bytes += i->_value.width * i->_value.height;
+
+	return stats;
+}
+
 /**
  * Show AGI picture.
  * This function copies a ``hidden'' AGI picture to the output device.
@@ -23,6 +23,8 @@
 #ifndef AGI_PICTURE_H
 #define AGI_PICTURE_H
 
+#include "common/hashmap.h"
+
 namespace Agi {
 
 #define _DEFAULT_WIDTH		160
@@ -65,7 +67,7 @@ private:
 	void drawLine(int x1, int y1, int x2, int y2);
 	void dynamicDrawLine();
 	void absoluteDrawLine();
-	int isOkFillHere(int x, int y);
+	bool isOkFillColor(uint8 p) const;
 	void agiFill(unsigned int x, unsigned int y);
 	void xCorner(bool skipOtherCoords = false);
 	void yCorner(bool skipOtherCoords = false);
@@ -75,14 +77,22 @@ private:
 
 	uint8 nextByte() { return _data[_foffs++]; }
 
+	void setupPicture(byte *data, uint32 length, int pic_width, int pic_height);
+
+	uint32 cacheKey(int n) const;
+	bool restoreCachedPicture(int n);
+	void storeCachedPicture(int n);
+
 public:
 	PictureMgr(AgiBase *agi, GfxMgr *gfx);
+	~PictureMgr();
 
 	void putVirtPixel(int x, int y);
 
 	int decodePicture(int n, int clear, bool agi256 = false, int pic_width = _DEFAULT_WIDTH, int pic_height = _DEFAULT_HEIGHT);
 	int decodePicture(byte* data, uint32 length, int clear, int pic_width = _DEFAULT_WIDTH, int pic_height = _DEFAULT_HEIGHT);
 	int unloadPicture(int);
+	void renderPicture(int n, bool clr, int pic_width = _DEFAULT_WIDTH, int pic_height = _DEFAULT_HEIGHT);
 	void drawPicture();
 	void showPic(int x = 0, int y = 0, int pic_width = _DEFAULT_WIDTH, int pic_height = _DEFAULT_HEIGHT);
 	uint8 *convertV3Pic(uint8 *src, uint32 len);
@@ -98,6 +108,21 @@ public:
 
 	void clear();
 
+	/**
+	 * Statistics of the cache of rendered pictures.
+	 */
+	struct CacheStatistics {
+		uint32 hits;
+		uint32 misses;
+		uint32 entries;
+		uint32 bytes;
+	};
+
+	void enablePictureCache(bool enable);
+	bool isPictureCacheEnabled() const { return _cacheEnabled; }
+	void clearPictureCache();
+	CacheStatistics getCacheStatistics() const;
+
 	void setOffset(int offX, int offY) {
 		_xOffset = offX;
 		_yOffset = offY;
@@ -135,6 +160,30 @@ private:
 
 	int _flags;
 	int _currentStep;
+
+	/**
+	 * Picture rendered on a cleared screen buffer. Pictures only depend on
+	 * their data and the drawing mode, so revisiting a room just copies the
+	 * finished visual and priority planes back.
+	 */
+	struct CachedPicture {
+		uint8 *buffer;
+		uint32 flen;
+		int width, height;
+		uint32 lastUse;
+	};
+
+	enum {
+		kMaxCachedPictures = 32
+	};
+
+	typedef Common::HashMap<uint32, CachedPicture> PictureCache;
+
+	PictureCache _cache;
+	bool _cacheEnabled;
+	uint32 _cacheClock;
+	uint32 _cacheHits;
+	uint32 _cacheMisses;
 };
 
 } // End of namespace Agi
@@ -216,6 +216,13 @@ AGOSEngine::AGOSEngine(OSystem *system, const AGOSGameDescription *gd)
 	_dumpVgaOpcodes = false;
 	_dumpImages = false;
 
+	_imageCacheEnabled = true;
+	_imageCacheSize = 0;
+	_imageCacheClock = 0;
+	_imageCacheHits = 0;
+	_imageCacheMisses = 0;
+	_imageCacheDecodeTime = 0;
+
 	_copyProtection = false;
 	_pause = false;
 	_speech = false;
@@ -871,6 +878,8 @@ void AGOSEngine::setupGame() {
 AGOSEngine::~AGOSEngine() {
 	_system->getAudioCDManager()->stop();
 
+	clearImageCache();
+
 	for (uint i = 0; i < _itemHeap.size(); i++) {
 		delete[] _itemHeap[i];
 	}
@@ -27,6 +27,7 @@
 
 #include "common/array.h"
 #include "common/error.h"
+#include "common/hashmap.h"
 #include "common/keyboard.h"
 #include "common/random.h"
 #include "common/rect.h"
@@ -141,6 +142,40 @@ struct AnimTable {
 	AnimTable() { memset(this, 0, sizeof(*this)); }
 };
 
+/**
+ * A compressed image decoded into 8 bit pixels, kept in the image cache.
+ * For every row, the runs of non transparent pixels are stored as pairs of
+ * start and length, starting at runs[rowRuns[y]] and ending before
+ * runs[rowRuns[y + 1]].
+ */
+struct DecodedImage {
+	byte *pixels;
+	uint16 width, height;
+	uint32 *rowRuns;
+	uint16 *runs;
+	uint32 size;
+	uint32 lastUse;
+	DecodedImage() { memset(this, 0, sizeof(*this)); }
+};
+
+struct DecodedImageKey {
+	const byte *src;
+	uint16 palette;
+	bool flip;
+};
+
+struct DecodedImageKey_Hash {
+	uint operator()(const DecodedImageKey &key) const {
+		return (uint)((size_t)key.src * 31 + key.palette * 2 + key.flip);
+	}
+};
+
+struct DecodedImageKey_EqualTo {
+	bool operator()(const DecodedImageKey &a, const DecodedImageKey &b) const {
+		return a.src == b.src && a.palette == b.palette && a.flip == b.flip;
+	}
+};
+
 enum SIMONGameType {
 	GType_PN = 0,
 	GType_ELVIRA1 = 1,
@@ -321,6 +356,15 @@ protected:
 	bool _dumpVgaScripts;
 	bool _dumpVgaOpcodes;
 	bool _dumpImages;
+
+	typedef Common::HashMap<DecodedImageKey, DecodedImage, DecodedImageKey_Hash, DecodedImageKey_EqualTo> ImageCache;
+	ImageCache _imageCache;
+	bool _imageCacheEnabled;
+	uint32 _imageCacheSize;
+	uint32 _imageCacheClock;
+	uint32 _imageCacheHits;
+	uint32 _imageCacheMisses;
+	uint32 _imageCacheDecodeTime;
 	bool _speech;
 	bool _subtitles;
 	bool _vgaVar9;
@@ -1124,6 +1168,13 @@ protected:
 	void drawVertImageCompressed(VC10_state *state);
 	void drawVertImageUncompressed(VC10_state *state);
 
+	const DecodedImage *getDecodedImage(VC10_state *state, bool fourBit);
+	const byte *getUncompressedFlip(const byte *src, uint16 w, uint16 h);
+	void drawDecodedImage(const DecodedImage *image, byte *dst, uint pitch, uint x, uint y, uint w, uint h, bool nonTrans);
+	DecodedImage &insertDecodedImage(const DecodedImageKey &key, uint32 size);
+	void invalidateImageCache(const byte *start, const byte *end);
+	void clearImageCache();
+
 	void setMoveRect(uint16 x, uint16 y, uint16 width, uint16 height);
 
 	void horizontalScroll(VC10_state *state);
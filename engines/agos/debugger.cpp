@@ -46,6 +46,7 @@ Debugger::Debugger(AGOSEngine *vm)
 	DCmd_Register("sub",      WRAP_METHOD(Debugger, Cmd_StartSubroutine));
 	DCmd_Register("dumpimage",      WRAP_METHOD(Debugger, Cmd_dumpImage));
 	DCmd_Register("dumpscript",     WRAP_METHOD(Debugger, Cmd_dumpScript));
+	DCmd_Register("imagecache",     WRAP_METHOD(Debugger, Cmd_ImageCache));
 
 }
 
@@ -286,5 +287,33 @@ bool Debugger::Cmd_dumpScript(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::Cmd_ImageCache(int argc, const char **argv) {
+	if (argc > 1) {
+		if (!strcmp(argv[1], "on")) {
+			_vm->_imageCacheEnabled = true;
+		} else if (!strcmp(argv[1], "off")) {
+			_vm->_imageCacheEnabled = false;
+			_vm->clearImageCache();
+		} else if (!strcmp(argv[1], "clear")) {
+			_vm->clearImageCache();
+			_vm->_imageCacheHits = 0;
+			_vm->_imageCacheMisses = 0;
+			_vm->_imageCacheDecodeTime = 0;
+		} else {
+			DebugPrintf("Syntax: imagecache [on|off|clear]\n");
+			return true;
+		}
+	}
+
+	const uint32 lookups = _vm->_imageCacheHits + _vm->_imageCacheMisses;
+	DebugPrintf("Image cache is %s\n", _vm->_imageCacheEnabled ? "on" : "off");
+	DebugPrintf("%d images, %d bytes\n", _vm->_imageCache.size(), _vm->_imageCacheSize);
+	DebugPrintf("%d hits, %d misses, hit rate %d%%\n", _vm->_imageCacheHits, _vm->_imageCacheMisses,
+		lookups ? _vm->_imageCacheHits * 100 / lookups : 0);
+	DebugPrintf("%d ms spent decoding\n", _vm->_imageCacheDecodeTime);
+
+	return true;
+}
+
 } // End of namespace AGOS
 
@@ -49,6 +49,7 @@ private:
 	bool Cmd_StartSubroutine(int argc, const char **argv);
 	bool Cmd_dumpImage(int argc, const char **argv);
 	bool Cmd_dumpScript(int argc, const char **argv);
+	bool Cmd_ImageCache(int argc, const char **argv);
 };
 
 } // End of namespace AGOS
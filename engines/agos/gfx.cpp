@@ -294,6 +294,8 @@ void AGOSEngine_Feeble::drawImage(VC10_state *state) {
 	state->surf_pitch = _backBuf->pitch;
 
 	if (state->flags & kDFCompressed) {
+		const DecodedImage *image = _imageCacheEnabled ? getDecodedImage(state, false) : 0;
+
 		if (state->flags & kDFScaled) {
 			state->surf_addr = getScaleBuf();
 			state->surf_pitch = _scaleBuf->pitch;
@@ -304,20 +306,24 @@ void AGOSEngine_Feeble::drawImage(VC10_state *state) {
 			state->dl = state->width;
 			state->dh = state->height;
 
-			dstPtr = state->surf_addr;
-			w = 0;
-			do {
-				src = vc10_depackColumn(state);
-				dst = dstPtr;
-
-				h = 0;
+			if (image) {
+				drawDecodedImage(image, state->surf_addr, state->surf_pitch, 0, 0, state->draw_width, state->draw_height, true);
+			} else {
+				dstPtr = state->surf_addr;
+				w = 0;
 				do {
-					*dst = *src;
-					dst += state->surf_pitch;
-					src++;
-				} while (++h != state->draw_height);
-				dstPtr++;
-			} while (++w != state->draw_width);
+					src = vc10_depackColumn(state);
+					dst = dstPtr;
+
+					h = 0;
+					do {
+						*dst = *src;
+						dst += state->surf_pitch;
+						src++;
+					} while (++h != state->draw_height);
+					dstPtr++;
+				} while (++w != state->draw_width);
+			}
 
 			if (_vgaCurSpritePriority % 10 != 9) {
 				_scaleX = state->x;
@@ -338,24 +344,28 @@ void AGOSEngine_Feeble::drawImage(VC10_state *state) {
 			state->dl = state->width;
 			state->dh = state->height;
 
-			dstPtr = state->surf_addr;
-			w = 0;
-			do {
-				byte color;
+			if (image) {
+				drawDecodedImage(image, state->surf_addr, state->surf_pitch, 0, 0, state->draw_width, state->draw_height, false);
+			} else {
+				dstPtr = state->surf_addr;
+				w = 0;
+				do {
+					byte color;
 
-				src = vc10_depackColumn(state);
-				dst = dstPtr;
+					src = vc10_depackColumn(state);
+					dst = dstPtr;
 
-				h = 0;
-				do {
-					color = *src;
-					if (color != 0)
-						*dst = color;
-					dst += state->surf_pitch;
-					src++;
-				} while (++h != state->draw_height);
-				dstPtr++;
-			} while (++w != state->draw_width);
+					h = 0;
+					do {
+						color = *src;
+						if (color != 0)
+							*dst = color;
+						dst += state->surf_pitch;
+						src++;
+					} while (++h != state->draw_height);
+					dstPtr++;
+				} while (++w != state->draw_width);
+			}
 
 			if (_vgaCurSpritePriority % 10 == 9) {
 				scaleClip(_scaleHeight, _scaleWidth, _scaleY, _scaleX, _scaleY + _scrollY);
@@ -370,6 +380,28 @@ void AGOSEngine_Feeble::drawImage(VC10_state *state) {
 			uint w, h;
 			byte *src, *dst, *dstPtr;
 
+			if ((state->flags & kDFMasked) && getGameType() == GType_FF && !getBitFlag(81)) {
+				if (state->x > _feebleRect.right) {
+					return;
+				}
+				if (state->y > _feebleRect.bottom) {
+					return;
+				}
+				if (state->x + state->width < _feebleRect.left) {
+					return;
+				}
+				if (state->y + state->height < _feebleRect.top) {
+					return;
+				}
+			}
+
+			if (image) {
+				const bool nonTrans = !(state->flags & kDFMasked) && (state->flags & kDFNonTrans);
+				drawDecodedImage(image, state->surf_addr, state->surf_pitch, state->x_skip, state->y_skip,
+					state->draw_width, state->draw_height, nonTrans);
+				return;
+			}
+
 			state->dl = state->width;
 			state->dh = state->height;
 
@@ -377,21 +409,6 @@ void AGOSEngine_Feeble::drawImage(VC10_state *state) {
 
 
 			if (state->flags & kDFMasked) {
-				if (getGameType() == GType_FF && !getBitFlag(81)) {
-					if (state->x > _feebleRect.right) {
-						return;
-					}
-					if (state->y > _feebleRect.bottom) {
-						return;
-					}
-					if (state->x + state->width < _feebleRect.left) {
-						return;
-					}
-					if (state->y + state->height < _feebleRect.top) {
-						return;
-					}
-				}
-
 				dstPtr = state->surf_addr;
 				w = 0;
 				do {
@@ -767,6 +784,210 @@ void AGOSEngine::drawBackGroundImage(VC10_state *state) {
 	} while (--h);
 }
 
+enum {
+	kImageCacheBudget = 2 * 1024 * 1024,
+	kImageCacheBudgetAGOS2 = 8 * 1024 * 1024
+};
+
+DecodedImage &AGOSEngine::insertDecodedImage(const DecodedImageKey &key, uint32 size) {
+	const uint32 budget = (getGameType() == GType_FF || getGameType() == GType_PP) ? kImageCacheBudgetAGOS2 : kImageCacheBudget;
+
+	// Drop the least recently drawn images until the new one fits
+	while (!_imageCache.empty() && _imageCacheSize + size > budget) {
+		ImageCache::iterator oldest = _imageCache.begin();
+		for (ImageCache::iterator i = _imageCache.begin(); i != _imageCache.end(); ++i) {
+			if (i->_value.lastUse < oldest->_value.lastUse)
+				oldest = i;
+		}
+
+		_imageCacheSize -= oldest->_value.size;
+		free(oldest->_value.pixels);
+		free(oldest->_value.rowRuns);
+		_imageCache.erase(oldest);
+	}
+
+	DecodedImage &image = _imageCache[key];
+	image = DecodedImage();
+	image.size = size;
+	image.lastUse = ++_imageCacheClock;
+	_imageCacheSize += size;
+	return image;
+}
+
+const DecodedImage *AGOSEngine::getDecodedImage(VC10_state *state, bool fourBit) {
+	DecodedImageKey key;
+	key.src = state->srcPtr;
+	key.palette = fourBit ? state->palette : 0;
+	key.flip = false;
+
+	ImageCache::iterator i = _imageCache.find(key);
+	if (i != _imageCache.end()) {
+		_imageCacheHits++;
+		i->_value.lastUse = ++_imageCacheClock;
+		return &i->_value;
+	}
+
+	// The columns are depacked into the state, which limits their height
+	if (state->height > sizeof(state->depack_dest))
+		return 0;
+
+	_imageCacheMisses++;
+	const uint32 startTime = _system->getMillis();
+
+	const uint columns = fourBit ? state->width * 8 : state->width;
+	const uint width = fourBit ? columns * 2 : columns;
+	const uint height = state->height;
+
+	byte *pixels = (byte *)malloc(width * height);
+	byte *opaque = (byte *)malloc(width * height);
+
+	VC10_state vs;
+	vs.srcPtr = state->srcPtr;
+	vs.depack_cont = -0x80;
+	vs.dh = height;
+
+	for (uint x = 0; x < columns; x++) {
+		const byte *src = vc10_depackColumn(&vs);
+		if (fourBit) {
+			for (uint y = 0; y < height; y++) {
+				const uint pos = y * width + x * 2;
+				pixels[pos] = (src[y] / 16) | state->palette;
+				pixels[pos + 1] = (src[y] & 15) | state->palette;
+				opaque[pos] = (src[y] / 16) != 0;
+				opaque[pos + 1] = (src[y] & 15) != 0;
+			}
+		} else {
+			for (uint y = 0; y < height; y++) {
+				pixels[y * width + x] = src[y];
+				opaque[y * width + x] = src[y] != 0;
+			}
+		}
+	}
+
+	Common::Array<uint16> runs;
+	uint32 *rowRuns = (uint32 *)malloc((height + 1) * sizeof(uint32));
+	for (uint y = 0; y < height; y++) {
+		const byte *row = opaque + y * width;
+		rowRuns[y] = runs.size();
+
+		uint x = 0;
+		while (x < width) {
+			if (!row[x]) {
+				x++;
+				continue;
+			}
+
+			const uint start = x;
+			while (x < width && row[x])
+				x++;
+			runs.push_back(start);
+			runs.push_back(x - start);
+		}
+	}
+	rowRuns[height] = runs.size();
+	free(opaque);
+
+	// The runs are kept in the same allocation as the row index
+	rowRuns = (uint32 *)realloc(rowRuns, (height + 1) * sizeof(uint32) + runs.size() * sizeof(uint16));
+	uint16 *runPtr = (uint16 *)(rowRuns + height + 1);
+	if (!runs.empty())
+		memcpy(runPtr, &runs.front(), runs.size() * sizeof(uint16));
+
+	DecodedImage &image = insertDecodedImage(key, width * height + (height + 1) * sizeof(uint32) + runs.size() * sizeof(uint16));
+	image.pixels = pixels;
+	image.width = width;
+	image.height = height;
+	image.rowRuns = rowRuns;
+	image.runs = runPtr;
+
+	_imageCacheDecodeTime += _system->getMillis() - startTime;
+	return &image;
+}
+
+const byte *AGOSEngine::getUncompressedFlip(const byte *src, uint16 w, uint16 h) {
+	DecodedImageKey key;
+	key.src = src;
+	key.palette = 0;
+	key.flip = true;
+
+	ImageCache::iterator i = _imageCache.find(key);
+	if (i != _imageCache.end()) {
+		_imageCacheHits++;
+		i->_value.lastUse = ++_imageCacheClock;
+		return i->_value.pixels;
+	}
+
+	_imageCacheMisses++;
+	const uint32 startTime = _system->getMillis();
+
+	// Flipped images stay packed, they are drawn like uncompressed ones
+	const uint32 size = w * 8 * h;
+	byte *pixels = (byte *)malloc(size);
+	memcpy(pixels, vc10_uncompressFlip(src, w, h), size);
+
+	DecodedImage &image = insertDecodedImage(key, size);
+	image.pixels = pixels;
+	image.width = w * 8;
+	image.height = h;
+
+	_imageCacheDecodeTime += _system->getMillis() - startTime;
+	return pixels;
+}
+
+void AGOSEngine::drawDecodedImage(const DecodedImage *image, byte *dst, uint pitch, uint x, uint y, uint w, uint h, bool nonTrans) {
+	const byte *src = image->pixels + y * image->width;
+
+	if (nonTrans) {
+		for (uint row = 0; row < h; row++) {
+			memcpy(dst, src + x, w);
+			dst += pitch;
+			src += image->width;
+		}
+		return;
+	}
+
+	const uint right = x + w;
+	for (uint row = y; row < y + h; row++) {
+		const uint16 *run = image->runs + image->rowRuns[row];
+		const uint16 *end = image->runs + image->rowRuns[row + 1];
+
+		for (; run != end; run += 2) {
+			const uint start = MAX<uint>(run[0], x);
+			const uint stop = MIN<uint>(run[0] + run[1], right);
+			if (start < stop)
+				memcpy(dst + start - x, src + start, stop - start);
+		}
+
+		dst += pitch;
+		src += image->width;
+	}
+}
+
+void AGOSEngine::invalidateImageCache(const byte *start, const byte *end) {
+	Common::Array<DecodedImageKey> stale;
+	for (ImageCache::iterator i = _imageCache.begin(); i != _imageCache.end(); ++i) {
+		if (i->_key.src >= start && i->_key.src < end)
+			stale.push_back(i->_key);
+	}
+
+	for (uint i = 0; i < stale.size(); i++) {
+		DecodedImage &image = _imageCache[stale[i]];
+		_imageCacheSize -= image.size;
+		free(image.pixels);
+		free(image.rowRuns);
+		_imageCache.erase(stale[i]);
+	}
+}
+
+void AGOSEngine::clearImageCache() {
+	for (ImageCache::iterator i = _imageCache.begin(); i != _imageCache.end(); ++i) {
+		free(i->_value.pixels);
+		free(i->_value.rowRuns);
+	}
+	_imageCache.clear();
+	_imageCacheSize = 0;
+}
+
 void AGOSEngine::drawVertImage(VC10_state *state) {
 	if (state->flags & kDFCompressed) {
 		drawVertImageCompressed(state);
@@ -807,15 +1028,25 @@ void AGOSEngine::drawVertImageCompressed(VC10_state *state) {
 
 	state->x_skip *= 4;				/* reached */
 
+	byte *dstPtr = state->surf_addr;
+	if (!(state->flags & kDFNonTrans) && (state->flags & 0x40)) { /* reached */
+		dstPtr += vcReadVar(252);
+	}
+
+	if (_imageCacheEnabled) {
+		const DecodedImage *image = getDecodedImage(state, true);
+		if (image) {
+			drawDecodedImage(image, dstPtr, state->surf_pitch, state->x_skip * 2, state->y_skip,
+				state->draw_width * 2, state->draw_height, (state->flags & kDFNonTrans) != 0);
+			return;
+		}
+	}
+
 	state->dl = state->width;
 	state->dh = state->height;
 
 	vc10_skip_cols(state);
 
-	byte *dstPtr = state->surf_addr;
-	if (!(state->flags & kDFNonTrans) && (state->flags & 0x40)) { /* reached */
-		dstPtr += vcReadVar(252);
-	}
 	w = 0;
 	do {
 		byte color;
@@ -779,6 +779,9 @@ void AGOSEngine::decompressPN(Common::Stack<uint32> &dataList, uint8 *&dataOut,
 void AGOSEngine::loadVGABeardFile(uint16 id) {
 	uint32 offs, size;
 
+	// The beard images are loaded over the ones of an existing zone
+	clearImageCache();
+
 	if (getFeatures() & GF_OLD_BUNDLE) {
 		Common::File in;
 		char filename[15];
@@ -700,7 +700,10 @@ void AGOSEngine::drawImage_init(int16 image, uint16 palette, int16 x, int16 y, u
 
 	if (getGameType() != GType_FF && getGameType() != GType_PP) {
 		if (state.flags & kDFCompressedFlip) {
-			state.srcPtr = vc10_uncompressFlip(state.srcPtr, width, height);
+			if (_imageCacheEnabled)
+				state.srcPtr = getUncompressedFlip(state.srcPtr, width, height);
+			else
+				state.srcPtr = vc10_uncompressFlip(state.srcPtr, width, height);
 		} else if (state.flags & kDFFlip) {
 			state.srcPtr = vc10_flip(state.srcPtr, width, height);
 		}
@@ -135,6 +135,7 @@ byte *AGOSEngine::allocBlock(uint32 size) {
 			if (_rejectBlock)
 				continue;
 			checkZonePtrs();
+			invalidateImageCache(_block, _blockEnd);
 			_vgaMemPtr = _blockEnd;
 			return _block;
 		}
@@ -52,6 +52,7 @@ bool Infogrames::loadSong(const char *fileName) {
 
 	_song = new Audio::Infogrames(*_instruments, true,
 			_mixer->getOutputRate(), _mixer->getOutputRate() / 75);
+	_song->setInterpolation(Audio::Paula::getConfiguredInterpolation());
 
 	if (!_song->load(fileName)) {
 		warning("Infogrames: Couldn't load music \"%s\"", fileName);
@@ -20,6 +20,13 @@
  *
  */
 
+// The SSE2 intrinsics pull in system headers, so they have to be included
+// before common/scummsys.h enables the forbidden symbol checks.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GOB_SURFACE_SSE2
+#endif
+
 #include "gob/surface.h"
 
 #include "common/system.h"
@@ -400,6 +407,143 @@ bool Surface::clipBlitRect(int16 &left, int16 &top, int16 &right, int16 &bottom,
 	return true;
 }
 
+/** Copy a row of pixels, skipping those with the transparent color. */
+template<typename P>
+static inline void blitRowTransp(P *dst, const P *src, uint16 width, P transp) {
+	for (uint16 i = 0; i < width; i++, dst++, src++)
+		if (*src != transp)
+			*dst = *src;
+}
+
+#ifdef GOB_SURFACE_SSE2
+
+template<>
+inline void blitRowTransp<byte>(byte *dst, const byte *src, uint16 width, byte transp) {
+	const __m128i key = _mm_set1_epi8((char) transp);
+
+	for (; width >= 16; width -= 16, dst += 16, src += 16) {
+		const __m128i s = _mm_loadu_si128((const __m128i *) src);
+		const __m128i d = _mm_loadu_si128((const __m128i *) dst);
+		const __m128i mask = _mm_cmpeq_epi8(s, key);
+
+		_mm_storeu_si128((__m128i *) dst, _mm_or_si128(_mm_and_si128(mask, d), _mm_andnot_si128(mask, s)));
+	}
+
+	for (; width > 0; width--, dst++, src++)
+		if (*src != transp)
+			*dst = *src;
+}
+
+template<>
+inline void blitRowTransp<uint16>(uint16 *dst, const uint16 *src, uint16 width, uint16 transp) {
+	const __m128i key = _mm_set1_epi16((short) transp);
+
+	for (; width >= 8; width -= 8, dst += 8, src += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *) src);
+		const __m128i d = _mm_loadu_si128((const __m128i *) dst);
+		const __m128i mask = _mm_cmpeq_epi16(s, key);
+
+		_mm_storeu_si128((__m128i *) dst, _mm_or_si128(_mm_and_si128(mask, d), _mm_andnot_si128(mask, s)));
+	}
+
+	for (; width > 0; width--, dst++, src++)
+		if (*src != transp)
+			*dst = *src;
+}
+
+#endif // GOB_SURFACE_SSE2
+
+template<typename P>
+static void blitTransp(byte *dst, const byte *src, uint16 width, uint16 height,
+		uint32 dstPitch, uint32 srcPitch, uint32 transp, bool overlap) {
+
+	if (overlap) {
+		// Source and destination are the same surface, so keep the plain
+		// pixel by pixel copy order
+		for (; height > 0; height--, dst += dstPitch, src += srcPitch) {
+			P *d = (P *) dst;
+			const P *s = (const P *) src;
+
+			for (uint16 i = 0; i < width; i++, d++, s++)
+				if (*s != (P) transp)
+					*d = *s;
+		}
+
+		return;
+	}
+
+	for (; height > 0; height--, dst += dstPitch, src += srcPitch)
+		blitRowTransp<P>((P *) dst, (const P *) src, width, (P) transp);
+}
+
+/**
+ * Scale a block of pixels, stepping through the source by the inverse scale
+ * in fixed point, just like the original per pixel loop did. Destination
+ * rows which map to the same source row are copied from the previous one.
+ */
+template<typename P>
+static void blitScaledRows(byte *dst, const byte *src, uint16 width, uint16 height,
+		uint32 dstPitch, uint32 srcPitch, frac_t step) {
+
+	// Source column of each destination column
+	uint16 *columns = new uint16[width];
+
+	if (((frac_t) FRAC_ONE % step) == 0) {
+		// Integer scale factor, every source pixel is repeated exactly n times
+		const uint16 n = FRAC_ONE / step;
+		for (uint16 i = 0; i < width; i++)
+			columns[i] = i / n;
+	} else {
+		frac_t posW = 0;
+		uint16 column = 0;
+		for (uint16 i = 0; i < width; i++) {
+			columns[i] = column;
+
+			posW += step;
+			while (posW >= ((frac_t) FRAC_ONE)) {
+				column++;
+				posW -= FRAC_ONE;
+			}
+		}
+	}
+
+	frac_t posH = 0;
+	const byte *prevRow = 0;
+	while (height-- > 0) {
+		if (prevRow) {
+			memcpy(dst, prevRow, width * sizeof(P));
+		} else {
+			P *d = (P *) dst;
+			const P *s = (const P *) src;
+
+			for (uint16 i = 0; i < width; i++)
+				d[i] = s[columns[i]];
+		}
+
+		prevRow = dst;
+
+		posH += step;
+		while (posH >= ((frac_t) FRAC_ONE)) {
+			src += srcPitch;
+			posH -= FRAC_ONE;
+			prevRow = 0;
+		}
+
+		dst += dstPitch;
+	}
+
+	delete[] columns;
+}
+
+template<typename P>
+static void fillRows(byte *dst, uint16 width, uint16 height, uint32 pitch, uint32 color) {
+	for (; height > 0; height--, dst += pitch) {
+		P *d = (P *) dst;
+		for (uint16 i = 0; i < width; i++)
+			d[i] = (P) color;
+	}
+}
+
 void Surface::blit(const Surface &from, int16 left, int16 top, int16 right, int16 bottom,
 		int16 x, int16 y, int32 transp) {
 
@@ -449,20 +593,13 @@ void Surface::blit(const Surface &from, int16 left, int16 top, int16 right, int1
 	// Otherwise, we have to copy by pixel
 
 	// Pointers to the blit destination and source start points
-	     Pixel dst =      get(x   , y);
-	ConstPixel src = from.get(left, top);
-
-	while (height-- > 0) {
-		     Pixel dstRow = dst;
-		ConstPixel srcRow = src;
-
-		for (uint16 i = 0; i < width; i++, dstRow++, srcRow++)
-			if (srcRow.get() != ((uint32) transp))
-				dstRow.set(srcRow.get());
+	      byte *dst =      getData(x   , y);
+	const byte *src = from.getData(left, top);
 
-		dst +=      _width;
-		src += from._width;
-	}
+	if (_bpp == 1)
+		blitTransp<byte>  (dst, src, width, height, _width, from._width, transp, &from == this);
+	else
+		blitTransp<uint16>(dst, src, width, height, _width * 2, from._width * 2, transp, &from == this);
 }
 
 void Surface::blit(const Surface &from, int16 x, int16 y, int32 transp) {
@@ -511,33 +648,13 @@ void Surface::blitScaled(const Surface &from, int16 left, int16 top, int16 right
 	const byte *src = from.getData(left, top);
 
 	frac_t step = scale.getInverse().toFrac();
+	if (step <= 0)
+		return;
 
-	frac_t posW = 0, posH = 0;
-	while (height-- > 0) {
-		      byte *dstRow = dst;
-		const byte *srcRow = src;
-
-		posW = 0;
-
-		for (uint16 i = 0; i < width; i++, dstRow += _bpp) {
-			memmove(dstRow, srcRow, _bpp);
-
-			posW += step;
-			while (posW >= ((frac_t) FRAC_ONE)) {
-				srcRow += from._bpp;
-				posW   -= FRAC_ONE;
-			}
-		}
-
-		posH += step;
-		while (posH >= ((frac_t) FRAC_ONE)) {
-			src  += from._width * from._bpp;
-			posH -= FRAC_ONE;
-		}
-
-		dst += _width * _bpp;
-	}
-
+	if (_bpp == 1)
+		blitScaledRows<byte>  (dst, src, width, height, _width, from._width, step);
+	else
+		blitScaledRows<uint16>(dst, src, width, height, _width * 2, from._width * 2, step);
 }
 
 void Surface::blitScaled(const Surface &from, int16 x, int16 y, Common::Rational scale, int32 transp) {
@@ -592,14 +709,7 @@ void Surface::fillRect(uint16 left, uint16 top, uint16 right, uint16 bottom, uin
 	assert(_bpp == 2);
 
 	// Otherwise, we have to fill by pixel
-
-	Pixel p = get(left, top);
-	while (height-- > 0) {
-		for (uint16 i = 0; i < width; i++, ++p)
-			p.set(color);
-
-		p += _width - width;
-	}
+	fillRows<uint16>(getData(left, top), width, height, _width * 2, color);
 }
 
 void Surface::fill(uint32 color) {
@@ -653,21 +763,28 @@ void Surface::shadeRect(uint16 left, uint16 top, uint16 right, uint16 bottom,
 	int shadeG = cG * (16 - strength);
 	int shadeB = cB * (16 - strength);
 
-	Pixel p = get(left, top);
+	// Every component is shaded independently, so the shaded and already
+	// shifted components can be looked up for each of their values
+	uint16 tableR[256], tableG[256], tableB[256];
+	for (int i = 0; i < 256; i++) {
+		tableR[i] = pixelFormat.RGBToColor(CLIP<int>((shadeR + strength * i) >> 4, 0, 255), 0, 0);
+		tableG[i] = pixelFormat.RGBToColor(0, CLIP<int>((shadeG + strength * i) >> 4, 0, 255), 0);
+		tableB[i] = pixelFormat.RGBToColor(0, 0, CLIP<int>((shadeB + strength * i) >> 4, 0, 255));
+	}
+
+	byte *dst = getData(left, top);
 	while (height-- > 0) {
-		for (uint16 i = 0; i < width; i++, ++p) {
-			uint8 r, g, b;
+		uint16 *p = (uint16 *) dst;
 
-			pixelFormat.colorToRGB(p.get(), r, g, b);
+		for (uint16 i = 0; i < width; i++, p++) {
+			uint8 r, g, b;
 
-			r = CLIP<int>((shadeR + strength * r) >> 4, 0, 255);
-			g = CLIP<int>((shadeG + strength * g) >> 4, 0, 255);
-			b = CLIP<int>((shadeB + strength * b) >> 4, 0, 255);
+			pixelFormat.colorToRGB(*p, r, g, b);
 
-			p.set(pixelFormat.RGBToColor(r, g, b));
+			*p = tableR[r] | tableG[g] | tableB[b];
 		}
 
-		p += _width - width;
+		dst += _width * 2;
 	}
 
 }
@@ -45,6 +45,7 @@ Debugger::Debugger(KyraEngine_v1 *vm)
 	DCmd_Register("queryflag",			WRAP_METHOD(Debugger, cmd_queryFlag));
 	DCmd_Register("timers",				WRAP_METHOD(Debugger, cmd_listTimers));
 	DCmd_Register("settimercountdown",	WRAP_METHOD(Debugger, cmd_setTimerCountdown));
+	DCmd_Register("shape_kernels",		WRAP_METHOD(Debugger, cmd_checkShapeKernels));
 }
 
 bool Debugger::cmd_setScreenDebug(int argc, const char **argv) {
@@ -185,6 +186,133 @@ bool Debugger::cmd_setTimerCountdown(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmd_checkShapeKernels(int argc, const char **argv) {
+	Screen *screen = _vm->screen();
+
+	if (argc > 1 && scumm_stricmp(argv[1], "check")) {
+		if (!scumm_stricmp(argv[1], "enable"))
+			screen->enableShapeKernels(true);
+		else if (!scumm_stricmp(argv[1], "disable"))
+			screen->enableShapeKernels(false);
+		else
+			DebugPrintf("Use shape_kernels <enable/disable/check>\n");
+		return true;
+	} else if (argc <= 1) {
+		DebugPrintf("Shape kernels are %s.\n", screen->queryShapeKernels() ? "enabled" : "disabled");
+		DebugPrintf("Use shape_kernels <enable/disable/check>, check compares them with the generic plotters.\n");
+		return true;
+	}
+
+	// Draws random shapes in all combinations the kernels handle, once with
+	// the kernels and once with the generic plotters, and compares the pages.
+	const int page = 10;
+	const int pageSize = Screen::SCREEN_W * Screen::SCREEN_H;
+	uint8 *backup = new uint8[pageSize];
+	uint8 *reference = new uint8[pageSize];
+	uint8 *shape = new uint8[12 + 100 * 200];
+	uint8 *shapeColorTable = new uint8[28 + 100 * 200];
+	uint8 *background = new uint8[pageSize];
+	uint8 table[256];
+	const uint8 *pagePtr = screen->getCPagePtr(page);
+	memcpy(backup, pagePtr, pageSize);
+
+	const bool kernelsEnabled = screen->queryShapeKernels();
+	const int headerSize = _vm->gameFlags().useAltShapeHeader ? 2 : 0;
+	uint32 seed = 1;
+	int draws = 0, mismatches = 0;
+
+	for (int i = 0; i < pageSize; ++i)
+		background[i] = (i * 31) >> 3;
+	for (int i = 0; i < 256; ++i)
+		table[i] = (i * 7 + 3) & 0xff;
+	table[5] = table[77] = 0;
+
+	for (int n = 0; n < 64; ++n) {
+		seed = seed * 1103515245 + 12345;
+		const int width = 1 + (seed >> 16) % 100;
+		seed = seed * 1103515245 + 12345;
+		const int height = 1 + (seed >> 16) % 100;
+
+		// Uncompressed shape without color table, lines are runs of opaque
+		// pixels and transparent gaps
+		uint8 *dst = shape;
+		memset(dst, 0, headerSize + 10);
+		dst += headerSize;
+		WRITE_LE_UINT16(dst, 2);
+		dst[2] = height;
+		WRITE_LE_UINT16(dst + 3, width);
+		dst += 10;
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width;) {
+				seed = seed * 1103515245 + 12345;
+				int run = 1 + (seed >> 16) % MIN(width - x, 40);
+				if ((seed >> 8) & 1) {
+					for (int i = 0; i < run; ++i)
+						*dst++ = 1 + ((seed >> 12) + i * 13) % 255;
+				} else {
+					*dst++ = 0;
+					*dst++ = run;
+				}
+				x += run;
+			}
+		}
+		WRITE_LE_UINT16(shape + headerSize + 8, dst - shape - headerSize - 10);
+
+		// Plot type 4 is used with shapes which contain a color table
+		memcpy(shapeColorTable, shape, headerSize + 10);
+		shapeColorTable[headerSize] |= 1;
+		for (int i = 0; i < 16; ++i)
+			shapeColorTable[headerSize + 10 + i] = i * 3;
+		memcpy(shapeColorTable + headerSize + 26, shape + headerSize + 10, dst - shape - headerSize - 10);
+
+		for (int flags = 0; flags < 8; ++flags) {
+			for (int plotType = 0; plotType < 3; ++plotType) {
+				seed = seed * 1103515245 + 12345;
+				const int x = (int)((seed >> 16) % 400) - 60;
+				const int y = (int)((seed >> 8) % 260) - 30;
+				const int scaleW = 0x20 + (seed >> 4) % 0x200;
+				const int scaleH = 0x20 + (seed >> 20) % 0x200;
+
+				for (int pass = 0; pass < 2; ++pass) {
+					screen->copyBlockToPage(page, 0, 0, Screen::SCREEN_W, Screen::SCREEN_H, background);
+
+					screen->enableShapeKernels(pass == 1);
+
+					if (plotType == 0)
+						screen->drawShape(page, shape, x, y, 0, flags, scaleW, scaleH);
+					else if (plotType == 1)
+						screen->drawShape(page, shape, x, y, 0, flags | 0x100, table, 2, scaleW, scaleH);
+					else
+						screen->drawShape(page, shapeColorTable, x, y, 0, flags | 0x8000, table, scaleW, scaleH);
+
+					if (pass == 0)
+						memcpy(reference, pagePtr, pageSize);
+				}
+
+				++draws;
+				if (memcmp(reference, pagePtr, pageSize)) {
+					++mismatches;
+					DebugPrintf("Mismatch: shape %dx%d at %d,%d flags 0x%.2X plot type %d scale 0x%X,0x%X\n",
+						width, height, x, y, flags, plotType == 2 ? 4 : plotType, scaleW, scaleH);
+				}
+			}
+		}
+	}
+
+	screen->enableShapeKernels(kernelsEnabled);
+	screen->copyBlockToPage(page, 0, 0, Screen::SCREEN_W, Screen::SCREEN_H, backup);
+
+	delete[] backup;
+	delete[] background;
+	delete[] reference;
+	delete[] shape;
+	delete[] shapeColorTable;
+
+	DebugPrintf("%d shapes drawn, %d mismatches\n", draws, mismatches);
+	return true;
+}
+
 #pragma mark -
 
 Debugger_LoK::Debugger_LoK(KyraEngine_LoK *vm)
@@ -46,6 +46,7 @@ Screen::Screen(KyraEngine_v1 *vm, OSystem *system)
 	_drawShapeVar3 = 1;
 	_drawShapeVar4 = 0;
 	_drawShapeVar5 = 0;
+	_dsUseKernels = true;
 
 	memset(_fonts, 0, sizeof(_fonts));
 
@@ -1365,6 +1366,22 @@ void Screen::drawShape(uint8 pageNum, const uint8 *shapeData, int x, int y, int
 		0
 	};
 
+#define KERNELS(plotType) \
+		&Screen::drawShapeProcessLineNoScaleKernel<false, plotType>, \
+		&Screen::drawShapeProcessLineNoScaleKernel<true, plotType>, \
+		&Screen::drawShapeProcessLineNoScaleKernel<false, plotType>, \
+		&Screen::drawShapeProcessLineNoScaleKernel<true, plotType>, \
+		&Screen::drawShapeProcessLineScaleKernel<false, plotType>, \
+		&Screen::drawShapeProcessLineScaleKernel<true, plotType>, \
+		&Screen::drawShapeProcessLineScaleKernel<false, plotType>, \
+		&Screen::drawShapeProcessLineScaleKernel<true, plotType>
+
+	static const DsLineFunc dsLineKernelPlot0[] = { KERNELS(0) };
+	static const DsLineFunc dsLineKernelPlot1[] = { KERNELS(1) };
+	static const DsLineFunc dsLineKernelPlot4[] = { KERNELS(4) };
+
+#undef KERNELS
+
 	int scaleCounterV = 0;
 
 	const int drawFunc = flags & 0x0f;
@@ -1373,6 +1390,18 @@ void Screen::drawShape(uint8 pageNum, const uint8 *shapeData, int x, int y, int
 	_dsProcessLine = dsLineFunc[drawFunc];
 
 	const int ppc = (flags >> 8) & 0x3F;
+
+	// The most common plot types have line kernels which don't call the
+	// plotter for every pixel. They can't be used when the plotter changes
+	// from line to line.
+	if (_dsUseKernels && !(flags & 0x800) && drawFunc < ARRAYSIZE(dsLineKernelPlot0)) {
+		if (ppc == 0)
+			_dsProcessLine = dsLineKernelPlot0[drawFunc];
+		else if (ppc == 1)
+			_dsProcessLine = dsLineKernelPlot1[drawFunc];
+		else if (ppc == 4)
+			_dsProcessLine = dsLineKernelPlot4[drawFunc];
+	}
 	_dsPlot = dsPlotFunc[ppc];
 	DsPlotFunc dsPlot2 = dsPlotFunc[ppc], dsPlot3 = dsPlotFunc[ppc];
 	if (flags & 0x800)
@@ -1791,6 +1820,97 @@ void Screen::drawShapeProcessLineScaleDownwind(uint8 *&dst, const uint8 *&src, i
 	cnt = -1;
 }
 
+template<int plotType>
+inline void Screen::drawShapePlotKernel(uint8 *dst, uint8 cmd) {
+	switch (plotType) {
+	case 0:
+		*dst = cmd;
+		break;
+
+	case 1:
+		for (int i = 0; i < _dsTableLoopCount; ++i)
+			cmd = _dsTable[cmd];
+		if (cmd)
+			*dst = cmd;
+		break;
+
+	case 4:
+		*dst = _dsTable2[cmd];
+		break;
+	}
+}
+
+template<bool downwind, int plotType>
+void Screen::drawShapeProcessLineNoScaleKernel(uint8 *&dst, const uint8 *&src, int &cnt, int16) {
+	do {
+		if (*src) {
+			// Process the whole run of opaque pixels at once
+			int run = 1;
+			while (run < cnt && src[run])
+				++run;
+
+			if (plotType == 0 && !downwind) {
+				memcpy(dst, src, run);
+				dst += run;
+			} else {
+				for (int i = 0; i < run; ++i) {
+					drawShapePlotKernel<plotType>(dst, src[i]);
+					dst += downwind ? -1 : 1;
+				}
+			}
+
+			src += run;
+			cnt -= run;
+		} else {
+			uint8 c = src[1];
+			src += 2;
+			dst += downwind ? -c : c;
+			cnt -= c;
+		}
+	} while (cnt > 0);
+}
+
+template<bool downwind, int plotType>
+void Screen::drawShapeProcessLineScaleKernel(uint8 *&dst, const uint8 *&src, int &cnt, int16 scaleState) {
+	int c = 0;
+
+	do {
+		if ((scaleState & 0x8000) || !(scaleState & 0xFF00)) {
+			c = *src++;
+			_dsTmpWidth--;
+			if (c) {
+				scaleState += _dsScaleW;
+			} else {
+				_dsTmpWidth++;
+				c = *src++;
+				_dsTmpWidth -= c;
+				int r = c * _dsScaleW + scaleState;
+				dst += downwind ? -(r >> 8) : (r >> 8);
+				cnt -= (r >> 8);
+				scaleState = r & 0xff;
+			}
+		} else {
+			// Plot all repetitions of the pixel at once
+			const int run = MIN<int>(scaleState >> 8, cnt);
+
+			if (plotType == 0) {
+				memset(downwind ? dst - run + 1 : dst, c, run);
+				dst += downwind ? -run : run;
+			} else {
+				for (int i = 0; i < run; ++i) {
+					drawShapePlotKernel<plotType>(dst, c);
+					dst += downwind ? -1 : 1;
+				}
+			}
+
+			scaleState -= run << 8;
+			cnt -= run;
+		}
+	} while (cnt > 0);
+
+	cnt = -1;
+}
+
 void Screen::drawShapePlotType0(uint8 *dst, uint8 cmd) {
 	*dst = cmd;
 }
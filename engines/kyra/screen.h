@@ -348,6 +348,11 @@ public:
 	bool queryScreenDebug() const { return _debugEnabled; }
 	bool enableScreenDebug(bool enable);
 
+	// Specialized line kernels of drawShape, can be disabled to compare
+	// their output with the generic plotters
+	bool queryShapeKernels() const { return _dsUseKernels; }
+	void enableShapeKernels(bool enable) { _dsUseKernels = enable; }
+
 	// page cur. functions
 	int setCurPage(int pageNum);
 	void clearCurPage();
@@ -557,6 +562,14 @@ protected:
 	void drawShapeProcessLineScaleUpwind(uint8 *&dst, const uint8 *&src, int &cnt, int16 scaleState);
 	void drawShapeProcessLineScaleDownwind(uint8 *&dst, const uint8 *&src, int &cnt, int16 scaleState);
 
+	// Line processing with the plotter inlined, used for the most common plot types
+	template<bool downwind, int plotType>
+	void drawShapeProcessLineNoScaleKernel(uint8 *&dst, const uint8 *&src, int &cnt, int16 scaleState);
+	template<bool downwind, int plotType>
+	void drawShapeProcessLineScaleKernel(uint8 *&dst, const uint8 *&src, int &cnt, int16 scaleState);
+	template<int plotType>
+	void drawShapePlotKernel(uint8 *dst, uint8 cmd);
+
 	void drawShapePlotType0(uint8 *dst, uint8 cmd);
 	void drawShapePlotType1(uint8 *dst, uint8 cmd);
 	void drawShapePlotType3_7(uint8 *dst, uint8 cmd);
@@ -585,6 +598,7 @@ protected:
 	DsMarginSkipFunc _dsScaleSkip;
 	DsLineFunc _dsProcessLine;
 	DsPlotFunc _dsPlot;
+	bool _dsUseKernels;
 
 	const uint8 *_dsTable;
 	int _dsTableLoopCount;
@@ -46,6 +46,7 @@ SoundAmiga::~SoundAmiga() {
 
 bool SoundAmiga::init() {
 	_driver = new Audio::MaxTrax(_mixer->getOutputRate(), true);
+	_driver->setInterpolation(Audio::Paula::getConfiguredInterpolation());
 
 	_tableSfxIntro = _vm->staticres()->loadAmigaSfxTable(k1AmigaIntroSFXTable, _tableSfxIntro_Size);
 	_tableSfxGame = _vm->staticres()->loadAmigaSfxTable(k1AmigaGameSFXTable, _tableSfxGame_Size);
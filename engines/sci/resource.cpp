@@ -25,6 +25,8 @@
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/ptr.h"
+#include "common/streamreader.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
@@ -1578,24 +1580,30 @@ void ResourceManager::readResourcePatches() {
 }
 
 int ResourceManager::readResourceMapSCI0(ResourceSource *map) {
-	Common::SeekableReadStream *fileStream = 0;
+	Common::ScopedPtr<Common::SeekableReadStream> fileStream;
 	ResourceType type = kResourceTypeInvalid;	// to silence a false positive in MSVC
 	uint16 number, id;
 	uint32 offset;
 
 	if (map->_resourceFile) {
-		fileStream = map->_resourceFile->createReadStream();
+		fileStream.reset(map->_resourceFile->createReadStream());
 		if (!fileStream)
 			return SCI_ERROR_RESMAP_NOT_FOUND;
 	} else {
 		Common::File *file = new Common::File();
-		if (!file->open(map->getLocationName()))
+		if (!file->open(map->getLocationName())) {
+			delete file;
 			return SCI_ERROR_RESMAP_NOT_FOUND;
-		fileStream = file;
+		}
+		fileStream.reset(file);
 	}
 
 	fileStream->seek(0, SEEK_SET);
 
+	// The map consists of thousands of small entries, which are parsed
+	// from a window instead of reading each field from the file
+	Common::StreamReader reader(*fileStream);
+
 	byte bMask = (_mapVersion >= kResVersionSci1Middle) ? 0xF0 : 0xFC;
 	byte bShift = (_mapVersion >= kResVersionSci1Middle) ? 28 : 26;
 
@@ -1603,13 +1611,12 @@ int ResourceManager::readResourceMapSCI0(ResourceSource *map) {
 		// King's Quest 5 FM-Towns uses a 7 byte version of the SCI1 Middle map,
 		// splitting the type from the id.
 		if (_mapVersion == kResVersionKQ5FMT)
-			type = convertResType(fileStream->readByte());
+			type = convertResType(reader.readByte());
 
-		id = fileStream->readUint16LE();
-		offset = fileStream->readUint32LE();
+		id = reader.readUint16LE();
+		offset = reader.readUint32LE();
 
-		if (fileStream->eos() || fileStream->err()) {
-			delete fileStream;
+		if (reader.eos() || reader.err()) {
 			warning("Error while reading %s", map->getLocationName().c_str());
 			return SCI_ERROR_RESMAP_NOT_FOUND;
 		}
@@ -1642,26 +1649,29 @@ int ResourceManager::readResourceMapSCI0(ResourceSource *map) {
 
 			addResource(resId, source, offset & (((~bMask) << 24) | 0xFFFFFF));
 		}
-	} while (!fileStream->eos());
+	} while (!reader.eos());
 
-	delete fileStream;
 	return 0;
 }
 
 int ResourceManager::readResourceMapSCI1(ResourceSource *map) {
-	Common::SeekableReadStream *fileStream = 0;
+	Common::ScopedPtr<Common::SeekableReadStream> fileStream;
 
 	if (map->_resourceFile) {
-		fileStream = map->_resourceFile->createReadStream();
+		fileStream.reset(map->_resourceFile->createReadStream());
 		if (!fileStream)
 			return SCI_ERROR_RESMAP_NOT_FOUND;
 	} else {
 		Common::File *file = new Common::File();
-		if (!file->open(map->getLocationName()))
+		if (!file->open(map->getLocationName())) {
+			delete file;
 			return SCI_ERROR_RESMAP_NOT_FOUND;
-		fileStream = file;
+		}
+		fileStream.reset(file);
 	}
 
+	Common::StreamReader reader(*fileStream);
+
 	resource_index_t resMap[32];
 	memset(resMap, 0, sizeof(resource_index_t) * 32);
 	byte type = 0, prevtype = 0;
@@ -1671,8 +1681,8 @@ int ResourceManager::readResourceMapSCI1(ResourceSource *map) {
 	// Read resource type and offsets to resource offsets block from .MAP file
 	// The last entry has type=0xFF (0x1F) and offset equals to map file length
 	do {
-		type = fileStream->readByte() & 0x1F;
-		resMap[type].wOffset = fileStream->readUint16LE();
+		type = reader.readByte() & 0x1F;
+		resMap[type].wOffset = reader.readUint16LE();
 		resMap[prevtype].wSize = (resMap[type].wOffset
 		                          - resMap[prevtype].wOffset) / nEntrySize;
 		prevtype = type;
@@ -1683,18 +1693,18 @@ int ResourceManager::readResourceMapSCI1(ResourceSource *map) {
 	for (type = 0; type < 32; type++) {
 		if (resMap[type].wOffset == 0) // this resource does not exist in map
 			continue;
-		fileStream->seek(resMap[type].wOffset);
+		reader.seek(resMap[type].wOffset);
 		for (int i = 0; i < resMap[type].wSize; i++) {
-			uint16 number = fileStream->readUint16LE();
+			uint16 number = reader.readUint16LE();
 			int volume_nr = 0;
 			if (_mapVersion == kResVersionSci11) {
 				// offset stored in 3 bytes
-				fileOffset = fileStream->readUint16LE();
-				fileOffset |= fileStream->readByte() << 16;
+				fileOffset = reader.readUint16LE();
+				fileOffset |= reader.readByte() << 16;
 				fileOffset <<= 1;
 			} else {
 				// offset/volume stored in 4 bytes
-				fileOffset = fileStream->readUint32LE();
+				fileOffset = reader.readUint32LE();
 				if (_mapVersion < kResVersionSci11) {
 					volume_nr = fileOffset >> 28; // most significant 4 bits
 					fileOffset &= 0x0FFFFFFF;     // least significant 28 bits
@@ -1702,8 +1712,7 @@ int ResourceManager::readResourceMapSCI1(ResourceSource *map) {
 					// in SCI32 it's a plain offset
 				}
 			}
-			if (fileStream->eos() || fileStream->err()) {
-				delete fileStream;
+			if (reader.eos() || reader.err()) {
 				warning("Error while reading %s", map->getLocationName().c_str());
 				return SCI_ERROR_RESMAP_NOT_FOUND;
 			}
@@ -1734,7 +1743,6 @@ int ResourceManager::readResourceMapSCI1(ResourceSource *map) {
 		}
 	}
 
-	delete fileStream;
 	return 0;
 }
 
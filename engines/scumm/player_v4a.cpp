@@ -44,6 +44,8 @@ Player_V4A::Player_V4A(ScummEngine *scumm, Audio::Mixer *mixer)
 	assert(mixer);
 	assert(_vm->_game.id == GID_MONKEY_VGA);
 	_tfmxMusic.setSignalPtr(&_signal, 1);
+	_tfmxMusic.setInterpolation(Audio::Paula::getConfiguredInterpolation());
+	_tfmxSfx.setInterpolation(Audio::Paula::getConfiguredInterpolation());
 }
 
 bool Player_V4A::init() {
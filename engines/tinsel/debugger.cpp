@@ -23,6 +23,7 @@
 #include "tinsel/tinsel.h"
 #include "tinsel/debugger.h"
 #include "tinsel/dialogs.h"
+#include "tinsel/heapmem.h"
 #include "tinsel/pcode.h"
 #include "tinsel/scene.h"
 #include "tinsel/sound.h"
@@ -63,6 +64,7 @@ int strToInt(const char *s) {
 
 Console::Console() : GUI::Debugger() {
 	DCmd_Register("item",		WRAP_METHOD(Console, cmd_item));
+	DCmd_Register("mem",		WRAP_METHOD(Console, cmd_mem));
 	DCmd_Register("scene",		WRAP_METHOD(Console, cmd_scene));
 	DCmd_Register("music",		WRAP_METHOD(Console, cmd_music));
 	DCmd_Register("sound",		WRAP_METHOD(Console, cmd_sound));
@@ -84,6 +86,22 @@ bool Console::cmd_item(int argc, const char **argv) {
 	return false;
 }
 
+bool Console::cmd_mem(int argc, const char **argv) {
+	MemoryStatistics stats;
+	MemoryGetStats(stats);
+
+	DebugPrintf("Heap: %d of %d bytes free, largest block %d bytes\n",
+		stats.heapFree, stats.heapSize, stats.largestBlock);
+	DebugPrintf("Nodes: %d used, %d discarded, %d locked (%d bytes), %d discardable (%d bytes)\n",
+		stats.usedNodes, stats.discardedNodes, stats.lockedNodes, stats.lockedSize,
+		stats.discardableNodes, stats.discardableSize);
+	DebugPrintf("Allocations: %d, %d failed\n", stats.allocations, stats.failures);
+	DebugPrintf("Compactions: %d, %d blocks discarded, %d ms total, %d ms max\n",
+		stats.compactions, stats.compactDiscards, stats.compactTime, stats.compactTimeMax);
+
+	return true;
+}
+
 bool Console::cmd_scene(int argc, const char **argv) {
 	if (argc < 1 || argc > 3) {
 		DebugPrintf("%s [scene_number [entry number]]\n", argv[0]);
@@ -36,6 +36,7 @@ public:
 
 private:
 	bool cmd_item(int argc, const char **argv);
+	bool cmd_mem(int argc, const char **argv);
 	bool cmd_scene(int argc, const char **argv);
 	bool cmd_music(int argc, const char **argv);
 	bool cmd_sound(int argc, const char **argv);
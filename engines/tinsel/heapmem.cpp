@@ -21,6 +21,8 @@
  * This file contains the handle based Memory Manager code.
  */
 
+#include "common/system.h"
+
 #include "tinsel/heapmem.h"
 #include "tinsel/timers.h"	// For DwGetCurrentTime
 #include "tinsel/tinsel.h"
@@ -41,6 +43,8 @@ namespace Tinsel {
 struct MEM_NODE {
 	MEM_NODE *pNext;	// link to the next node in the list
 	MEM_NODE *pPrev;	// link to the previous node in the list
+	MEM_NODE *pLruNext;	// link to the next node in the discardable list
+	MEM_NODE *pLruPrev;	// link to the previous node in the discardable list
 	uint8 *pBaseAddr;	// base address of the memory object
 	long size;		// size of the memory object
 	uint32 lruTime;		// time when memory object was last accessed
@@ -69,6 +73,12 @@ MEM_NODE s_fixedMnodesList[5];
 // the mnode heap sentinel
 static MEM_NODE heapSentinel;
 
+// the sentinel of the list of discardable mnodes, least recently used first
+static MEM_NODE lruSentinel;
+
+// allocation statistics, reported by the debugger
+static MemoryStatistics s_memStats;
+
 //
 static MEM_NODE *AllocMemNode();
 
@@ -130,6 +140,14 @@ void MemoryInit() {
 	if (TinselVersion == TINSEL_V1) size = MemoryPoolSize[1];
 	else if (TinselVersion == TINSEL_V2) size = MemoryPoolSize[2];
 	heapSentinel.size = size;
+
+	// the discardable list starts out empty
+	lruSentinel.pLruPrev = &lruSentinel;
+	lruSentinel.pLruNext = &lruSentinel;
+	lruSentinel.flags = DWM_LOCKED | DWM_SENTINEL;
+
+	memset(&s_memStats, 0, sizeof(s_memStats));
+	s_memStats.heapSize = size;
 }
 
 /**
@@ -188,37 +206,60 @@ void FreeMemNode(MEM_NODE *pMemNode) {
 }
 
 
+/**
+ * Appends a heap mnode to the end of the discardable list, if its memory
+ * block is in use and neither locked nor discarded.
+ * @param pMemNode			Node of the memory object
+ */
+static void LruAppend(MEM_NODE *pMemNode) {
+	if (pMemNode < mnodeList || pMemNode > mnodeList + NUM_MNODES - 1 || pMemNode->flags != DWM_USED)
+		return;
+
+	pMemNode->pLruPrev = lruSentinel.pLruPrev;
+	pMemNode->pLruNext = &lruSentinel;
+	lruSentinel.pLruPrev->pLruNext = pMemNode;
+	lruSentinel.pLruPrev = pMemNode;
+}
+
+/**
+ * Removes a mnode from the discardable list, if it is part of it.
+ * @param pMemNode			Node of the memory object
+ */
+static void LruUnlink(MEM_NODE *pMemNode) {
+	if (!pMemNode->pLruNext)
+		return;
+
+	pMemNode->pLruPrev->pLruNext = pMemNode->pLruNext;
+	pMemNode->pLruNext->pLruPrev = pMemNode->pLruPrev;
+	pMemNode->pLruNext = pMemNode->pLruPrev = NULL;
+}
+
 /**
  * Tries to make space for the specified number of bytes on the specified heap.
  * @param size			Number of bytes to free up
  * @return true if any blocks were discarded, false otherwise
  */
 static bool HeapCompact(long size) {
-	const MEM_NODE *pHeap = &heapSentinel;
-	MEM_NODE *pCur, *pOldest;
-	uint32 oldest;		// time of the oldest discardable block
+	MEM_NODE *pOldest;
 
 	while (heapSentinel.size < size) {
-
-		// find the oldest discardable block
-		oldest = DwGetCurrentTime();
-		pOldest = NULL;
-		for (pCur = pHeap->pNext; pCur != pHeap; pCur = pCur->pNext) {
-			if (pCur->flags == DWM_USED) {
-				// found a non-discarded discardable block
-				if (pCur->lruTime < oldest) {
-					oldest = pCur->lruTime;
-					pOldest = pCur;
-				}
-			}
+		// The discardable list is kept in access order, so the oldest block
+		// is at its head. Blocks accessed during the current tick are never
+		// discarded, and they are the only ones which may be out of order
+		// (new blocks get the next tick as their LRU time).
+		const uint32 now = DwGetCurrentTime();
+		for (pOldest = lruSentinel.pLruNext; pOldest != &lruSentinel; pOldest = pOldest->pLruNext) {
+			if (pOldest->lruTime < now)
+				break;
 		}
 
-		if (pOldest)
-			// discard the oldest block
-			MemoryDiscard(pOldest);
-		else
+		if (pOldest == &lruSentinel)
 			// cannot discard any blocks
 			return false;
+
+		// discard the oldest block
+		MemoryDiscard(pOldest);
+		s_memStats.compactDiscards++;
 	}
 
 	// we have freed enough memory
@@ -238,9 +279,23 @@ static MEM_NODE *MemoryAlloc(long size) {
 	size = (size + alignPadding) & ~alignPadding;	//round up to nearest multiple of sizeof(void*), this ensures the addresses that are returned are alignment-safe.
 #endif
 
+	s_memStats.allocations++;
+
 	// compact the heap to make up room for 'size' bytes, if necessary
-	if (!HeapCompact(size))
-		return 0;
+	if (heapSentinel.size < size) {
+		const uint32 startTime = g_system->getMillis();
+		const bool compacted = HeapCompact(size);
+		const uint32 elapsed = g_system->getMillis() - startTime;
+
+		s_memStats.compactions++;
+		s_memStats.compactTime += elapsed;
+		s_memStats.compactTimeMax = MAX(s_memStats.compactTimeMax, elapsed);
+
+		if (!compacted) {
+			s_memStats.failures++;
+			return 0;
+		}
+	}
 
 	// success! we may allocate a new node of the right size
 
@@ -274,6 +329,9 @@ static MEM_NODE *MemoryAlloc(long size) {
 	pHeap->pPrev->pNext = pNode;
 	pHeap->pPrev = pNode;
 
+	// the new block is the most recently used one
+	LruAppend(pNode);
+
 	return pNode;
 }
 
@@ -349,6 +407,8 @@ void MemoryDiscard(MEM_NODE *pMemNode) {
 
 	// discard it if it isn't already
 	if ((pMemNode->flags & DWM_DISCARDED) == 0) {
+		LruUnlink(pMemNode);
+
 		// free memory
 		free(pMemNode->pBaseAddr);
 		heapSentinel.size += pMemNode->size;
@@ -380,6 +440,9 @@ void *MemoryLock(MEM_NODE *pMemNode) {
 	// set the lock flag
 	pMemNode->flags |= DWM_LOCKED;
 
+	// locked blocks can't be discarded
+	LruUnlink(pMemNode);
+
 #ifdef DEBUG
 	MemoryStats();
 #endif
@@ -405,6 +468,9 @@ void MemoryUnlock(MEM_NODE *pMemNode) {
 
 	// update the LRU time
 	pMemNode->lruTime = DwGetCurrentTime();
+
+	// the block is discardable again, as the most recently used one
+	LruAppend(pMemNode);
 }
 
 /**
@@ -446,6 +512,12 @@ void MemoryReAlloc(MEM_NODE *pMemNode, long size) {
 		pMemNode->pPrev->pNext = pMemNode;
 		pMemNode->pNext->pPrev = pMemNode;
 
+		// and into the discardable list, where the new node was placed
+		if (pMemNode->pLruNext) {
+			pMemNode->pLruPrev->pLruNext = pMemNode;
+			pMemNode->pLruNext->pLruPrev = pMemNode;
+		}
+
 		// free the new node
 		FreeMemNode(pNew);
 	}
@@ -460,11 +532,49 @@ void MemoryReAlloc(MEM_NODE *pMemNode, long size) {
 void MemoryTouch(MEM_NODE *pMemNode) {
 	// update the LRU time
 	pMemNode->lruTime = DwGetCurrentTime();
+
+	// move the block to the end of the discardable list
+	if (pMemNode->pLruNext) {
+		LruUnlink(pMemNode);
+		LruAppend(pMemNode);
+	}
 }
 
 uint8 *MemoryDeref(MEM_NODE *pMemNode) {
 	return pMemNode->pBaseAddr;
 }
 
+/**
+ * Fills in the allocation statistics and the current state of the heap.
+ * @param stats			Structure receiving the statistics
+ */
+void MemoryGetStats(MemoryStatistics &stats) {
+	const MEM_NODE *pHeap = &heapSentinel;
+	const MEM_NODE *pCur;
+
+	stats = s_memStats;
+	stats.heapFree = heapSentinel.size;
+	stats.usedNodes = stats.discardedNodes = stats.lockedNodes = stats.discardableNodes = 0;
+	stats.lockedSize = stats.discardableSize = stats.largestBlock = 0;
+
+	for (pCur = pHeap->pNext; pCur != pHeap; pCur = pCur->pNext) {
+		stats.usedNodes++;
+
+		if (pCur->flags & DWM_DISCARDED) {
+			stats.discardedNodes++;
+		} else if (pCur->flags & DWM_LOCKED) {
+			stats.lockedNodes++;
+			stats.lockedSize += pCur->size;
+		}
+
+		stats.largestBlock = MAX<uint32>(stats.largestBlock, pCur->size);
+	}
+
+	for (pCur = lruSentinel.pLruNext; pCur != &lruSentinel; pCur = pCur->pLruNext) {
+		stats.discardableNodes++;
+		stats.discardableSize += pCur->size;
+	}
+}
+
 
 } // End of namespace Tinsel
@@ -30,6 +30,27 @@ namespace Tinsel {
 
 struct MEM_NODE;
 
+/** Memory manager statistics, as shown by the debugger */
+struct MemoryStatistics {
+	uint32 heapSize;		// total size of the heap
+	uint32 heapFree;		// bytes not used by any block
+
+	uint32 allocations;		// number of blocks allocated from the heap
+	uint32 compactions;		// allocations which had to discard blocks first
+	uint32 compactDiscards;	// blocks discarded to make room for new ones
+	uint32 compactTime;		// total time spent discarding blocks, in ms
+	uint32 compactTimeMax;	// longest time spent discarding for one allocation, in ms
+	uint32 failures;		// allocations which couldn't be satisfied
+
+	uint32 usedNodes;		// mnodes in the heap
+	uint32 discardedNodes;	// mnodes whose block is discarded
+	uint32 lockedNodes;		// mnodes whose block is locked
+	uint32 lockedSize;		// bytes in locked blocks
+	uint32 discardableNodes;	// mnodes whose block may be discarded
+	uint32 discardableSize;	// bytes in discardable blocks
+	uint32 largestBlock;	// size of the largest block in the heap
+};
+
 
 /*----------------------------------------------------------------------*\
 |*			Memory Function Prototypes			*|
@@ -63,6 +84,9 @@ void MemoryTouch(MEM_NODE *pMemNode);
 // Dereference a given memory node
 uint8 *MemoryDeref(MEM_NODE *pMemNode);
 
+// Retrieves the memory manager statistics
+void MemoryGetStats(MemoryStatistics &stats);
+
 } // End of namespace Tinsel
 
 #endif
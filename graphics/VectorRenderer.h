@@ -81,6 +81,14 @@ struct DrawStep {
 
 VectorRenderer *createRenderer(int mode);
 
+/**
+ * Enables or disables the SIMD code paths of the renderers, which are used
+ * by default when the CPU supports them.
+ *
+ * @return true if the SIMD code paths are used.
+ */
+bool enableRendererSIMD(bool enable);
+
 /**
  * VectorRenderer: The core Vector Renderer Class
  *
@@ -264,6 +272,11 @@ public:
 		_activeSurface = surface;
 	}
 
+	/**
+	 * Returns the surface all drawing is currently being done on.
+	 */
+	Surface *getActiveSurface() const { return _activeSurface; }
+
 	/**
 	 * Fills the active surface with the specified fg/bg color or the active gradient.
 	 * Defaults to using the active Foreground color for filling.
@@ -472,6 +485,7 @@ public:
 	 */
 	virtual void disableShadows() { _disableShadows = true; }
 	virtual void enableShadows() { _disableShadows = false; }
+	bool shadowsDisabled() const { return _disableShadows; }
 
 	/**
 	 * Applies a whole-screen shading effect, used before opening a new dialog.
@@ -20,6 +20,17 @@
  *
  */
 
+// The SSE2 kernels are built on x86 whenever the compiler can enable SSE2
+// for single functions, and are only used when the CPU supports it. The
+// intrinsics pull in system headers, so they have to be included before
+// common/scummsys.h enables the forbidden symbol checks.
+#if (defined(__i386__) || defined(__x86_64__)) && \
+	(defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#include <emmintrin.h>
+#define VECTOR_RENDERER_SSE2
+#define VECTOR_RENDERER_SSE2_FUNC __attribute__((target("sse2")))
+#endif
+
 #include "common/util.h"
 #include "common/system.h"
 #include "common/frac.h"
@@ -166,6 +177,160 @@ inline frac_t fp_sqroot(uint32 x) {
 
 namespace Graphics {
 
+#ifdef VECTOR_RENDERER_SSE2
+/** Whether the SSE2 kernels are used: 1 or 0, or -1 when not checked yet. */
+static int s_useSSE2 = -1;
+
+static bool useSSE2() {
+	if (s_useSSE2 < 0) {
+#ifdef __x86_64__
+		// SSE2 is part of the x86-64 baseline
+		s_useSSE2 = 1;
+#else
+		__builtin_cpu_init();
+		s_useSSE2 = __builtin_cpu_supports("sse2") ? 1 : 0;
+#endif
+	}
+
+	return s_useSSE2 != 0;
+}
+
+/**
+ * SSE2 version of colorFill for 16 bit pixels: fills 8 pixels per store.
+ * Used for solid fills and for each row of the gradient fills.
+ */
+VECTOR_RENDERER_SSE2_FUNC
+static void colorFillSSE2(uint16 *first, int count, uint16 color) {
+	while (count > 0 && ((size_t)first & 15)) {
+		*first++ = color;
+		count--;
+	}
+
+	const __m128i value = _mm_set1_epi16((short)color);
+	while (count >= 8) {
+		_mm_store_si128((__m128i *)first, value);
+		first += 8;
+		count -= 8;
+	}
+
+	while (count--)
+		*first++ = color;
+}
+
+#ifdef VECTOR_RENDERER_32BIT
+/**
+ * SSE2 version of colorFill for 32 bit pixels: fills 4 pixels per store.
+ */
+VECTOR_RENDERER_SSE2_FUNC
+static void colorFillSSE2(uint32 *first, int count, uint32 color) {
+	while (count > 0 && ((size_t)first & 15)) {
+		*first++ = color;
+		count--;
+	}
+
+	const __m128i value = _mm_set1_epi32((int)color);
+	while (count >= 4) {
+		_mm_store_si128((__m128i *)first, value);
+		first += 4;
+		count -= 4;
+	}
+
+	while (count--)
+		*first++ = color;
+}
+#endif
+
+/**
+ * Blends the color components in the 16 bit lanes of dst towards the ones
+ * of src as dst + ((src - dst) * alpha >> 8), which is what blendPixelPtr()
+ * does for every component. The product takes up to 17 bits, so it is put
+ * together from its low and high halves.
+ */
+VECTOR_RENDERER_SSE2_FUNC
+static inline __m128i blendLanesSSE2(__m128i dst, __m128i src, __m128i alpha) {
+	const __m128i diff = _mm_sub_epi16(src, dst);
+	const __m128i low = _mm_mullo_epi16(diff, alpha);
+	const __m128i high = _mm_mulhi_epi16(diff, alpha);
+
+	return _mm_add_epi16(dst, _mm_or_si128(_mm_slli_epi16(high, 8), _mm_srli_epi16(low, 8)));
+}
+
+/**
+ * SSE2 version of blendFill for 16 bit formats without alpha: blends 8
+ * pixels at a time, and leaves the remaining ones to the caller. Every color
+ * component is moved to the low bits of a 16 bit lane.
+ */
+VECTOR_RENDERER_SSE2_FUNC
+static void blendFillSSE2(uint16 *&first, uint16 *last, uint16 color, uint8 alpha, const PixelFormat &format) {
+	const __m128i rShift = _mm_cvtsi32_si128(format.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(format.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(format.bShift);
+	const __m128i rBits = _mm_set1_epi16(0xFF >> format.rLoss);
+	const __m128i gBits = _mm_set1_epi16(0xFF >> format.gLoss);
+	const __m128i bBits = _mm_set1_epi16(0xFF >> format.bLoss);
+
+	const __m128i srcR = _mm_set1_epi16((color >> format.rShift) & (0xFF >> format.rLoss));
+	const __m128i srcG = _mm_set1_epi16((color >> format.gShift) & (0xFF >> format.gLoss));
+	const __m128i srcB = _mm_set1_epi16((color >> format.bShift) & (0xFF >> format.bLoss));
+	const __m128i a = _mm_set1_epi16(alpha);
+
+	while (last - first >= 8) {
+		const __m128i dst = _mm_loadu_si128((const __m128i *)first);
+
+		const __m128i r = blendLanesSSE2(_mm_and_si128(_mm_srl_epi16(dst, rShift), rBits), srcR, a);
+		const __m128i g = blendLanesSSE2(_mm_and_si128(_mm_srl_epi16(dst, gShift), gBits), srcG, a);
+		const __m128i b = blendLanesSSE2(_mm_and_si128(_mm_srl_epi16(dst, bShift), bBits), srcB, a);
+
+		const __m128i out = _mm_or_si128(_mm_or_si128(
+			_mm_sll_epi16(_mm_and_si128(r, rBits), rShift),
+			_mm_sll_epi16(_mm_and_si128(g, gBits), gShift)),
+			_mm_sll_epi16(_mm_and_si128(b, bBits), bShift));
+
+		_mm_storeu_si128((__m128i *)first, out);
+		first += 8;
+	}
+}
+
+#ifdef VECTOR_RENDERER_32BIT
+/**
+ * SSE2 version of blendFill for 32 bit formats without alpha and with 8 bit
+ * color components: blends 4 pixels at a time, and leaves the remaining ones
+ * to the caller. The bytes are widened to 16 bit lanes, and the unused byte
+ * is cleared, like blendPixelPtr() does.
+ */
+VECTOR_RENDERER_SSE2_FUNC
+static void blendFillSSE2(uint32 *&first, uint32 *last, uint32 color, uint8 alpha, const PixelFormat &format) {
+	const uint32 colorMask = (0xFF << format.rShift) | (0xFF << format.gShift) | (0xFF << format.bShift);
+	const __m128i mask = _mm_set1_epi32((int)colorMask);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)(color & colorMask)), zero);
+	const __m128i a = _mm_set1_epi16(alpha);
+
+	while (last - first >= 4) {
+		const __m128i dst = _mm_and_si128(_mm_loadu_si128((const __m128i *)first), mask);
+
+		const __m128i low = blendLanesSSE2(_mm_unpacklo_epi8(dst, zero), src, a);
+		const __m128i high = blendLanesSSE2(_mm_unpackhi_epi8(dst, zero), src, a);
+
+		_mm_storeu_si128((__m128i *)first, _mm_and_si128(_mm_packus_epi16(low, high), mask));
+		first += 4;
+	}
+}
+#endif // VECTOR_RENDERER_32BIT
+#endif
+
+bool enableRendererSIMD(bool enable) {
+#ifdef VECTOR_RENDERER_SSE2
+	s_useSSE2 = -1;
+	if (!enable)
+		s_useSSE2 = 0;
+
+	return useSSE2();
+#else
+	return false;
+#endif
+}
+
 /**
  * Fills several pixels in a row with a given color.
  *
@@ -187,6 +352,14 @@ void colorFill(PixelType *first, PixelType *last, PixelType color) {
 	register int count = (last - first);
 	if (!count)
 		return;
+
+#ifdef VECTOR_RENDERER_SSE2
+	if (count >= 16 && useSSE2()) {
+		colorFillSSE2(first, count, color);
+		return;
+	}
+#endif
+
 	register int n = (count + 7) >> 3;
 	switch (count % 8) {
 	case 0: do {
@@ -244,6 +417,21 @@ VectorRendererSpec(PixelFormat format) :
 	_alphaMask((0xFF >> format.aLoss) << format.aShift) {
 
 	_bitmapAlphaColor = _format.RGBToColor(255, 0, 255);
+
+	// The vectorized span blending works on 16 bit lanes, which can hold the
+	// intermediate products for formats without alpha and with at most 7 bits
+	// per color component for 16 bit pixels, or 8 bits in separate bytes for
+	// 32 bit pixels.
+	_fastBlendFill = false;
+#ifdef VECTOR_RENDERER_SSE2
+	if (sizeof(PixelType) == 2) {
+		_fastBlendFill = (format.aLoss == 8 && format.rLoss >= 1 && format.gLoss >= 1 && format.bLoss >= 1);
+	} else if (sizeof(PixelType) == 4) {
+		_fastBlendFill = (format.aLoss == 8 && format.rLoss == 0 && format.gLoss == 0 && format.bLoss == 0 &&
+		                  format.rShift % 8 == 0 && format.gShift % 8 == 0 && format.bShift % 8 == 0 &&
+		                  format.rShift <= 16 && format.gShift <= 16 && format.bShift <= 16);
+	}
+#endif
 }
 
 template<typename PixelType>
@@ -413,6 +601,18 @@ blendPixelPtr(PixelType *ptr, PixelType color, uint8 alpha) {
                 (((int)(idst & _alphaMask) * alpha) >> 8))));
 }
 
+template<typename PixelType>
+void VectorRendererSpec<PixelType>::
+blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha) {
+#ifdef VECTOR_RENDERER_SSE2
+	if (_fastBlendFill && useSSE2())
+		blendFillSSE2(first, last, color, alpha, _format);
+#endif
+
+	while (first != last)
+		blendPixelPtr(first++, color, alpha);
+}
+
 template<typename PixelType>
 inline PixelType VectorRendererSpec<PixelType>::
 calcGradient(uint32 pos, uint32 max) {
@@ -1617,4 +1817,11 @@ drawCircleAlg(int x1, int y1, int r, PixelType color, VectorRenderer::FillMode f
 
 #endif
 
-}
+#ifdef VECTOR_RENDERER_32BIT
+// Overlays always use OverlayColor pixels, so the renderer for 32 bit pixels
+// is not part of the library. graphics_bench builds its own copy of this
+// file with it, see test/benchmark/benchmark.mk.
+template class VectorRendererSpec<uint32>;
+#endif
+
+} // End of namespace Graphics
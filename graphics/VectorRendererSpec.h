@@ -195,9 +195,7 @@ protected:
 	 * @param color Color of the pixel
 	 * @param alpha Alpha intensity of the pixel (0-255)
 	 */
-	inline void blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha) {
-		while (first != last) blendPixelPtr(first++, color, alpha);
-	}
+	void blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha);
 
 	const PixelFormat _format;
 	const PixelType _redMask, _greenMask, _blueMask, _alphaMask;
@@ -210,6 +208,9 @@ protected:
 
 	PixelType _bevelColor;
 	PixelType _bitmapAlphaColor;
+
+	/** Whether the overlay format allows the vectorized blendFill() path */
+	bool _fastBlendFill;
 };
 
 
@@ -19,6 +19,15 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+// The SSE2 intrinsics pull in system headers, so they have to be included
+// before common/scummsys.h enables the forbidden symbol checks.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GRAPHICS_CONVERSION_SSE2
+#endif
+
+#include "common/endian.h"
+
 #include "graphics/conversion.h"
 #include "graphics/pixelformat.h"
 
@@ -26,13 +35,377 @@ namespace Graphics {
 
 // TODO: YUV to RGB conversion function
 
+template<int bytesPerPixel>
+static inline uint32 readPixel(const byte *src);
+
+template<>
+inline uint32 readPixel<2>(const byte *src) {
+	return *(const uint16 *)src;
+}
+
+template<>
+inline uint32 readPixel<3>(const byte *src) {
+#ifdef SCUMM_BIG_ENDIAN
+	return (src[0] << 16) | (src[1] << 8) | src[2];
+#else
+	return src[0] | (src[1] << 8) | (src[2] << 16);
+#endif
+}
+
+template<>
+inline uint32 readPixel<4>(const byte *src) {
+	return *(const uint32 *)src;
+}
+
+template<int bytesPerPixel>
+static inline void writePixel(byte *dst, uint32 color);
+
+template<>
+inline void writePixel<2>(byte *dst, uint32 color) {
+	*(uint16 *)dst = color;
+}
+
+template<>
+inline void writePixel<3>(byte *dst, uint32 color) {
+#ifdef SCUMM_BIG_ENDIAN
+	dst[0] = color >> 16;
+	dst[1] = color >> 8;
+	dst[2] = color;
+#else
+	dst[0] = color;
+	dst[1] = color >> 8;
+	dst[2] = color >> 16;
+#endif
+}
+
+template<>
+inline void writePixel<4>(byte *dst, uint32 color) {
+	*(uint32 *)dst = color;
+}
+
+template<int srcBpp, int dstBpp>
+static void crossBlitLoop(byte *dst, const byte *src, int dstDelta, int srcDelta,
+						int w, int h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	uint8 r, g, b, a;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++, src += srcBpp, dst += dstBpp) {
+			srcFmt.colorToARGB(readPixel<srcBpp>(src), a, r, g, b);
+			writePixel<dstBpp>(dst, dstFmt.ARGBToColor(a, r, g, b));
+		}
+		src += srcDelta;
+		dst += dstDelta;
+	}
+}
+
+template<int srcBpp>
+static bool crossBlitLoop(byte *dst, const byte *src, int dstDelta, int srcDelta,
+						int w, int h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	switch (dstFmt.bytesPerPixel) {
+	case 2:
+		crossBlitLoop<srcBpp, 2>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+		return true;
+	case 3:
+		crossBlitLoop<srcBpp, 3>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+		return true;
+	case 4:
+		crossBlitLoop<srcBpp, 4>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool crossBlitGeneric(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+	const int srcDelta = (srcpitch - w * srcFmt.bytesPerPixel);
+	const int dstDelta = (dstpitch - w * dstFmt.bytesPerPixel);
+
+	switch (srcFmt.bytesPerPixel) {
+	case 2:
+		return crossBlitLoop<2>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+	case 3:
+		return crossBlitLoop<3>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+	case 4:
+		return crossBlitLoop<4>(dst, src, dstDelta, srcDelta, w, h, dstFmt, srcFmt);
+	default:
+		return false;
+	}
+}
+
+// Every converter has to produce exactly the same pixels as the generic
+// conversion above. Note that this means the alpha channel of formats
+// without one is converted to 0, and that channels aren't rounded when
+// their precision is increased.
+
+struct RGB565ToRGB555 {
+	static inline uint32 convert(uint32 c) {
+		return ((c >> 1) & 0x7FE0) | (c & 0x001F);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		return _mm_or_si128(_mm_and_si128(_mm_srli_epi16(c, 1), _mm_set1_epi16(0x7FE0)),
+		                    _mm_and_si128(c, _mm_set1_epi16(0x001F)));
+	}
+#endif
+};
+
+struct RGB555ToRGB565 {
+	static inline uint32 convert(uint32 c) {
+		return ((c & 0x7FE0) << 1) | (c & 0x001F);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(c, _mm_set1_epi16(0x7FE0)), 1),
+		                    _mm_and_si128(c, _mm_set1_epi16(0x001F)));
+	}
+#endif
+};
+
+/** Swaps the red and blue channel of RGB565 and BGR565. */
+struct SwapRB565 {
+	static inline uint32 convert(uint32 c) {
+		return ((c >> 11) & 0x001F) | (c & 0x07E0) | ((c & 0x001F) << 11);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		return _mm_or_si128(_mm_or_si128(_mm_srli_epi16(c, 11), _mm_slli_epi16(c, 11)),
+		                    _mm_and_si128(c, _mm_set1_epi16(0x07E0)));
+	}
+#endif
+};
+
+struct RGB565ToARGB8888 {
+	static inline uint32 convert(uint32 c) {
+		return ((c & 0xF800) << 8) | ((c & 0x07E0) << 5) | ((c & 0x001F) << 3);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		const __m128i r = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0xF800)), 8);
+		const __m128i g = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x07E0)), 5);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x001F)), 3);
+		return _mm_or_si128(_mm_or_si128(r, g), b);
+	}
+#endif
+};
+
+struct ARGB8888ToRGB565 {
+	static inline uint32 convert(uint32 c) {
+		return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF800));
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x07E0));
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(c, 3), _mm_set1_epi32(0x001F));
+		return _mm_or_si128(_mm_or_si128(r, g), b);
+	}
+#endif
+};
+
+/** Swaps the red and blue channel of ARGB8888 and ABGR8888. */
+struct SwapRB8888 {
+	static inline uint32 convert(uint32 c) {
+		return (c & 0xFF00FF00) | ((c >> 16) & 0xFF) | ((c & 0xFF) << 16);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		const __m128i rb = _mm_and_si128(c, _mm_set1_epi32(0x00FF00FF));
+		return _mm_or_si128(_mm_and_si128(c, _mm_set1_epi32(0xFF00FF00)),
+		                    _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16)));
+	}
+#endif
+};
+
+/** Converts ARGB8888 to RGBA8888. */
+struct RotateLeft8 {
+	static inline uint32 convert(uint32 c) {
+		return (c << 8) | (c >> 24);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		return _mm_or_si128(_mm_slli_epi32(c, 8), _mm_srli_epi32(c, 24));
+	}
+#endif
+};
+
+/** Converts RGBA8888 to ARGB8888. */
+struct RotateRight8 {
+	static inline uint32 convert(uint32 c) {
+		return (c >> 8) | (c << 24);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		return _mm_or_si128(_mm_srli_epi32(c, 8), _mm_slli_epi32(c, 24));
+	}
+#endif
+};
+
+/** Converts ARGB8888 to BGRA8888, RGBA8888 to ABGR8888 and back. */
+struct ByteSwap32 {
+	static inline uint32 convert(uint32 c) {
+		return SWAP_BYTES_32(c);
+	}
+#ifdef GRAPHICS_CONVERSION_SSE2
+	static inline __m128i convert(__m128i c) {
+		c = _mm_or_si128(_mm_slli_epi32(c, 16), _mm_srli_epi32(c, 16));
+		return _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+	}
+#endif
+};
+
+template<class Op>
+static void convertRow16(byte *dst, const byte *src, int w) {
+	uint16 *d = (uint16 *)dst;
+	const uint16 *s = (const uint16 *)src;
+	int x = 0;
+#ifdef GRAPHICS_CONVERSION_SSE2
+	for (; x + 8 <= w; x += 8)
+		_mm_storeu_si128((__m128i *)(d + x), Op::convert(_mm_loadu_si128((const __m128i *)(s + x))));
+#endif
+	for (; x < w; x++)
+		d[x] = Op::convert(s[x]);
+}
+
+template<class Op>
+static void convertRow32(byte *dst, const byte *src, int w) {
+	uint32 *d = (uint32 *)dst;
+	const uint32 *s = (const uint32 *)src;
+	int x = 0;
+#ifdef GRAPHICS_CONVERSION_SSE2
+	for (; x + 4 <= w; x += 4)
+		_mm_storeu_si128((__m128i *)(d + x), Op::convert(_mm_loadu_si128((const __m128i *)(s + x))));
+#endif
+	for (; x < w; x++)
+		d[x] = Op::convert(s[x]);
+}
+
+template<class Op>
+static void convertRow16To32(byte *dst, const byte *src, int w) {
+	uint32 *d = (uint32 *)dst;
+	const uint16 *s = (const uint16 *)src;
+	int x = 0;
+#ifdef GRAPHICS_CONVERSION_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 8 <= w; x += 8) {
+		const __m128i c = _mm_loadu_si128((const __m128i *)(s + x));
+		_mm_storeu_si128((__m128i *)(d + x), Op::convert(_mm_unpacklo_epi16(c, zero)));
+		_mm_storeu_si128((__m128i *)(d + x + 4), Op::convert(_mm_unpackhi_epi16(c, zero)));
+	}
+#endif
+	for (; x < w; x++)
+		d[x] = Op::convert(s[x]);
+}
+
+template<class Op>
+static void convertRow32To16(byte *dst, const byte *src, int w) {
+	uint16 *d = (uint16 *)dst;
+	const uint32 *s = (const uint32 *)src;
+	int x = 0;
+#ifdef GRAPHICS_CONVERSION_SSE2
+	for (; x + 8 <= w; x += 8) {
+		// There is only a signed saturating pack in SSE2, so the 16 bit
+		// results are sign extended first to keep them from saturating.
+		__m128i lo = Op::convert(_mm_loadu_si128((const __m128i *)(s + x)));
+		__m128i hi = Op::convert(_mm_loadu_si128((const __m128i *)(s + x + 4)));
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i *)(d + x), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; x < w; x++)
+		d[x] = Op::convert(s[x]);
+}
+
+// There is no byte shuffle before SSSE3, so the 24 bit formats are only
+// converted without the detour through colorToARGB/ARGBToColor.
+
+static void convertRGB888ToARGB8888(byte *dst, const byte *src, int w) {
+	uint32 *d = (uint32 *)dst;
+	for (int x = 0; x < w; x++, src += 3)
+		d[x] = readPixel<3>(src);
+}
+
+static void convertARGB8888ToRGB888(byte *dst, const byte *src, int w) {
+	const uint32 *s = (const uint32 *)src;
+	for (int x = 0; x < w; x++, dst += 3)
+		writePixel<3>(dst, s[x]);
+}
+
+/**
+ * A pixel format, which can be used in static tables unlike PixelFormat,
+ * as it has no constructors.
+ */
+struct FormatDesc {
+	byte bytesPerPixel;
+	byte rBits, gBits, bBits, aBits;
+	byte rShift, gShift, bShift, aShift;
+
+	bool matches(const PixelFormat &fmt) const {
+		return bytesPerPixel == fmt.bytesPerPixel &&
+		       rBits == fmt.rBits() && gBits == fmt.gBits() &&
+		       bBits == fmt.bBits() && aBits == fmt.aBits() &&
+		       rShift == fmt.rShift && gShift == fmt.gShift && bShift == fmt.bShift &&
+		       (!aBits || aShift == fmt.aShift);
+	}
+};
+
+#define FORMAT_RGB565   { 2, 5, 6, 5, 0, 11,  5,  0,  0 }
+#define FORMAT_BGR565   { 2, 5, 6, 5, 0,  0,  5, 11,  0 }
+#define FORMAT_RGB555   { 2, 5, 5, 5, 0, 10,  5,  0,  0 }
+#define FORMAT_RGB888   { 3, 8, 8, 8, 0, 16,  8,  0,  0 }
+#define FORMAT_ARGB8888 { 4, 8, 8, 8, 8, 16,  8,  0, 24 }
+#define FORMAT_ABGR8888 { 4, 8, 8, 8, 8,  0,  8, 16, 24 }
+#define FORMAT_RGBA8888 { 4, 8, 8, 8, 8, 24, 16,  8,  0 }
+#define FORMAT_BGRA8888 { 4, 8, 8, 8, 8,  8, 16, 24,  0 }
+
+typedef void (*ConvertRowProc)(byte *dst, const byte *src, int w);
+
+static const struct {
+	FormatDesc dstFmt;
+	FormatDesc srcFmt;
+	ConvertRowProc convert;
+} s_converters[] = {
+	{ FORMAT_RGB555,   FORMAT_RGB565,   convertRow16<RGB565ToRGB555> },
+	{ FORMAT_RGB565,   FORMAT_RGB555,   convertRow16<RGB555ToRGB565> },
+	{ FORMAT_BGR565,   FORMAT_RGB565,   convertRow16<SwapRB565> },
+	{ FORMAT_RGB565,   FORMAT_BGR565,   convertRow16<SwapRB565> },
+	{ FORMAT_ARGB8888, FORMAT_RGB565,   convertRow16To32<RGB565ToARGB8888> },
+	{ FORMAT_RGB565,   FORMAT_ARGB8888, convertRow32To16<ARGB8888ToRGB565> },
+	{ FORMAT_ARGB8888, FORMAT_RGB888,   convertRGB888ToARGB8888 },
+	{ FORMAT_RGB888,   FORMAT_ARGB8888, convertARGB8888ToRGB888 },
+	{ FORMAT_ABGR8888, FORMAT_ARGB8888, convertRow32<SwapRB8888> },
+	{ FORMAT_ARGB8888, FORMAT_ABGR8888, convertRow32<SwapRB8888> },
+	{ FORMAT_RGBA8888, FORMAT_ARGB8888, convertRow32<RotateLeft8> },
+	{ FORMAT_ARGB8888, FORMAT_RGBA8888, convertRow32<RotateRight8> },
+	{ FORMAT_BGRA8888, FORMAT_ARGB8888, convertRow32<ByteSwap32> },
+	{ FORMAT_ARGB8888, FORMAT_BGRA8888, convertRow32<ByteSwap32> },
+	{ FORMAT_ABGR8888, FORMAT_RGBA8888, convertRow32<ByteSwap32> },
+	{ FORMAT_RGBA8888, FORMAT_ABGR8888, convertRow32<ByteSwap32> }
+};
+
+#undef FORMAT_RGB565
+#undef FORMAT_BGR565
+#undef FORMAT_RGB555
+#undef FORMAT_RGB888
+#undef FORMAT_ARGB8888
+#undef FORMAT_ABGR8888
+#undef FORMAT_RGBA8888
+#undef FORMAT_BGRA8888
+
+static ConvertRowProc findConverter(const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	for (uint i = 0; i < ARRAYSIZE(s_converters); ++i) {
+		if (s_converters[i].dstFmt.matches(dstFmt) && s_converters[i].srcFmt.matches(srcFmt))
+			return s_converters[i].convert;
+	}
+	return 0;
+}
+
 // Function to blit a rect from one color format to another
 bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
 	// Error out if conversion is impossible
 	if ((srcFmt.bytesPerPixel == 1) || (dstFmt.bytesPerPixel == 1)
-			 || (!srcFmt.bytesPerPixel) || (!dstFmt.bytesPerPixel)
-			 || (srcFmt.bytesPerPixel > dstFmt.bytesPerPixel))
+			 || (!srcFmt.bytesPerPixel) || (!dstFmt.bytesPerPixel))
 		return false;
 
 	// Don't perform unnecessary conversion
@@ -52,96 +425,20 @@ bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 		}
 	}
 
-	// Faster, but larger, to provide optimized handling for each case.
-	int srcDelta, dstDelta;
-	srcDelta = (srcpitch - w * srcFmt.bytesPerPixel);
-	dstDelta = (dstpitch - w * dstFmt.bytesPerPixel);
+	const ConvertRowProc convert = findConverter(dstFmt, srcFmt);
+	if (!convert)
+		return crossBlitGeneric(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
 
-	// TODO: optimized cases for dstDelta of 0
-	uint8 r, g, b, a;
-	if (dstFmt.bytesPerPixel == 2) {
-		uint16 color;
-		for (int y = 0; y < h; y++) {
-			for (int x = 0; x < w; x++, src += 2, dst += 2) {
-				color = *(const uint16 *)src;
-				srcFmt.colorToARGB(color, a, r, g, b);
-				color = dstFmt.ARGBToColor(a, r, g, b);
-				*(uint16 *)dst = color;
-			}
-			src += srcDelta;
-			dst += dstDelta;
-		}
-	} else if (dstFmt.bytesPerPixel == 3) {
-		uint32 color;
-		uint8 *col = (uint8 *) &color;
-#ifdef SCUMM_BIG_ENDIAN
-		col++;
-#endif
-		if (srcFmt.bytesPerPixel == 2) {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 3) {
-					color = *(const uint16 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					memcpy(dst, col, 3);
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 3, dst += 3) {
-					memcpy(col, src, 3);
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					memcpy(dst, col, 3);
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		}
-	} else if (dstFmt.bytesPerPixel == 4) {
-		uint32 color;
-		if (srcFmt.bytesPerPixel == 2) {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 4) {
-					color = *(const uint16 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else if (srcFmt.bytesPerPixel == 3) {
-			uint8 *col = (uint8 *)&color;
-#ifdef SCUMM_BIG_ENDIAN
-			col++;
-#endif
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 4) {
-					memcpy(col, src, 3);
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 4, dst += 4) {
-					color = *(const uint32 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		}
-	} else {
-		return false;
+	// Convert the whole rect at once if there is no padding between the rows
+	if (w * srcFmt.bytesPerPixel == srcpitch && w * dstFmt.bytesPerPixel == dstpitch) {
+		convert(dst, src, w * h);
+		return true;
+	}
+
+	for (int y = 0; y < h; y++) {
+		convert(dst, src, w);
+		dst += dstpitch;
+		src += srcpitch;
 	}
 	return true;
 }
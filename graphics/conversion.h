@@ -59,9 +59,9 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
  * @return			true if conversion completes successfully,
  *					false if there is an error.
  *
- * @note This implementation currently arbitrarily requires that the
- *		 destination's format have at least as high a bytedepth as
- *		 the source's.
+ * @note Conversions between the common 16 and 32 bit formats are done by
+ *		 specialized (and where possible SSE2) converters, all others
+ *		 by converting every pixel through colorToARGB and ARGBToColor.
  * @note This can convert a rectangle in place, if the source and
  *		 destination format have the same bytedepth.
  *
@@ -69,6 +69,18 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
 bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Blits a rectangle from one graphical format to another, like crossBlit,
+ * but always converts every pixel through colorToARGB and ARGBToColor.
+ * This is the reference the specialized converters of crossBlit are
+ * checked against.
+ *
+ * @return			true if conversion completes successfully,
+ *					false if either format is CLUT8 or invalid.
+ */
+bool crossBlitGeneric(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
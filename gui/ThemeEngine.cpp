@@ -22,6 +22,7 @@
 
 #include "common/system.h"
 #include "common/config-manager.h"
+#include "common/hashmap.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/unzip.h"
@@ -96,12 +97,13 @@ protected:
 
 class ThemeItemDrawData : public ThemeItem {
 public:
-	ThemeItemDrawData(ThemeEngine *engine, const WidgetDrawData *data, const Common::Rect &area, uint32 dynData) :
-		ThemeItem(engine, area), _dynamicData(dynData), _data(data) {}
+	ThemeItemDrawData(ThemeEngine *engine, DrawData type, const WidgetDrawData *data, const Common::Rect &area, uint32 dynData) :
+		ThemeItem(engine, area), _type(type), _dynamicData(dynData), _data(data) {}
 
 	void drawSelf(bool draw, bool restore);
 
 protected:
+	DrawData _type;
 	uint32 _dynamicData;
 	const WidgetDrawData *_data;
 };
@@ -127,6 +129,247 @@ protected:
 	int _deltax;
 };
 
+/**
+ * Cache of rasterized DrawData items.
+ *
+ * Running the DrawSteps of a widget yields pixels which only depend on the
+ * DrawData type, the drawn area, the dynamic data, whether shadows are
+ * enabled and on the pixels which were already in the area (the renderers
+ * blend shadows and antialiased edges into them). Every entry stores all of
+ * these, including a copy of the background it was drawn on, and is only
+ * used while the surface still holds that background. Drawing anything else
+ * over the area thus only invalidates the items overlapping it.
+ *
+ * An item is only stored once it was drawn twice with the same inputs, so
+ * contents which are drawn once, like a list while it scrolls, cost no
+ * copies. Entries are evicted in least recently used order once their total
+ * size exceeds the byte budget.
+ */
+class DrawDataCache {
+public:
+	DrawDataCache(uint32 budget);
+	~DrawDataCache();
+
+	/**
+	 * Tries to draw a DrawData item from the cache.
+	 *
+	 * On a miss, the background of the item may be remembered so the result
+	 * of the actual rendering can be stored with storeResult() afterwards.
+	 *
+	 * @param type      DrawData item to draw.
+	 * @param area      Area covered by the item, including its background offset.
+	 * @param dynamic   Dynamic data passed to the DrawSteps.
+	 * @param shadows   Whether shadows are currently enabled in the renderer.
+	 * @param surface   Surface to draw on.
+	 * @return true if the item was drawn from the cache.
+	 */
+	bool draw(DrawData type, const Common::Rect &area, uint32 dynamic, bool shadows, Graphics::Surface *surface);
+
+	/**
+	 * Stores the pixels rendered after a failed draw() call.
+	 */
+	void storeResult(const Graphics::Surface *surface);
+
+	/** Drops all cached items. */
+	void clear();
+
+private:
+	struct Key {
+		DrawData type;
+		Common::Rect area;
+		uint32 dynamic;
+		bool shadows;
+
+		bool operator==(const Key &key) const {
+			return type == key.type && area == key.area && dynamic == key.dynamic && shadows == key.shadows;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const {
+			uint hash = key.type | (key.shadows ? 0x100 : 0);
+			hash = hash * 31 + key.dynamic;
+			hash = hash * 31 + ((uint16)key.area.left | ((uint16)key.area.top << 16));
+			return hash * 31 + ((uint16)key.area.right | ((uint16)key.area.bottom << 16));
+		}
+	};
+
+	struct Entry {
+		Key key;
+		uint32 size;          ///< Size of each of the pixel buffers
+		byte *background;     ///< Pixels of the area before drawing the item
+		byte *pixels;         ///< Pixels of the area after drawing the item
+		Common::List<Entry *>::iterator lru;
+	};
+
+	typedef Common::HashMap<Key, Entry *, KeyHash> EntryMap;
+	typedef Common::HashMap<Key, bool, KeyHash> KeySet;
+
+	/** Maximum number of items drawn once which are remembered. */
+	static const uint kMaxSeenKeys = 1024;
+
+	void removeEntry(Entry *entry);
+	void freeEntry(Entry *entry);
+
+	EntryMap _map;
+	KeySet _seen;               ///< Items drawn once, which have no entry yet
+	Common::List<Entry *> _lru; ///< Most recently used entries first
+	uint32 _budget;
+	uint32 _used;
+
+	Entry *_pending;            ///< Entry waiting for storeResult() after a miss
+
+	uint32 _hits, _misses;
+};
+
+DrawDataCache::DrawDataCache(uint32 budget) :
+	_budget(budget), _used(0), _pending(0), _hits(0), _misses(0) {
+}
+
+DrawDataCache::~DrawDataCache() {
+	clear();
+}
+
+void DrawDataCache::clear() {
+	if (_hits || _misses)
+		debug(3, "DrawDataCache: %d hits, %d misses, %d bytes used", _hits, _misses, _used);
+
+	for (Common::List<Entry *>::iterator i = _lru.begin(); i != _lru.end(); ++i)
+		freeEntry(*i);
+
+	_lru.clear();
+	_map.clear();
+	_seen.clear();
+	_used = 0;
+	_pending = 0;
+
+	_hits = _misses = 0;
+}
+
+bool DrawDataCache::draw(DrawData type, const Common::Rect &area, uint32 dynamic, bool shadows, Graphics::Surface *surface) {
+	_pending = 0;
+
+	// Items which are clipped by the surface borders are not cached, their
+	// pixels can't be copied from and to the area.
+	if (!surface || area.isEmpty() || area.left < 0 || area.top < 0 || area.right > surface->w || area.bottom > surface->h)
+		return false;
+
+	const uint32 size = area.width() * area.height() * surface->format.bytesPerPixel;
+	if (2 * size > _budget / 2)
+		return false;
+
+	Key key;
+	key.type = type;
+	key.area = area;
+	key.dynamic = dynamic;
+	key.shadows = shadows;
+
+	const int rowBytes = area.width() * surface->format.bytesPerPixel;
+	byte *dst = (byte *)surface->getBasePtr(area.left, area.top);
+
+	Entry *entry;
+	EntryMap::iterator i = _map.find(key);
+	if (i != _map.end()) {
+		entry = i->_value;
+
+		const byte *background = entry->background;
+		const byte *row = dst;
+		int y = 0;
+		for (; y < area.height(); ++y) {
+			if (memcmp(row, background, rowBytes))
+				break;
+			background += rowBytes;
+			row += surface->pitch;
+		}
+
+		_lru.erase(entry->lru);
+		_lru.push_front(entry);
+		entry->lru = _lru.begin();
+
+		if (y == area.height()) {
+			const byte *src = entry->pixels;
+			for (y = 0; y < area.height(); ++y) {
+				memcpy(dst, src, rowBytes);
+				src += rowBytes;
+				dst += surface->pitch;
+			}
+
+			_hits++;
+			return true;
+		}
+
+		// Something else was drawn in the area, render the item again and
+		// reuse the buffers of the entry for the new result.
+	} else if (_seen.contains(key)) {
+		_seen.erase(key);
+
+		while (!_lru.empty() && _used + 2 * size > _budget)
+			removeEntry(_lru.back());
+
+		entry = new Entry;
+		entry->key = key;
+		entry->size = size;
+		entry->background = new byte[size];
+		entry->pixels = new byte[size];
+
+		_lru.push_front(entry);
+		entry->lru = _lru.begin();
+		_map[key] = entry;
+		_used += 2 * size;
+	} else {
+		if (_seen.size() >= kMaxSeenKeys)
+			_seen.clear();
+		_seen[key] = true;
+
+		_misses++;
+		return false;
+	}
+
+	_misses++;
+
+	const byte *src = dst;
+	byte *background = entry->background;
+	for (int y = 0; y < area.height(); ++y) {
+		memcpy(background, src, rowBytes);
+		src += surface->pitch;
+		background += rowBytes;
+	}
+
+	_pending = entry;
+	return false;
+}
+
+void DrawDataCache::storeResult(const Graphics::Surface *surface) {
+	if (!_pending)
+		return;
+
+	Entry *entry = _pending;
+	_pending = 0;
+
+	const int rowBytes = entry->key.area.width() * surface->format.bytesPerPixel;
+	const byte *src = (const byte *)surface->getBasePtr(entry->key.area.left, entry->key.area.top);
+	byte *dst = entry->pixels;
+
+	for (int y = 0; y < entry->key.area.height(); ++y) {
+		memcpy(dst, src, rowBytes);
+		src += surface->pitch;
+		dst += rowBytes;
+	}
+}
+
+void DrawDataCache::removeEntry(Entry *entry) {
+	_map.erase(entry->key);
+	_lru.erase(entry->lru);
+	_used -= 2 * entry->size;
+	freeEntry(entry);
+}
+
+void DrawDataCache::freeEntry(Entry *entry) {
+	delete[] entry->background;
+	delete[] entry->pixels;
+	delete entry;
+}
+
 class ThemeItemBitmap : public ThemeItem {
 public:
 	ThemeItemBitmap(ThemeEngine *engine, const Common::Rect &area, const Graphics::Surface *bitmap, bool alpha) :
@@ -217,9 +460,19 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 		_engine->restoreBackground(extendedRect);
 
 	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
+		Graphics::VectorRenderer *renderer = _engine->renderer();
+		Graphics::Surface *surface = renderer->getActiveSurface();
+		DrawDataCache *cache = _engine->getDrawDataCache();
+		const bool shadows = !renderer->shadowsDisabled();
+
+		if (!cache || !cache->draw(_type, extendedRect, _dynamicData, shadows, surface)) {
+			Common::List<Graphics::DrawStep>::const_iterator step;
+			for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
+				renderer->drawStep(_area, *step, _dynamicData);
+
+			if (cache)
+				cache->storeResult(surface);
+		}
 	}
 
 	_engine->addDirtyRect(extendedRect);
@@ -264,6 +517,7 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system = g_system;
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
+	_drawDataCache = new DrawDataCache(kDrawDataCacheBudget);
 
 	_useCursor = false;
 
@@ -314,6 +568,7 @@ ThemeEngine::~ThemeEngine() {
 
 	delete _parser;
 	delete _themeEval;
+	delete _drawDataCache;
 	delete[] _cursor;
 	delete _themeArchive;
 }
@@ -502,6 +757,10 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	delete _vectorRenderer;
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
+
+	// Cached items were rendered in the old overlay format
+	if (_drawDataCache)
+		_drawDataCache->clear();
 }
 
 void WidgetDrawData::calcBackgroundOffset() {
@@ -523,6 +782,15 @@ void ThemeEngine::restoreBackground(Common::Rect r) {
 	_vectorRenderer->blitSurface(&_backBuffer, r);
 }
 
+void ThemeEngine::setDrawDataCaching(bool enable) {
+	if (enable && !_drawDataCache) {
+		_drawDataCache = new DrawDataCache(kDrawDataCacheBudget);
+	} else if (!enable) {
+		delete _drawDataCache;
+		_drawDataCache = 0;
+	}
+}
+
 
 
 /**********************************************************
@@ -684,6 +952,9 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	if (_drawDataCache)
+		_drawDataCache->clear();
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
@@ -797,7 +1068,7 @@ void ThemeEngine::queueDD(DrawData type, const Common::Rect &r, uint32 dynamic,
 	Common::Rect area = r;
 	area.clip(_screen.w, _screen.h);
 
-	ThemeItemDrawData *q = new ThemeItemDrawData(this, _widgets[type], area, dynamic);
+	ThemeItemDrawData *q = new ThemeItemDrawData(this, type, _widgets[type], area, dynamic);
 
 	if (_buffering) {
 		if (_widgets[type]->_buffer) {
@@ -52,6 +52,7 @@ namespace GUI {
 
 struct WidgetDrawData;
 struct TextDrawData;
+class DrawDataCache;
 struct TextColorData;
 class Dialog;
 class GuiObject;
@@ -243,6 +244,9 @@ public:
 	/** Constant value to expand dirty rectangles, to make sure they are fully copied */
 	static const int kDirtyRectangleThreshold = 1;
 
+	/** Maximum amount of memory used for caching rendered DrawData items and their backgrounds */
+	static const uint32 kDrawDataCacheBudget = 4 * 1024 * 1024;
+
 	struct Renderer {
 		const char *name;
 		const char *shortname;
@@ -468,6 +472,12 @@ public:
 
 	inline ThemeEval *getEvaluator() { return _themeEval; }
 	inline Graphics::VectorRenderer *renderer() { return _vectorRenderer; }
+	inline DrawDataCache *getDrawDataCache() { return _drawDataCache; }
+
+	/**
+	 * Enables or disables caching of rendered DrawData items.
+	 */
+	void setDrawDataCaching(bool enable);
 
 	inline bool supportsImages() const { return true; }
 	inline bool ownCursor() const { return _useCursor; }
@@ -603,6 +613,9 @@ protected:
 	/** Theme getEvaluator (changed from GUI::Eval to add functionality) */
 	GUI::ThemeEval *_themeEval;
 
+	/** Cache of rendered DrawData items, cleared on theme and overlay format changes */
+	DrawDataCache *_drawDataCache;
+
 	/** Main screen surface. This is blitted straight into the overlay. */
 	Graphics::Surface _screen;
 
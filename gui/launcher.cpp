@@ -660,24 +660,26 @@ void LauncherDialog::close() {
 void LauncherDialog::updateListing() {
 	StringArray l;
 
-	// Retrieve a list of all games defined in the config file
+	// Retrieve a list of all games defined in the config file. Only the
+	// values which are listed are read, so that the targets don't have to
+	// be loaded from the config snapshot.
 	_domains.clear();
-	const ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
-	ConfigManager::DomainMap::const_iterator iter;
+	const StringArray domains = ConfMan.getGameDomainNames();
+	StringArray::const_iterator iter;
 	for (iter = domains.begin(); iter != domains.end(); ++iter) {
 #ifdef __DS__
 		// DS port uses an extra section called 'ds'.  This prevents the section from being
 		// detected as a game.
-		if (iter->_key == "ds") {
+		if (*iter == "ds") {
 			continue;
 		}
 #endif
 
-		String gameid(iter->_value.getVal("gameid"));
-		String description(iter->_value.getVal("description"));
+		String gameid(ConfMan.getGameDomainValue(*iter, "gameid"));
+		String description(ConfMan.getGameDomainValue(*iter, "description"));
 
 		if (gameid.empty())
-			gameid = iter->_key;
+			gameid = *iter;
 		if (description.empty()) {
 			GameDescriptor g = EngineMan.findGame(gameid);
 			if (g.contains("description"))
@@ -685,7 +687,7 @@ void LauncherDialog::updateListing() {
 		}
 
 		if (description.empty()) {
-			description = Common::String::format("Unknown (target %s, gameid %s)", iter->_key.c_str(), gameid.c_str());
+			description = Common::String::format("Unknown (target %s, gameid %s)", iter->c_str(), gameid.c_str());
 		}
 
 		if (!gameid.empty() && !description.empty()) {
@@ -695,7 +697,7 @@ void LauncherDialog::updateListing() {
 			while (pos < size && (scumm_stricmp(description.c_str(), l[pos].c_str()) > 0))
 				pos++;
 			l.insert_at(pos, description);
-			_domains.insert_at(pos, iter->_key);
+			_domains.insert_at(pos, *iter);
 		}
 	}
 
@@ -14,6 +14,7 @@ MODULE_OBJS := \
 	object.o \
 	options.o \
 	saveload.o \
+	savemetaindex.o \
 	themebrowser.o \
 	ThemeEngine.o \
 	ThemeEval.o \
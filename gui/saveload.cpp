@@ -25,6 +25,7 @@
 #include "gui/widgets/list.h"
 #include "gui/message.h"
 #include "gui/saveload.h"
+#include "gui/savemetaindex.h"
 #include "gui/ThemeEval.h"
 #include "gui/gui-manager.h"
 
@@ -41,7 +42,7 @@ enum {
 };
 
 SaveLoadChooser::SaveLoadChooser(const String &title, const String &buttonLabel)
-	: Dialog("SaveLoadChooser"), _delSupport(0), _list(0), _chooseButton(0), _deleteButton(0), _gfxWidget(0)  {
+	: Dialog("SaveLoadChooser"), _delSupport(0), _list(0), _chooseButton(0), _deleteButton(0), _gfxWidget(0), _metaIndex(0)  {
 	_delSupport = _metaInfoSupport = _thumbnailSupport = _saveDateSupport = _playTimeSupport = false;
 
 	_backgroundType = ThemeEngine::kDialogBackgroundSpecial;
@@ -74,6 +75,7 @@ SaveLoadChooser::SaveLoadChooser(const String &title, const String &buttonLabel)
 }
 
 SaveLoadChooser::~SaveLoadChooser() {
+	delete _metaIndex;
 }
 
 int SaveLoadChooser::runModalWithPluginAndTarget(const EnginePlugin *plugin, const String &target) {
@@ -93,6 +95,10 @@ int SaveLoadChooser::runModalWithPluginAndTarget(const EnginePlugin *plugin, con
 	_saveDateSupport = _metaInfoSupport && (*_plugin)->hasFeature(MetaEngine::kSavesSupportCreationDate);
 	_playTimeSupport = _metaInfoSupport && (*_plugin)->hasFeature(MetaEngine::kSavesSupportPlayTime);
 	_resultString = "";
+
+	delete _metaIndex;
+	_metaIndex = _metaInfoSupport ? new SaveMetaIndex(target) : 0;
+
 	reflowLayout();
 	updateSaveList();
 
@@ -130,20 +136,16 @@ void SaveLoadChooser::handleCommand(CommandSender *sender, uint32 cmd, uint32 da
 		if (selItem >= 0 && _chooseButton->isEnabled()) {
 			if (_list->isEditable() || !_list->getSelectedString().empty()) {
 				_list->endEditMode();
-				if (!_saveList.empty()) {
-					setResult(atoi(_saveList[selItem].save_slot().c_str()));
-					_resultString = _list->getSelectedString();
-				}
+				if (!_saveList.empty())
+					chooseSlot(selItem);
 				close();
 			}
 		}
 		break;
 	case kChooseCmd:
 		_list->endEditMode();
-		if (!_saveList.empty()) {
-			setResult(atoi(_saveList[selItem].save_slot().c_str()));
-			_resultString = _list->getSelectedString();
-		}
+		if (!_saveList.empty())
+			chooseSlot(selItem);
 		close();
 		break;
 	case GUI::kListSelectionChangedCmd:
@@ -154,7 +156,10 @@ void SaveLoadChooser::handleCommand(CommandSender *sender, uint32 cmd, uint32 da
 			MessageDialog alert(_("Do you really want to delete this savegame?"),
 								_("Delete"), _("Cancel"));
 			if (alert.runModal() == GUI::kMessageOK) {
-				(*_plugin)->removeSaveState(_target.c_str(), atoi(_saveList[selItem].save_slot().c_str()));
+				const int slot = atoi(_saveList[selItem].save_slot().c_str());
+				(*_plugin)->removeSaveState(_target.c_str(), slot);
+				if (_metaIndex)
+					_metaIndex->remove(slot);
 
 				setResult(-1);
 				_list->setSelected(-1);
@@ -171,6 +176,18 @@ void SaveLoadChooser::handleCommand(CommandSender *sender, uint32 cmd, uint32 da
 	}
 }
 
+void SaveLoadChooser::chooseSlot(int selItem) {
+	const int slot = atoi(_saveList[selItem].save_slot().c_str());
+
+	// The engine is going to overwrite the slot, so its indexed meta
+	// information is stale.
+	if (_metaIndex && _list->isEditable())
+		_metaIndex->remove(slot);
+
+	setResult(slot);
+	_resultString = _list->getSelectedString();
+}
+
 void SaveLoadChooser::reflowLayout() {
 	if (g_gui.xmlEval()->getVar("Globals.SaveLoadChooser.ExtInfo.Visible") == 1 && _thumbnailSupport) {
 		int16 x, y;
@@ -241,7 +258,13 @@ void SaveLoadChooser::updateSelection(bool redraw) {
 	_playtime->setLabel(_("No playtime saved"));
 
 	if (selItem >= 0 && !_list->getSelectedString().empty() && _metaInfoSupport) {
-		SaveStateDescriptor desc = (*_plugin)->querySaveMetaInfos(_target.c_str(), atoi(_saveList[selItem].save_slot().c_str()));
+		const int slot = atoi(_saveList[selItem].save_slot().c_str());
+		SaveStateDescriptor desc(slot, _saveList[selItem].description());
+
+		if (!_metaIndex)
+			desc = (*_plugin)->querySaveMetaInfos(_target.c_str(), slot);
+		else if (!_metaIndex->lookup(slot, desc))
+			desc = _metaIndex->query(*_plugin, slot);
 
 		isDeletable = desc.getBool("is_deletable") && _delSupport;
 		isWriteProtected = desc.getBool("is_write_protected");
@@ -314,12 +337,18 @@ void SaveLoadChooser::close() {
 	_saveList.clear();
 	_list->setList(StringArray());
 
+	delete _metaIndex;
+	_metaIndex = 0;
+
 	Dialog::close();
 }
 
 void SaveLoadChooser::updateSaveList() {
 	_saveList = (*_plugin)->listSaves(_target.c_str());
 
+	if (_metaIndex)
+		_metaIndex->validate(_saveList);
+
 	int curSlot = 0;
 	int saveSlot = 0;
 	StringArray saveNames;
@@ -33,6 +33,7 @@ class ButtonWidget;
 class CommandSender;
 class ContainerWidget;
 class StaticTextWidget;
+class SaveMetaIndex;
 
 class SaveLoadChooser : GUI::Dialog {
 	typedef Common::String String;
@@ -56,11 +57,13 @@ protected:
 	String					_target;
 	SaveStateList			_saveList;
 	String					_resultString;
+	SaveMetaIndex			*_metaIndex;
 
 	uint8 _fillR, _fillG, _fillB;
 
 	void updateSaveList();
 	void updateSelection(bool redraw);
+	void chooseSlot(int selItem);
 public:
 	SaveLoadChooser(const String &title, const String &buttonLabel);
 	~SaveLoadChooser();
@@ -0,0 +1,429 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/list.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "graphics/surface.h"
+
+#include "gui/savemetaindex.h"
+
+namespace GUI {
+
+enum {
+	kIndexTag = MKTAG('S','M','I','X'),
+	kIndexVersion = 2
+};
+
+/**
+ * Drops index entries when the savefiles they were queried from change, and
+ * records which savefiles the engine loads while a slot is queried.
+ */
+class SaveMetaListener : public Common::SaveFileListener {
+public:
+	SaveMetaListener() : _recording(false) {}
+
+	void savefileLoaded(const Common::String &name) {
+		if (_recording)
+			_loaded.push_back(name);
+	}
+
+	void savefileChanged(const Common::String &name);
+
+	bool _recording;
+	Common::StringArray _loaded;            ///< Savefiles loaded while recording
+	Common::List<SaveMetaIndex *> _indexes; ///< Indexes currently in memory
+};
+
+static SaveMetaListener *s_listener = 0;
+
+void SaveMetaListener::savefileChanged(const Common::String &name) {
+	const Common::String target = ConfMan.getActiveDomainName();
+	bool inMemory = false;
+
+	// Writing an index doesn't affect any other
+	if (name == SaveMetaIndex::getFilename(target))
+		return;
+	for (Common::List<SaveMetaIndex *>::iterator i = _indexes.begin(); i != _indexes.end(); ++i) {
+		if (name == SaveMetaIndex::getFilename((*i)->getTarget()))
+			return;
+	}
+
+	// Indexes in memory are written back when they are closed
+	for (Common::List<SaveMetaIndex *>::iterator i = _indexes.begin(); i != _indexes.end(); ++i) {
+		(*i)->invalidate(name);
+		if ((*i)->getTarget() == target)
+			inMemory = true;
+	}
+
+	if (!inMemory && !target.empty()) {
+		SaveMetaIndex index(target);
+		index.invalidate(name);
+	}
+}
+
+void SaveMetaIndex::attach() {
+	if (!s_listener)
+		s_listener = new SaveMetaListener();
+	g_system->getSavefileManager()->setListener(s_listener);
+}
+
+void SaveMetaIndex::detach() {
+	g_system->getSavefileManager()->setListener(0);
+	delete s_listener;
+	s_listener = 0;
+}
+
+static void writeIndexString(Common::WriteStream &out, const Common::String &str) {
+	out.writeUint16LE(str.size());
+	out.write(str.c_str(), str.size());
+}
+
+/** Position of a thumbnail in the index, to read them in the order they are stored. */
+struct ThumbnailPosition {
+	uint32 offset;
+	int slot;
+
+	ThumbnailPosition() : offset(0), slot(0) {}
+	ThumbnailPosition(uint32 o, int s) : offset(o), slot(s) {}
+
+	bool operator<(const ThumbnailPosition &pos) const {
+		return offset < pos.offset;
+	}
+};
+
+static Common::String readIndexString(Common::ReadStream &in) {
+	Common::String str;
+	uint16 size = in.readUint16LE();
+	while (size--)
+		str += (char)in.readByte();
+	return str;
+}
+
+SaveMetaIndex::SaveMetaIndex(const Common::String &target) : _target(target), _dirty(false), _in(0) {
+	_filename = getFilename(target);
+	load();
+
+	if (s_listener)
+		s_listener->_indexes.push_back(this);
+}
+
+SaveMetaIndex::~SaveMetaIndex() {
+	if (s_listener)
+		s_listener->_indexes.remove(this);
+
+	flush();
+	delete _in;
+}
+
+void SaveMetaIndex::load() {
+	Common::ScopedPtr<Common::InSaveFile> in(g_system->getSavefileManager()->openForLoading(_filename));
+	if (!in)
+		return;
+
+	if (in->readUint32BE() != kIndexTag || in->readByte() != kIndexVersion) {
+		warning("SaveMetaIndex: Ignoring invalid index '%s'", _filename.c_str());
+		return;
+	}
+
+	const uint32 count = in->readUint32LE();
+	Common::Array<int> slots;
+
+	for (uint32 i = 0; i < count && !in->eos(); ++i) {
+		const int slot = in->readSint32LE();
+		Entry &entry = _entries[slot];
+		slots.push_back(slot);
+
+		uint16 values = in->readUint16LE();
+		while (values--) {
+			const Common::String key = readIndexString(*in);
+			entry.values.setVal(key, readIndexString(*in));
+		}
+
+		uint16 savefiles = in->readUint16LE();
+		while (savefiles--)
+			entry.savefiles.push_back(readIndexString(*in));
+
+		entry.thumbnailOffset = in->readUint32LE();
+		entry.hasThumbnail = (entry.thumbnailOffset != 0xFFFFFFFF);
+	}
+
+	if (in->err() || in->eos()) {
+		warning("SaveMetaIndex: Index '%s' is truncated", _filename.c_str());
+		_entries.clear();
+		return;
+	}
+
+	// Thumbnail offsets are stored relative to the end of the table
+	const uint32 base = in->pos();
+	for (uint i = 0; i < slots.size(); ++i) {
+		Entry &entry = _entries[slots[i]];
+		if (entry.hasThumbnail)
+			entry.thumbnailOffset += base;
+	}
+
+	// The thumbnails follow the table, so they are read from where it ends
+	_in = in.release();
+}
+
+bool SaveMetaIndex::loadThumbnail(Entry &entry) {
+	if (!_in)
+		_in = g_system->getSavefileManager()->openForLoading(_filename);
+
+	Common::InSaveFile *in = _in;
+	if (!in || !in->seek(entry.thumbnailOffset))
+		return false;
+
+	const uint16 w = in->readUint16LE();
+	const uint16 h = in->readUint16LE();
+
+	Graphics::PixelFormat format;
+	format.bytesPerPixel = in->readByte();
+	format.rLoss = in->readByte();
+	format.gLoss = in->readByte();
+	format.bLoss = in->readByte();
+	format.aLoss = in->readByte();
+	format.rShift = in->readByte();
+	format.gShift = in->readByte();
+	format.bShift = in->readByte();
+	format.aShift = in->readByte();
+
+	// Thumbnails are stored ready to be displayed, so they have to be
+	// queried again when the overlay format changed.
+	if (format != g_system->getOverlayFormat())
+		return false;
+
+	Graphics::Surface *thumb = new Graphics::Surface();
+	thumb->create(w, h, format);
+
+	const uint32 rowBytes = w * format.bytesPerPixel;
+	for (int y = 0; y < h; ++y)
+		in->read(thumb->getBasePtr(0, y), rowBytes);
+
+	if (in->err() || in->eos()) {
+		thumb->free();
+		delete thumb;
+		return false;
+	}
+
+	entry.thumbnail = Common::SharedPtr<Graphics::Surface>(thumb, Graphics::SharedPtrSurfaceDeleter());
+	return true;
+}
+
+void SaveMetaIndex::validate(const SaveStateList &saves) {
+	EntryMap valid;
+
+	for (SaveStateList::const_iterator i = saves.begin(); i != saves.end(); ++i) {
+		const int slot = atoi(i->save_slot().c_str());
+		EntryMap::iterator entry = _entries.find(slot);
+
+		if (entry != _entries.end() && entry->_value.values.getVal("description") == i->description())
+			valid[slot] = entry->_value;
+	}
+
+	if (valid.size() != _entries.size()) {
+		_entries = valid;
+		_dirty = true;
+	}
+}
+
+bool SaveMetaIndex::lookup(int slot, SaveStateDescriptor &desc) {
+	EntryMap::iterator i = _entries.find(slot);
+	if (i == _entries.end())
+		return false;
+
+	Entry &entry = i->_value;
+	if (entry.hasThumbnail && !entry.thumbnail && !loadThumbnail(entry)) {
+		_entries.erase(i);
+		_dirty = true;
+		return false;
+	}
+
+	for (Common::StringMap::const_iterator value = entry.values.begin(); value != entry.values.end(); ++value)
+		desc.setVal(value->_key, value->_value);
+
+	if (entry.thumbnail) {
+		Graphics::Surface *thumb = new Graphics::Surface();
+		thumb->copyFrom(*entry.thumbnail);
+		desc.setThumbnail(thumb);
+	}
+
+	return true;
+}
+
+SaveStateDescriptor SaveMetaIndex::query(const EnginePlugin &plugin, int slot) {
+	if (s_listener) {
+		s_listener->_recording = true;
+		s_listener->_loaded.clear();
+	}
+
+	const SaveStateDescriptor desc = plugin->querySaveMetaInfos(_target.c_str(), slot);
+	if (!s_listener)
+		return desc;
+
+	s_listener->_recording = false;
+
+	// Without knowing which savefiles the engine read, the entry could not
+	// be dropped when they change.
+	if (s_listener->_loaded.empty() || atoi(desc.save_slot().c_str()) != slot)
+		return desc;
+
+	Entry entry;
+	entry.savefiles = s_listener->_loaded;
+	entry.values = desc;
+	entry.values.erase("save_slot");
+	entry.thumbnailOffset = 0;
+	entry.hasThumbnail = false;
+
+	const Graphics::Surface *thumb = desc.getThumbnail();
+	if (thumb) {
+		Graphics::Surface *copy = new Graphics::Surface();
+		copy->copyFrom(*thumb);
+		entry.thumbnail = Common::SharedPtr<Graphics::Surface>(copy, Graphics::SharedPtrSurfaceDeleter());
+		entry.hasThumbnail = true;
+	}
+
+	_entries[slot] = entry;
+	_dirty = true;
+
+	return desc;
+}
+
+void SaveMetaIndex::remove(int slot) {
+	if (_entries.contains(slot)) {
+		_entries.erase(slot);
+		_dirty = true;
+	}
+}
+
+void SaveMetaIndex::invalidate(const Common::String &savefile) {
+	Common::Array<int> stale;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Common::StringArray &savefiles = i->_value.savefiles;
+		if (Common::find(savefiles.begin(), savefiles.end(), savefile) != savefiles.end())
+			stale.push_back(i->_key);
+	}
+
+	for (uint i = 0; i < stale.size(); ++i)
+		remove(stale[i]);
+}
+
+void SaveMetaIndex::flush() {
+	if (!_dirty)
+		return;
+
+	_dirty = false;
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+
+	// All thumbnails have to be in memory before the old index is replaced.
+	// They are read in the order they are stored, and kept in memory
+	// afterwards, so the stored offsets aren't needed anymore.
+	Common::Array<ThumbnailPosition> missing;
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->_value.hasThumbnail && !i->_value.thumbnail)
+			missing.push_back(ThumbnailPosition(i->_value.thumbnailOffset, i->_key));
+	}
+
+	Common::sort(missing.begin(), missing.end());
+	for (uint i = 0; i < missing.size(); ++i) {
+		if (!loadThumbnail(_entries[missing[i].slot]))
+			_entries.erase(missing[i].slot);
+	}
+
+	delete _in;
+	_in = 0;
+
+	if (_entries.empty()) {
+		saveFileMan->removeSavefile(_filename);
+		return;
+	}
+
+	Common::MemoryWriteStreamDynamic table(DisposeAfterUse::YES);
+	Common::MemoryWriteStreamDynamic thumbnails(DisposeAfterUse::YES);
+
+	Common::Array<int> slots;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+		slots.push_back(i->_key);
+	Common::sort(slots.begin(), slots.end());
+
+	for (uint i = 0; i < slots.size(); ++i) {
+		const Entry &entry = _entries[slots[i]];
+
+		table.writeSint32LE(slots[i]);
+		table.writeUint16LE(entry.values.size());
+		for (Common::StringMap::const_iterator value = entry.values.begin(); value != entry.values.end(); ++value) {
+			writeIndexString(table, value->_key);
+			writeIndexString(table, value->_value);
+		}
+
+		table.writeUint16LE(entry.savefiles.size());
+		for (uint j = 0; j < entry.savefiles.size(); ++j)
+			writeIndexString(table, entry.savefiles[j]);
+
+		const Graphics::Surface *thumb = entry.thumbnail.get();
+		if (!thumb) {
+			table.writeUint32LE(0xFFFFFFFF);
+			continue;
+		}
+
+		table.writeUint32LE(thumbnails.pos());
+
+		thumbnails.writeUint16LE(thumb->w);
+		thumbnails.writeUint16LE(thumb->h);
+		thumbnails.writeByte(thumb->format.bytesPerPixel);
+		thumbnails.writeByte(thumb->format.rLoss);
+		thumbnails.writeByte(thumb->format.gLoss);
+		thumbnails.writeByte(thumb->format.bLoss);
+		thumbnails.writeByte(thumb->format.aLoss);
+		thumbnails.writeByte(thumb->format.rShift);
+		thumbnails.writeByte(thumb->format.gShift);
+		thumbnails.writeByte(thumb->format.bShift);
+		thumbnails.writeByte(thumb->format.aShift);
+
+		for (int y = 0; y < thumb->h; ++y)
+			thumbnails.write(thumb->getBasePtr(0, y), thumb->w * thumb->format.bytesPerPixel);
+	}
+
+	Common::OutSaveFile *out = saveFileMan->openForSaving(_filename);
+	if (!out) {
+		warning("SaveMetaIndex: Could not write index '%s'", _filename.c_str());
+		return;
+	}
+
+	out->writeUint32BE(kIndexTag);
+	out->writeByte(kIndexVersion);
+	out->writeUint32LE(_entries.size());
+	out->write(table.getData(), table.size());
+	out->write(thumbnails.getData(), thumbnails.size());
+	out->finalize();
+
+	if (out->err())
+		warning("SaveMetaIndex: Could not write index '%s'", _filename.c_str());
+
+	delete out;
+}
+
+} // End of namespace GUI
@@ -0,0 +1,141 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_SAVEMETAINDEX_H
+#define GUI_SAVEMETAINDEX_H
+
+#include "common/hashmap.h"
+#include "common/ptr.h"
+#include "common/savefile.h"
+#include "common/str.h"
+
+#include "engines/metaengine.h"
+#include "engines/savestate.h"
+
+namespace Graphics {
+struct Surface;
+}
+
+namespace GUI {
+
+/**
+ * Per target index of save state meta information.
+ *
+ * Querying the meta information of a save state makes the engine open and
+ * inflate the save file and convert its thumbnail. The index keeps the result
+ * of MetaEngine::querySaveMetaInfos() for every slot which was looked at in a
+ * savefile next to the saves, with thumbnails stored in the overlay format.
+ *
+ * Only the descriptive values are loaded when the index is opened; thumbnails
+ * are read from the index file when their slot is actually displayed. Like
+ * all savefiles, the index may be compressed, where seeking backwards means
+ * inflating it from the start again. It is thus read through a single stream,
+ * with thumbnails stored in slot order, the order in which they are usually
+ * displayed.
+ *
+ * The engines write and remove their save files without telling the GUI.
+ * Every entry therefore records the savefiles the engine loaded to query it,
+ * and is dropped when the save file manager reports that one of them gets
+ * written or removed, see attach(). Slots are only indexed with save file
+ * managers which send these notifications. The index still has to be
+ * validated against the list returned by MetaEngine::listSaves() before it is
+ * used, for slots which were added or removed.
+ */
+class SaveMetaIndex {
+public:
+	SaveMetaIndex(const Common::String &target);
+	~SaveMetaIndex();
+
+	/**
+	 * Starts keeping the indexes up to date with the savefiles changed
+	 * through the save file manager of g_system.
+	 */
+	static void attach();
+
+	/** Stops listening to the save file manager, see attach(). */
+	static void detach();
+
+	/** Returns the name of the savefile holding the index of a target. */
+	static Common::String getFilename(const Common::String &target) {
+		// The name must not match any of the patterns the engines use to
+		// list their save files, which usually are variations of "target.*".
+		return target.empty() ? Common::String() : target + "-savemeta.idx";
+	}
+
+	/**
+	 * Drops all entries whose slot doesn't exist anymore or whose
+	 * description differs from the one reported by the engine.
+	 */
+	void validate(const SaveStateList &saves);
+
+	/**
+	 * Looks up the meta information of a slot.
+	 *
+	 * @param slot   Save slot to look up.
+	 * @param desc   Descriptor receiving the meta information and thumbnail.
+	 * @return true if the slot was found in the index.
+	 */
+	bool lookup(int slot, SaveStateDescriptor &desc);
+
+	/**
+	 * Queries the meta information of a slot from the engine, and adds it
+	 * to the index.
+	 */
+	SaveStateDescriptor query(const EnginePlugin &plugin, int slot);
+
+	/** Removes a slot, e.g. when it got deleted or is about to be overwritten. */
+	void remove(int slot);
+
+	/** Returns the target the index belongs to. */
+	const Common::String &getTarget() const { return _target; }
+
+	/** Drops all entries queried from the given savefile. */
+	void invalidate(const Common::String &savefile);
+
+	/** Writes the index back to its savefile, if anything changed. */
+	void flush();
+
+private:
+	struct Entry {
+		Common::StringMap values;
+		Common::StringArray savefiles;      ///< Savefiles loaded by the engine to query the slot
+		bool hasThumbnail;
+		uint32 thumbnailOffset;             ///< Offset of the thumbnail in the index file
+		Common::SharedPtr<Graphics::Surface> thumbnail; ///< Thumbnail, once loaded
+	};
+
+	typedef Common::HashMap<int, Entry> EntryMap;
+
+	void load();
+	bool loadThumbnail(Entry &entry);
+
+	Common::String _target;
+	Common::String _filename;
+	EntryMap _entries;
+	bool _dirty;
+
+	Common::InSaveFile *_in;                ///< Stream thumbnails are read from, opened on demand
+};
+
+} // End of namespace GUI
+
+#endif
@@ -0,0 +1,128 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/dbopl.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+class DBOPLTestSuite : public CxxTest::TestSuite
+{
+private:
+	typedef OPL::DOSBox::DBOPL::Chip Chip;
+
+	static const uint kRate = 44100;
+	static const uint kBlock = 512;
+
+	static uint operatorOffset(int channel) {
+		static const uint offsets[9] = { 0, 1, 2, 8, 9, 10, 16, 17, 18 };
+		return offsets[channel % 9] + (channel >= 9 ? 0x100 : 0);
+	}
+
+	static uint channelOffset(int channel) {
+		return (channel % 9) + (channel >= 9 ? 0x100 : 0);
+	}
+
+	/**
+	 * Programs a different instrument on every channel, so that all
+	 * envelope states, wave forms, feedback and connection types are hit.
+	 */
+	static void setupInstruments(Chip &chip, int channels) {
+		chip.WriteReg(0x01, 0x20);
+		for (int c = 0; c < channels; ++c) {
+			const uint op = operatorOffset(c);
+			const uint ch = channelOffset(c);
+
+			chip.WriteReg(0x20 + op, (c * 0x37 + 0x01) & 0xff);
+			chip.WriteReg(0x23 + op, (c * 0x53 + 0x21) & 0xff);
+			chip.WriteReg(0x40 + op, (c * 5) & 0x3f);
+			chip.WriteReg(0x43 + op, (c * 0x41) & 0xc7);
+			chip.WriteReg(0x60 + op, 0xf0 - c * 0x11 + 3);
+			chip.WriteReg(0x63 + op, 0xd4 + c * 0x03);
+			chip.WriteReg(0x80 + op, 0x25 + c * 0x12);
+			chip.WriteReg(0x83 + op, 0x16 + c * 0x21);
+			chip.WriteReg(0xe0 + op, c & 7);
+			chip.WriteReg(0xe3 + op, (c + 3) & 7);
+			chip.WriteReg(0xc0 + ch, 0x30 | ((c * 3) & 0x0f));
+		}
+	}
+
+	static void keyOn(Chip &chip, int channels, int octave, bool on) {
+		for (int c = 0; c < channels; ++c) {
+			const uint ch = channelOffset(c);
+			const uint fnum = 0x150 + c * 0x1b;
+			chip.WriteReg(0xa0 + ch, fnum & 0xff);
+			chip.WriteReg(0xb0 + ch, (on ? 0x20 : 0) | ((octave + c) & 7) << 2 | fnum >> 8);
+		}
+	}
+
+	static uint32 render(Chip &chip, uint32 hash, bool stereo, uint blocks) {
+		int32 buffer[kBlock * 2];
+		const uint length = stereo ? kBlock * 2 : kBlock;
+
+		while (blocks--) {
+			if (stereo)
+				chip.GenerateBlock3(kBlock, buffer);
+			else
+				chip.GenerateBlock2(kBlock, buffer);
+
+			for (uint i = 0; i < length; ++i)
+				hash = hash * 31 + (uint32)buffer[i];
+		}
+
+		return hash;
+	}
+
+	static uint32 renderProgram(bool opl3, uint8 fourOp, uint8 rhythm) {
+		OPL::DOSBox::DBOPL::InitTables();
+		Chip chip;
+		chip.Setup(kRate);
+
+		const int channels = opl3 ? 18 : 9;
+		if (opl3) {
+			chip.WriteReg(0x105, 1);
+			chip.WriteReg(0x104, fourOp);
+		}
+
+		setupInstruments(chip, channels);
+		chip.WriteReg(0xbd, 0xc0 | rhythm);
+
+		uint32 hash = 0;
+		keyOn(chip, channels, 2, true);
+		hash = render(chip, hash, opl3, 40);
+		chip.WriteReg(0xbd, 0x00 | (rhythm & 0x20));
+		keyOn(chip, channels, 2, false);
+		hash = render(chip, hash, opl3, 20);
+		keyOn(chip, channels, 4, true);
+		chip.WriteReg(0xbd, 0x40 | rhythm);
+		hash = render(chip, hash, opl3, 30);
+		keyOn(chip, channels, 4, false);
+		hash = render(chip, hash, opl3, 60);
+
+		return hash;
+	}
+
+public:
+	// The checksums are taken from the sample by sample renderer, the
+	// output of the emulator has to stay bit exact.
+
+	void test_opl2_melodic() {
+		TS_ASSERT_EQUALS(renderProgram(false, 0x00, 0x00), 2052650975u);
+	}
+
+	void test_opl2_rhythm() {
+		TS_ASSERT_EQUALS(renderProgram(false, 0x00, 0x3f), 3752941870u);
+	}
+
+	void test_opl3_melodic() {
+		TS_ASSERT_EQUALS(renderProgram(true, 0x00, 0x00), 2248674752u);
+	}
+
+	void test_opl3_four_operator() {
+		TS_ASSERT_EQUALS(renderProgram(true, 0x3f, 0x00), 1498216192u);
+	}
+
+	void test_opl3_four_operator_rhythm() {
+		TS_ASSERT_EQUALS(renderProgram(true, 0x2d, 0x3f), 2848980928u);
+	}
+};
+
+#endif
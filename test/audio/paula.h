@@ -0,0 +1,241 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mods/paula.h"
+
+#include "test/system.h"
+
+class PaulaTestSuite : public CxxTest::TestSuite
+{
+private:
+	static const int kRate = 44100;
+	static const int kIntFreq = kRate / 50;
+
+	enum {
+		kLoopSize = 1000,
+		kShotSize = 300,
+		kLongSize = 70000,
+		kNumSamples = 3
+	};
+
+	struct Sample {
+		const int8 *data;
+		uint32 length;
+		uint32 repeatStart;
+		uint32 repeatLength;
+	};
+
+	/** Starts a sample on a voice at the given tick, or only changes period and volume if sample is -1. */
+	struct Event {
+		uint tick;
+		int voice;
+		int sample;
+		int16 period;
+		byte volume;
+	};
+
+	static const Event *getEvents() {
+		static const Event events[] = {
+			{  0, 0,  0, 428, 64 }, {  0, 1,  1, 214, 48 }, {  0, 2,  2, 856, 32 },
+			{  3, 3,  0, 113, 40 }, {  5, 1,  1, 320, 64 }, {  7, 0, -1, 254, 80 },
+			{ 10, 2,  0,  60, 64 }, { 12, 3,  1, 508, 20 }, { 15, 1, -1, 124, 64 },
+			{ 18, 0,  2, 170, 50 }, { 21, 3, -1,  95, 64 }, { 25, 2,  1, 678, 64 },
+			{ 30, 1,  0, 285, 33 }, { 0xffff, 0, 0, 0, 0 }
+		};
+		return events;
+	}
+
+	// Paula needs a mutex
+	TestSystem _system;
+
+	Sample _samples[kNumSamples];
+	int8 _loop[kLoopSize];
+	int8 _shot[kShotSize];
+	int8 *_long;
+
+	/** Paula playing the events, one tick per interrupt. */
+	class EventPaula : public Audio::Paula {
+	public:
+		EventPaula(const Sample *samples, bool stereo) : Paula(stereo, kRate, kIntFreq), _samples(samples), _tick(0) {
+			startPaula();
+		}
+
+	protected:
+		void interrupt() {
+			for (const Event *e = getEvents(); e->tick != 0xffff; ++e) {
+				if (e->tick != _tick)
+					continue;
+				if (e->sample >= 0) {
+					const Sample &s = _samples[e->sample];
+					setChannelData(e->voice, s.data, s.repeatLength ? s.data + s.repeatStart : 0, s.length, s.repeatLength);
+				}
+				setChannelPeriod(e->voice, e->period);
+				setChannelVolume(e->voice, e->volume);
+			}
+			_tick++;
+		}
+
+	private:
+		const Sample *_samples;
+		uint _tick;
+	};
+
+	struct RefVoice {
+		const int8 *data;
+		const int8 *dataRepeat;
+		uint32 length;
+		uint32 lengthRepeat;
+		int16 period;
+		byte volume;
+		Audio::Paula::Offset offset;
+		byte panning;
+	};
+
+	template<bool stereo>
+	static int refMix(int16 *&buf, RefVoice &v, frac_t rate, int neededSamples) {
+		int samples;
+		for (samples = 0; samples < neededSamples && v.offset.int_off < v.length; ++samples) {
+			const int32 tmp = ((int32)v.data[v.offset.int_off]) * v.volume;
+			if (stereo) {
+				*buf++ += (tmp * (255 - v.panning)) >> 7;
+				*buf++ += (tmp * (v.panning)) >> 7;
+			} else
+				*buf++ += tmp;
+
+			v.offset.rem_off += rate;
+			if (v.offset.rem_off >= (frac_t)FRAC_ONE) {
+				v.offset.int_off += fracToInt(v.offset.rem_off);
+				v.offset.rem_off &= FRAC_LO_MASK;
+			}
+		}
+
+		return samples;
+	}
+
+	/** The sample by sample mixer Paula used before it mixed in blocks. */
+	template<bool stereo>
+	void refRender(int16 *buffer, int frames) {
+		RefVoice voices[Audio::Paula::NUM_VOICES];
+		static const byte panning[Audio::Paula::NUM_VOICES] = { 191, 63, 63, 191 };
+		for (int i = 0; i < Audio::Paula::NUM_VOICES; ++i) {
+			voices[i] = RefVoice();
+			voices[i].panning = panning[i];
+		}
+
+		const double periodScale = (double)Audio::Paula::kPalPaulaClock / kRate;
+		uint curInt = 0, tick = 0;
+
+		memset(buffer, 0, frames * (stereo ? 4 : 2));
+		while (frames > 0) {
+			if (curInt == 0) {
+				curInt = kIntFreq;
+				for (const Event *e = getEvents(); e->tick != 0xffff; ++e) {
+					if (e->tick != tick)
+						continue;
+					RefVoice &v = voices[e->voice];
+					if (e->sample >= 0) {
+						const Sample &s = _samples[e->sample];
+						v.data = s.data;
+						v.length = s.length;
+						v.dataRepeat = s.repeatLength ? s.data + s.repeatStart : 0;
+						v.lengthRepeat = s.repeatLength;
+						v.offset = Audio::Paula::Offset(0);
+					}
+					v.period = e->period;
+					v.volume = e->volume;
+				}
+				tick++;
+			}
+
+			const int n = MIN<int>(frames, curInt);
+			for (int i = 0; i < Audio::Paula::NUM_VOICES; ++i) {
+				RefVoice &v = voices[i];
+				if (!v.data || v.period <= 0)
+					continue;
+
+				const frac_t rate = doubleToFrac(periodScale / v.period);
+				v.volume = MIN<byte>(0x40, v.volume);
+
+				int16 *p = buffer;
+				int needed = n - refMix<stereo>(p, v, rate, n);
+				if (v.offset.int_off >= v.length) {
+					v.offset.int_off -= v.length;
+					v.data = v.dataRepeat;
+					v.length = v.lengthRepeat;
+				}
+
+				if (needed > 0 && v.length > 2) {
+					while (needed > 0) {
+						needed -= refMix<stereo>(p, v, rate, needed);
+						if (v.offset.int_off >= v.length)
+							v.offset.int_off -= v.length;
+					}
+				}
+			}
+
+			buffer += stereo ? n * 2 : n;
+			curInt -= n;
+			frames -= n;
+		}
+	}
+
+	void compareWithReference(bool stereo) {
+		const int frames = kIntFreq * 40;
+		const int length = stereo ? frames * 2 : frames;
+		int16 *expected = new int16[length];
+		int16 *output = new int16[length];
+
+		if (stereo)
+			refRender<true>(expected, frames);
+		else
+			refRender<false>(expected, frames);
+
+		// Read in chunks which don't line up with the interrupts
+		EventPaula paula(_samples, stereo);
+		TS_ASSERT_EQUALS(paula.getInterpolation(), Audio::Paula::kInterpolationNone);
+		const int chunk = stereo ? 1234 : 617;
+		for (int pos = 0; pos < length; pos += chunk)
+			TS_ASSERT_EQUALS(paula.readBuffer(output + pos, MIN(chunk, length - pos)), MIN(chunk, length - pos));
+
+		TS_ASSERT_EQUALS(memcmp(expected, output, length * sizeof(int16)), 0);
+
+		delete[] expected;
+		delete[] output;
+	}
+
+public:
+	void setUp() {
+		g_system = &_system;
+
+		uint32 seed = 1;
+		for (int i = 0; i < kLoopSize; ++i)
+			_loop[i] = (int8)((i * 37) & 0xff) / 2 + ((i & 8) ? 40 : -40);
+		for (int i = 0; i < kShotSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_shot[i] = (int8)(seed >> 24);
+		}
+		_long = new int8[kLongSize];
+		for (int i = 0; i < kLongSize; ++i)
+			_long[i] = (int8)(i * 7);
+
+		// A looping sample, a one-shot sample, and one too long for the 16.16 countdown
+		const Sample samples[kNumSamples] = {
+			{ _loop, kLoopSize, 400, kLoopSize - 400 },
+			{ _shot, kShotSize, 0, 0 },
+			{ _long, kLongSize, 0, kLongSize }
+		};
+		memcpy(_samples, samples, sizeof(_samples));
+	}
+
+	void tearDown() {
+		delete[] _long;
+		g_system = 0;
+	}
+
+	void test_default_mono_bit_exact() {
+		compareWithReference(false);
+	}
+
+	void test_default_stereo_bit_exact() {
+		compareWithReference(true);
+	}
+};
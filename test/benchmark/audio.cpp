@@ -0,0 +1,552 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Offline throughput benchmark for the audio decoders and the mixer.
+ *
+ * Every fixture is decoded through readBuffer() in chunks of the given sizes
+ * until enough time has passed, and the decoded samples per second and the
+ * number of operator new calls per second are reported. Fixtures for the
+ * PCM and ADPCM decoders are generated in memory; files given on the command
+ * line are picked by their extension.
+ *
+ * The mixer mode plays looping streams on N channels of a MixerImpl and
+ * calls its mixCallback() directly, without any backend.
+ *
+ * Usage: audio_bench [-c chunk[,chunk...]] [-t seconds] [-m channels] [file...]
+ */
+
+// The benchmark reads its fixtures with stdio and measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "audio/decoders/adpcm.h"
+#include "audio/decoders/aiff.h"
+#include "audio/decoders/flac.h"
+#include "audio/decoders/mp3.h"
+#include "audio/decoders/quicktime.h"
+#include "audio/decoders/raw.h"
+#include "audio/decoders/vag.h"
+#include "audio/decoders/voc.h"
+#include "audio/decoders/vorbis.h"
+#include "audio/decoders/wave.h"
+
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/system.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#pragma mark --- Allocation counting ---
+
+static uint32 s_allocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc) {
+	s_allocations++;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		abort();
+	return ptr;
+}
+
+void *operator new[](size_t size) throw(std::bad_alloc) {
+	return operator new(size);
+}
+
+void operator delete(void *ptr) throw() {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) throw() {
+	free(ptr);
+}
+
+#pragma mark --- Fixtures ---
+
+struct Fixture;
+typedef Audio::AudioStream *(*CreateProc)(const Fixture &fixture);
+
+struct Fixture {
+	Common::String name;
+	byte *data;
+	uint32 size;
+	int rate;
+	int channels;
+	byte rawFlags;
+	uint32 blockAlign;
+	Audio::typesADPCM adpcmType;
+	CreateProc create;
+	bool rewindable;
+};
+
+static Common::SeekableReadStream *openFixture(const Fixture &fixture) {
+	return new Common::MemoryReadStream(fixture.data, fixture.size, DisposeAfterUse::NO);
+}
+
+static Audio::AudioStream *createRaw(const Fixture &fixture) {
+	return Audio::makeRawStream(openFixture(fixture), fixture.rate, fixture.rawFlags);
+}
+
+static Audio::AudioStream *createADPCM(const Fixture &fixture) {
+	return Audio::makeADPCMStream(openFixture(fixture), DisposeAfterUse::YES, fixture.size,
+	                              fixture.adpcmType, fixture.rate, fixture.channels, fixture.blockAlign);
+}
+
+static Audio::AudioStream *createWAV(const Fixture &fixture) {
+	return Audio::makeWAVStream(openFixture(fixture), DisposeAfterUse::YES);
+}
+
+static Audio::AudioStream *createVOC(const Fixture &fixture) {
+	return Audio::makeVOCStream(openFixture(fixture), Audio::FLAG_UNSIGNED, DisposeAfterUse::YES);
+}
+
+static Audio::AudioStream *createAIFF(const Fixture &fixture) {
+	return Audio::makeAIFFStream(openFixture(fixture), DisposeAfterUse::YES);
+}
+
+static Audio::AudioStream *createVAG(const Fixture &fixture) {
+	return Audio::makeVagStream(openFixture(fixture), fixture.rate);
+}
+
+#ifdef USE_FLAC
+static Audio::AudioStream *createFLAC(const Fixture &fixture) {
+	return Audio::makeFLACStream(openFixture(fixture), DisposeAfterUse::YES);
+}
+#endif
+
+#ifdef USE_MAD
+static Audio::AudioStream *createMP3(const Fixture &fixture) {
+	return Audio::makeMP3Stream(openFixture(fixture), DisposeAfterUse::YES);
+}
+#endif
+
+#ifdef USE_VORBIS
+static Audio::AudioStream *createVorbis(const Fixture &fixture) {
+	return Audio::makeVorbisStream(openFixture(fixture), DisposeAfterUse::YES);
+}
+#endif
+
+static Audio::AudioStream *createQuickTime(const Fixture &fixture) {
+	return Audio::makeQuickTimeStream(openFixture(fixture), DisposeAfterUse::YES);
+}
+
+enum {
+	kFixtureRate = 22050,
+	kFixtureSeconds = 10
+};
+
+static uint32 s_seed = 1;
+
+static byte randomByte() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 16) & 0xFF;
+}
+
+static Fixture makeFixture(const char *name, uint32 size, CreateProc create, bool rewindable, int channels = 2) {
+	Fixture fixture;
+	fixture.name = name;
+	fixture.data = (byte *)malloc(size);
+	fixture.size = size;
+	fixture.rate = kFixtureRate;
+	fixture.channels = channels;
+	fixture.rawFlags = 0;
+	fixture.blockAlign = 0;
+	fixture.adpcmType = Audio::kADPCMOki;
+	fixture.create = create;
+	fixture.rewindable = rewindable;
+
+	for (uint32 i = 0; i < size; ++i)
+		fixture.data[i] = randomByte();
+	return fixture;
+}
+
+/**
+ * Creates ADPCM data with random samples but valid block headers, which the
+ * decoders expect to be in range.
+ */
+static Fixture makeADPCMFixture(const char *name, Audio::typesADPCM type, int channels, uint32 blockAlign) {
+	Fixture fixture = makeFixture(name, kFixtureRate * kFixtureSeconds * channels / 2, createADPCM, true, channels);
+	fixture.size -= fixture.size % (blockAlign ? blockAlign * channels : 1);
+	fixture.adpcmType = type;
+	fixture.blockAlign = blockAlign;
+
+	for (uint32 block = 0; blockAlign && block < fixture.size; block += blockAlign) {
+		byte *header = fixture.data + block;
+		switch (type) {
+		case Audio::kADPCMMSIma:
+			if (block % (blockAlign * channels) == 0) {
+				for (int i = 0; i < channels; ++i)
+					WRITE_LE_UINT16(header + i * 4 + 2, randomByte() % 89);
+			}
+			break;
+		case Audio::kADPCMMS:
+			if (block % (blockAlign * channels) == 0) {
+				for (int i = 0; i < channels; ++i) {
+					header[i] = randomByte() % 7;
+					WRITE_LE_UINT16(header + channels + i * 2, 16 + randomByte());
+				}
+			}
+			break;
+		case Audio::kADPCMDK3:
+			WRITE_LE_UINT16(header + 2, fixture.rate);
+			header[14] = randomByte() % 89;
+			header[15] = randomByte() % 89;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return fixture;
+}
+
+static Fixture makeWAVFixture() {
+	const uint32 dataSize = kFixtureRate * kFixtureSeconds * 4;
+	Fixture fixture = makeFixture("wav-pcm16-stereo", 44 + dataSize, createWAV, true);
+	byte *header = fixture.data;
+
+	memcpy(header, "RIFF", 4);
+	WRITE_LE_UINT32(header + 4, 36 + dataSize);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	WRITE_LE_UINT32(header + 16, 16);
+	WRITE_LE_UINT16(header + 20, 1);
+	WRITE_LE_UINT16(header + 22, 2);
+	WRITE_LE_UINT32(header + 24, kFixtureRate);
+	WRITE_LE_UINT32(header + 28, kFixtureRate * 4);
+	WRITE_LE_UINT16(header + 32, 4);
+	WRITE_LE_UINT16(header + 34, 16);
+	memcpy(header + 36, "data", 4);
+	WRITE_LE_UINT32(header + 40, dataSize);
+	return fixture;
+}
+
+static Fixture makeVOCFixture() {
+	const uint32 dataSize = kFixtureRate * kFixtureSeconds;
+	Fixture fixture = makeFixture("voc-u8-mono", 26 + 6 + dataSize + 1, createVOC, true, 1);
+	byte *header = fixture.data;
+
+	memcpy(header, "Creative Voice File\x1A", 20);
+	WRITE_LE_UINT16(header + 20, 26);
+	WRITE_LE_UINT16(header + 22, 0x010A);
+	WRITE_LE_UINT16(header + 24, 0x1129);
+
+	// A single sound data block
+	header[26] = 1;
+	header[27] = (dataSize + 2) & 0xFF;
+	header[28] = ((dataSize + 2) >> 8) & 0xFF;
+	header[29] = ((dataSize + 2) >> 16) & 0xFF;
+	header[30] = 256 - 1000000 / kFixtureRate;
+	header[31] = 0;
+	fixture.data[fixture.size - 1] = 0;
+	return fixture;
+}
+
+static Fixture makeAIFFFixture() {
+	const uint32 frames = kFixtureRate * kFixtureSeconds;
+	const uint32 dataSize = frames * 4;
+	Fixture fixture = makeFixture("aiff-pcm16-stereo", 54 + dataSize, createAIFF, true);
+	byte *header = fixture.data;
+
+	memcpy(header, "FORM", 4);
+	WRITE_BE_UINT32(header + 4, 46 + dataSize);
+	memcpy(header + 8, "AIFFCOMM", 8);
+	WRITE_BE_UINT32(header + 16, 18);
+	WRITE_BE_UINT16(header + 20, 2);
+	WRITE_BE_UINT32(header + 22, frames);
+	WRITE_BE_UINT16(header + 26, 16);
+
+	// The rate as 80 bit extended float
+	memset(header + 28, 0, 10);
+	header[28] = 0x40;
+	header[29] = 0x0D;
+	WRITE_BE_UINT32(header + 30, kFixtureRate << 17);
+
+	memcpy(header + 38, "SSND", 4);
+	WRITE_BE_UINT32(header + 42, 8 + dataSize);
+	WRITE_BE_UINT32(header + 46, 0);
+	WRITE_BE_UINT32(header + 50, 0);
+	return fixture;
+}
+
+static Fixture makeVAGFixture() {
+	const uint32 blocks = kFixtureRate * kFixtureSeconds / 28;
+	Fixture fixture = makeFixture("vag-mono", (blocks + 1) * 16, createVAG, true, 1);
+
+	for (uint32 i = 0; i < blocks; ++i) {
+		byte *block = fixture.data + i * 16;
+		block[0] = (randomByte() % 5) << 4 | (randomByte() % 13);
+		block[1] = 0;
+	}
+
+	// End marker
+	fixture.data[blocks * 16 + 1] = 7;
+	return fixture;
+}
+
+static void addBuiltinFixtures(Common::Array<Fixture> &fixtures) {
+	Fixture fixture;
+
+	fixture = makeFixture("raw-s16le-stereo", kFixtureRate * kFixtureSeconds * 4, createRaw, true);
+	fixture.rawFlags = Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | Audio::FLAG_STEREO;
+	fixtures.push_back(fixture);
+
+	fixture = makeFixture("raw-u8-mono", kFixtureRate * kFixtureSeconds, createRaw, true, 1);
+	fixture.rawFlags = Audio::FLAG_UNSIGNED;
+	fixtures.push_back(fixture);
+
+	fixtures.push_back(makeWAVFixture());
+	fixtures.push_back(makeVOCFixture());
+	fixtures.push_back(makeAIFFFixture());
+	fixtures.push_back(makeADPCMFixture("adpcm-oki-mono", Audio::kADPCMOki, 1, 0));
+	fixtures.push_back(makeADPCMFixture("adpcm-dvi-stereo", Audio::kADPCMDVI, 2, 0));
+	fixtures.push_back(makeADPCMFixture("adpcm-ms-ima-stereo", Audio::kADPCMMSIma, 2, 1024));
+	fixtures.push_back(makeADPCMFixture("adpcm-ms-stereo", Audio::kADPCMMS, 2, 1024));
+	fixtures.push_back(makeADPCMFixture("adpcm-apple-stereo", Audio::kADPCMApple, 2, 34));
+	fixtures.push_back(makeADPCMFixture("adpcm-dk3-stereo", Audio::kADPCMDK3, 2, 1024));
+	fixtures.push_back(makeVAGFixture());
+}
+
+static bool addFileFixture(Common::Array<Fixture> &fixtures, const char *filename) {
+	Common::String name(filename);
+	name.toLowercase();
+
+	Fixture fixture;
+	fixture.name = filename;
+	fixture.rate = 0;
+	fixture.channels = 0;
+	fixture.rawFlags = 0;
+	fixture.blockAlign = 0;
+	fixture.adpcmType = Audio::kADPCMOki;
+	fixture.rewindable = true;
+
+	if (name.hasSuffix(".wav")) {
+		fixture.create = createWAV;
+	} else if (name.hasSuffix(".voc")) {
+		fixture.create = createVOC;
+	} else if (name.hasSuffix(".aif") || name.hasSuffix(".aiff")) {
+		fixture.create = createAIFF;
+#ifdef USE_FLAC
+	} else if (name.hasSuffix(".flac")) {
+		fixture.create = createFLAC;
+#endif
+#ifdef USE_MAD
+	} else if (name.hasSuffix(".mp3")) {
+		fixture.create = createMP3;
+#endif
+#ifdef USE_VORBIS
+	} else if (name.hasSuffix(".ogg")) {
+		fixture.create = createVorbis;
+#endif
+	} else if (name.hasSuffix(".mov") || name.hasSuffix(".m4a") || name.hasSuffix(".qt")) {
+		fixture.create = createQuickTime;
+	} else {
+		fprintf(stderr, "%s: Unsupported file type\n", filename);
+		return false;
+	}
+
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "%s: Could not open file\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	fixture.size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	fixture.data = (byte *)malloc(fixture.size);
+	const bool ok = fread(fixture.data, 1, fixture.size, file) == fixture.size;
+	fclose(file);
+
+	if (!ok) {
+		fprintf(stderr, "%s: Could not read file\n", filename);
+		free(fixture.data);
+		return false;
+	}
+
+	fixtures.push_back(fixture);
+	return true;
+}
+
+#pragma mark --- Benchmarks ---
+
+static void benchmarkDecoder(const Fixture &fixture, int chunk, double minTime) {
+	int16 *buffer = new int16[chunk];
+	Audio::AudioStream *stream = fixture.create(fixture);
+	if (!stream) {
+		printf("%-24s %6d  could not create stream\n", fixture.name.c_str(), chunk);
+		delete[] buffer;
+		return;
+	}
+
+	// Chunks have to be a whole number of frames
+	const int channels = stream->isStereo() ? 2 : 1;
+	const int length = chunk - chunk % (channels * 2);
+
+	uint32 samples = 0;
+	const uint32 allocations = s_allocations;
+	const double start = getSeconds();
+	double elapsed = 0;
+
+	while (elapsed < minTime) {
+		const int read = stream->readBuffer(buffer, length);
+		if (read > 0)
+			samples += read;
+
+		if (read <= 0 || stream->endOfData()) {
+			if (fixture.rewindable) {
+				((Audio::RewindableAudioStream *)stream)->rewind();
+			} else {
+				delete stream;
+				stream = fixture.create(fixture);
+			}
+		}
+
+		elapsed = getSeconds() - start;
+	}
+
+	printf("%-24s %6d %14.0f %12.1f %10.1fx\n", fixture.name.c_str(), length,
+	       samples / elapsed, (s_allocations - allocations) / elapsed,
+	       samples / elapsed / (stream->getRate() * channels));
+
+	delete stream;
+	delete[] buffer;
+}
+
+static void benchmarkMixer(int channels, int chunk, double minTime) {
+	BenchmarkSystem system;
+	g_system = &system;
+
+	const int outputRate = 44100;
+	Audio::MixerImpl *mixer = new Audio::MixerImpl(&system, outputRate);
+	mixer->setReady(true);
+
+	// Streams of all the rate converter variants: same rate, resampled,
+	// mono and stereo
+	static const int rates[] = { 44100, 22050, 11025, 48000 };
+	Common::Array<byte *> buffers;
+	for (int i = 0; i < channels; ++i) {
+		const int rate = rates[i % ARRAYSIZE(rates)];
+		const bool stereo = (i / ARRAYSIZE(rates)) % 2 == 0;
+		const uint32 size = rate * (stereo ? 4 : 2);
+
+		byte *data = (byte *)malloc(size);
+		for (uint32 j = 0; j < size; ++j)
+			data[j] = randomByte();
+		buffers.push_back(data);
+
+		Audio::SeekableAudioStream *stream = Audio::makeRawStream(data, size, rate,
+			Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0), DisposeAfterUse::NO);
+		mixer->playStream(Audio::Mixer::kPlainSoundType, 0, Audio::makeLoopingAudioStream(stream, 0),
+		                  -1, Audio::Mixer::kMaxChannelVolume, (i % 3 - 1) * 100, DisposeAfterUse::YES, false, false);
+	}
+
+	byte *output = new byte[chunk * 4];
+	uint32 frames = 0;
+	const uint32 allocations = s_allocations;
+	const double start = getSeconds();
+	double elapsed = 0;
+
+	while (elapsed < minTime) {
+		mixer->mixCallback(output, chunk * 4);
+		frames += chunk;
+		elapsed = getSeconds() - start;
+	}
+
+	printf("mixer, %3d channels      %6d %14.0f %12.1f %10.1fx\n", channels, chunk,
+	       frames * 2 / elapsed, (s_allocations - allocations) / elapsed, frames / elapsed / outputRate);
+
+	delete[] output;
+	delete mixer;
+	for (uint i = 0; i < buffers.size(); ++i)
+		free(buffers[i]);
+	g_system = 0;
+}
+
+static void usage() {
+	printf("Usage: audio_bench [-c chunk[,chunk...]] [-t seconds] [-m channels] [file...]\n"
+	       "\n"
+	       "  -c  Samples read per readBuffer() call (default: 256,1024,4096)\n"
+	       "  -t  Minimum time spent on every measurement (default: 0.5)\n"
+	       "  -m  Benchmark the mixer with this many channels instead of the decoders;\n"
+	       "      the chunk size is in frames then\n"
+	       "\n"
+	       "Without files, fixtures for the PCM and ADPCM decoders are generated.\n");
+}
+
+int main(int argc, char *argv[]) {
+	Common::Array<int> chunks;
+	double minTime = 0.5;
+	int mixerChannels = 0;
+	Common::Array<Fixture> fixtures;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			for (const char *chunk = argv[++i]; chunk; chunk = strchr(chunk, ',')) {
+				if (*chunk == ',')
+					chunk++;
+				if (atoi(chunk) > 0)
+					chunks.push_back(atoi(chunk));
+			}
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			mixerChannels = atoi(argv[++i]);
+		} else if (argv[i][0] == '-') {
+			usage();
+			return 1;
+		} else if (!addFileFixture(fixtures, argv[i])) {
+			return 1;
+		}
+	}
+
+	if (chunks.empty()) {
+		chunks.push_back(256);
+		chunks.push_back(1024);
+		chunks.push_back(4096);
+	}
+
+	printf("%-24s %6s %14s %12s %11s\n", "Stream", "Chunk", "Samples/s", "Allocs/s", "Realtime");
+
+	if (mixerChannels > 0) {
+		for (uint i = 0; i < chunks.size(); ++i)
+			benchmarkMixer(mixerChannels, chunks[i], minTime);
+		return 0;
+	}
+
+	if (fixtures.empty())
+		addBuiltinFixtures(fixtures);
+
+	for (uint i = 0; i < fixtures.size(); ++i) {
+		for (uint j = 0; j < chunks.size(); ++j)
+			benchmarkDecoder(fixtures[i], chunks[j], minTime);
+		free(fixtures[i].data);
+	}
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Helpers shared by the benchmarks in this directory.
+ *
+ * Every benchmark is a standalone program in a single source file, built
+ * and run with "make bench-NAME", see test/benchmark/benchmark.mk. The
+ * benchmarks measure time and print with the C library, so they define
+ * FORBIDDEN_SYMBOL_ALLOW_ALL before including this header.
+ */
+
+#ifndef TEST_BENCHMARK_BENCHMARK_H
+#define TEST_BENCHMARK_BENCHMARK_H
+
+#include "test/system.h"
+
+#include <time.h>
+
+#ifdef USE_THREADS
+#include <sys/time.h>
+#endif
+
+/** Returns the processor time used by the benchmark so far, in seconds. */
+inline double getSeconds() {
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/**
+ * Returns the elapsed real time in seconds, for benchmarks running on several
+ * threads. Falls back to the processor time without thread support.
+ */
+inline double getWallSeconds() {
+#ifdef USE_THREADS
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+	return getSeconds();
+#endif
+}
+
+/** A TestSystem with a running clock. */
+class BenchmarkSystem : public TestSystem {
+public:
+	uint32 getMillis() { return (uint32)(getWallSeconds() * 1000); }
+};
+
+#endif
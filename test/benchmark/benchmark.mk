@@ -0,0 +1,34 @@
+######################################################################
+# Throughput benchmarks, which are not run as part of the tests.
+# Every test/benchmark/NAME.cpp is a standalone program, which the
+# 'bench-NAME' target builds and runs. Arguments can be passed in
+# BENCH_ARGS, e.g. "make bench-audio BENCH_ARGS='-m 16 -c 512'".
+# Benchmarks which need more than TEST_LIBS list their libraries in
+# BENCH_LIBS_NAME.
+######################################################################
+
+BENCHMARKS   := $(basename $(notdir $(wildcard $(srcdir)/test/benchmark/*.cpp)))
+
+# A static pattern rule, since make skips implicit rules for phony targets
+$(addprefix bench-,$(BENCHMARKS)): bench-%: test/%_bench
+	./test/$*_bench $(BENCH_ARGS)
+
+test/%_bench: $(srcdir)/test/benchmark/%.cpp $(srcdir)/test/benchmark/benchmark.h $(srcdir)/test/system.h $(TEST_LIBS)
+	$(QUIET_LINK)$(CXX) $(TEST_CXXFLAGS) $(CPPFLAGS) -o $@ $< $(BENCH_LIBS_$*) $(TEST_LIBS) $(TEST_LDFLAGS)
+
+BENCH_LIBS_gui := gui/libgui.a backends/libbackends.a
+test/gui_bench: gui/libgui.a backends/libbackends.a
+
+# The theme renderer for 32 bit pixels is not part of libgraphics, so the
+# graphics benchmark links its own copy of the renderer which includes it.
+test/graphics_bench_renderer.o: $(srcdir)/graphics/VectorRendererSpec.cpp
+	$(QUIET_CXX)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -DVECTOR_RENDERER_32BIT -c $< -o $@
+
+BENCH_LIBS_graphics := test/graphics_bench_renderer.o
+test/graphics_bench: test/graphics_bench_renderer.o
+
+clean-test: clean-bench
+clean-bench:
+	-$(RM) $(addprefix test/,$(addsuffix _bench,$(BENCHMARKS))) test/graphics_bench_renderer.o
+
+.PHONY: $(addprefix bench-,$(BENCHMARKS)) clean-bench
@@ -0,0 +1,247 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Benchmark of config domains keyed by strings against domains keyed by
+ * atoms, like the ones of Common::ConfigManager.
+ *
+ * A config with many game targets is built in both layouts, and the heap
+ * memory used by it is reported. Then every key of every target is looked
+ * up by name, the way ConfMan.get(key, domain) does. The atom layout is
+ * also measured with atoms which were interned up front, which is what
+ * callers holding on to their keys get.
+ *
+ * Usage: config_bench [-n targets] [-t seconds]
+ */
+
+// The benchmark measures time with clock(), and the memory with mallinfo()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/atom.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/** Return the number of bytes allocated on the heap, or -1 if unknown. */
+static long getHeapUsage() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 info = mallinfo2();
+	return (long)info.uordblks + (long)info.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+	return (long)(unsigned int)info.uordblks + (long)(unsigned int)info.hblkhd;
+#else
+	return -1;
+#endif
+}
+
+/** The keys of a typical game target. */
+static const char *const kKeys[] = {
+	"gameid", "description", "path", "language", "platform", "extrapath",
+	"savepath", "music_volume", "sfx_volume", "speech_volume", "subtitles",
+	"talkspeed", "gfx_mode", "fullscreen", "aspect_ratio", "music_driver"
+};
+
+static const int kKeyCount = ARRAYSIZE(kKeys);
+
+/** A domain as ConfigManager stored it before, with an empty comment per key. */
+struct StringDomain : public Common::StringMap {
+	Common::StringMap _comments;
+};
+
+typedef Common::HashMap<Common::String, StringDomain, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringDomainMap;
+
+/** A domain as ConfigManager stores it now, comments are only kept if there are any. */
+struct AtomDomain : public Common::AtomStringMap {
+	Common::AtomStringMap _comments;
+};
+
+typedef Common::HashMap<Common::Atom, AtomDomain, Common::Atom_IgnoreCase_Hash, Common::Atom_IgnoreCase_EqualTo> AtomDomainMap;
+
+static Common::String getValue(int target, int key) {
+	switch (key) {
+	case 0:
+		return Common::String::format("game%d", target % 300);
+	case 1:
+		return Common::String::format("Game %d (DOS/English)", target);
+	case 2:
+		return Common::String::format("/home/user/games/target-%d/", target);
+	case 3:
+		return "en";
+	case 4:
+		return "pc";
+	default:
+		return Common::String::format("%d", (target * 7 + key) % 256);
+	}
+}
+
+/** Keeps the compiler from dropping the measured loops. */
+static uint32 g_sink = 0;
+
+static void print(const char *layout, long bytes, int targets, double lookups) {
+	if (bytes >= 0)
+		printf("%-20s %12ld %12.1f %10.2f\n", layout, bytes, (double)bytes / targets, lookups);
+	else
+		printf("%-20s %12s %12s %10.2f\n", layout, "-", "-", lookups);
+}
+
+static void usage() {
+	printf("Usage: config_bench [-n targets] [-t seconds]\n"
+	       "\n"
+	       "  -n  Number of game targets (default: 10000)\n"
+	       "  -t  Minimum time spent on every measurement (default: 0.2)\n");
+}
+
+int main(int argc, char *argv[]) {
+	int n = 10000;
+	double minTime = 0.2;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			n = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (n <= 0) {
+		usage();
+		return 1;
+	}
+
+	// The names are created up front, like the parser has them in hand
+	Common::String *targets = new Common::String[n];
+	Common::String *keys = new Common::String[kKeyCount];
+	for (int i = 0; i < n; ++i)
+		targets[i] = Common::String::format("game%d-cd-%d", i % 300, i);
+	for (int k = 0; k < kKeyCount; ++k)
+		keys[k] = kKeys[k];
+
+	long heap = getHeapUsage();
+	StringDomainMap *stringDomains = new StringDomainMap();
+	for (int i = 0; i < n; ++i) {
+		StringDomain &domain = (*stringDomains)[targets[i]];
+		for (int k = 0; k < kKeyCount; ++k) {
+			domain[keys[k]] = getValue(i, k);
+			domain._comments[keys[k]] = "";
+		}
+	}
+	const long stringBytes = heap < 0 ? -1 : getHeapUsage() - heap;
+
+	// This includes the atom table, the atoms are interned on the fly
+	heap = getHeapUsage();
+	AtomDomainMap *atomDomains = new AtomDomainMap();
+	for (int i = 0; i < n; ++i) {
+		AtomDomain &domain = (*atomDomains)[targets[i]];
+		for (int k = 0; k < kKeyCount; ++k)
+			domain[keys[k]] = getValue(i, k);
+	}
+	const long atomBytes = heap < 0 ? -1 : getHeapUsage() - heap;
+
+	Common::Atom *targetAtoms = new Common::Atom[n];
+	Common::Atom keyAtoms[kKeyCount];
+	for (int i = 0; i < n; ++i)
+		targetAtoms[i] = targets[i];
+	for (int k = 0; k < kKeyCount; ++k)
+		keyAtoms[k] = keys[k];
+
+	const double lookupsPerRun = (double)n * kKeyCount / 1000000;
+	uint32 stringChecksum = 0, atomChecksum = 0, internedChecksum = 0;
+
+	uint32 runs = 0;
+	double start = getSeconds(), elapsed = 0;
+	while (elapsed < minTime) {
+		stringChecksum = 0;
+		for (int i = 0; i < n; ++i) {
+			StringDomainMap::const_iterator domain = stringDomains->find(targets[i]);
+			for (int k = 0; k < kKeyCount; ++k)
+				stringChecksum = stringChecksum * 31 + domain->_value.getVal(keys[k]).size();
+		}
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	const double stringLookups = lookupsPerRun * runs / elapsed;
+
+	// Like ConfigManager: look up the domain atom, then intern the key
+	runs = 0;
+	start = getSeconds();
+	elapsed = 0;
+	while (elapsed < minTime) {
+		atomChecksum = 0;
+		for (int i = 0; i < n; ++i) {
+			Common::Atom target;
+			Common::Atom::findIgnoreCase(targets[i], target);
+			AtomDomainMap::const_iterator domain = atomDomains->find(target);
+			for (int k = 0; k < kKeyCount; ++k) {
+				const Common::Atom key(keys[k]);
+				atomChecksum = atomChecksum * 31 + domain->_value.getVal(key).size();
+			}
+		}
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	const double atomLookups = lookupsPerRun * runs / elapsed;
+
+	runs = 0;
+	start = getSeconds();
+	elapsed = 0;
+	while (elapsed < minTime) {
+		internedChecksum = 0;
+		for (int i = 0; i < n; ++i) {
+			AtomDomainMap::const_iterator domain = atomDomains->find(targetAtoms[i]);
+			for (int k = 0; k < kKeyCount; ++k)
+				internedChecksum = internedChecksum * 31 + domain->_value.getVal(keyAtoms[k]).size();
+		}
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	const double internedLookups = lookupsPerRun * runs / elapsed;
+	g_sink += stringChecksum + atomChecksum + internedChecksum;
+
+	printf("%d targets with %d keys each, lookups in million keys per second\n\n", n, kKeyCount);
+	printf("%-20s %12s %12s %10s\n", "Layout", "Heap bytes", "Per target", "Lookups");
+	print("String keys", stringBytes, n, stringLookups);
+	print("Atom keys", atomBytes, n, atomLookups);
+	print("Atom keys, interned", -1, n, internedLookups);
+	printf("\n%u strings interned\n", Common::AtomTable::getGlobal().size());
+
+	if (stringChecksum != atomChecksum || stringChecksum != internedChecksum)
+		printf("\nMISMATCH\n");
+
+	delete[] targetAtoms;
+	delete atomDomains;
+	delete stringDomains;
+	delete[] keys;
+	delete[] targets;
+	return 0;
+}
@@ -0,0 +1,347 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Startup benchmark of Common::ConfigManager with a large config file.
+ *
+ * A config file with many game targets is kept in memory, where the
+ * default config file and its binary snapshot are read from and written
+ * to. Loading it is measured by parsing the file, and with the snapshot:
+ * when only the target which is started is accessed, when the gameid and
+ * description of all targets are read, like the launcher and
+ * --list-targets list them, when all targets are loaded, and validated by
+ * hashing the file instead of by its modification stamp. Writing it is
+ * measured after a change, and without one, when nothing has to be written
+ * at all. The domains and listed values loaded from the snapshot are
+ * checked against the parsed ones.
+ *
+ * Usage: confman_bench [-n targets] [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/config-manager.h"
+#include "common/memstream.h"
+#include "common/system.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The contents of a file kept in memory. */
+struct MemoryFile {
+	byte *data;
+	uint32 size;
+	uint32 stamp;	///< Stands in for the modification stamp
+};
+
+static void setFile(MemoryFile &file, const byte *data, uint32 size) {
+	free(file.data);
+	file.data = (byte *)malloc(size + 1);
+	memcpy(file.data, data, size);
+	file.size = size;
+	file.stamp++;
+}
+
+/** Replaces the contents of a MemoryFile when it's destroyed. */
+class MemoryFileWriteStream : public Common::WriteStream {
+public:
+	MemoryFileWriteStream(MemoryFile &file) : _file(file), _data(DisposeAfterUse::YES) {}
+	~MemoryFileWriteStream() { setFile(_file, _data.getData(), _data.size()); }
+
+	uint32 write(const void *dataPtr, uint32 dataSize) { return _data.write(dataPtr, dataSize); }
+
+private:
+	MemoryFile &_file;
+	Common::MemoryWriteStreamDynamic _data;
+};
+
+/** A system with the default config file and its snapshot in memory. */
+class ConfigSystem : public BenchmarkSystem {
+public:
+	MemoryFile _config;
+	MemoryFile _snapshot;
+
+	ConfigSystem() {
+		_config.data = _snapshot.data = 0;
+		_config.size = _snapshot.size = 0;
+		_config.stamp = _snapshot.stamp = 0;
+		_useStamp = true;
+	}
+
+	~ConfigSystem() {
+		free(_config.data);
+		free(_snapshot.data);
+	}
+
+	Common::SeekableReadStream *createConfigReadStream() {
+		return _config.data ? new Common::MemoryReadStream(_config.data, _config.size) : 0;
+	}
+
+	Common::WriteStream *createConfigWriteStream() {
+		return new MemoryFileWriteStream(_config);
+	}
+
+	Common::SeekableReadStream *createConfigCacheReadStream() {
+		return _snapshot.data ? new Common::MemoryReadStream(_snapshot.data, _snapshot.size) : 0;
+	}
+
+	Common::WriteStream *createConfigCacheWriteStream() {
+		return new MemoryFileWriteStream(_snapshot);
+	}
+
+	uint32 getConfigModificationStamp() {
+		return _useStamp ? _config.stamp : 0;
+	}
+
+	/** Whether the modification stamp is known, or the file has to be hashed. */
+	bool _useStamp;
+};
+
+/** Build a config file like the ones of large collections of mass added games. */
+static Common::String createConfig(int targets) {
+	Common::String config =
+		"[scummvm]\n"
+		"gfx_mode=2x\n"
+		"fullscreen=false\n"
+		"music_volume=192\n"
+		"sfx_volume=192\n"
+		"speech_volume=192\n"
+		"subtitles=true\n"
+		"lastselectedgame=game0-cd-0\n"
+		"versioninfo=1.3.0git\n"
+		"\n"
+		"[cloud]\n"
+		"# Not a game\n"
+		"enabled=false\n"
+		"\n";
+
+	for (int i = 0; i < targets; ++i) {
+		if (i % 100 == 0)
+			config += "# Added by the mass add dialog\n";
+		config += Common::String::format(
+			"[game%d-cd-%d]\n"
+			"gameid=game%d\n"
+			"description=Game %d (CD/DOS/English)\n"
+			"path=/home/user/games/collection/game%d-cd-%d/\n"
+			"language=en\n"
+			"platform=pc\n"
+			"extra=CD\n"
+			"guioptions=sndNoSpeech lang_English\n"
+			"music_volume=%d\n"
+			"sfx_volume=%d\n"
+			"speech_volume=%d\n"
+			"subtitles=%s\n"
+			"talkspeed=%d\n"
+			"\n",
+			i % 300, i, i % 300, i, i % 300, i, (i * 7) % 256, (i * 11) % 256, (i * 13) % 256,
+			(i & 1) ? "true" : "false", (i * 3) % 256);
+	}
+
+	return config;
+}
+
+static bool equalDomains(const Common::ConfigManager::Domain &a, const Common::ConfigManager::Domain &b) {
+	if (a.size() != b.size() || a.getDomainComment() != b.getDomainComment())
+		return false;
+
+	for (Common::ConfigManager::Domain::const_iterator i = a.begin(); i != a.end(); ++i) {
+		Common::ConfigManager::Domain::const_iterator j = b.find(i->_key);
+		if (j == b.end() || j->_key.getString() != i->_key.getString() || j->_value != i->_value ||
+		    a.getKVComment(i->_key) != b.getKVComment(i->_key))
+			return false;
+	}
+
+	return true;
+}
+
+enum Access {
+	kAccessNone,
+	kAccessTarget,
+	kAccessList,	///< Read the values the launcher lists of every target
+	kAccessAll
+};
+
+/** Read the gameid and description of every target, like the launcher does. */
+static uint listTargets() {
+	const Common::Array<Common::String> names = ConfMan.getGameDomainNames();
+	uint size = 0;
+	for (uint i = 0; i < names.size(); ++i) {
+		size += ConfMan.getGameDomainValue(names[i], "gameid").size();
+		size += ConfMan.getGameDomainValue(names[i], "description").size();
+	}
+	return size;
+}
+
+/** Measure loading the default config file, and return seconds per load. */
+static double measureLoad(const char *target, Access access, double minTime) {
+	uint32 runs = 0;
+	double elapsed = 0;
+	while (elapsed < minTime) {
+		const double start = getSeconds();
+
+		ConfMan.loadDefaultConfigFile();
+		if (access == kAccessTarget) {
+			ConfMan.setActiveDomain(target);
+			ConfMan.get("path");
+		} else if (access == kAccessList) {
+			listTargets();
+		} else if (access == kAccessAll) {
+			ConfMan.getGameDomains();
+		}
+
+		elapsed += getSeconds() - start;
+		runs++;
+
+		// Destroying the domains is not part of starting up
+		Common::ConfigManager::destroy();
+	}
+
+	return elapsed / runs;
+}
+
+/** Measure flushToDisk(), with or without a change before, and return seconds per flush. */
+static double measureFlush(bool change, double minTime) {
+	ConfMan.loadDefaultConfigFile();
+	ConfMan.flushToDisk();
+
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+	while (elapsed < minTime) {
+		if (change)
+			ConfMan.setInt("lastselectedgame", runs, Common::ConfigManager::kApplicationDomain);
+		ConfMan.flushToDisk();
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	Common::ConfigManager::destroy();
+	return elapsed / runs;
+}
+
+static void usage() {
+	printf("Usage: confman_bench [-n targets] [-t seconds]\n"
+	       "\n"
+	       "  -n  Number of game targets (default: 10000)\n"
+	       "  -t  Minimum time spent on every measurement (default: 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+	int n = 10000;
+	double minTime = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			n = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (n <= 0) {
+		usage();
+		return 1;
+	}
+
+	ConfigSystem system;
+	g_system = &system;
+
+	const Common::String config = createConfig(n);
+	setFile(system._config, (const byte *)config.c_str(), config.size());
+	const Common::String target = Common::String::format("game%d-cd-%d", (n / 2) % 300, n / 2);
+
+	// Parse the file, which was not written by ScummVM, so there is no snapshot yet
+	const double parse = measureLoad(target.c_str(), kAccessAll, minTime);
+
+	// Writing the config also writes the snapshot
+	const double flushChanged = measureFlush(true, minTime);
+	const double flushUnchanged = measureFlush(false, minTime);
+	const uint32 configSize = system._config.size;
+	const uint32 snapshotSize = system._snapshot.size;
+
+	// Parse the file written by ScummVM, for a fair comparison
+	system._snapshot.size = 0;
+	const double parseWritten = measureLoad(target.c_str(), kAccessAll, minTime);
+	system._snapshot.size = snapshotSize;
+
+	const double snapshotNone = measureLoad(target.c_str(), kAccessNone, minTime);
+	const double snapshotTarget = measureLoad(target.c_str(), kAccessTarget, minTime);
+	const double snapshotList = measureLoad(target.c_str(), kAccessList, minTime);
+	const double snapshotAll = measureLoad(target.c_str(), kAccessAll, minTime);
+
+	system._useStamp = false;
+	const double snapshotHashed = measureLoad(target.c_str(), kAccessNone, minTime);
+	system._useStamp = true;
+
+	// The snapshot has to result in the same domains as parsing the file
+	ConfMan.loadDefaultConfigFile();
+	const Common::ConfigManager::DomainMap loaded = ConfMan.getGameDomains();
+	const Common::ConfigManager::Domain loadedApp = *ConfMan.getDomain(Common::ConfigManager::kApplicationDomain);
+	const Common::ConfigManager::Domain loadedMisc = *ConfMan.getDomain("cloud");
+	Common::ConfigManager::destroy();
+
+	// Listing the targets from the snapshot has to read the same values
+	ConfMan.loadDefaultConfigFile();
+	bool match = ConfMan.getGameDomainNames().size() == loaded.size();
+	for (Common::ConfigManager::DomainMap::const_iterator i = loaded.begin(); match && i != loaded.end(); ++i) {
+		match = ConfMan.getGameDomainValue(i->_key, "gameid") == i->_value.getVal("gameid") &&
+		        ConfMan.getGameDomainValue(i->_key, "Description") == i->_value.getVal("description") &&
+		        ConfMan.getGameDomainValue(i->_key, "nokey").empty();
+	}
+	Common::ConfigManager::destroy();
+
+	system._snapshot.size = 0;
+	ConfMan.loadDefaultConfigFile();
+	match = match && ConfMan.getGameDomains().size() == loaded.size() &&
+	             equalDomains(*ConfMan.getDomain(Common::ConfigManager::kApplicationDomain), loadedApp) &&
+	             equalDomains(*ConfMan.getDomain("cloud"), loadedMisc);
+	for (Common::ConfigManager::DomainMap::const_iterator i = loaded.begin(); match && i != loaded.end(); ++i) {
+		const Common::ConfigManager::Domain *domain = ConfMan.getDomain(i->_key);
+		match = domain && equalDomains(*domain, i->_value);
+	}
+	Common::ConfigManager::destroy();
+
+	printf("%d targets, config file %u bytes, snapshot %u bytes\n\n", n, configSize, snapshotSize);
+	printf("%-40s %10s\n", "Operation", "ms");
+	printf("%-40s %10.2f\n", "Parse config file", parse * 1000);
+	printf("%-40s %10.2f\n", "Parse config file written by ScummVM", parseWritten * 1000);
+	printf("%-40s %10.2f\n", "Snapshot, no target accessed", snapshotNone * 1000);
+	printf("%-40s %10.2f\n", "Snapshot, one target accessed", snapshotTarget * 1000);
+	printf("%-40s %10.2f\n", "Snapshot, all targets listed", snapshotList * 1000);
+	printf("%-40s %10.2f\n", "Snapshot, all targets accessed", snapshotAll * 1000);
+	printf("%-40s %10.2f\n", "Snapshot, hashed, no target accessed", snapshotHashed * 1000);
+	printf("%-40s %10.2f\n", "Flush after a change", flushChanged * 1000);
+	printf("%-40s %10.2f\n", "Flush without a change", flushUnchanged * 1000);
+
+	if (!match)
+		printf("\nMISMATCH\n");
+
+	g_system = 0;
+	return 0;
+}
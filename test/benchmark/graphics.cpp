@@ -0,0 +1,241 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Throughput benchmark of Graphics::crossBlit and of the span fills of the
+ * theme renderer.
+ *
+ * Every format pair with a specialized converter is converted once with
+ * crossBlit and once with crossBlitGeneric, which converts every pixel
+ * through colorToARGB and ARGBToColor. The rect is either contiguous or
+ * has padding at the end of every row, like a sub rect of a surface.
+ *
+ * The theme renderer draws a screen of shadowed widgets on a gradient, for
+ * 16 and 32 bit pixels, once with its SIMD code paths and once without. The
+ * results have to be identical.
+ *
+ * Usage: graphics_bench [-w width] [-h height] [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+#include "graphics/VectorRendererSpec.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Format {
+	const char *name;
+	Graphics::PixelFormat format;
+};
+
+typedef bool (*BlitProc)(byte *dst, const byte *src, int dstpitch, int srcpitch,
+                         int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
+
+static double measure(BlitProc blit, byte *dst, const byte *src, int dstPitch, int srcPitch, int w, int h,
+                      const Format &dstFmt, const Format &srcFmt, double minTime) {
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+
+	while (elapsed < minTime) {
+		blit(dst, src, dstPitch, srcPitch, w, h, dstFmt.format, srcFmt.format);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	// Megapixels per second
+	return (double)w * h * runs / elapsed / 1000000;
+}
+
+static void benchmark(const Format &srcFmt, const Format &dstFmt, int w, int h, double minTime) {
+	// Room for padding of 16 pixels at the end of every row
+	const int srcPitch = (w + 16) * srcFmt.format.bytesPerPixel;
+	const int dstPitch = (w + 16) * dstFmt.format.bytesPerPixel;
+
+	byte *src = (byte *)malloc(srcPitch * h);
+	byte *dst = (byte *)malloc(dstPitch * h);
+	byte *ref = (byte *)malloc(dstPitch * h);
+
+	uint32 seed = 1;
+	for (int i = 0; i < srcPitch * h; ++i) {
+		seed = seed * 1103515245 + 12345;
+		src[i] = seed >> 16;
+	}
+
+	for (int padded = 0; padded < 2; ++padded) {
+		const int sp = padded ? srcPitch : w * srcFmt.format.bytesPerPixel;
+		const int dp = padded ? dstPitch : w * dstFmt.format.bytesPerPixel;
+
+		const double generic = measure(Graphics::crossBlitGeneric, ref, src, dp, sp, w, h, dstFmt, srcFmt, minTime);
+		const double specialized = measure(Graphics::crossBlit, dst, src, dp, sp, w, h, dstFmt, srcFmt, minTime);
+
+		bool match = true;
+		for (int y = 0; y < h && match; ++y)
+			match = !memcmp(dst + y * dp, ref + y * dp, w * dstFmt.format.bytesPerPixel);
+
+		printf("%-9s %-9s %-6s %12.1f %12.1f %8.1fx%s\n", srcFmt.name, dstFmt.name, padded ? "padded" : "flat",
+		       generic, specialized, specialized / generic, match ? "" : "  MISMATCH");
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+}
+
+/** Draws a screen of widgets like the ones of the builtin theme. */
+static void drawWidgets(Graphics::VectorRenderer &renderer) {
+	const Graphics::Surface *surface = renderer.getActiveSurface();
+
+	renderer.setFillMode(Graphics::VectorRenderer::kFillGradient);
+	renderer.setGradientColors(206, 121, 99, 255, 210, 143);
+	renderer.setGradientFactor(1);
+	renderer.fillSurface();
+
+	renderer.setFgColor(255, 255, 255);
+	renderer.setBgColor(96, 160, 8);
+	renderer.setGradientColors(255, 220, 140, 228, 166, 71);
+	renderer.setStrokeWidth(1);
+
+	for (int y = 8; y + 40 <= surface->h; y += 48) {
+		for (int x = 8; x + 120 <= surface->w; x += 136) {
+			renderer.setShadowOffset(4);
+			renderer.drawRoundedSquare(x, y, 6, 120, 40);
+			renderer.setShadowOffset(2);
+			renderer.drawSquare(x + 8, y + 8, 32, 24);
+		}
+	}
+}
+
+/** Measure drawing the widgets, and return seconds per screen. */
+static double measureWidgets(Graphics::VectorRenderer &renderer, double minTime) {
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+
+	while (elapsed < minTime) {
+		drawWidgets(renderer);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	return elapsed / runs;
+}
+
+static void benchmarkRenderer(Graphics::VectorRenderer &renderer, const Format &format, int w, int h, double minTime) {
+	Graphics::Surface scalar, simd;
+	scalar.create(w, h, format.format);
+	simd.create(w, h, format.format);
+
+	Graphics::enableRendererSIMD(false);
+	renderer.setSurface(&scalar);
+	const double scalarTime = measureWidgets(renderer, minTime);
+
+	const bool useSIMD = Graphics::enableRendererSIMD(true);
+	renderer.setSurface(&simd);
+	const double simdTime = measureWidgets(renderer, minTime);
+
+	bool match = true;
+	for (int y = 0; y < h && match; ++y)
+		match = !memcmp(scalar.getBasePtr(0, y), simd.getBasePtr(0, y), w * format.format.bytesPerPixel);
+
+	printf("%-9s %10.2fms %10.2fms %8.2fx%s%s\n", format.name, scalarTime * 1000, simdTime * 1000, scalarTime / simdTime,
+	       useSIMD ? "" : "  (no SIMD)", match ? "" : "  MISMATCH");
+
+	scalar.free();
+	simd.free();
+}
+
+static void usage() {
+	printf("Usage: graphics_bench [-w width] [-h height] [-t seconds]\n"
+	       "\n"
+	       "  -w  Width of the converted rect (default: 640)\n"
+	       "  -h  Height of the converted rect (default: 480)\n"
+	       "  -t  Minimum time spent on every measurement (default: 0.2)\n");
+}
+
+int main(int argc, char *argv[]) {
+	int w = 640, h = 480;
+	double minTime = 0.2;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+			w = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-h") && i + 1 < argc) {
+			h = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (w <= 0 || h <= 0) {
+		usage();
+		return 1;
+	}
+
+	const Format rgb565   = { "RGB565",   Graphics::PixelFormat(2, 5, 6, 5, 0, 11,  5,  0,  0) };
+	const Format bgr565   = { "BGR565",   Graphics::PixelFormat(2, 5, 6, 5, 0,  0,  5, 11,  0) };
+	const Format rgb555   = { "RGB555",   Graphics::PixelFormat(2, 5, 5, 5, 0, 10,  5,  0,  0) };
+	const Format rgb888   = { "RGB888",   Graphics::PixelFormat(3, 8, 8, 8, 0, 16,  8,  0,  0) };
+	const Format argb8888 = { "ARGB8888", Graphics::PixelFormat(4, 8, 8, 8, 8, 16,  8,  0, 24) };
+	const Format abgr8888 = { "ABGR8888", Graphics::PixelFormat(4, 8, 8, 8, 8,  0,  8, 16, 24) };
+	const Format rgba8888 = { "RGBA8888", Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16,  8,  0) };
+	const Format bgra8888 = { "BGRA8888", Graphics::PixelFormat(4, 8, 8, 8, 8,  8, 16, 24,  0) };
+
+	const Format *pairs[][2] = {
+		{ &rgb565,   &rgb555   }, { &rgb555,   &rgb565   },
+		{ &rgb565,   &bgr565   }, { &bgr565,   &rgb565   },
+		{ &rgb565,   &argb8888 }, { &argb8888, &rgb565   },
+		{ &rgb888,   &argb8888 }, { &argb8888, &rgb888   },
+		{ &argb8888, &abgr8888 }, { &abgr8888, &argb8888 },
+		{ &argb8888, &rgba8888 }, { &rgba8888, &argb8888 },
+		{ &argb8888, &bgra8888 }, { &bgra8888, &argb8888 },
+		{ &rgba8888, &abgr8888 }, { &abgr8888, &rgba8888 }
+	};
+
+	printf("%dx%d pixels, throughput in megapixels per second\n\n", w, h);
+	printf("%-9s %-9s %-6s %12s %12s %9s\n", "Source", "Dest", "Rect", "Generic", "crossBlit", "Speedup");
+
+	for (uint i = 0; i < ARRAYSIZE(pairs); ++i)
+		benchmark(*pairs[i][0], *pairs[i][1], w, h, minTime);
+
+	const Format xrgb8888 = { "XRGB8888", Graphics::PixelFormat(4, 8, 8, 8, 0, 16,  8,  0,  0) };
+	Graphics::VectorRendererSpec<uint16> renderer16(rgb565.format);
+	Graphics::VectorRendererSpec<uint32> renderer32(xrgb8888.format);
+
+	printf("\nTheme renderer, %dx%d screen of widgets\n\n", w, h);
+	printf("%-9s %12s %12s %9s\n", "Format", "Scalar", "SIMD", "Speedup");
+	benchmarkRenderer(renderer16, rgb565, w, h, minTime);
+	benchmarkRenderer(renderer32, xrgb8888, w, h, minTime);
+
+	return 0;
+}
@@ -0,0 +1,275 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Redraw benchmark of the GUI::ThemeEngine with the builtin theme.
+ *
+ * An options dialog is drawn on top of a launcher like dialog, the way
+ * GUI::GuiManager redraws the whole dialog stack, on an overlay kept in
+ * memory. Scrolling redraws only the game list of the launcher, the way the
+ * list widget does, once for every position while scrolling down and up.
+ * Every renderer is measured with and without the DrawData cache. The
+ * overlay contents resulting from cached redraws are checked against the
+ * ones of uncached redraws.
+ *
+ * Usage: gui_bench [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-fs-factory.h"
+#include "common/rect.h"
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+#include "gui/ThemeEngine.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	kWidth = 640,
+	kHeight = 480
+};
+
+/**
+ * A system with a 16 bit overlay in memory, and a file system for the
+ * translations looked up by the theme.
+ */
+class OverlaySystem : public BenchmarkSystem {
+public:
+	OverlayColor _overlay[kWidth * kHeight];
+	POSIXFilesystemFactory _fsFactory;
+
+	FilesystemFactory *getFilesystemFactory() { return &_fsFactory; }
+
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+	int16 getOverlayHeight() { return kHeight; }
+	int16 getOverlayWidth() { return kWidth; }
+
+	void clearOverlay() {
+		// Stands in for the game screen
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x)
+				_overlay[y * kWidth + x] = (OverlayColor)((x >> 2) * 0x0841 + (y >> 3) * 0x20);
+		}
+	}
+
+	void grabOverlay(OverlayColor *buf, int pitch) {
+		for (int y = 0; y < kHeight; ++y)
+			memcpy(buf + y * pitch, _overlay + y * kWidth, kWidth * sizeof(OverlayColor));
+	}
+
+	void copyRectToOverlay(const OverlayColor *buf, int pitch, int x, int y, int w, int h) {
+		for (int i = 0; i < h; ++i)
+			memcpy(_overlay + (y + i) * kWidth + x, buf + i * pitch, w * sizeof(OverlayColor));
+	}
+};
+
+enum {
+	kScrollPositions = 40
+};
+
+/** Draws the game list of the launcher, scrolled down by the given number of lines. */
+static void drawList(GUI::ThemeEngine &theme, int pos) {
+	theme.drawWidgetBackground(Common::Rect(20, 60, 480, 440), 0, GUI::ThemeEngine::kWidgetBackgroundBorder);
+	for (int i = 0; i < 20; ++i) {
+		const Common::Rect line(24, 64 + i * 18, 460, 82 + i * 18);
+		theme.drawText(line, Common::String::format("Game %d (CD/DOS/English)", pos + i), GUI::ThemeEngine::kStateEnabled,
+		               Graphics::kTextAlignLeft, pos + i == 3 ? GUI::ThemeEngine::kTextInversionFocus : GUI::ThemeEngine::kTextInversionNone,
+		               0, true, GUI::ThemeEngine::kFontStyleNormal);
+	}
+	theme.drawScrollbar(Common::Rect(462, 62, 478, 438), 10 + pos * 6, 80, GUI::ThemeEngine::kScrollbarStateNo);
+}
+
+static void drawLauncher(GUI::ThemeEngine &theme) {
+	theme.drawDialogBackground(Common::Rect(0, 0, kWidth, kHeight), GUI::ThemeEngine::kDialogBackgroundMain);
+	theme.drawText(Common::Rect(20, 20, 460, 40), "ScummVM 1.3.0git");
+
+	drawList(theme, 0);
+
+	static const char *const buttons[] = {
+		"Start", "Load...", "Add Game...", "Edit Game...", "Remove Game", "Options...", "About...", "Quit"
+	};
+	for (int i = 0; i < ARRAYSIZE(buttons); ++i)
+		theme.drawButton(Common::Rect(500, 60 + i * 40, 620, 84 + i * 40), buttons[i]);
+}
+
+static void drawOptions(GUI::ThemeEngine &theme) {
+	theme.drawDialogBackground(Common::Rect(60, 40, 580, 440), GUI::ThemeEngine::kDialogBackgroundDefault);
+
+	for (int i = 0; i < 4; ++i) {
+		const int y = 70 + i * 40;
+		theme.drawText(Common::Rect(80, y, 240, y + 20), Common::String::format("Volume %d:", i), GUI::ThemeEngine::kStateEnabled,
+		               Graphics::kTextAlignRight, GUI::ThemeEngine::kTextInversionNone, 0, true, GUI::ThemeEngine::kFontStyleNormal);
+		theme.drawSlider(Common::Rect(250, y, 450, y + 20), 40 * (i + 1));
+		theme.drawCheckbox(Common::Rect(460, y, 560, y + 20), "Mute", i == 2);
+	}
+
+	theme.drawLineSeparator(Common::Rect(80, 230, 560, 234));
+	theme.drawPopUpWidget(Common::Rect(80, 250, 360, 270), "AdLib emulator", 0);
+	theme.drawWidgetBackground(Common::Rect(80, 290, 360, 310), 0, GUI::ThemeEngine::kWidgetBackgroundEditText);
+	theme.drawText(Common::Rect(84, 292, 356, 308), "/home/user/games", GUI::ThemeEngine::kStateEnabled, Graphics::kTextAlignLeft);
+
+	theme.drawButton(Common::Rect(380, 400, 470, 424), "Cancel");
+	theme.drawButton(Common::Rect(480, 400, 570, 424), "OK");
+}
+
+/** Redraws the dialog stack the way GuiManager::redraw() does for kRedrawFull. */
+static void redraw(GUI::ThemeEngine &theme) {
+	theme.clearAll();
+	theme.openDialog(true, GUI::ThemeEngine::kShadingNone);
+	drawLauncher(theme);
+	theme.finishBuffering();
+
+	theme.updateScreen(false);
+	theme.openDialog(true, GUI::ThemeEngine::kShadingDim);
+	drawOptions(theme);
+	theme.finishBuffering();
+
+	theme.updateScreen();
+}
+
+/**
+ * Scrolls the game list of the launcher down to the last position and back
+ * up, redrawing only the list the way a focused ListWidget does.
+ */
+static void scroll(GUI::ThemeEngine &theme) {
+	for (int i = 1; i < 2 * kScrollPositions; ++i) {
+		drawList(theme, i < kScrollPositions ? i : 2 * kScrollPositions - i);
+		theme.updateScreen();
+	}
+}
+
+/** Draws the launcher alone, which is scrolled by scroll(). */
+static void redrawLauncher(GUI::ThemeEngine &theme) {
+	theme.clearAll();
+	theme.openDialog(true, GUI::ThemeEngine::kShadingNone);
+	drawLauncher(theme);
+	theme.finishBuffering();
+	theme.updateScreen();
+}
+
+/** Measure full redraws, and return seconds per redraw. */
+static double measure(GUI::ThemeEngine &theme, double minTime) {
+	// Warm up, which fills the cache
+	redraw(theme);
+
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+	while (elapsed < minTime) {
+		redraw(theme);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	return elapsed / runs;
+}
+
+/** Measure scrolling the launcher, and return seconds per redraw of the list. */
+static double measureScroll(GUI::ThemeEngine &theme, double minTime) {
+	redrawLauncher(theme);
+	scroll(theme);
+
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+	while (elapsed < minTime) {
+		scroll(theme);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	return elapsed / (runs * (2 * kScrollPositions - 1));
+}
+
+/** Measures a redraw function with and without the cache, and compares the resulting overlays. */
+static bool compare(GUI::ThemeEngine &theme, OverlaySystem &system, double (*function)(GUI::ThemeEngine &, double), double minTime,
+                    double &uncachedTime, double &cachedTime) {
+	static OverlayColor uncached[kWidth * kHeight];
+
+	theme.setDrawDataCaching(false);
+	uncachedTime = function(theme, minTime);
+	memcpy(uncached, system._overlay, sizeof(uncached));
+
+	theme.setDrawDataCaching(true);
+	cachedTime = function(theme, minTime);
+	return !memcmp(uncached, system._overlay, sizeof(uncached));
+}
+
+static void usage() {
+	printf("Usage: gui_bench [-t seconds]\n"
+	       "\n"
+	       "  -t  Minimum time spent on every measurement (default: 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+	double minTime = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	static OverlaySystem system;
+	g_system = &system;
+
+	bool match = true;
+
+	printf("%dx%d overlay, launcher and options dialog\n\n", kWidth, kHeight);
+	printf("%-28s %-10s %10s %10s %8s\n", "Renderer", "Redraw", "Uncached", "Cached", "Speedup");
+
+	for (uint i = 0; i < GUI::ThemeEngine::_rendererModesSize; ++i) {
+		const GUI::ThemeEngine::Renderer &mode = GUI::ThemeEngine::_rendererModes[i];
+		if (mode.mode == GUI::ThemeEngine::kGfxDisabled)
+			continue;
+
+		GUI::ThemeEngine theme("builtin", mode.mode);
+		if (!theme.init()) {
+			printf("%-28s failed to load the theme\n", mode.name);
+			continue;
+		}
+
+		double uncachedTime, cachedTime;
+		if (!compare(theme, system, measure, minTime, uncachedTime, cachedTime))
+			match = false;
+		printf("%-28s %-10s %8.2fms %8.2fms %7.2fx\n", mode.name, "Full", uncachedTime * 1000, cachedTime * 1000, uncachedTime / cachedTime);
+
+		if (!compare(theme, system, measureScroll, minTime, uncachedTime, cachedTime))
+			match = false;
+		printf("%-28s %-10s %8.2fms %8.2fms %7.2fx\n", "", "Scrolling", uncachedTime * 1000, cachedTime * 1000, uncachedTime / cachedTime);
+	}
+
+	if (!match)
+		printf("\nMISMATCH\n");
+
+	g_system = 0;
+	return 0;
+}
@@ -0,0 +1,194 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Benchmark of Common::HashMap against Common::FlatHashMap.
+ *
+ * Both maps are filled with the same keys, looked up with keys which are
+ * in the map and keys which are not, and iterated over. The keys are
+ * either integers, or strings like the target names of a config file in
+ * a case insensitive map, like Common::StringMap.
+ *
+ * Usage: hashmap_bench [-n entries] [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The results of one map type, in million operations per second. */
+struct Result {
+	double insert;
+	double lookupHit;
+	double lookupMiss;
+	double iterate;
+	uint32 checksum;	///< Of the lookups and the iteration, has to be the same for all map types
+};
+
+/** Keeps the compiler from dropping the measured loops. */
+static uint32 g_sink = 0;
+
+/**
+ * Runs all measurements for one map type. The keys array holds the keys
+ * to insert, followed by as many keys which aren't inserted.
+ */
+template<class Map, class Key>
+static Result measure(const Key *keys, int n, double minTime) {
+	Result result;
+
+	uint32 runs = 0;
+	double start = getSeconds(), elapsed = 0;
+	while (elapsed < minTime) {
+		Map map;
+		for (int i = 0; i < n; ++i)
+			map[keys[i]] = i;
+		g_sink += map.size();
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	result.insert = (double)n * runs / elapsed / 1000000;
+
+	Map map;
+	for (int i = 0; i < n; ++i)
+		map[keys[i]] = i;
+
+	runs = 0;
+	start = getSeconds();
+	elapsed = 0;
+	while (elapsed < minTime) {
+		for (int i = 0; i < n; ++i)
+			g_sink += map.getVal(keys[i], -1);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	result.lookupHit = (double)n * runs / elapsed / 1000000;
+
+	runs = 0;
+	start = getSeconds();
+	elapsed = 0;
+	while (elapsed < minTime) {
+		for (int i = n; i < 2 * n; ++i)
+			g_sink += map.contains(keys[i]);
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	result.lookupMiss = (double)n * runs / elapsed / 1000000;
+
+	runs = 0;
+	start = getSeconds();
+	elapsed = 0;
+	while (elapsed < minTime) {
+		for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+			g_sink += i->_value;
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+	result.iterate = (double)n * runs / elapsed / 1000000;
+
+	result.checksum = map.size();
+	for (int i = 0; i < 2 * n; ++i)
+		result.checksum = result.checksum * 31 + map.getVal(keys[i], -1);
+	for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+		result.checksum += i->_value * 7;
+
+	return result;
+}
+
+static void print(const char *keyType, const char *mapType, const Result &result) {
+	printf("%-7s %-12s %9.2f %10.2f %11.2f %10.2f\n", keyType, mapType,
+	       result.insert, result.lookupHit, result.lookupMiss, result.iterate);
+}
+
+static void usage() {
+	printf("Usage: hashmap_bench [-n entries] [-t seconds]\n"
+	       "\n"
+	       "  -n  Number of entries in the map (default: 10000)\n"
+	       "  -t  Minimum time spent on every measurement (default: 0.2)\n");
+}
+
+int main(int argc, char *argv[]) {
+	int n = 10000;
+	double minTime = 0.2;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			n = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (n <= 0) {
+		usage();
+		return 1;
+	}
+
+	int *intKeys = new int[2 * n];
+	Common::String *stringKeys = new Common::String[2 * n];
+
+	// Random keys from a xorshift generator, which doesn't repeat before
+	// all 2^32 - 1 values were returned. Consecutive keys would let HashMap,
+	// with the trivial hash of integers, access its table in order.
+	uint32 seed = 1;
+	for (int i = 0; i < 2 * n; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		intKeys[i] = (int)seed;
+		stringKeys[i] = Common::String::format("Game-Target-%d-%s", i, (i & 1) ? "cd" : "floppy");
+	}
+
+	typedef Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringHashMap;
+	typedef Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringFlatHashMap;
+
+	printf("%d entries, throughput in million operations per second\n\n", n);
+	printf("%-7s %-12s %9s %10s %11s %10s\n", "Keys", "Map", "Insert", "Lookup hit", "Lookup miss", "Iterate");
+
+	const Result intHashMap = measure<Common::HashMap<int, int> >(intKeys, n, minTime);
+	const Result intFlatHashMap = measure<Common::FlatHashMap<int, int> >(intKeys, n, minTime);
+	print("int", "HashMap", intHashMap);
+	print("int", "FlatHashMap", intFlatHashMap);
+
+	const Result stringHashMap = measure<StringHashMap>(stringKeys, n, minTime);
+	const Result stringFlatHashMap = measure<StringFlatHashMap>(stringKeys, n, minTime);
+	print("String", "HashMap", stringHashMap);
+	print("String", "FlatHashMap", stringFlatHashMap);
+
+	if (intHashMap.checksum != intFlatHashMap.checksum || stringHashMap.checksum != stringFlatHashMap.checksum)
+		printf("\nMISMATCH\n");
+
+	delete[] intKeys;
+	delete[] stringKeys;
+	return 0;
+}
@@ -0,0 +1,234 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Mixing benchmark of Audio::Paula, playing a ProTracker module.
+ *
+ * A 4 channel module with looping and one-shot samples, portamento,
+ * vibrato and volume slides is built in memory. It is rendered through
+ * readBuffer() for every interpolation mode, in stereo and mono. The
+ * output is hashed, so that builds can be checked against each other.
+ *
+ * Usage: paula_bench [-r rate] [-s seconds] [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/mods/paula.h"
+#include "audio/mods/protracker.h"
+
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/util.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	kNumSamples = 31,
+	kNumPatterns = 4,
+	kSongLength = 16,
+	kChunkSize = 4096
+};
+
+/** Periods of the notes C-1 to B-3, without finetune. */
+static const uint16 s_periods[36] = {
+	856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+	428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226,
+	214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113
+};
+
+static void writeSample(byte *header, const char *name, uint16 words, byte volume, uint16 repeat, uint16 repeatLength) {
+	strncpy((char *)header, name, 22);
+	WRITE_BE_UINT16(header + 22, words);
+	header[24] = 0;
+	header[25] = volume;
+	WRITE_BE_UINT16(header + 26, repeat);
+	WRITE_BE_UINT16(header + 28, repeatLength);
+}
+
+static void writeNote(byte *cell, int sample, int note, uint16 effect) {
+	const uint16 period = note >= 0 ? s_periods[note] : 0;
+	WRITE_BE_UINT32(cell, (uint32)(sample & 0xf0) << 24 | (uint32)period << 16 | (sample & 0x0f) << 12 | effect);
+}
+
+/** Build the module, and return its size. */
+static uint32 createModule(byte *&module) {
+	// Sample lengths in words
+	static const uint16 lengths[4] = { 2048, 64, 3000, 400 };
+	uint32 sampleBytes = 0;
+	for (int i = 0; i < 4; ++i)
+		sampleBytes += lengths[i] * 2;
+
+	const uint32 size = 1084 + kNumPatterns * 1024 + sampleBytes;
+	module = (byte *)calloc(size, 1);
+	strcpy((char *)module, "paula benchmark");
+
+	// A string like sample looping its tail, a square wave loop, a noise
+	// drum, and a short looping sine
+	byte *header = module + 20;
+	writeSample(header + 0 * 30, "strings", lengths[0], 64, 512, 1536);
+	writeSample(header + 1 * 30, "square", lengths[1], 48, 0, lengths[1]);
+	writeSample(header + 2 * 30, "drum", lengths[2], 64, 0, 1);
+	writeSample(header + 3 * 30, "sine", lengths[3], 56, 0, lengths[3]);
+	for (int i = 4; i < kNumSamples; ++i)
+		writeSample(header + i * 30, "", 0, 0, 0, 1);
+
+	byte *song = module + 950;
+	song[0] = kSongLength;
+	song[1] = 127;
+	for (int i = 0; i < kSongLength; ++i)
+		song[2 + i] = i % kNumPatterns;
+	WRITE_BE_UINT32(module + 1080, MKTAG('M','.','K','.'));
+
+	byte *patterns = module + 1084;
+	for (int p = 0; p < kNumPatterns; ++p) {
+		for (int row = 0; row < 64; ++row) {
+			byte *cell = patterns + (p * 64 + row) * 16;
+
+			// Chords with vibrato, an arpeggio bass, drums and a lead
+			// sliding between its notes
+			if (row % 16 == 0)
+				writeNote(cell, 1, 12 + (p * 5) % 12, 0x000);
+			else
+				writeNote(cell, 0, -1, 0x446);
+			if (row % 4 == 0)
+				writeNote(cell + 4, 2, (p * 3 + row / 4) % 12, 0x037);
+			else
+				writeNote(cell + 4, 0, -1, 0xA01);
+			if (row % 8 == 0 || row % 8 == 6)
+				writeNote(cell + 8, 3, 24 + row % 3, 0xC00 | (row % 8 ? 0x20 : 0x40));
+			else
+				writeNote(cell + 8, 0, -1, 0x000);
+			if (row % 2 == 0)
+				writeNote(cell + 12, 4, 12 + (row * 7 + p) % 24, row % 8 == 2 ? 0x308 : 0x000);
+			else
+				writeNote(cell + 12, 0, -1, 0x308);
+		}
+	}
+
+	int8 *data = (int8 *)(patterns + kNumPatterns * 1024);
+	for (int i = 0; i < lengths[0] * 2; ++i)
+		*data++ = (int8)(60 * sin(i * 0.11) + 30 * sin(i * 0.37) + 20 * sin(i * 0.053));
+	for (int i = 0; i < lengths[1] * 2; ++i)
+		*data++ = (i & 32) ? 90 : -90;
+	uint32 seed = 1;
+	for (int i = 0; i < lengths[2] * 2; ++i) {
+		seed = seed * 1103515245 + 12345;
+		*data++ = (int8)((int)((seed >> 24) & 0xff) - 128) * (lengths[2] * 2 - i) / (lengths[2] * 2);
+	}
+	for (int i = 0; i < lengths[3] * 2; ++i)
+		*data++ = (int8)(100 * sin(i * 2 * M_PI / 50));
+
+	return size;
+}
+
+/** Render the module, and return seconds per pass. */
+static double measure(const byte *module, uint32 size, int rate, bool stereo, Audio::Paula::InterpolationMode mode,
+                      int seconds, double minTime, uint32 &hash) {
+	static int16 buffer[kChunkSize];
+	const int total = rate * seconds * (stereo ? 2 : 1);
+
+	uint32 runs = 0;
+	double elapsed = 0;
+	while (elapsed < minTime) {
+		Common::MemoryReadStream stream(module, size);
+		Audio::Paula *paula = static_cast<Audio::Paula *>(Audio::makeProtrackerStream(&stream, 0, rate, stereo));
+		paula->setInterpolation(mode);
+
+		hash = 0;
+		const double start = getSeconds();
+		for (int done = 0; done < total; done += kChunkSize) {
+			const int count = MIN<int>(kChunkSize, total - done);
+			paula->readBuffer(buffer, count);
+			for (int i = 0; i < count; ++i)
+				hash = hash * 31 + (uint16)buffer[i];
+		}
+		elapsed += getSeconds() - start;
+		runs++;
+
+		delete paula;
+	}
+
+	return elapsed / runs;
+}
+
+static void usage() {
+	printf("Usage: paula_bench [-r rate] [-s seconds] [-t seconds]\n"
+	       "\n"
+	       "  -r  Output rate (default: 44100)\n"
+	       "  -s  Length of the rendered music (default: 60)\n"
+	       "  -t  Minimum time spent on every measurement (default: 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+	int rate = 44100;
+	int seconds = 60;
+	double minTime = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			rate = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			seconds = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (rate <= 0 || seconds <= 0) {
+		usage();
+		return 1;
+	}
+
+	BenchmarkSystem system;
+	g_system = &system;
+
+	byte *module;
+	const uint32 size = createModule(module);
+
+	static const char *const names[] = { "none", "linear", "cubic" };
+
+	printf("%d s of a 4 channel module at %d Hz\n\n", seconds, rate);
+	printf("%-8s %-8s %10s %12s   %-8s\n", "Output", "Interp", "ms", "Real time", "Hash");
+
+	for (int stereo = 1; stereo >= 0; --stereo) {
+		for (int mode = Audio::Paula::kInterpolationNone; mode <= Audio::Paula::kInterpolationCubic; ++mode) {
+			uint32 hash;
+			const double time = measure(module, size, rate, stereo != 0, (Audio::Paula::InterpolationMode)mode, seconds, minTime, hash);
+			printf("%-8s %-8s %10.2f %11.0fx   %08x\n", stereo ? "stereo" : "mono", names[mode], time * 1000, seconds / time, hash);
+		}
+	}
+
+	free(module);
+	g_system = 0;
+	return 0;
+}
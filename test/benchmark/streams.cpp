@@ -0,0 +1,248 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Microbenchmark for parsing many small fields out of a stream.
+ *
+ * Synthetic resource maps in the SCI0 and SCI1.1 layouts and a QuickTime
+ * style atom list are parsed once with the ReadStream field accessors and
+ * once with a Common::StreamReader. The data comes either from a
+ * MemoryReadStream, which the reader accesses directly, or through a
+ * buffered stream, which stands in for a file.
+ *
+ * Usage: stream_bench [-n entries] [-t seconds]
+ */
+
+// The benchmark measures time with clock()
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/bufferedstream.h"
+#include "common/memstream.h"
+#include "common/streamreader.h"
+#include "common/util.h"
+
+#include "test/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark --- Parsers ---
+
+// The parsers are templates, so that the same code is used for a
+// SeekableReadStream and a StreamReader.
+
+/** SCI0 map: 6 byte entries of id and offset, terminated by an offset of 0xFFFFFFFF. */
+template<class Reader>
+static uint32 parseSCI0(Reader &reader) {
+	uint32 hash = 0;
+	while (true) {
+		const uint16 id = reader.readUint16LE();
+		const uint32 offset = reader.readUint32LE();
+		if (reader.eos() || offset == 0xFFFFFFFF)
+			break;
+		hash = hash * 31 + id + offset;
+	}
+	return hash;
+}
+
+/** SCI1.1 map: a table of type and offset, then 5 byte entries per type. */
+template<class Reader>
+static uint32 parseSCI11(Reader &reader) {
+	uint16 offsets[33];
+	int types = 0;
+	byte type;
+	do {
+		type = reader.readByte();
+		offsets[types++] = reader.readUint16LE();
+	} while (type != 0xFF && types < 32);
+
+	uint32 hash = 0;
+	for (int i = 0; i + 1 < types; ++i) {
+		reader.seek(offsets[i]);
+		for (int j = 0; j < (offsets[i + 1] - offsets[i]) / 5; ++j) {
+			const uint16 number = reader.readUint16LE();
+			uint32 offset = reader.readUint16LE();
+			offset |= reader.readByte() << 16;
+			hash = hash * 31 + number + (offset << 1);
+		}
+	}
+	return hash;
+}
+
+/** QuickTime style atoms: big endian size and tag, followed by the contents. */
+template<class Reader>
+static uint32 parseAtoms(Reader &reader) {
+	uint32 hash = 0;
+	const int32 size = reader.size();
+	while (reader.pos() + 8 <= size) {
+		const uint32 atomSize = reader.readUint32BE();
+		const uint32 tag = reader.readUint32BE();
+		hash = hash * 31 + tag + reader.readUint32BE();
+		if (atomSize < 12)
+			break;
+		reader.skip(atomSize - 12);
+	}
+	return hash;
+}
+
+#pragma mark --- Fixtures ---
+
+static uint32 s_seed = 1;
+
+static uint32 randomValue() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static byte *createSCI0(uint32 entries, uint32 &size) {
+	size = (entries + 1) * 6;
+	byte *data = (byte *)malloc(size);
+	for (uint32 i = 0; i < entries; ++i) {
+		WRITE_LE_UINT16(data + i * 6, randomValue());
+		WRITE_LE_UINT32(data + i * 6 + 2, randomValue() & 0x7FFFFFFF);
+	}
+	WRITE_LE_UINT16(data + entries * 6, 0xFFFF);
+	WRITE_LE_UINT32(data + entries * 6 + 2, 0xFFFFFFFF);
+	return data;
+}
+
+static byte *createSCI11(uint32 entries, uint32 &size) {
+	// The offsets in the type table are 16 bit, which limits the map size
+	const int types = 16;
+	const uint32 perType = MIN<uint32>(entries / types, (0xFFFF - (types + 1) * 3) / 5 / types);
+	const uint32 tableSize = (types + 1) * 3;
+	size = tableSize + types * perType * 5;
+
+	byte *data = (byte *)malloc(size);
+	for (int i = 0; i <= types; ++i) {
+		data[i * 3] = (i == types) ? 0xFF : 0x80 + i;
+		WRITE_LE_UINT16(data + i * 3 + 1, tableSize + i * perType * 5);
+	}
+	for (uint32 i = tableSize; i < size; ++i)
+		data[i] = randomValue();
+	return data;
+}
+
+static byte *createAtoms(uint32 entries, uint32 &size) {
+	size = entries * 16;
+	byte *data = (byte *)malloc(size);
+	uint32 pos = 0;
+	while (pos + 12 <= size) {
+		const uint32 atomSize = MIN<uint32>(12 + (randomValue() % 3) * 4, size - pos);
+		WRITE_BE_UINT32(data + pos, atomSize);
+		WRITE_BE_UINT32(data + pos + 4, MKTAG('a', 't', 'o', 'm') + (randomValue() & 3));
+		for (uint32 i = 8; i < atomSize; ++i)
+			data[pos + i] = randomValue();
+		pos += atomSize;
+	}
+	size = pos;
+	return data;
+}
+
+#pragma mark --- Benchmark ---
+
+typedef uint32 (*StreamParser)(Common::SeekableReadStream &stream);
+typedef uint32 (*ReaderParser)(Common::StreamReader &reader);
+
+static Common::SeekableReadStream *openFixture(const byte *data, uint32 size, bool buffered) {
+	Common::SeekableReadStream *stream = new Common::MemoryReadStream(data, size);
+	if (buffered)
+		stream = Common::wrapBufferedSeekableReadStream(stream, 4096, DisposeAfterUse::YES);
+	return stream;
+}
+
+static double measure(const byte *data, uint32 size, bool buffered, StreamParser streamParser,
+                      ReaderParser readerParser, uint32 &hash, double minTime) {
+	Common::SeekableReadStream *stream = openFixture(data, size, buffered);
+	uint32 runs = 0;
+	const double start = getSeconds();
+	double elapsed = 0;
+
+	while (elapsed < minTime) {
+		stream->seek(0);
+		if (streamParser) {
+			hash = streamParser(*stream);
+		} else {
+			Common::StreamReader reader(*stream);
+			hash = readerParser(reader);
+		}
+		runs++;
+		elapsed = getSeconds() - start;
+	}
+
+	delete stream;
+	return elapsed * 1000 / runs;
+}
+
+static void benchmark(const char *name, const byte *data, uint32 size, StreamParser streamParser,
+                      ReaderParser readerParser, double minTime) {
+	for (int buffered = 0; buffered < 2; ++buffered) {
+		uint32 streamHash, readerHash;
+		const double streamTime = measure(data, size, buffered, streamParser, 0, streamHash, minTime);
+		const double readerTime = measure(data, size, buffered, 0, readerParser, readerHash, minTime);
+
+		printf("%-8s %-9s %9u %12.3f %12.3f %8.1fx%s\n", name, buffered ? "buffered" : "memory", size,
+		       streamTime, readerTime, streamTime / readerTime,
+		       streamHash != readerHash ? "  MISMATCH" : "");
+	}
+}
+
+static void usage() {
+	printf("Usage: stream_bench [-n entries] [-t seconds]\n"
+	       "\n"
+	       "  -n  Number of entries in the generated maps (default: 10000)\n"
+	       "  -t  Minimum time spent on every measurement (default: 0.5)\n");
+}
+
+int main(int argc, char *argv[]) {
+	uint32 entries = 10000;
+	double minTime = 0.5;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			entries = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			minTime = atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+
+	printf("%-8s %-9s %9s %12s %12s %9s\n", "Map", "Stream", "Bytes", "Stream ms", "Reader ms", "Speedup");
+
+	uint32 size;
+	byte *data = createSCI0(entries, size);
+	benchmark("sci0", data, size, parseSCI0<Common::SeekableReadStream>, parseSCI0<Common::StreamReader>, minTime);
+	free(data);
+
+	data = createSCI11(entries, size);
+	benchmark("sci11", data, size, parseSCI11<Common::SeekableReadStream>, parseSCI11<Common::StreamReader>, minTime);
+	free(data);
+
+	data = createAtoms(entries, size);
+	benchmark("atoms", data, size, parseAtoms<Common::SeekableReadStream>, parseAtoms<Common::StreamReader>, minTime);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atom.h"
+
+class AtomTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_interning() {
+		Common::AtomTable table;
+		const Common::Atom a("foo", table);
+		const Common::Atom b(Common::String("foo"), table);
+		const Common::Atom c("bar", table);
+
+		TS_ASSERT(a == b);
+		TS_ASSERT(a != c);
+		TS_ASSERT_EQUALS(a.getString(), "foo");
+		TS_ASSERT_EQUALS(a.size(), 3u);
+		TS_ASSERT_EQUALS(table.size(), 2u);
+
+		TS_ASSERT_EQUALS(a.hash(), Common::hashit("foo"));
+		TS_ASSERT_EQUALS(a.hashIgnoreCase(), Common::hashit_lower("foo"));
+	}
+
+	void test_empty() {
+		Common::AtomTable table;
+		const Common::Atom empty;
+		const Common::Atom interned("", table);
+
+		TS_ASSERT(empty.empty());
+		TS_ASSERT(empty == interned);
+		TS_ASSERT(empty.equalsIgnoreCase(interned));
+		TS_ASSERT_EQUALS(empty.getString(), "");
+		TS_ASSERT_EQUALS(empty.hash(), Common::hashit(""));
+		TS_ASSERT_EQUALS(table.size(), 0u);
+	}
+
+	void test_ignore_case() {
+		Common::AtomTable table;
+		const Common::Atom lower("path", table);
+		const Common::Atom upper("PATH", table);
+		const Common::Atom other("paths", table);
+
+		TS_ASSERT(lower != upper);
+		TS_ASSERT(lower.equalsIgnoreCase(upper));
+		TS_ASSERT(!lower.equalsIgnoreCase(other));
+		TS_ASSERT_EQUALS(lower.hashIgnoreCase(), upper.hashIgnoreCase());
+		TS_ASSERT_EQUALS(upper.getString(), "PATH");
+	}
+
+	void test_find() {
+		Common::AtomTable table;
+		const Common::Atom atom("Description", table);
+
+		Common::Atom found;
+		TS_ASSERT(table.find("Description", found));
+		TS_ASSERT(found == atom);
+		TS_ASSERT(!table.find("description", found));
+		TS_ASSERT(table.findIgnoreCase("DESCRIPTION", found));
+		TS_ASSERT(found.equalsIgnoreCase(atom));
+		TS_ASSERT(!table.findIgnoreCase("gameid", found));
+
+		// Looking up must not intern anything
+		TS_ASSERT_EQUALS(table.size(), 1u);
+	}
+
+	void test_map() {
+		Common::AtomStringMap map;
+		map["Path"] = "/games/monkey";
+		map[Common::Atom("gameid")] = "monkey";
+
+		TS_ASSERT(map.contains("path"));
+		TS_ASSERT(map.contains(Common::Atom("GAMEID")));
+		TS_ASSERT_EQUALS(map["PATH"], "/games/monkey");
+		TS_ASSERT(!map.contains("description"));
+
+		// The key keeps the case it was first inserted with
+		TS_ASSERT_EQUALS(map.find("PATH")->_key.getString(), "Path");
+	}
+
+	void test_destroy_global() {
+		Common::Atom found;
+		{
+			const Common::Atom atom("atom test key");
+			TS_ASSERT(Common::Atom::find("atom test key", found));
+			TS_ASSERT(found == atom);
+		}
+
+		// Released strings are gone, and the table is created again on demand
+		Common::AtomTable::destroyGlobal();
+		TS_ASSERT(!Common::Atom::find("atom test key", found));
+		TS_ASSERT_EQUALS(Common::AtomTable::getGlobal().size(), 0u);
+	}
+};
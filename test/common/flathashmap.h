@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	// Puts all keys into the same probe sequence
+	struct ConstantHash {
+		uint operator()(int val) const { return 7; }
+	};
+
+	public:
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(3));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[4] = 96;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(4, -10), 96);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.find(17), containerRef.end());
+		TS_ASSERT_EQUALS(container.size(), 2u);
+	}
+
+	void test_lookup_keeps_references() {
+		Common::FlatHashMap<int, Common::String> container;
+
+		// One entry short of growing the storage
+		for (int i = 0; i < 12; ++i)
+			container[i] = Common::String::format("value %d", i);
+
+		const Common::String *ref = &container[3];
+		container[4] = container[5];
+		container[3] = container[3];
+		TS_ASSERT_EQUALS(&container[3], ref);
+		TS_ASSERT_EQUALS(container[4], "value 5");
+		TS_ASSERT_EQUALS(container[3], "value 3");
+
+		// Inserting grows the storage, and still finds a free slot
+		const Common::String first = container[0];
+		container[12] = first;
+		TS_ASSERT_EQUALS(container.size(), 13u);
+		for (int i = 0; i < 13; ++i)
+			TS_ASSERT(container.contains(i));
+		TS_ASSERT_EQUALS(container[12], "value 0");
+	}
+
+	void test_string_map() {
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container;
+		container["foo"] = "bar";
+		container.setVal("Quux", "blub");
+		TS_ASSERT(container.contains("FOO"));
+		TS_ASSERT(container.contains("quux"));
+		TS_ASSERT_EQUALS(container["QUUX"], "blub");
+		TS_ASSERT(!container.contains("bar"));
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> copy(container);
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(copy.size(), 2u);
+		TS_ASSERT_EQUALS(copy["Foo"], "bar");
+	}
+
+	void test_collision() {
+		// All keys share their home slot, and the probe sequence wraps
+		// around the end of the table
+		Common::FlatHashMap<int, int, ConstantHash> h;
+		for (int i = 0; i < 12; ++i)
+			h[i] = i * 10;
+		for (int i = 0; i < 12; i += 3)
+			h.erase(i);
+
+		TS_ASSERT_EQUALS(h.size(), 8u);
+		for (int i = 0; i < 12; ++i) {
+			TS_ASSERT_EQUALS(h.contains(i), (i % 3) != 0);
+			TS_ASSERT_EQUALS(h.getVal(i, -1), (i % 3) ? i * 10 : -1);
+		}
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; ++i)
+			container[i] = i;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::const_iterator j;
+		for (j = container.begin(); j != container.end(); ++j) {
+			int key = j->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+	}
+
+	void test_compare_with_hashmap() {
+		// Random inserts and erases, growing the map several times
+		Common::HashMap<int, int> reference;
+		Common::FlatHashMap<int, int> container;
+
+		uint32 seed = 1;
+		for (int i = 0; i < 20000; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const int key = (seed >> 16) % 3000;
+			if (seed & 0x80000000) {
+				reference.erase(key);
+				container.erase(key);
+			} else {
+				reference[key] = i;
+				container[key] = i;
+			}
+		}
+
+		TS_ASSERT_EQUALS(container.size(), reference.size());
+		for (int key = 0; key < 3000; ++key)
+			TS_ASSERT_EQUALS(container.getVal(key, -1), reference.getVal(key, -1));
+
+		uint count = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_value, reference[i->_key]);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+};
@@ -0,0 +1,223 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+
+#include "test/system.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kChunkSize = 24,
+		kWindow = 256,
+		kThreads = 4,
+		kOperations = 200000
+	};
+
+	// SharedMemoryPool needs a mutex
+	TestSystem _system;
+
+	struct Worker {
+		Common::SharedMemoryPool *pool;
+		Worker *next;
+		int id;
+		uint32 errors;
+
+#ifdef USE_THREADS
+		pthread_mutex_t handOverMutex;
+#endif
+		/** A chunk allocated by the previous thread, to be freed by this one. */
+		uint32 *handOver;
+	};
+
+	static uint32 *exchangeHandOver(Worker &worker, uint32 *chunk) {
+#ifdef USE_THREADS
+		pthread_mutex_lock(&worker.handOverMutex);
+#endif
+		uint32 *old = worker.handOver;
+		worker.handOver = chunk;
+#ifdef USE_THREADS
+		pthread_mutex_unlock(&worker.handOverMutex);
+#endif
+		return old;
+	}
+
+	/**
+	 * Allocate and free chunks in a random pattern through a magazine,
+	 * keeping a window of live chunks. Every chunk is tagged, and checked
+	 * before it is freed. Every other chunk is freed by the next worker.
+	 */
+	static void *runWorker(void *arg) {
+		Worker &worker = *(Worker *)arg;
+		Common::SharedMemoryPool::Magazine magazine(*worker.pool);
+
+		uint32 *window[kWindow];
+		memset(window, 0, sizeof(window));
+
+		uint32 seed = worker.id * 7919 + 1;
+		for (uint32 i = 0; i < kOperations; ++i) {
+			seed = seed * 1103515245 + 12345;
+			uint32 *&slot = window[(seed >> 16) % kWindow];
+
+			if (!slot) {
+				slot = (uint32 *)magazine.allocChunk();
+				slot[0] = seed;
+				slot[1] = ~seed;
+				continue;
+			}
+
+			uint32 *chunk = slot;
+			slot = 0;
+
+			if (seed & 0x100) {
+				uint32 *old = exchangeHandOver(*worker.next, chunk);
+				chunk = exchangeHandOver(worker, 0);
+				if (old)
+					magazine.freeChunk(old);
+				if (!chunk)
+					continue;
+			}
+
+			if (chunk[1] != ~chunk[0])
+				worker.errors++;
+			magazine.freeChunk(chunk);
+		}
+
+		for (int i = 0; i < kWindow; ++i) {
+			if (window[i])
+				magazine.freeChunk(window[i]);
+		}
+
+		return 0;
+	}
+
+public:
+	void setUp() {
+		g_system = &_system;
+	}
+
+	void tearDown() {
+		g_system = 0;
+	}
+
+	void test_statistics() {
+		Common::MemoryPool pool(sizeof(int));
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 0u);
+		TS_ASSERT_EQUALS(pool.getPeakChunks(), 0u);
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0u);
+
+		void *chunks[20];
+		for (int i = 0; i < 20; ++i)
+			chunks[i] = pool.allocChunk();
+
+		// Pages of 8, 16 chunks
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 20u);
+		TS_ASSERT_EQUALS(pool.getPeakChunks(), 20u);
+		TS_ASSERT_EQUALS(pool.getPageCount(), 2u);
+
+		for (int i = 0; i < 12; ++i)
+			pool.freeChunk(chunks[i]);
+
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 8u);
+		TS_ASSERT_EQUALS(pool.getPeakChunks(), 20u);
+
+		for (int i = 12; i < 20; ++i)
+			pool.freeChunk(chunks[i]);
+
+		pool.freeUnusedPages();
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 0u);
+		TS_ASSERT_EQUALS(pool.getPeakChunks(), 20u);
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0u);
+	}
+
+	void test_internal_storage() {
+		// The internal storage of a FixedSizeMemoryPool is no page
+		Common::FixedSizeMemoryPool<16, 4> pool;
+
+		void *chunks[5];
+		for (int i = 0; i < 4; ++i)
+			chunks[i] = pool.allocChunk();
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0u);
+
+		chunks[4] = pool.allocChunk();
+		TS_ASSERT_EQUALS(pool.getPageCount(), 1u);
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 5u);
+
+		for (int i = 0; i < 5; ++i)
+			pool.freeChunk(chunks[i]);
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 0u);
+	}
+
+	void test_shared_magazines() {
+		Common::SharedMemoryPool pool(kChunkSize, 4);
+		void *chunks[10];
+
+		{
+			Common::SharedMemoryPool::Magazine first(pool);
+			Common::SharedMemoryPool::Magazine second(pool);
+
+			// The first allocation takes a whole batch
+			chunks[0] = first.allocChunk();
+			TS_ASSERT_EQUALS(pool.getLiveChunks(), 4u);
+			for (int i = 1; i < 10; ++i)
+				chunks[i] = first.allocChunk();
+			TS_ASSERT_EQUALS(pool.getLiveChunks(), 12u);
+
+			// The second magazine gives back a batch once it holds two
+			for (int i = 0; i < 10; ++i)
+				second.freeChunk(chunks[i]);
+			TS_ASSERT_EQUALS(pool.getLiveChunks(), 8u);
+
+			// Chunks freed by one magazine are handed out by another
+			for (int i = 0; i < 10; ++i)
+				chunks[i] = first.allocChunk();
+			for (int i = 0; i < 10; ++i)
+				first.freeChunk(chunks[i]);
+		}
+
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 0u);
+		pool.freeUnusedPages();
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0u);
+	}
+
+	void test_shared_threads() {
+		Common::SharedMemoryPool pool(kChunkSize);
+		Worker workers[kThreads];
+
+		for (int i = 0; i < kThreads; ++i) {
+			workers[i].pool = &pool;
+			workers[i].next = &workers[(i + 1) % kThreads];
+			workers[i].id = i;
+			workers[i].errors = 0;
+			workers[i].handOver = 0;
+#ifdef USE_THREADS
+			pthread_mutex_init(&workers[i].handOverMutex, 0);
+#endif
+		}
+
+		// Without threads, the workers run one after another
+#ifdef USE_THREADS
+		pthread_t threads[kThreads];
+		for (int i = 0; i < kThreads; ++i)
+			pthread_create(&threads[i], 0, runWorker, &workers[i]);
+		for (int i = 0; i < kThreads; ++i)
+			pthread_join(threads[i], 0);
+#else
+		for (int i = 0; i < kThreads; ++i)
+			runWorker(&workers[i]);
+#endif
+
+		for (int i = 0; i < kThreads; ++i) {
+			TS_ASSERT_EQUALS(workers[i].errors, 0u);
+			if (workers[i].handOver)
+				pool.freeChunk(workers[i].handOver);
+#ifdef USE_THREADS
+			pthread_mutex_destroy(&workers[i].handOverMutex);
+#endif
+		}
+
+		// All chunks must be back in the pool
+		TS_ASSERT_EQUALS(pool.getLiveChunks(), 0u);
+		pool.freeUnusedPages();
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0u);
+	}
+};
@@ -84,4 +84,24 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		TS_ASSERT_EQUALS(ms.pos(), 7);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_view() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		TS_ASSERT_EQUALS(ms.getView(0, 7), contents);
+		TS_ASSERT_EQUALS(ms.getView(3, 4), contents + 3);
+		TS_ASSERT_EQUALS(ms.getView(7, 0), contents + 7);
+		TS_ASSERT(!ms.getView(3, 5));
+		TS_ASSERT(!ms.getView(8, 0));
+		TS_ASSERT(!ms.getView(1, 0xFFFFFFFF));
+		TS_ASSERT_EQUALS(ms.pos(), 0);
+
+		ms.seek(2);
+		TS_ASSERT_EQUALS(ms.readView(3), contents + 2);
+		TS_ASSERT_EQUALS(ms.pos(), 5);
+		TS_ASSERT(!ms.readView(3));
+		TS_ASSERT_EQUALS(ms.pos(), 5);
+		TS_ASSERT_EQUALS(ms.readByte(), 6);
+	}
 };
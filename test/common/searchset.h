@@ -0,0 +1,119 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/str-array.h"
+
+class SearchSetTestSuite : public CxxTest::TestSuite {
+	/** An archive with a fixed list of empty files, which counts the lookups. */
+	class TestArchive : public Common::Archive {
+	public:
+		Common::StringArray _files;
+		int _lookups;
+
+		TestArchive(const char *file1, const char *file2) : _lookups(0) {
+			_files.push_back(file1);
+			_files.push_back(file2);
+		}
+
+		bool hasFile(const Common::String &name) {
+			_lookups++;
+			for (uint i = 0; i < _files.size(); ++i) {
+				if (_files[i].equalsIgnoreCase(name))
+					return true;
+			}
+			return false;
+		}
+
+		int listMembers(Common::ArchiveMemberList &list) {
+			for (uint i = 0; i < _files.size(); ++i)
+				list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_files[i], this)));
+			return _files.size();
+		}
+
+		Common::ArchiveMemberPtr getMember(const Common::String &name) {
+			return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+		}
+
+		Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+			for (uint i = 0; i < _files.size(); ++i) {
+				if (_files[i].equalsIgnoreCase(name))
+					return new Common::MemoryReadStream((const byte *)"", 0);
+			}
+			return 0;
+		}
+	};
+
+public:
+	void test_cache() {
+		Common::SearchSet set;
+		TestArchive *high = new TestArchive("a.dat", "b.dat");
+		TestArchive *low = new TestArchive("b.dat", "c.dat");
+		set.add("low", low, 0);
+		set.add("high", high, 1);
+
+		TS_ASSERT(set.hasFile("c.dat"));
+		TS_ASSERT(!set.hasFile("d.dat"));
+		TS_ASSERT_EQUALS(set.getLookupCacheMisses(), 2u);
+		TS_ASSERT_EQUALS(high->_lookups, 2);
+		TS_ASSERT_EQUALS(low->_lookups, 2);
+
+		// Positive and negative results are answered from the cache
+		delete set.createReadStreamForMember("c.dat");
+		TS_ASSERT(!set.createReadStreamForMember("d.dat"));
+		TS_ASSERT(set.hasFile("c.dat"));
+		TS_ASSERT(!set.hasFile("d.dat"));
+		TS_ASSERT_EQUALS(set.getLookupCacheHits(), 4u);
+		TS_ASSERT_EQUALS(set.getLookupCacheMisses(), 2u);
+		TS_ASSERT_EQUALS(high->_lookups, 2);
+		TS_ASSERT_EQUALS(low->_lookups, 2);
+
+		Common::ArchiveMemberPtr member = set.getMember("b.dat");
+		TS_ASSERT(member);
+		TS_ASSERT_EQUALS(high->_lookups, 3);
+		TS_ASSERT_EQUALS(low->_lookups, 2);
+	}
+
+	void test_invalidation() {
+		Common::SearchSet set;
+		TestArchive *first = new TestArchive("a.dat", "b.dat");
+		set.add("first", first, 0);
+		TS_ASSERT(!set.hasFile("c.dat"));
+
+		// Adding an archive
+		TestArchive *second = new TestArchive("b.dat", "c.dat");
+		set.add("second", second, 1);
+		TS_ASSERT(set.hasFile("c.dat"));
+		TS_ASSERT_EQUALS(set.getLookupCacheMisses(), 2u);
+
+		// Changing the priority
+		TS_ASSERT(set.hasFile("b.dat"));
+		TS_ASSERT_EQUALS(first->_lookups, 1);
+		set.setPriority("first", 2);
+		TS_ASSERT(set.hasFile("b.dat"));
+		TS_ASSERT_EQUALS(first->_lookups, 2);
+
+		// Removing an archive
+		set.remove("second");
+		TS_ASSERT(!set.hasFile("c.dat"));
+
+		// Changing the contents of an archive
+		first->_files.push_back("c.dat");
+		TS_ASSERT(!set.hasFile("c.dat"));
+		set.invalidateLookupCache();
+		TS_ASSERT(set.hasFile("c.dat"));
+	}
+
+	void test_nested() {
+		Common::SearchSet outer;
+		Common::SearchSet inner;
+		outer.add("inner", &inner, 0, false);
+		TS_ASSERT(!outer.hasFile("a.dat"));
+
+		// Changes to the inner set have to reach the outer one
+		inner.add("archive", new TestArchive("a.dat", "b.dat"));
+		TS_ASSERT(outer.hasFile("a.dat"));
+		inner.remove("archive");
+		TS_ASSERT(!outer.hasFile("a.dat"));
+	}
+};
@@ -70,4 +70,20 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_view() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+		Common::SeekableSubReadStream ssrs(&ms, 1, 9);
+
+		TS_ASSERT_EQUALS(ssrs.getView(0, 8), contents + 1);
+		TS_ASSERT_EQUALS(ssrs.getView(5, 3), contents + 6);
+		TS_ASSERT(!ssrs.getView(5, 4));
+		TS_ASSERT(!ssrs.getView(9, 0));
+
+		ssrs.seek(2);
+		TS_ASSERT_EQUALS(ssrs.readView(4), contents + 3);
+		TS_ASSERT_EQUALS(ssrs.pos(), 6);
+		TS_ASSERT_EQUALS(ssrs.readByte(), 7);
+	}
 };
@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bufferedstream.h"
+#include "common/memstream.h"
+#include "common/streamreader.h"
+
+class StreamReaderTestSuite : public CxxTest::TestSuite {
+	enum {
+		kSize = 1000
+	};
+
+	byte _contents[kSize];
+
+	// The reader takes the data directly from memory streams, so they are
+	// wrapped into a stream which only supports read() to test the buffer.
+	void checkFields(Common::SeekableReadStream &stream) {
+		stream.seek(1);
+		{
+			Common::StreamReader reader(stream, 16);
+			TS_ASSERT_EQUALS(reader.pos(), 1);
+			TS_ASSERT_EQUALS(reader.size(), kSize);
+
+			for (int i = 1; i + 7 <= kSize; i += 7) {
+				TS_ASSERT_EQUALS(reader.readByte(), _contents[i]);
+				TS_ASSERT_EQUALS(reader.readUint16LE(), READ_LE_UINT16(_contents + i + 1));
+				TS_ASSERT_EQUALS(reader.readUint32BE(), READ_BE_UINT32(_contents + i + 3));
+			}
+			TS_ASSERT(!reader.eos());
+
+			// 999 bytes were read in records of 7, so 5 are left
+			TS_ASSERT_EQUALS(reader.pos(), kSize - 5);
+			TS_ASSERT(!reader.require(6));
+			TS_ASSERT(reader.eos());
+			TS_ASSERT_EQUALS(reader.pos(), kSize - 5);
+
+			const byte *rest = reader.require(5);
+			TS_ASSERT(rest);
+			TS_ASSERT_SAME_DATA(rest, _contents + kSize - 5, 5);
+			TS_ASSERT_EQUALS(reader.readUint16BE(), 0);
+			TS_ASSERT(reader.eos());
+		}
+		// The stream is positioned after the data read
+		TS_ASSERT_EQUALS(stream.pos(), kSize);
+	}
+
+	void checkSeekRead(Common::SeekableReadStream &stream) {
+		stream.seek(0);
+		Common::StreamReader reader(stream, 16);
+		byte buffer[100];
+
+		TS_ASSERT(reader.seek(500));
+		TS_ASSERT_EQUALS(reader.readUint32LE(), READ_LE_UINT32(_contents + 500));
+		TS_ASSERT(reader.seek(-8, SEEK_CUR));
+		TS_ASSERT_EQUALS(reader.pos(), 496);
+		TS_ASSERT_EQUALS(reader.readUint16BE(), READ_BE_UINT16(_contents + 496));
+		TS_ASSERT(reader.seek(10));
+		TS_ASSERT_EQUALS(reader.readSint32LE(), (int32)READ_LE_UINT32(_contents + 10));
+		TS_ASSERT(!reader.seek(kSize + 1));
+		TS_ASSERT(!reader.seek(-1));
+
+		// Reads smaller and larger than the buffer
+		TS_ASSERT_EQUALS(reader.read(buffer, 5), 5u);
+		TS_ASSERT_SAME_DATA(buffer, _contents + 14, 5);
+		TS_ASSERT_EQUALS(reader.read(buffer, 100), 100u);
+		TS_ASSERT_SAME_DATA(buffer, _contents + 19, 100);
+		TS_ASSERT_EQUALS(reader.readByte(), _contents[119]);
+
+		TS_ASSERT(reader.seek(-30, SEEK_END));
+		TS_ASSERT_EQUALS(reader.read(buffer, 100), 30u);
+		TS_ASSERT_SAME_DATA(buffer, _contents + kSize - 30, 30);
+		TS_ASSERT(reader.eos());
+		TS_ASSERT(reader.skip(0));
+		TS_ASSERT(!reader.eos());
+	}
+
+public:
+	void setUp() {
+		for (int i = 0; i < kSize; ++i)
+			_contents[i] = (i * 37 + 11) & 0xff;
+	}
+
+	void test_memory() {
+		Common::MemoryReadStream ms(_contents, kSize);
+		checkFields(ms);
+		checkSeekRead(ms);
+	}
+
+	void test_buffered() {
+		Common::MemoryReadStream ms(_contents, kSize);
+		Common::SeekableReadStream *stream = Common::wrapBufferedSeekableReadStream(&ms, 8, DisposeAfterUse::NO);
+		checkFields(*stream);
+		checkSeekRead(*stream);
+		delete stream;
+	}
+};
@@ -0,0 +1,326 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+#include "test/system.h"
+
+#ifdef USE_THREADS
+#include <sched.h>
+#endif
+
+#ifdef USE_ZLIB
+
+class UnzipTestSuite : public CxxTest::TestSuite {
+	enum {
+		kStoredSize = 100000,
+		kSmallSize = 1000,
+		kLargeSize = 700000
+	};
+
+	byte *_stored;
+	byte *_small;
+	byte *_large;
+
+	TestSystem _system;
+
+	/**
+	 * Memory stream without views, like a file, so members are read from the
+	 * archive stream. Reading lets other threads run first, which moves the
+	 * stream if seeking and reading it aren't done under one lock.
+	 */
+	class FileLikeStream : public Common::MemoryReadStream {
+	public:
+		FileLikeStream(const byte *data, uint32 size) : Common::MemoryReadStream(data, size, DisposeAfterUse::YES) {}
+		const byte *getView(uint32 offset, uint32 size) { return 0; }
+
+		uint32 read(void *dataPtr, uint32 dataSize) {
+#ifdef USE_THREADS
+			sched_yield();
+#endif
+			return Common::MemoryReadStream::read(dataPtr, dataSize);
+		}
+	};
+
+	struct Reader {
+		Common::SeekableReadStream *stream;
+		const byte *data;
+		uint32 size;
+		uint32 errors;
+	};
+
+	static void *runReader(void *arg) {
+		Reader &reader = *(Reader *)arg;
+		byte buffer[3000];
+
+		for (int pass = 0; pass < 3; ++pass) {
+			reader.stream->seek(0, SEEK_SET);
+			for (uint32 pos = 0; pos < reader.size; pos += sizeof(buffer)) {
+				const uint32 size = MIN<uint32>(sizeof(buffer), reader.size - pos);
+				if (reader.stream->read(buffer, size) != size || memcmp(buffer, reader.data + pos, size))
+					reader.errors++;
+			}
+		}
+
+		return 0;
+	}
+
+	static void fillData(byte *data, uint32 size, uint32 seed) {
+		// Compressible, but not so well that the compressed data fits into
+		// a single read buffer
+		for (uint32 i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (seed >> 16) & 0x1f;
+		}
+	}
+
+	/**
+	 * Deflates the data with the gzip stream and strips the gzip header and
+	 * trailer, which leaves the raw deflate data ZIP archives contain.
+	 */
+	static byte *deflate(const byte *data, uint32 size, uint32 &compressedSize, uint32 &crc) {
+		Common::MemoryWriteStreamDynamic *out = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(out);
+		gzip->write(data, size);
+		gzip->finalize();
+
+		byte *gzipData = out->getData();
+		const uint32 gzipSize = out->size();
+		delete gzip;
+
+		compressedSize = gzipSize - 10 - 8;
+		crc = READ_LE_UINT32(gzipData + gzipSize - 8);
+
+		byte *compressed = (byte *)malloc(compressedSize);
+		memcpy(compressed, gzipData + 10, compressedSize);
+		free(gzipData);
+		return compressed;
+	}
+
+	struct Member {
+		const char *name;
+		const byte *data;
+		uint32 size;
+		bool deflated;
+
+		byte *compressed;
+		uint32 compressedSize;
+		uint32 crc;
+		uint32 offset;
+	};
+
+	static void writeHeader(Common::WriteStream &out, const Member &member, bool central) {
+		out.writeUint32LE(central ? 0x02014b50 : 0x04034b50);
+		if (central)
+			out.writeUint16LE(20);
+		out.writeUint16LE(20);
+		out.writeUint16LE(0);
+		out.writeUint16LE(member.deflated ? 8 : 0);
+		out.writeUint32LE(0);
+		out.writeUint32LE(member.crc);
+		out.writeUint32LE(member.compressedSize);
+		out.writeUint32LE(member.size);
+		out.writeUint16LE(strlen(member.name));
+		out.writeUint16LE(0);
+		if (central) {
+			out.writeUint16LE(0);
+			out.writeUint16LE(0);
+			out.writeUint16LE(0);
+			out.writeUint32LE(0);
+			out.writeUint32LE(member.offset);
+		}
+		out.write(member.name, strlen(member.name));
+	}
+
+	Common::Archive *createArchive(bool views = true) {
+		Member members[3] = {
+			{ "stored.bin", _stored, kStoredSize, false, 0, 0, 0, 0 },
+			{ "small.bin", _small, kSmallSize, true, 0, 0, 0, 0 },
+			{ "large.bin", _large, kLargeSize, true, 0, 0, 0, 0 }
+		};
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::NO);
+
+		for (int i = 0; i < 3; ++i) {
+			Member &member = members[i];
+			if (member.deflated) {
+				member.compressed = deflate(member.data, member.size, member.compressedSize, member.crc);
+			} else {
+				uint32 dummy;
+				free(deflate(member.data, member.size, dummy, member.crc));
+				member.compressedSize = member.size;
+			}
+
+			member.offset = out.pos();
+			writeHeader(out, member, false);
+			out.write(member.deflated ? member.compressed : member.data, member.compressedSize);
+			free(member.compressed);
+		}
+
+		const uint32 centralStart = out.pos();
+		for (int i = 0; i < 3; ++i)
+			writeHeader(out, members[i], true);
+		const uint32 centralSize = out.pos() - centralStart;
+
+		out.writeUint32LE(0x06054b50);
+		out.writeUint16LE(0);
+		out.writeUint16LE(0);
+		out.writeUint16LE(3);
+		out.writeUint16LE(3);
+		out.writeUint32LE(centralSize);
+		out.writeUint32LE(centralStart);
+		out.writeUint16LE(0);
+
+		if (!views)
+			return Common::makeZipArchive(new FileLikeStream(out.getData(), out.size()));
+		return Common::makeZipArchive(new Common::MemoryReadStream(out.getData(), out.size(), DisposeAfterUse::YES));
+	}
+
+	static bool compare(Common::SeekableReadStream &stream, const byte *data, uint32 offset, uint32 size) {
+		byte *buffer = new byte[size];
+		const bool ok = stream.pos() == (int32)offset &&
+		                stream.read(buffer, size) == size &&
+		                !memcmp(buffer, data + offset, size);
+		delete[] buffer;
+		return ok;
+	}
+
+public:
+	void setUp() {
+		// Archives lock their stream with an OSystem mutex
+		g_system = &_system;
+
+		_stored = new byte[kStoredSize];
+		_small = new byte[kSmallSize];
+		_large = new byte[kLargeSize];
+		fillData(_stored, kStoredSize, 1);
+		fillData(_small, kSmallSize, 2);
+		fillData(_large, kLargeSize, 3);
+	}
+
+	void tearDown() {
+		delete[] _stored;
+		delete[] _small;
+		delete[] _large;
+
+		g_system = 0;
+	}
+
+	void test_members() {
+		Common::Archive *archive = createArchive();
+		TS_ASSERT(archive);
+
+		Common::ArchiveMemberList list;
+		TS_ASSERT_EQUALS(archive->listMembers(list), 3);
+		TS_ASSERT(archive->hasFile("stored.bin"));
+		TS_ASSERT(archive->hasFile("LARGE.BIN"));
+		TS_ASSERT(!archive->hasFile("missing.bin"));
+		TS_ASSERT(!archive->createReadStreamForMember("missing.bin"));
+
+		delete archive;
+	}
+
+	void test_read_members() {
+		Common::Archive *archive = createArchive();
+
+		const char *names[3] = { "stored.bin", "small.bin", "large.bin" };
+		const byte *data[3] = { _stored, _small, _large };
+		const uint32 sizes[3] = { kStoredSize, kSmallSize, kLargeSize };
+
+		for (int i = 0; i < 3; ++i) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(names[i]);
+			TS_ASSERT(stream);
+			TS_ASSERT_EQUALS(stream->size(), (int32)sizes[i]);
+			TS_ASSERT(compare(*stream, data[i], 0, sizes[i]));
+			TS_ASSERT(!stream->err());
+
+			byte b;
+			TS_ASSERT_EQUALS(stream->read(&b, 1), 0u);
+			TS_ASSERT(stream->eos());
+
+			stream->clearErr();
+			TS_ASSERT(!stream->eos());
+			TS_ASSERT(stream->seek(0, SEEK_SET));
+			TS_ASSERT(compare(*stream, data[i], 0, 100));
+			delete stream;
+		}
+
+		delete archive;
+	}
+
+	void test_seek_deflated() {
+		Common::Archive *archive = createArchive();
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("large.bin");
+
+		// Forward, then back across several inflate checkpoints
+		const uint32 offsets[] = { 650000, 10, 400000, 300000, 699990, 0, 520000, 260000 };
+		for (uint i = 0; i < ARRAYSIZE(offsets); ++i) {
+			TS_ASSERT(stream->seek(offsets[i], SEEK_SET));
+			TS_ASSERT(compare(*stream, _large, offsets[i], 10));
+		}
+
+		TS_ASSERT(stream->seek(-100, SEEK_END));
+		TS_ASSERT(compare(*stream, _large, kLargeSize - 100, 100));
+		TS_ASSERT(stream->seek(-1000, SEEK_CUR));
+		TS_ASSERT(compare(*stream, _large, kLargeSize - 1000, 100));
+		TS_ASSERT(!stream->err());
+
+		delete stream;
+		delete archive;
+	}
+
+	void test_independent_streams() {
+		Common::Archive *archive = createArchive();
+		Common::SeekableReadStream *large1 = archive->createReadStreamForMember("large.bin");
+		Common::SeekableReadStream *large2 = archive->createReadStreamForMember("large.bin");
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.bin");
+
+		// The member streams must stay usable after the archive is gone
+		delete archive;
+
+		const uint32 chunk = 5000;
+		for (uint32 i = 0; i < kStoredSize / chunk; ++i) {
+			TS_ASSERT(compare(*large1, _large, i * chunk, chunk));
+			TS_ASSERT(compare(*stored, _stored, i * chunk, chunk));
+			TS_ASSERT(compare(*large2, _large, i * chunk * 2, chunk * 2));
+		}
+
+		delete large1;
+		delete large2;
+		delete stored;
+	}
+
+	void test_threads() {
+		Common::Archive *archive = createArchive(false);
+
+		Reader readers[4] = {
+			{ archive->createReadStreamForMember("stored.bin"), _stored, kStoredSize, 0 },
+			{ archive->createReadStreamForMember("stored.bin"), _stored, kStoredSize, 0 },
+			{ archive->createReadStreamForMember("large.bin"), _large, kLargeSize, 0 },
+			{ archive->createReadStreamForMember("large.bin"), _large, kLargeSize, 0 }
+		};
+
+		// Without threads, the readers run one after another
+#ifdef USE_THREADS
+		pthread_t threads[ARRAYSIZE(readers)];
+		for (uint i = 0; i < ARRAYSIZE(readers); ++i)
+			pthread_create(&threads[i], 0, runReader, &readers[i]);
+		for (uint i = 0; i < ARRAYSIZE(readers); ++i)
+			pthread_join(threads[i], 0);
+#else
+		for (uint i = 0; i < ARRAYSIZE(readers); ++i)
+			runReader(&readers[i]);
+#endif
+
+		for (uint i = 0; i < ARRAYSIZE(readers); ++i) {
+			TS_ASSERT_EQUALS(readers[i].errors, 0u);
+			delete readers[i].stream;
+		}
+
+		delete archive;
+	}
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 37,
+		kHeight = 5,
+		kPadding = 12,
+		kMaxPitch = kWidth * 4 + kPadding
+	};
+
+	static Graphics::PixelFormat getFormat(int i) {
+		static const byte formats[][9] = {
+			{ 2, 5, 6, 5, 0, 11,  5,  0,  0 }, // RGB565
+			{ 2, 5, 6, 5, 0,  0,  5, 11,  0 }, // BGR565
+			{ 2, 5, 5, 5, 0, 10,  5,  0,  0 }, // RGB555
+			{ 2, 4, 4, 4, 4,  8,  4,  0, 12 }, // ARGB4444
+			{ 3, 8, 8, 8, 0, 16,  8,  0,  0 }, // RGB888
+			{ 4, 8, 8, 8, 8, 16,  8,  0, 24 }, // ARGB8888
+			{ 4, 8, 8, 8, 8,  0,  8, 16, 24 }, // ABGR8888
+			{ 4, 8, 8, 8, 8, 24, 16,  8,  0 }, // RGBA8888
+			{ 4, 8, 8, 8, 8,  8, 16, 24,  0 }  // BGRA8888
+		};
+
+		const byte *f = formats[i];
+		return Graphics::PixelFormat(f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7], f[8]);
+	}
+
+	static void fillData(byte *data, uint32 size, uint32 seed) {
+		for (uint32 i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 16;
+		}
+	}
+
+public:
+	void test_specialized_matches_generic() {
+		byte src[kMaxPitch * kHeight];
+		byte dst[kMaxPitch * kHeight];
+		byte ref[kMaxPitch * kHeight];
+
+		for (int i = 0; i < 9; ++i) {
+			for (int j = 0; j < 9; ++j) {
+				// Identical formats are copied, including any unused bits
+				if (i == j)
+					continue;
+
+				const Graphics::PixelFormat srcFmt = getFormat(i);
+				const Graphics::PixelFormat dstFmt = getFormat(j);
+
+				// Once with padding between the rows and once without
+				for (int padding = 0; padding <= kPadding; padding += kPadding) {
+					const int srcPitch = kWidth * srcFmt.bytesPerPixel + padding;
+					const int dstPitch = kWidth * dstFmt.bytesPerPixel + padding;
+
+					fillData(src, sizeof(src), i * 9 + j);
+					memset(dst, 0xAA, sizeof(dst));
+					memset(ref, 0xAA, sizeof(ref));
+
+					TS_ASSERT(Graphics::crossBlit(dst, src, dstPitch, srcPitch, kWidth, kHeight, dstFmt, srcFmt));
+					TS_ASSERT(Graphics::crossBlitGeneric(ref, src, dstPitch, srcPitch, kWidth, kHeight, dstFmt, srcFmt));
+					TS_ASSERT(!memcmp(dst, ref, sizeof(dst)));
+				}
+			}
+		}
+	}
+
+	void test_generic_values() {
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat rgb888(3, 8, 8, 8, 0, 16, 8, 0, 0);
+		const Graphics::PixelFormat argb8888(4, 8, 8, 8, 8, 16, 8, 0, 24);
+
+		const uint16 src565[2] = { 0xF800, 0x07FF };
+		uint32 dst[2];
+		TS_ASSERT(Graphics::crossBlitGeneric((byte *)dst, (const byte *)src565, 8, 4, 2, 1, argb8888, rgb565));
+		TS_ASSERT_EQUALS(dst[0], 0x00F80000u);
+		TS_ASSERT_EQUALS(dst[1], 0x0000FCF8u);
+
+		// Every pixel of a 24 bit source has to be read from its own 3 bytes
+		byte src888[6];
+		const uint32 colors[2] = { 0x123456, 0xABCDEF };
+		for (int i = 0; i < 2; ++i) {
+#ifdef SCUMM_BIG_ENDIAN
+			src888[i * 3 + 0] = colors[i] >> 16;
+			src888[i * 3 + 1] = colors[i] >> 8;
+			src888[i * 3 + 2] = colors[i];
+#else
+			src888[i * 3 + 0] = colors[i];
+			src888[i * 3 + 1] = colors[i] >> 8;
+			src888[i * 3 + 2] = colors[i] >> 16;
+#endif
+		}
+		TS_ASSERT(Graphics::crossBlitGeneric((byte *)dst, src888, 8, 6, 2, 1, argb8888, rgb888));
+		TS_ASSERT_EQUALS(dst[0], 0x123456u);
+		TS_ASSERT_EQUALS(dst[1], 0xABCDEFu);
+	}
+
+	void test_invalid_formats() {
+		byte buffer[16];
+		const Graphics::PixelFormat clut8 = Graphics::PixelFormat::createFormatCLUT8();
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+
+		TS_ASSERT(!Graphics::crossBlit(buffer, buffer, 8, 4, 4, 1, rgb565, clut8));
+		TS_ASSERT(!Graphics::crossBlit(buffer, buffer, 4, 8, 4, 1, clut8, rgb565));
+		TS_ASSERT(!Graphics::crossBlitGeneric(buffer, buffer, 8, 4, 4, 1, rgb565, clut8));
+	}
+};
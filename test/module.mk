@@ -5,8 +5,8 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h
+TEST_LIBS    := audio/libaudio.a graphics/libgraphics.a common/libcommon.a
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh
@@ -35,6 +35,8 @@ test/runner.cpp: $(TESTS)
 	$(srcdir)/test/cxxtest/cxxtestgen.py $(TEST_FLAGS) -o $@ $+
 
 
+include $(srcdir)/test/benchmark/benchmark.mk
+
 clean: clean-test
 clean-test:
 	-$(RM) test/runner.cpp test/runner
@@ -0,0 +1,104 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TEST_SYSTEM_H
+#define TEST_SYSTEM_H
+
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+#include <string.h>
+
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * Just enough of an OSystem for the code under test: mutexes, which are
+ * real ones when threads are available. Everything else does nothing, and
+ * the clock stands still. Tests which need more override it, and install
+ * the system as g_system for as long as it is used.
+ */
+class TestSystem : public OSystem {
+public:
+	const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return false; }
+	int getGraphicsMode() const { return 0; }
+	void resetGraphicsScale() {}
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const byte *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(OverlayColor *buf, int pitch) {}
+	void copyRectToOverlay(const OverlayColor *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const byte *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, int cursorTargetScale, const Graphics::PixelFormat *format) {}
+	uint32 getMillis() { return 0; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	Common::TimerManager *getTimerManager() { return 0; }
+	Common::EventManager *getEventManager() { return 0; }
+#ifdef USE_THREADS
+	MutexRef createMutex() {
+		pthread_mutex_t *mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, 0);
+		return (MutexRef)mutex;
+	}
+	void lockMutex(MutexRef mutex) { pthread_mutex_lock((pthread_mutex_t *)mutex); }
+	void unlockMutex(MutexRef mutex) { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+	void deleteMutex(MutexRef mutex) {
+		pthread_mutex_destroy((pthread_mutex_t *)mutex);
+		delete (pthread_mutex_t *)mutex;
+	}
+#else
+	MutexRef createMutex() { return (MutexRef)this; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+#endif
+	Audio::Mixer *getMixer() { return 0; }
+	AudioCDManager *getAudioCDManager() { return 0; }
+	void quit() {}
+	void displayMessageOnOSD(const char *msg) {}
+	Common::SaveFileManager *getSavefileManager() { return 0; }
+	FilesystemFactory *getFilesystemFactory() { return 0; }
+	Common::SeekableReadStream *createConfigReadStream() { return 0; }
+	Common::WriteStream *createConfigWriteStream() { return 0; }
+};
+
+#endif